@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <cstring>
@@ -21,6 +22,7 @@
 #include <benchmark/benchmark.h>
 
 #include "ultrahdr_api.h"
+#include "ultrahdr/gainmapmath.h"
 
 #ifdef __ANDROID__
 std::string kTestImagesPath = "/sdcard/test/UltrahdrBenchmarkTestRes-1.2/";
@@ -87,6 +89,8 @@ using TestParamsEncoderAPI1 =
 std::vector<TestParamsDecodeAPI> testParamsDecodeAPI;
 std::vector<TestParamsEncoderAPI0> testParamsAPI0;
 std::vector<TestParamsEncoderAPI1> testParamsAPI1;
+std::vector<TestParamsEncoderAPI1> testParamsPreset;
+std::vector<std::pair<TestParamsEncoderAPI0, int>> testParamsGainMapScale;
 
 std::string imgFmtToString(const uhdr_img_fmt of) {
   switch (of) {
@@ -114,6 +118,21 @@ std::string colorGamutToString(const uhdr_color_gamut_t cg) {
   }
 }
 
+std::string presetToString(const uhdr_enc_preset_t preset) {
+  switch (preset) {
+    case UHDR_USAGE_FASTEST:
+      return "fastest";
+    case UHDR_USAGE_REALTIME:
+      return "realtime";
+    case UHDR_USAGE_BALANCED:
+      return "balanced";
+    case UHDR_USAGE_BEST_QUALITY:
+      return "best_quality";
+    default:
+      return "Unknown";
+  }
+}
+
 std::string tfToString(const uhdr_color_transfer_t of) {
   switch (of) {
     case UHDR_CT_LINEAR:
@@ -428,7 +447,7 @@ static void BM_UHDREncode_Api1(benchmark::State& s, TestParamsEncoderAPI1 testVe
       ", sdrCg: " + colorGamutToString(benchmark.mSdrCg) + ", " +
       (benchmark.mUseMultiChannelGainMap == 0 ? "singlechannelgainmap" : "multichannelgainmap") +
       ", gamma: " + std::to_string(benchmark.mGamma) + ", " +
-      (benchmark.mEncPreset == UHDR_USAGE_BEST_QUALITY ? "best_quality" : "realtime"));
+      presetToString(benchmark.mEncPreset));
 
   if (benchmark.mHdrFile.find("p010") != std::string::npos) {
     benchmark.mHdrFile = kTestImagesPath + "p010/" + benchmark.mHdrFile;
@@ -484,6 +503,184 @@ static void BM_UHDREncode_Api1(benchmark::State& s, TestParamsEncoderAPI1 testVe
   uhdr_release_encoder(encHandle);
 }
 
+/* psnr of the rgb channels of two rgba8888 images */
+static double computePsnrRgba8888(const uhdr_raw_image_t* ref, const uhdr_raw_image_t* test) {
+  const uint8_t* refData = static_cast<const uint8_t*>(ref->planes[UHDR_PLANE_PACKED]);
+  const uint8_t* testData = static_cast<const uint8_t*>(test->planes[UHDR_PLANE_PACKED]);
+  double sse = 0;
+  for (unsigned int i = 0; i < ref->h; i++) {
+    const uint8_t* refRow = refData + (size_t)i * ref->stride[UHDR_PLANE_PACKED] * 4;
+    const uint8_t* testRow = testData + (size_t)i * test->stride[UHDR_PLANE_PACKED] * 4;
+    for (unsigned int j = 0; j < ref->w * 4; j++) {
+      if ((j & 3) == 3) continue;  // alpha
+      double diff = (double)refRow[j] - testRow[j];
+      sse += diff * diff;
+    }
+  }
+  double mse = sse / ((double)ref->w * ref->h * 3);
+  return mse == 0 ? 100.0 : 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+static void BM_UHDREncode_Preset(benchmark::State& s, TestParamsEncoderAPI1 testVectors) {
+  EncBenchmark benchmark(testVectors);
+
+  s.SetLabel(benchmark.mHdrFile + ", " + benchmark.mSdrFile + ", " +
+             std::to_string(benchmark.mWidth) + "x" + std::to_string(benchmark.mHeight) + ", " +
+             presetToString(benchmark.mEncPreset));
+
+  if (benchmark.mHdrFile.find("p010") != std::string::npos) {
+    benchmark.mHdrFile = kTestImagesPath + "p010/" + benchmark.mHdrFile;
+    benchmark.mHdrCf = UHDR_IMG_FMT_24bppYCbCrP010;
+  } else if (benchmark.mHdrFile.find("rgba1010102") != std::string::npos) {
+    benchmark.mHdrFile = kTestImagesPath + "rgba1010102/" + benchmark.mHdrFile;
+    benchmark.mHdrCf = UHDR_IMG_FMT_32bppRGBA1010102;
+  } else {
+    s.SkipWithError("Invalid hdr file format : " + benchmark.mHdrFile);
+    return;
+  }
+
+  if (benchmark.mSdrFile.find("rgba8888") != std::string::npos) {
+    benchmark.mSdrFile = kTestImagesPath + "rgba8888/" + benchmark.mSdrFile;
+    benchmark.mSdrCf = UHDR_IMG_FMT_32bppRGBA8888;
+  } else {
+    s.SkipWithError("Invalid sdr file format : " + benchmark.mSdrFile);
+    return;
+  }
+
+  if (!benchmark.fillRawImageHandle(&benchmark.mHdrImg, benchmark.mWidth, benchmark.mHeight,
+                                    benchmark.mHdrFile, benchmark.mHdrCf, benchmark.mHdrCg,
+                                    benchmark.mHdrCt)) {
+    s.SkipWithError("unable to load file : " + benchmark.mHdrFile);
+    return;
+  }
+  if (!benchmark.fillRawImageHandle(&benchmark.mSdrImg, benchmark.mWidth, benchmark.mHeight,
+                                    benchmark.mSdrFile, benchmark.mSdrCf, benchmark.mSdrCg,
+                                    benchmark.mSdrCt)) {
+    s.SkipWithError("unable to load sdr file : " + benchmark.mSdrFile);
+    return;
+  }
+
+  // gain map scale factor and channel count are left to the preset
+  uhdr_codec_private_t* encHandle = uhdr_create_encoder();
+  for (auto _ : s) {
+    RET_IF_ERR(uhdr_enc_set_raw_image(encHandle, &benchmark.mHdrImg, UHDR_HDR_IMG))
+    RET_IF_ERR(uhdr_enc_set_raw_image(encHandle, &benchmark.mSdrImg, UHDR_SDR_IMG))
+    RET_IF_ERR(uhdr_enc_set_preset(encHandle, benchmark.mEncPreset))
+    RET_IF_ERR(uhdr_encode(encHandle))
+    uhdr_reset_encoder(encHandle);
+  }
+
+  // report size and sdr rendition quality of the encoded output
+  RET_IF_ERR(uhdr_enc_set_raw_image(encHandle, &benchmark.mHdrImg, UHDR_HDR_IMG))
+  RET_IF_ERR(uhdr_enc_set_raw_image(encHandle, &benchmark.mSdrImg, UHDR_SDR_IMG))
+  RET_IF_ERR(uhdr_enc_set_preset(encHandle, benchmark.mEncPreset))
+  RET_IF_ERR(uhdr_encode(encHandle))
+  uhdr_compressed_image_t* output = uhdr_get_encoded_stream(encHandle);
+  s.counters["size_bytes"] = output->data_sz;
+  s.counters["bpp"] = output->data_sz * 8.0 / ((double)benchmark.mWidth * benchmark.mHeight);
+
+  uhdr_codec_private_t* decHandle = uhdr_create_decoder();
+  if (uhdr_dec_set_image(decHandle, output).error_code == UHDR_CODEC_OK &&
+      uhdr_dec_set_out_img_format(decHandle, UHDR_IMG_FMT_32bppRGBA8888).error_code ==
+          UHDR_CODEC_OK &&
+      uhdr_dec_set_out_color_transfer(decHandle, UHDR_CT_SRGB).error_code == UHDR_CODEC_OK &&
+      uhdr_decode(decHandle).error_code == UHDR_CODEC_OK) {
+    s.counters["psnr_sdr"] =
+        computePsnrRgba8888(&benchmark.mSdrImg, uhdr_get_decoded_image(decHandle));
+  }
+  uhdr_release_decoder(decHandle);
+  uhdr_release_encoder(encHandle);
+}
+
+/* decode of a stream encoded from the hdr intent with the given gain map scale factor, the
+   encode is not timed */
+static void BM_UHDRDecode_GainMapScale(benchmark::State& s,
+                                       std::pair<TestParamsEncoderAPI0, int> testVectors) {
+  EncBenchmark benchmark(testVectors.first);
+  benchmark.mMapDimensionScaleFactor = testVectors.second;
+
+  s.SetLabel(benchmark.mHdrFile + ", " + std::to_string(benchmark.mWidth) + "x" +
+             std::to_string(benchmark.mHeight) + ", " +
+             (benchmark.mUseMultiChannelGainMap == 0 ? "singlechannelgainmap"
+                                                     : "multichannelgainmap") +
+             ", scale factor: " + std::to_string(benchmark.mMapDimensionScaleFactor));
+
+  benchmark.mHdrFile = kTestImagesPath + "p010/" + benchmark.mHdrFile;
+  benchmark.mHdrCf = UHDR_IMG_FMT_24bppYCbCrP010;
+  if (!benchmark.fillRawImageHandle(&benchmark.mHdrImg, benchmark.mWidth, benchmark.mHeight,
+                                    benchmark.mHdrFile, benchmark.mHdrCf, benchmark.mHdrCg,
+                                    benchmark.mHdrCt)) {
+    s.SkipWithError("unable to load file : " + benchmark.mHdrFile);
+    return;
+  }
+
+  uhdr_codec_private_t* encHandle = uhdr_create_encoder();
+  RET_IF_ERR(uhdr_enc_set_raw_image(encHandle, &benchmark.mHdrImg, UHDR_HDR_IMG))
+  RET_IF_ERR(
+      uhdr_enc_set_using_multi_channel_gainmap(encHandle, benchmark.mUseMultiChannelGainMap))
+  RET_IF_ERR(uhdr_enc_set_gainmap_scale_factor(encHandle, benchmark.mMapDimensionScaleFactor))
+  RET_IF_ERR(uhdr_encode(encHandle))
+  uhdr_compressed_image_t* output = uhdr_get_encoded_stream(encHandle);
+
+  uhdr_codec_private_t* decHandle = uhdr_create_decoder();
+  for (auto _ : s) {
+    uhdr_error_info_t status = uhdr_dec_set_image(decHandle, output);
+    if (status.error_code == UHDR_CODEC_OK)
+      status = uhdr_dec_set_out_color_transfer(decHandle, benchmark.mHdrCt);
+    if (status.error_code == UHDR_CODEC_OK)
+      status = uhdr_dec_set_out_img_format(decHandle, UHDR_IMG_FMT_32bppRGBA1010102);
+    if (status.error_code == UHDR_CODEC_OK) status = uhdr_decode(decHandle);
+    if (status.error_code != UHDR_CODEC_OK) {
+      s.SkipWithError(status.has_detail ? status.detail : "Unknown error");
+      break;
+    }
+    uhdr_reset_decoder(decHandle);
+  }
+  uhdr_release_decoder(decHandle);
+  uhdr_release_encoder(encHandle);
+}
+
+/* gain map upsampling for a 4080x3072 output, either sampled per pixel in raster order as decodes
+   did before gain maps were traversed by bands of cells, or a row at a time by GainMapRowSampler.
+   The map is synthetic, no resources are needed */
+static void BM_GainMapUpsample(benchmark::State& s, int mapScaleFactor, int channels, bool band) {
+  const size_t width = 4080, height = 3072;
+  const size_t map_w = (width + mapScaleFactor - 1) / mapScaleFactor;
+  const size_t map_h = (height + mapScaleFactor - 1) / mapScaleFactor;
+  ultrahdr::uhdr_raw_image_ext_t map(
+      channels == 1 ? UHDR_IMG_FMT_8bppYCbCr400 : UHDR_IMG_FMT_32bppRGBA8888, UHDR_CG_UNSPECIFIED,
+      UHDR_CT_UNSPECIFIED, UHDR_CR_UNSPECIFIED, map_w, map_h, 64);
+  const size_t bpp = channels == 1 ? 1 : 4;
+  uint8_t* data = static_cast<uint8_t*>(map.planes[UHDR_PLANE_PACKED]);
+  for (size_t i = 0; i < map.stride[UHDR_PLANE_PACKED] * map_h * bpp; i++) {
+    data[i] = (uint8_t)(i * 2654435761u >> 24);
+  }
+
+  s.SetLabel(std::string(band ? "band" : "raster") + ", " +
+             (channels == 1 ? "singlechannelgainmap" : "multichannelgainmap") +
+             ", scale factor: " + std::to_string(mapScaleFactor));
+
+  std::shared_ptr<const ultrahdr::ShepardsIDW> idw = ultrahdr::getShepardsIDW(mapScaleFactor);
+  for (auto _ : s) {
+    float sum = 0.0f;
+    if (band) {
+      ultrahdr::GainMapRowSampler sampler(&map, (float)mapScaleFactor, width);
+      for (size_t y = 0; y < height; y++) sum += sampler.sampleRow(y)[y % width];
+    } else {
+      for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+          if (channels == 1) {
+            sum += ultrahdr::sampleMap(&map, (size_t)mapScaleFactor, x, y, *idw);
+          } else {
+            sum += ultrahdr::sampleMap3Channel(&map, (size_t)mapScaleFactor, x, y, *idw, true).r;
+          }
+        }
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
 void addTestVectors() {
   for (const auto& uhdrFile : kDecodeAPITestImages) {
     /* Decode API - uhdrFile, colorTransfer, imgFormat, enableGLES */
@@ -527,6 +724,27 @@ void addTestVectors() {
     testParamsAPI1.push_back({inputFiles.first, inputFiles.second, 4080, 3072, UHDR_CG_BT_2100,
                               UHDR_CT_PQ, UHDR_CG_BT_709, 1, 1.571f, UHDR_USAGE_BEST_QUALITY});
   }
+
+  for (const auto& inputFiles : kEncodeApi1TestImages12MpName) {
+    if (inputFiles.second.find("rgba8888") == std::string::npos) continue;
+    /* Encode API 1 presets - hdrFile, sdrFile, width, height, hdrColorGamut, hdrColorTransfer,
+       sdrColorGamut, useMultiChannelGainmap (unused), gamma, encPreset */
+    for (auto preset : {UHDR_USAGE_FASTEST, UHDR_USAGE_REALTIME, UHDR_USAGE_BALANCED,
+                        UHDR_USAGE_BEST_QUALITY}) {
+      testParamsPreset.push_back({inputFiles.first, inputFiles.second, 4080, 3072,
+                                  UHDR_CG_BT_2100, UHDR_CT_PQ, UHDR_CG_BT_709, 0, 1.0f, preset});
+    }
+  }
+
+  /* Decode with gain map scale factor - {hdrFile, width, height, hdrColorGamut, hdrColorTransfer,
+     useMultiChannelGainmap, gamma}, mapScaleFactor */
+  for (int useMultiChannelGainMap : {0, 1}) {
+    for (int scale : {1, 2, 4, 8}) {
+      testParamsGainMapScale.push_back({{"mountains_p010.p010", 4080, 3072, UHDR_CG_BT_2100,
+                                         UHDR_CT_HLG, useMultiChannelGainMap, 1.0f},
+                                        scale});
+    }
+  }
 }
 
 void registerBenchmarks() {
@@ -542,6 +760,23 @@ void registerBenchmarks() {
     benchmark::RegisterBenchmark("BM_UHDREncode_Api1", BM_UHDREncode_Api1, param)
         ->Unit(benchmark::kMillisecond);
   }
+  for (auto& param : testParamsPreset) {
+    benchmark::RegisterBenchmark("BM_UHDREncode_Preset", BM_UHDREncode_Preset, param)
+        ->Unit(benchmark::kMillisecond);
+  }
+  for (auto& param : testParamsGainMapScale) {
+    benchmark::RegisterBenchmark("BM_UHDRDecode_GainMapScale", BM_UHDRDecode_GainMapScale, param)
+        ->Unit(benchmark::kMillisecond);
+  }
+  for (int channels : {1, 3}) {
+    for (int scale : {1, 2, 4, 8}) {
+      for (bool band : {false, true}) {
+        benchmark::RegisterBenchmark("BM_GainMapUpsample", BM_GainMapUpsample, scale, channels,
+                                     band)
+            ->Unit(benchmark::kMillisecond);
+      }
+    }
+  }
 }
 
 int main(int argc, char** argv) {
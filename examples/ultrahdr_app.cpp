@@ -304,11 +304,13 @@ class UltraHdrAppInput {
         mMinContentBoost(minContentBoost),
         mMaxContentBoost(maxContentBoost),
         mTargetDispPeakBrightness(targetDispPeakBrightness),
+        mDecPreset(UHDR_DEC_USAGE_BALANCED),
         mMode(0){};
 
   UltraHdrAppInput(const char* gainmapMetadataCfgFile, const char* uhdrFile, const char* outputFile,
                    uhdr_color_transfer_t oTf = UHDR_CT_HLG,
-                   uhdr_img_fmt_t oFmt = UHDR_IMG_FMT_32bppRGBA1010102, bool enableGLES = false)
+                   uhdr_img_fmt_t oFmt = UHDR_IMG_FMT_32bppRGBA1010102, bool enableGLES = false,
+                   uhdr_dec_preset_t decPreset = UHDR_DEC_USAGE_BALANCED)
       : mHdrIntentRawFile(nullptr),
         mSdrIntentRawFile(nullptr),
         mSdrIntentCompressedFile(nullptr),
@@ -337,6 +339,7 @@ class UltraHdrAppInput {
         mMinContentBoost(FLT_MIN),
         mMaxContentBoost(FLT_MAX),
         mTargetDispPeakBrightness(-1.0f),
+        mDecPreset(decPreset),
         mMode(1){};
 
   ~UltraHdrAppInput() {
@@ -425,6 +428,7 @@ class UltraHdrAppInput {
   const float mMinContentBoost;
   const float mMaxContentBoost;
   const float mTargetDispPeakBrightness;
+  const uhdr_dec_preset_t mDecPreset;
   const int mMode;
 
   uhdr_raw_image_t mRawP010Image{};
@@ -837,6 +841,7 @@ bool UltraHdrAppInput::decode() {
   RET_IF_ERR(uhdr_dec_set_image(handle, &mUhdrImage))
   RET_IF_ERR(uhdr_dec_set_out_color_transfer(handle, mOTf))
   RET_IF_ERR(uhdr_dec_set_out_img_format(handle, mOfmt))
+  RET_IF_ERR(uhdr_dec_set_preset(handle, mDecPreset))
   if (mEnableGLES) {
     RET_IF_ERR(uhdr_enable_gpu_acceleration(handle, mEnableGLES))
   }
@@ -1469,7 +1474,8 @@ static void usage(const char* name) {
           "    -M    select multi channel gain map, optional. [0:disable, 1:enable (default)]. \n");
   fprintf(
       stderr,
-      "    -D    select encoding preset, optional. [0:real time, 1:best quality (default)]. \n");
+      "    -D    select encoding preset, optional. [0:real time, 1:best quality (default), "
+      "2:fastest, 3:balanced]. \n");
   fprintf(stderr,
           "    -k    min content boost recommendation, must be in linear scale, optional. [any "
           "positive real number] \n");
@@ -1498,6 +1504,9 @@ static void usage(const char* name) {
       "          linear shall be paired with rgbahalffloat. \n");
   fprintf(stderr,
           "    -u    enable gles acceleration, optional. [0:disable (default), 1:enable]. \n");
+  fprintf(stderr,
+          "    -P    select decoding preset, optional. [0:balanced (default), 1:real time, "
+          "2:best quality]. \n");
   fprintf(stderr, "\n## common options : \n");
   fprintf(stderr,
           "    -z    output filename, optional. \n"
@@ -1568,7 +1577,7 @@ static void usage(const char* name) {
 }
 
 int main(int argc, char* argv[]) {
-  char opt_string[] = "p:y:i:g:f:w:h:C:c:t:q:o:O:m:j:e:a:b:z:R:s:M:Q:G:x:u:D:k:K:L:";
+  char opt_string[] = "p:y:i:g:f:w:h:C:c:t:q:o:O:m:j:e:a:b:z:R:s:M:Q:G:x:u:D:k:K:L:P:";
   char *hdr_intent_raw_file = nullptr, *sdr_intent_raw_file = nullptr, *uhdr_file = nullptr,
        *sdr_intent_compressed_file = nullptr, *gainmap_compressed_file = nullptr,
        *gainmap_metadata_cfg_file = nullptr, *output_file = nullptr, *exif_file = nullptr;
@@ -1590,6 +1599,7 @@ int main(int argc, char* argv[]) {
   float gamma = 1.0f;
   bool enable_gles = false;
   uhdr_enc_preset_t enc_preset = UHDR_USAGE_BEST_QUALITY;
+  uhdr_dec_preset_t dec_preset = UHDR_DEC_USAGE_BALANCED;
   float min_content_boost = FLT_MIN;
   float max_content_boost = FLT_MAX;
   float target_disp_peak_brightness = -1.0f;
@@ -1681,6 +1691,9 @@ int main(int argc, char* argv[]) {
       case 'D':
         enc_preset = static_cast<uhdr_enc_preset_t>(atoi(optarg_s));
         break;
+      case 'P':
+        dec_preset = static_cast<uhdr_dec_preset_t>(atoi(optarg_s));
+        break;
       case 'k':
         min_content_boost = (float)atof(optarg_s);
         break;
@@ -1752,7 +1765,7 @@ int main(int argc, char* argv[]) {
     }
     UltraHdrAppInput appInput(gainmap_metadata_cfg_file, uhdr_file,
                               output_file ? output_file : "outrgb.raw", out_tf, out_cf,
-                              enable_gles);
+                              enable_gles, dec_preset);
     if (!appInput.decode()) return -1;
   } else {
     if (argc > 1) std::cerr << "did not receive valid mode of operation " << mode << std::endl;
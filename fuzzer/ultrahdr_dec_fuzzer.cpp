@@ -39,6 +39,8 @@ void UltraHdrDecFuzzer::process() {
       static_cast<uhdr_color_transfer>(mFdp.ConsumeIntegralInRange<int8_t>(kTfMin, kTfMax));
   auto displayBoost = mFdp.ConsumeFloatingPointInRange<float>(-10.0f, 100.0f);
   auto enableGpu = mFdp.ConsumeBool();
+  auto decPreset = static_cast<uhdr_dec_preset_t>(
+      mFdp.ConsumeIntegralInRange<int>(UHDR_DEC_USAGE_BALANCED, UHDR_DEC_USAGE_BEST_QUALITY));
 
   // editing effects
   auto applyMirror = mFdp.ConsumeBool();
@@ -86,6 +88,7 @@ void UltraHdrDecFuzzer::process() {
     else
       ON_ERR(uhdr_dec_set_out_img_format(dec_handle, UHDR_IMG_FMT_32bppRGBA1010102))
     ON_ERR(uhdr_dec_set_out_max_display_boost(dec_handle, displayBoost))
+    ON_ERR(uhdr_dec_set_preset(dec_handle, decPreset))
     ON_ERR(uhdr_enable_gpu_acceleration(dec_handle, enableGpu))
     if (applyMirror) ON_ERR(uhdr_add_effect_mirror(dec_handle, direction))
     if (applyRotate) ON_ERR(uhdr_add_effect_rotate(dec_handle, degrees))
@@ -129,7 +129,8 @@ void UltraHdrEncFuzzer::process() {
     auto gm_scale_factor = mFdp.ConsumeIntegralInRange<int16_t>(-32, 192);
 
     // encoding speed preset
-    auto enc_preset = mFdp.ConsumeBool() ? UHDR_USAGE_REALTIME : UHDR_USAGE_BEST_QUALITY;
+    auto enc_preset = static_cast<uhdr_enc_preset_t>(
+        mFdp.ConsumeIntegralInRange<int>(UHDR_USAGE_REALTIME, UHDR_USAGE_BALANCED));
 
     bool are_all_channels_identical = mFdp.ConsumeBool();
 
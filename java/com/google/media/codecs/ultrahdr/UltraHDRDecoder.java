@@ -35,6 +35,22 @@ import java.util.Arrays;
  */
 public class UltraHDRDecoder implements AutoCloseable {
 
+    // Fields describing the decoder tuning configurations
+    /**
+     * Tune decoder settings for a trade-off between performance and quality
+     */
+    public static final int UHDR_DEC_USAGE_BALANCED = 0;
+
+    /**
+     * Tune decoder settings for best performance
+     */
+    public static final int UHDR_DEC_USAGE_REALTIME = 1;
+
+    /**
+     * Tune decoder settings for best quality
+     */
+    public static final int UHDR_DEC_USAGE_BEST_QUALITY = 2;
+
     /**
      * GainMap Metadata Descriptor
      */
@@ -265,6 +281,22 @@ public class UltraHDRDecoder implements AutoCloseable {
         setMaxDisplayBoostNative(displayBoost);
     }
 
+    /**
+     * Set decoding preset. Tunes the decoder configurations for performance or quality. Default
+     * configuration is {@link UltraHDRDecoder#UHDR_DEC_USAGE_BALANCED}.
+     *
+     * @param preset decoding preset. {@link UltraHDRDecoder#UHDR_DEC_USAGE_REALTIME} for best
+     *               performance {@link UltraHDRDecoder#UHDR_DEC_USAGE_BALANCED} for a trade-off
+     *               between performance and quality
+     *               {@link UltraHDRDecoder#UHDR_DEC_USAGE_BEST_QUALITY} for best quality
+     * @throws IOException If parameters are not valid or current decoder instance is not valid
+     *                     or current decoder instance is not suitable for configuration
+     *                     exception is thrown
+     */
+    public void setDecPreset(int preset) throws IOException {
+        setDecPresetNative(preset);
+    }
+
     /**
      * Enable/Disable GPU acceleration. If enabled, certain operations (if possible) of uhdr
      * decode will be offloaded to GPU.
@@ -522,6 +554,8 @@ public class UltraHDRDecoder implements AutoCloseable {
 
     private native void setMaxDisplayBoostNative(float displayBoost) throws IOException;
 
+    private native void setDecPresetNative(int preset) throws IOException;
+
     private native void enableGpuAccelerationNative(int enable) throws IOException;
 
     private native void probeNative() throws IOException;
@@ -56,6 +56,16 @@ public class UltraHDREncoder implements AutoCloseable {
      */
     public static final int UHDR_USAGE_BEST_QUALITY = 1;
 
+    /**
+     * Tune encoder settings for fastest encoding at the cost of quality and size
+     */
+    public static final int UHDR_USAGE_FASTEST = 2;
+
+    /**
+     * Tune encoder settings for a trade-off between performance and quality
+     */
+    public static final int UHDR_USAGE_BALANCED = 3;
+
     // APIs
 
     /**
@@ -414,8 +424,11 @@ public class UltraHDREncoder implements AutoCloseable {
      * Set encoding preset. Tunes the encoder configurations for performance or quality. Default
      * configuration is {@link UltraHDREncoder#UHDR_USAGE_BEST_QUALITY}.
      *
-     * @param preset encoding preset. {@link UltraHDREncoder#UHDR_USAGE_REALTIME} for best
-     *               performance {@link UltraHDREncoder#UHDR_USAGE_BEST_QUALITY} for best quality
+     * @param preset encoding preset. {@link UltraHDREncoder#UHDR_USAGE_FASTEST} for fastest
+     *               encoding {@link UltraHDREncoder#UHDR_USAGE_REALTIME} for best performance
+     *               {@link UltraHDREncoder#UHDR_USAGE_BALANCED} for a trade-off between
+     *               performance and quality {@link UltraHDREncoder#UHDR_USAGE_BEST_QUALITY} for
+     *               best quality
      * @throws IOException If parameters are not valid or current encoder instance is not valid
      *                     or current encoder instance is not suitable for configuration
      *                     exception is thrown
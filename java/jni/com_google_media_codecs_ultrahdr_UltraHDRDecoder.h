@@ -7,6 +7,12 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+#undef com_google_media_codecs_ultrahdr_UltraHDRDecoder_UHDR_DEC_USAGE_BALANCED
+#define com_google_media_codecs_ultrahdr_UltraHDRDecoder_UHDR_DEC_USAGE_BALANCED 0L
+#undef com_google_media_codecs_ultrahdr_UltraHDRDecoder_UHDR_DEC_USAGE_REALTIME
+#define com_google_media_codecs_ultrahdr_UltraHDRDecoder_UHDR_DEC_USAGE_REALTIME 1L
+#undef com_google_media_codecs_ultrahdr_UltraHDRDecoder_UHDR_DEC_USAGE_BEST_QUALITY
+#define com_google_media_codecs_ultrahdr_UltraHDRDecoder_UHDR_DEC_USAGE_BEST_QUALITY 2L
 /*
  * Class:     com_google_media_codecs_ultrahdr_UltraHDRDecoder
  * Method:    isUHDRImageNative
@@ -63,6 +69,14 @@ JNIEXPORT void JNICALL Java_com_google_media_codecs_ultrahdr_UltraHDRDecoder_set
 JNIEXPORT void JNICALL Java_com_google_media_codecs_ultrahdr_UltraHDRDecoder_setMaxDisplayBoostNative
   (JNIEnv *, jobject, jfloat);
 
+/*
+ * Class:     com_google_media_codecs_ultrahdr_UltraHDRDecoder
+ * Method:    setDecPresetNative
+ * Signature: (I)V
+ */
+JNIEXPORT void JNICALL Java_com_google_media_codecs_ultrahdr_UltraHDRDecoder_setDecPresetNative
+  (JNIEnv *, jobject, jint);
+
 /*
  * Class:     com_google_media_codecs_ultrahdr_UltraHDRDecoder
  * Method:    enableGpuAccelerationNative
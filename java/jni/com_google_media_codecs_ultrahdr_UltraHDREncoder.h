@@ -17,6 +17,10 @@ extern "C" {
 #define com_google_media_codecs_ultrahdr_UltraHDREncoder_UHDR_USAGE_REALTIME 0L
 #undef com_google_media_codecs_ultrahdr_UltraHDREncoder_UHDR_USAGE_BEST_QUALITY
 #define com_google_media_codecs_ultrahdr_UltraHDREncoder_UHDR_USAGE_BEST_QUALITY 1L
+#undef com_google_media_codecs_ultrahdr_UltraHDREncoder_UHDR_USAGE_FASTEST
+#define com_google_media_codecs_ultrahdr_UltraHDREncoder_UHDR_USAGE_FASTEST 2L
+#undef com_google_media_codecs_ultrahdr_UltraHDREncoder_UHDR_USAGE_BALANCED
+#define com_google_media_codecs_ultrahdr_UltraHDREncoder_UHDR_USAGE_BALANCED 3L
 /*
  * Class:     com_google_media_codecs_ultrahdr_UltraHDREncoder
  * Method:    init
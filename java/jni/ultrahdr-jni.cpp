@@ -515,6 +515,17 @@ Java_com_google_media_codecs_ultrahdr_UltraHDRDecoder_setMaxDisplayBoostNative(
                                 : "uhdr_dec_set_out_max_display_boost() returned with error")
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_google_media_codecs_ultrahdr_UltraHDRDecoder_setDecPresetNative(JNIEnv *env, jobject thiz,
+                                                                         jint preset) {
+  GET_HANDLE()
+  RET_IF_TRUE(handle == 0, "java/io/IOException", "invalid decoder instance")
+  uhdr_error_info_t status =
+      uhdr_dec_set_preset((uhdr_codec_private_t *)handle, (uhdr_dec_preset_t)preset);
+  RET_IF_TRUE(status.error_code != UHDR_CODEC_OK, "java/io/IOException",
+              status.has_detail ? status.detail : "uhdr_dec_set_preset() returned with error")
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_google_media_codecs_ultrahdr_UltraHDRDecoder_enableGpuAccelerationNative(JNIEnv *env,
                                                                                   jobject thiz,
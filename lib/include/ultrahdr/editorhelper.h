@@ -101,6 +101,83 @@ typedef struct uhdr_resize_effect : uhdr_effect_desc {
   void (*m_resize_uint64_t)(uint64_t*, uint64_t*, int, int, int, int, int, int);
 } uhdr_resize_effect_t; /**< alias for struct uhdr_resize_effect */
 
+/*!\brief resampling filters */
+typedef enum uhdr_resample_filter {
+  UHDR_RESAMPLE_NEAREST,  /**< nearest neighbor */
+  UHDR_RESAMPLE_BILINEAR, /**< triangle, 2 taps */
+  UHDR_RESAMPLE_BICUBIC,  /**< catmull-rom, 4 taps */
+  UHDR_RESAMPLE_LANCZOS3, /**< lanczos, 6 taps */
+  UHDR_RESAMPLE_AREA,     /**< source pixel coverage, suited for large downscales */
+} uhdr_resample_filter_t; /**< alias for enum uhdr_resample_filter */
+
+/*!\brief filter taps of one resampled axis
+ *
+ * Output sample i covers the source interval [offset + i * scale, offset + (i + 1) * scale), a
+ * negative scale walks the source backwards. Its value is the weighted sum of m_taps consecutive
+ * source samples starting at m_start[i]. Taps that fall outside the source are folded on to the
+ * edge samples and the weights of every output sample add up to one.
+ */
+typedef struct uhdr_resample_table {
+  uhdr_resample_table(int src_len, int dst_len, double offset, double scale,
+                      uhdr_resample_filter_t filter);
+
+  int m_taps;
+  std::vector<int> m_start;
+  std::vector<float> m_weights; /**< m_taps weights per output sample */
+} uhdr_resample_table_t;        /**< alias for struct uhdr_resample_table */
+
+/*!\brief geometric transform compiled from a chain of crop, mirror, rotate and resize effects
+ *
+ * Every effect only updates the mapping of the output axes on to the source, pixels are moved once
+ * by apply_transform(). Chains without resizes reduce to an index remap of the source, others are
+ * resampled.
+ */
+typedef struct uhdr_effect_transform {
+  uhdr_effect_transform(uhdr_img_fmt_t fmt, int width, int height);
+
+  void crop(int left, int top, int wd, int ht);
+  void mirror(uhdr_mirror_direction_t direction);
+  void rotate(int degree);
+  void resize(int dst_w, int dst_h);
+
+  int width() const { return m_axis[0].m_len; }
+  int height() const { return m_axis[1].m_len; }
+
+  // returns true if every output sample maps to exactly one source sample
+  bool is_remap() const;
+
+  // returns true if the transform selects an untouched rectangle of the source, its top left
+  // corner is returned in left, top
+  bool is_crop(int* left, int* top) const;
+
+  // source index of every output sample of an axis, for chroma planes of subsampled formats pass
+  // chroma as true. Only meaningful if is_remap()
+  std::vector<int> get_index_map(int axis, bool chroma) const;
+
+  // the same mapping with rotations and mirrors taken out, its output is in source orientation
+  uhdr_effect_transform get_unoriented() const;
+
+  // places the output of get_unoriented() in the output of this transform. Pixel (x, y) lands at
+  // sample origin + x * step_x + y * step_y of an output plane with the given stride
+  void get_output_steps(ptrdiff_t stride, ptrdiff_t* origin, ptrdiff_t* step_x,
+                        ptrdiff_t* step_y) const;
+
+  uhdr_img_fmt_t m_fmt;
+  int m_src_w, m_src_h;
+
+  // if set, output columns walk source rows and output rows walk source columns
+  bool m_transposed;
+
+  // output axis [0] columns, [1] rows. Output sample i of an axis covers the source interval
+  // [m_offset + i * m_scale, m_offset + (i + 1) * m_scale)
+  struct {
+    int m_len;
+    double m_offset;
+    double m_scale;
+    uhdr_resample_filter_t m_filter;
+  } m_axis[2];
+} uhdr_effect_transform_t; /**< alias for struct uhdr_effect_transform */
+
 template <typename T>
 extern void rotate_buffer_clockwise(T* src_buffer, T* dst_buffer, int src_w, int src_h,
                                     int src_stride, int dst_stride, int degree);
@@ -109,11 +186,34 @@ template <typename T>
 extern void mirror_buffer(T* src_buffer, T* dst_buffer, int src_w, int src_h, int src_stride,
                           int dst_stride, uhdr_mirror_direction_t direction);
 
+// copies a src_w x src_h region of src to dst transposed, dst(i, j) = src(j, i). Strides are in
+// samples and may be negative to walk either buffer backwards. The region is processed in cache
+// sized tiles
+template <typename T>
+extern void transpose_buffer(const T* src_buffer, T* dst_buffer, int src_w, int src_h,
+                             ptrdiff_t src_stride, ptrdiff_t dst_stride);
+
+template <typename T>
+extern void transpose_tile(const T* src_buffer, T* dst_buffer, int src_w, int src_h,
+                           ptrdiff_t src_stride, ptrdiff_t dst_stride);
+
+// dst[j] = src[w - j - 1]
+template <typename T>
+extern void reverse_row(const T* src_buffer, T* dst_buffer, int w);
+
 template <typename T>
 extern void resize_buffer(T* src_buffer, T* dst_buffer, int src_w, int src_h, int dst_w, int dst_h,
                           int src_stride, int dst_stride);
 
-std::unique_ptr<uhdr_raw_image_ext_t> resize_image(uhdr_raw_image_t* src, int dst_w, int dst_h);
+std::unique_ptr<uhdr_raw_image_ext_t> resize_image(
+    uhdr_raw_image_t* src, int dst_w, int dst_h,
+    uhdr_resample_filter_t filter = UHDR_RESAMPLE_BILINEAR);
+
+// picks bicubic for upscales and mild downscales, area averaging past 2:1
+uhdr_resample_filter_t get_default_resample_filter(double scale);
+
+void resample_vertical(float* dst, const float* const* rows, const float* weights, int taps,
+                       int len);
 
 #if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__ARM_NEON__) || defined(__ARM_NEON)))
 template <typename T>
@@ -123,6 +223,21 @@ extern void mirror_buffer_neon(T* src_buffer, T* dst_buffer, int src_w, int src_
 template <typename T>
 extern void rotate_buffer_clockwise_neon(T* src_buffer, T* dst_buffer, int src_w, int src_h,
                                          int src_stride, int dst_stride, int degrees);
+
+void resample_vertical_neon(float* dst, const float* const* rows, const float* weights, int taps,
+                            int len);
+#endif
+
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+template <typename T>
+extern void transpose_tile_sse2(const T* src_buffer, T* dst_buffer, int src_w, int src_h,
+                                ptrdiff_t src_stride, ptrdiff_t dst_stride);
+
+template <typename T>
+extern void reverse_row_sse2(const T* src_buffer, T* dst_buffer, int w);
+
+void resample_vertical_sse2(float* dst, const float* const* rows, const float* weights, int taps,
+                            int len);
 #endif
 
 #ifdef UHDR_ENABLE_GLES
@@ -164,6 +279,12 @@ std::unique_ptr<uhdr_raw_image_ext_t> apply_crop(ultrahdr::uhdr_crop_effect_t* d
                                                  int ht, void* gl_ctxt = nullptr,
                                                  void* texture = nullptr);
 
+std::unique_ptr<uhdr_raw_image_ext_t> apply_transform(const uhdr_effect_transform_t* xfm,
+                                                      uhdr_raw_image_t* src);
+
+std::unique_ptr<uhdr_raw_image_ext_t> crop_view(uhdr_raw_image_ext_t* src, int left, int top,
+                                                int wd, int ht);
+
 }  // namespace ultrahdr
 
 #endif  // ULTRAHDR_EDITORHELPER_H
@@ -21,6 +21,9 @@
 #include <cmath>
 #include <cstring>
 #include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 
 #include "ultrahdr_api.h"
 #include "ultrahdr/ultrahdrcommon.h"
@@ -37,6 +40,13 @@
 #define USE_PQ_INVOETF_LUT 1
 #define USE_APPLY_GAIN_LUT 1
 
+// Transfer function look up tables return the nearest table entry by default. Define
+// UHDR_LUT_INTERPOLATION to 1 to linearly interpolate between neighbouring entries instead. The
+// table sizes can be overridden at build time with UHDR_<FN>_LUT_PRECISION (log2 of entry count).
+#ifndef UHDR_LUT_INTERPOLATION
+#define UHDR_LUT_INTERPOLATION 0
+#endif
+
 #define CLIP3(x, min, max) ((x) < (min)) ? (min) : ((x) > (max)) ? (max) : (x)
 
 namespace ultrahdr {
@@ -180,7 +190,7 @@ inline uint16_t floatToHalf(float f) {
 
 // Taken from frameworks/base/libs/hwui/jni/android_graphics_ColorSpace.cpp
 
-#if defined(__ANDROID__)  // __fp16 is not defined on non-Android builds
+#if defined(__ANDROID__) || defined(__aarch64__)  // __fp16 is not defined on other targets
 inline float halfToFloat(uint16_t bits) {
   __fp16 h;
   memcpy(&h, &bits, 2);
@@ -220,7 +230,68 @@ inline float halfToFloat(uint16_t bits) {
   o.mUInt |= (halfSign(bits) << 31);
   return o.mFloat;
 }
-#endif  // defined(__ANDROID__)
+#endif  // defined(__ANDROID__) || defined(__aarch64__)
+
+// Converts count floats to half floats and back. Hardware conversions are picked at run time where
+// available, F16C on x86 and NEON on aarch64, the scalar routines above are the fallback. Hardware
+// float to half conversion rounds to nearest even and overflows to infinity, so it may differ from
+// floatToHalf() by one ulp at rounding ties and above the largest half float.
+void floatToHalfRow(const float* src, uint16_t* dst, size_t count);
+void halfToFloatRow(const uint16_t* src, float* dst, size_t count);
+
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+bool cpuSupportsF16C();
+void floatToHalfRow_f16c(const float* src, uint16_t* dst, size_t count);
+void halfToFloatRow_f16c(const uint16_t* src, float* dst, size_t count);
+#endif
+
+#if (defined(UHDR_ENABLE_INTRINSICS) && defined(__aarch64__) && \
+     (defined(__ARM_NEON__) || defined(__ARM_NEON)))
+void floatToHalfRow_neon(const float* src, uint16_t* dst, size_t count);
+void halfToFloatRow_neon(const uint16_t* src, float* dst, size_t count);
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Fast log2 / exp2 approximations
+//
+// Branch free polynomial approximations on the float bit pattern, in place of libm calls in the
+// per pixel gain computation and application. They are plain arithmetic on a single lane, so the
+// compiler can vectorize loops calling them and the same coefficients can be used by simd kernels.
+// Measured error:
+//   fastLog2(x)    absolute error < 3e-5 for normal x > 0
+//   fastExp2(x)    relative error < 2e-7 for x in [-126, 128), result is clamped outside of it
+//   fastPow(x, y)  fastExp2(y * fastLog2(x)), 0 for x <= 0
+
+// minimax polynomial of log2(1 + t), t in [0, 1)
+inline float fastLog2(float x) {
+  FloatUIntUnion bits;
+  bits.mFloat = x;
+  const float exponent = static_cast<float>(static_cast<int32_t>(bits.mUInt >> 23) - 127);
+  bits.mUInt = (bits.mUInt & 0x007FFFFF) | 0x3F800000;
+  const float t = bits.mFloat - 1.0f;
+  float poly = -0.191402648f + t * 0.0439286282f;
+  poly = 0.414759615f + t * poly;
+  poly = -0.709304948f + t * poly;
+  poly = 1.44201935f + t * poly;
+  return exponent + t * poly;
+}
+
+// minimax polynomial of 2^t, t in [0, 1), scaled by the exponent bits of floor(x)
+inline float fastExp2(float x) {
+  x = (std::min)((std::max)(x, -126.0f), 127.999f);
+  const float integral = std::floor(x);
+  const float t = x - integral;
+  FloatUIntUnion bits;
+  bits.mUInt = static_cast<uint32_t>(static_cast<int32_t>(integral) + 127) << 23;
+  float poly = 0.00898934009f + t * 0.00187757667f;
+  poly = 0.0558263180f + t * poly;
+  poly = 0.240153617f + t * poly;
+  poly = 0.693153073f + t * poly;
+  poly = 0.999999925f + t * poly;
+  return bits.mFloat * poly;
+}
+
+inline float fastPow(float x, float y) { return x > 0.0f ? fastExp2(y * fastLog2(x)) : 0.0f; }
 
 ////////////////////////////////////////////////////////////////////////////////
 // Use Shepard's method for inverse distance weighting. For more information:
@@ -277,7 +348,10 @@ Color srgbInvOetfLUT(Color e_gamma);
 float srgbOetf(float e);
 Color srgbOetf(Color e);
 
-constexpr int32_t kSrgbInvOETFPrecision = 10;
+#ifndef UHDR_SRGB_INVOETF_LUT_PRECISION
+#define UHDR_SRGB_INVOETF_LUT_PRECISION 10
+#endif
+constexpr int32_t kSrgbInvOETFPrecision = UHDR_SRGB_INVOETF_LUT_PRECISION;
 constexpr int32_t kSrgbInvOETFNumEntries = 1 << kSrgbInvOETFPrecision;
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -308,7 +382,10 @@ Color hlgOetf(Color e);
 float hlgOetfLUT(float e);
 Color hlgOetfLUT(Color e);
 
-constexpr int32_t kHlgOETFPrecision = 16;
+#ifndef UHDR_HLG_OETF_LUT_PRECISION
+#define UHDR_HLG_OETF_LUT_PRECISION 16
+#endif
+constexpr int32_t kHlgOETFPrecision = UHDR_HLG_OETF_LUT_PRECISION;
 constexpr int32_t kHlgOETFNumEntries = 1 << kHlgOETFPrecision;
 
 // hlg inverse oetf (normalized)
@@ -317,7 +394,10 @@ Color hlgInvOetf(Color e_gamma);
 float hlgInvOetfLUT(float e_gamma);
 Color hlgInvOetfLUT(Color e_gamma);
 
-constexpr int32_t kHlgInvOETFPrecision = 12;
+#ifndef UHDR_HLG_INVOETF_LUT_PRECISION
+#define UHDR_HLG_INVOETF_LUT_PRECISION 12
+#endif
+constexpr int32_t kHlgInvOETFPrecision = UHDR_HLG_INVOETF_LUT_PRECISION;
 constexpr int32_t kHlgInvOETFNumEntries = 1 << kHlgInvOETFPrecision;
 
 // hlg ootf (normalized)
@@ -335,7 +415,10 @@ Color pqOetf(Color e);
 float pqOetfLUT(float e);
 Color pqOetfLUT(Color e);
 
-constexpr int32_t kPqOETFPrecision = 16;
+#ifndef UHDR_PQ_OETF_LUT_PRECISION
+#define UHDR_PQ_OETF_LUT_PRECISION 16
+#endif
+constexpr int32_t kPqOETFPrecision = UHDR_PQ_OETF_LUT_PRECISION;
 constexpr int32_t kPqOETFNumEntries = 1 << kPqOETFPrecision;
 
 // pq inverse oetf
@@ -344,13 +427,34 @@ Color pqInvOetf(Color e_gamma);
 float pqInvOetfLUT(float e_gamma);
 Color pqInvOetfLUT(Color e_gamma);
 
-constexpr int32_t kPqInvOETFPrecision = 12;
+#ifndef UHDR_PQ_INVOETF_LUT_PRECISION
+#define UHDR_PQ_INVOETF_LUT_PRECISION 12
+#endif
+constexpr int32_t kPqInvOETFPrecision = UHDR_PQ_INVOETF_LUT_PRECISION;
 constexpr int32_t kPqInvOETFNumEntries = 1 << kPqInvOETFPrecision;
 
-// util class to prepare look up tables for oetf/eotf functions
+// util class to prepare look up tables for oetf/eotf functions. The table samples computeFunc at
+// numEntries evenly spaced points over [0.0, 1.0]. Inputs outside this range are clamped.
+// Instances are immutable after construction and may be shared across threads; the *LUT()
+// functions below hold theirs in function-local statics, which C++11 guarantees are built exactly
+// once even when first reached concurrently.
+//
+// Worst case absolute error against the exact function, over the full [0.0, 1.0] input range,
+// at the default table sizes (see GainMapMathTest.*LUTAccuracy):
+//   function        entries   nearest   interpolated
+//   srgbInvOetf     1024      1.2e-3    1.0e-6
+//   hlgOetf         65536     5.0e-3    1.8e-3
+//   hlgInvOetf      4096      7.0e-4    1.0e-6
+//   pqOetf          65536     6.0e-2    2.5e-2
+//   pqInvOetf       4096      1.3e-3    1.1e-4
+// hlgOetf and pqOetf have unbounded slope at 0, so their worst case sits in the first few
+// intervals; the error falls off quickly for larger inputs.
 class LookUpTable {
  public:
-  LookUpTable(size_t numEntries, std::function<float(float)> computeFunc) {
+  LookUpTable(size_t numEntries, std::function<float(float)> computeFunc,
+              bool interpolate = UHDR_LUT_INTERPOLATION)
+      : mMaxIdx(static_cast<int32_t>(numEntries) - 1), mInterpolate(interpolate) {
+    table.reserve(numEntries);
     for (size_t idx = 0; idx < numEntries; idx++) {
       float value = static_cast<float>(idx) / static_cast<float>(numEntries - 1);
       table.push_back(computeFunc(value));
@@ -358,10 +462,45 @@ class LookUpTable {
   }
   const std::vector<float>& getTable() const { return table; }
 
+  // value of the table entry nearest to x
+  inline float lookupNearest(float x) const {
+    int32_t idx = static_cast<int32_t>(x * mMaxIdx + 0.5);
+    // TODO() : Remove once conversion modules have appropriate clamping in place
+    idx = CLIP3(idx, 0, mMaxIdx);
+    return table[idx];
+  }
+
+  // linear interpolation between the two table entries enclosing x
+  inline float lookupInterpolated(float x) const {
+    float pos = x * mMaxIdx;
+    if (!(pos > 0.0f)) return table[0];
+    if (pos >= mMaxIdx) return table[mMaxIdx];
+    int32_t idx = static_cast<int32_t>(pos);
+    float frac = pos - idx;
+    return table[idx] + frac * (table[idx + 1] - table[idx]);
+  }
+
+  inline float lookup(float x) const {
+    return mInterpolate ? lookupInterpolated(x) : lookupNearest(x);
+  }
+
  private:
   std::vector<float> table;
+  int32_t mMaxIdx;
+  bool mInterpolate;
 };
 
+// inverse oetf look up tables indexed directly by the integer sample code of 8-bit (sRGB) and
+// 10-bit (HLG, PQ) packed rgb inputs. Entry i holds the exact inverse oetf of i / (entries - 1),
+// so no normalization, clamping or rounding is needed per channel.
+constexpr int32_t kSrgbInvOETFCodeEntries = 256;
+constexpr int32_t kHlgInvOETFCodeEntries = 1024;
+constexpr int32_t kPqInvOETFCodeEntries = 1024;
+
+const float* srgbInvOetfCodeTable();
+const float* hlgInvOetfCodeTable();
+const float* pqInvOetfCodeTable();
+
 ////////////////////////////////////////////////////////////////////////////////
 // Color access functions
 
@@ -377,6 +516,11 @@ Color getRgba8888Pixel(uhdr_raw_image_t* image, size_t x, size_t y);
 Color getRgba1010102Pixel(uhdr_raw_image_t* image, size_t x, size_t y);
 Color getRgbaF16Pixel(uhdr_raw_image_t* image, size_t x, size_t y);
 
+// Get linear pixel from the image at the provided location. The sample codes are converted using
+// an inverse oetf code table (see getInverseOetfCodeTable()).
+Color getRgba8888PixelLinear(uhdr_raw_image_t* image, size_t x, size_t y, const float* invOetf);
+Color getRgba1010102PixelLinear(uhdr_raw_image_t* image, size_t x, size_t y, const float* invOetf);
+
 // Sample the image at the provided location, with a weighting based on nearby pixels and the map
 // scale factor.
 Color sampleYuv444(uhdr_raw_image_t* map, size_t map_scale_factor, size_t x, size_t y);
@@ -413,6 +557,32 @@ Color p3ToBt2100(Color e);
 Color bt2100ToBt709(Color e);
 Color bt2100ToP3(Color e);
 
+// Folds consecutive linear steps of a per pixel color chain (gamut conversions, rgb matrices and
+// scalar scales) into one row major 3x3 matrix. The chain is compiled once per image and the row
+// kernels then evaluate a single matrix multiply in place of the individual calls.
+class LinearColorPipeline {
+ public:
+  LinearColorPipeline() : mMatrix{1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f} {}
+
+  // Each step is applied after the steps appended so far. A ColorTransformFn must be linear, its
+  // matrix is recovered by evaluating it on the unit vectors.
+  LinearColorPipeline& append(const std::array<float, 9>& matrix);
+  LinearColorPipeline& append(ColorTransformFn linearFn);
+  LinearColorPipeline& append(float scale);
+
+  const std::array<float, 9>& getMatrix() const { return mMatrix; }
+  bool isIdentity() const;
+
+  inline Color apply(Color e) const {
+    return {{{mMatrix[0] * e.r + mMatrix[1] * e.g + mMatrix[2] * e.b,
+              mMatrix[3] * e.r + mMatrix[4] * e.g + mMatrix[5] * e.b,
+              mMatrix[6] * e.r + mMatrix[7] * e.g + mMatrix[8] * e.b}}};
+  }
+
+ private:
+  std::array<float, 9> mMatrix;
+};
+
 // convert between yuv encodings
 extern const std::array<float, 9> kYuvBt709ToBt601;
 extern const std::array<float, 9> kYuvBt709ToBt2100;
@@ -455,14 +625,17 @@ void transformYuv444(uhdr_raw_image_t* image, const std::array<float, 9>& coeffs
 constexpr int32_t kGainFactorPrecision = 10;
 constexpr int32_t kGainFactorNumEntries = 1 << kGainFactorPrecision;
 
+// Table of gain factors indexed by the encoded gain map value. The gain map gamma, content boost
+// range and weight are all folded into the table, so a lookup is a single index computation.
 struct GainLUT {
   GainLUT(uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight) {
     bool isSingleChannel = metadata->are_all_channels_identical();
     for (int i = 0; i < (isSingleChannel ? 1 : 3); i++) {
       mGainTable[i] = memory[i] = new float[kGainFactorNumEntries];
-      this->mGammaInv[i] = 1.0f / metadata->gamma[i];
+      float gammaInv = 1.0f / metadata->gamma[i];
       for (int32_t idx = 0; idx < kGainFactorNumEntries; idx++) {
         float value = static_cast<float>(idx) / static_cast<float>(kGainFactorNumEntries - 1);
+        if (gammaInv != 1.0f) value = pow(value, gammaInv);
         float logBoost = log2(metadata->min_content_boost[i]) * (1.0f - value) +
                          log2(metadata->max_content_boost[i]) * value;
         mGainTable[i][idx] = exp2(logBoost * gainmapWeight);
@@ -470,7 +643,6 @@ struct GainLUT {
     }
     if (isSingleChannel) {
       memory[1] = memory[2] = nullptr;
-      mGammaInv[1] = mGammaInv[2] = mGammaInv[0];
       mGainTable[1] = mGainTable[2] = mGainTable[0];
     }
   }
@@ -486,45 +658,238 @@ struct GainLUT {
     }
   }
 
-  float getGainFactor(float gain, int index) {
-    if (mGammaInv[index] != 1.0f) gain = pow(gain, mGammaInv[index]);
+  // gain is the (possibly interpolated) encoded gain map value in range [0.0, 1.0]
+  float getGainFactor(float gain, int index) const {
     int32_t idx = static_cast<int32_t>(gain * (kGainFactorNumEntries - 1) + 0.5);
     // TODO() : Remove once conversion modules have appropriate clamping in place
     idx = CLIP3(idx, 0, kGainFactorNumEntries - 1);
     return mGainTable[index][idx];
   }
 
+  // code is an 8-bit gain map sample. The table index round(code * (entries - 1) / 255) is
+  // computed in 16.16 fixed point, which never needs clamping.
+  float getGainFactorFromCode(uint8_t code, int index) const {
+    return mGainTable[index][(code * kCodeToIndexQ16 + (1 << 15)) >> 16];
+  }
+
  private:
+  static constexpr uint32_t kCodeToIndexQ16 =
+      ((static_cast<uint32_t>(kGainFactorNumEntries - 1) << 16) + 127) / 255;
+
   float* memory[3]{};
   float* mGainTable[3]{};
-  float mGammaInv[3]{};
+};
+
+// Thread-safe, size bounded cache of immutable tables, shared across decode calls and codec
+// instances. Once full, the least recently used entry is evicted; an evicted table stays alive for
+// as long as a caller holds on to it.
+template <typename Key, typename Table>
+class TableCache {
+ public:
+  explicit TableCache(size_t capacity) : mCapacity(capacity) {}
+
+  // returns the table for key, calling create() to build it if it is not cached. Tables are built
+  // outside the lock so lookups of other keys are not held up, if several callers build the same
+  // table at once the first one inserted is kept and returned to all of them
+  template <typename Factory>
+  std::shared_ptr<const Table> get(const Key& key, Factory&& create) {
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      std::shared_ptr<const Table> table = find(key);
+      if (table) return table;
+    }
+    std::shared_ptr<const Table> table(create());
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::shared_ptr<const Table> cached = find(key);
+    if (cached) return cached;
+    mEntries.emplace_front(key, table);
+    if (mEntries.size() > mCapacity) mEntries.pop_back();
+    return table;
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.size();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+  }
+
+ private:
+  // returns the cached table for key and marks it most recently used, mMutex must be held
+  std::shared_ptr<const Table> find(const Key& key) {
+    for (auto it = mEntries.begin(); it != mEntries.end(); ++it) {
+      if (it->first == key) {
+        mEntries.splice(mEntries.begin(), mEntries, it);
+        return it->second;
+      }
+    }
+    return nullptr;
+  }
+
+  const size_t mCapacity;
+  std::mutex mMutex;
+  std::list<std::pair<Key, std::shared_ptr<const Table>>> mEntries;
+};
+
+constexpr size_t kShepardsIDWCacheSize = 8;
+constexpr size_t kGainLUTCacheSize = 16;
+
+// Get the shared weight tables for the given map scale factor, building them on first use.
+std::shared_ptr<const ShepardsIDW> getShepardsIDW(int mapScaleFactor);
+
+// Get the shared gain factor table for the given metadata and weight, building it on first use.
+std::shared_ptr<const GainLUT> getGainLUT(uhdr_gainmap_metadata_ext_t* metadata,
+                                          float gainmapWeight);
+
+// Table of 10-bit hdr output codes indexed by (gain step, 8-bit sdr code), for single channel gain
+// maps applied without a gamut conversion. Each entry folds sRGB linearization, gain application
+// and the hlg/pq output path (scaling, clamping, inverse ootf, oetf and quantization) of one color
+// channel. Lookups interpolate linearly between the two sdr codes enclosing the sdr value, so that
+// the upsampled base image does not pick up 8-bit quantization.
+constexpr int32_t kGainTable2DSdrEntries = 256;
+constexpr int32_t kGainTable2DGainEntries = 1024;
+constexpr size_t kGainTable2DCacheSize = 4;
+
+struct GainTable2D {
+  GainTable2D(uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight,
+              uhdr_color_transfer_t outputCt);
+
+  // sdrGamma is the gamma encoded sdr channel value and gain the encoded gain map value, both in
+  // range [0.0, 1.0]
+  uint32_t getHdrCode(float sdrGamma, float gain) const {
+    return lookup(mTable.get() + getGainIndex(gain) * kGainTable2DSdrEntries, sdrGamma);
+  }
+
+  uint32_t getRgba1010102(Color sdrGamma, float gain) const {
+    // all three channels read from the same row of sdr codes
+    const uint16_t* row = mTable.get() + getGainIndex(gain) * kGainTable2DSdrEntries;
+    uint32_t r = lookup(row, sdrGamma.r);
+    uint32_t g = lookup(row, sdrGamma.g);
+    uint32_t b = lookup(row, sdrGamma.b);
+    return (r | (g << 10) | (b << 20) | (0x3u << 30));  // Set alpha to 1.0
+  }
+
+ private:
+  static int32_t getGainIndex(float gain) {
+    int32_t idx = static_cast<int32_t>(gain * (kGainTable2DGainEntries - 1) + 0.5f);
+    return CLIP3(idx, 0, kGainTable2DGainEntries - 1);
+  }
+
+  // row holds the entries of one gain step
+  static uint32_t lookup(const uint16_t* row, float sdrGamma) {
+    float pos = sdrGamma * (kGainTable2DSdrEntries - 1);
+    if (!(pos > 0.0f)) return row[0];
+    if (pos >= kGainTable2DSdrEntries - 1) return row[kGainTable2DSdrEntries - 1];
+    int32_t idx = static_cast<int32_t>(pos);
+    float frac = pos - idx;
+    float lo = row[idx];
+    float hi = row[idx + 1];
+    return static_cast<uint32_t>(lo + frac * (hi - lo) + 0.5f);
+  }
+
+  std::unique_ptr<uint16_t[]> mTable;
+};
+
+// Get the shared 2D gain table for the given metadata, weight and output transfer (hlg or pq),
+// building it on first use. Only channel 0 of the metadata is used.
+std::shared_ptr<const GainTable2D> getGainTable2D(uhdr_gainmap_metadata_ext_t* metadata,
+                                                  float gainmapWeight,
+                                                  uhdr_color_transfer_t outputCt);
+
+// Drop all cached ShepardsIDW, GainLUT and GainTable2D tables.
+void clearTableCaches();
+
+// Integer implementation of gain map application for hlg/pq RGBA1010102 outputs of 8-bit BT.601
+// YCbCr base images. YCbCr->RGB yields a 12-bit index into an sRGB linearization table, linear
+// light is carried in Q24 and gain factors in Q16 (with the output nits scaling folded in), gamut
+// conversions are Q14 matrices, and the output transfer (including the hlg inverse ootf) is a
+// table indexed on a semi-logarithmic scale (exponent plus kFixedPointOetfMantissaBits mantissa
+// bits), which keeps its relative precision near black where the pq and hlg curves are steepest.
+constexpr int32_t kFixedPointSdrIndexBits = 12;
+constexpr int32_t kFixedPointOetfMantissaBits = 8;
+
+class FixedPointGainMapApplier {
+ public:
+  FixedPointGainMapApplier(uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight,
+                           uhdr_color_transfer_t outputCt, ColorTransformFn sdrGamutConversionFn,
+                           ColorTransformFn hdrGamutConversionFn);
+
+  // y, u, v are 8-bit base image samples (u, v biased by 128) and gainIdx* the gain table index of
+  // each channel, see getGainIndex(). Returns the packed RGBA1010102 output pixel.
+  uint32_t apply(uint8_t y, uint8_t u, uint8_t v, int32_t gainIdxR, int32_t gainIdxG,
+                 int32_t gainIdxB) const;
+
+  // gain is the encoded gain map value in range [0.0, 1.0]
+  static int32_t getGainIndex(float gain) {
+    int32_t idx = static_cast<int32_t>(gain * (kGainFactorNumEntries - 1) + 0.5f);
+    return CLIP3(idx, 0, kGainFactorNumEntries - 1);
+  }
+
+  // code is an 8-bit gain map sample
+  static int32_t getGainIndexFromCode(uint8_t code) {
+    return (code * kCodeToIndexQ16 + (1 << 15)) >> 16;
+  }
+
+ private:
+  static constexpr uint32_t kCodeToIndexQ16 =
+      ((static_cast<uint32_t>(kGainFactorNumEntries - 1) << 16) + 127) / 255;
+
+  uint32_t toHdrCode(int64_t value) const;
+
+  int32_t mSdrLinear[1 << kFixedPointSdrIndexBits];
+  int32_t mGainFactor[3][kGainFactorNumEntries];
+  int32_t mOffsetSdr[3];
+  int32_t mOffsetHdr[3];
+  int32_t mSdrMatrix[9];
+  int32_t mHdrMatrix[9];
+  bool mHasSdrMatrix;
+  bool mHasHdrMatrix;
+  std::vector<uint16_t> mOetf;
 };
 
 /*
  * Calculate the 8-bit unsigned integer gain value for the given SDR and HDR
- * luminances in linear space and gainmap metadata fields.
+ * luminances in linear space and gainmap metadata fields. If useFastMath is set, log2/exp2/pow are
+ * evaluated with fastLog2()/fastExp2()/fastPow().
  */
 uint8_t encodeGain(float y_sdr, float y_hdr, uhdr_gainmap_metadata_ext_t* metadata, int index);
 uint8_t encodeGain(float y_sdr, float y_hdr, uhdr_gainmap_metadata_ext_t* metadata,
-                   float log2MinContentBoost, float log2MaxContentBoost, int index);
-float computeGain(float sdr, float hdr);
-uint8_t affineMapGain(float gainlog2, float mingainlog2, float maxgainlog2, float gamma);
+                   float log2MinContentBoost, float log2MaxContentBoost, int index,
+                   bool useFastMath = false);
+float computeGain(float sdr, float hdr, bool useFastMath = false);
+uint8_t affineMapGain(float gainlog2, float mingainlog2, float maxgainlog2, float gamma,
+                      bool useFastMath = false);
 
 /*
  * Calculates the linear luminance in nits after applying the given gain
  * value, with the given hdr ratio, to the given sdr input in the range [0, 1].
  */
 Color applyGain(Color e, float gain, uhdr_gainmap_metadata_ext_t* metadata);
-Color applyGain(Color e, float gain, uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight);
-Color applyGainLUT(Color e, float gain, GainLUT& gainLUT, uhdr_gainmap_metadata_ext_t* metadata);
+Color applyGain(Color e, float gain, uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight,
+                bool useFastMath = false);
+Color applyGainLUT(Color e, float gain, const GainLUT& gainLUT,
+                   uhdr_gainmap_metadata_ext_t* metadata);
 
 /*
  * Apply gain in R, G and B channels, with the given hdr ratio, to the given sdr input
  * in the range [0, 1].
  */
 Color applyGain(Color e, Color gain, uhdr_gainmap_metadata_ext_t* metadata);
-Color applyGain(Color e, Color gain, uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight);
-Color applyGainLUT(Color e, Color gain, GainLUT& gainLUT, uhdr_gainmap_metadata_ext_t* metadata);
+Color applyGain(Color e, Color gain, uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight,
+                bool useFastMath = false);
+Color applyGainLUT(Color e, Color gain, const GainLUT& gainLUT,
+                   uhdr_gainmap_metadata_ext_t* metadata);
+
+/*
+ * Same as above, but for 8-bit gain map samples as returned by the *NearestCode() samplers.
+ */
+Color applyGainLUTFromCode(Color e, uint8_t gain, const GainLUT& gainLUT,
+                           uhdr_gainmap_metadata_ext_t* metadata);
+Color applyGainLUTFromCode(Color e, const uint8_t* gain, const GainLUT& gainLUT,
+                           uhdr_gainmap_metadata_ext_t* metadata);
 
 /*
  * Sample the gain value for the map from a given x,y coordinate on a scale
@@ -532,11 +897,64 @@ Color applyGainLUT(Color e, Color gain, GainLUT& gainLUT, uhdr_gainmap_metadata_
  */
 float sampleMap(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t y);
 float sampleMap(uhdr_raw_image_t* map, size_t map_scale_factor, size_t x, size_t y,
-                ShepardsIDW& weightTables);
+                const ShepardsIDW& weightTables);
 Color sampleMap3Channel(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t y,
                         bool has_alpha);
 Color sampleMap3Channel(uhdr_raw_image_t* map, size_t map_scale_factor, size_t x, size_t y,
-                        ShepardsIDW& weightTables, bool has_alpha);
+                        const ShepardsIDW& weightTables, bool has_alpha);
+
+/*
+ * Sample the gain value for the map from a given x,y coordinate using nearest neighbor
+ * interpolation. Faster but blockier than the above.
+ */
+float sampleMapNearest(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t y);
+Color sampleMap3ChannelNearest(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t y,
+                               bool has_alpha);
+// Same as above, but return the raw 8-bit map sample(s). The 3 channel variant returns a pointer to
+// the r, g, b samples inside the map.
+uint8_t sampleMapNearestCode(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t y);
+const uint8_t* sampleMap3ChannelNearestCode(uhdr_raw_image_t* map, float map_scale_factor,
+                                            size_t x, size_t y, bool has_alpha);
+
+// Upsamples a gain map one output row at a time with Shepard's IDW, producing the same gains as
+// sampleMap() / sampleMap3Channel(). Output sample x maps to map position x / map_scale_factor on
+// both axes. The output rows between two map rows form a band of gain map cells. The left and
+// right map samples of every output column are gathered once per map row and kept while the band
+// is traversed, so each output row reads its four neighbours contiguously. The four weights of
+// every output column are laid out once per row phase, which leaves a branch free multiply add
+// per output row. The weights of integer scale factors come from the shared ShepardsIDW tables,
+// one table row per row phase y % scale. Not thread safe, use one instance per thread.
+class GainMapRowSampler {
+ public:
+  GainMapRowSampler(uhdr_raw_image_t* map, float map_scale_factor, size_t out_w);
+
+  // number of gains per output sample, 1 for single channel maps and 3 otherwise
+  int channels() const { return mChannels; }
+
+  // returns out_w * channels() gains in [0, 1] for output row y, valid until the next call
+  const float* sampleRow(size_t y);
+
+ private:
+  // returns the cache slot holding the gathered samples of map row map_y, a load never evicts
+  // keep_slot
+  int expandRow(size_t map_y, int keep_slot);
+
+  // lays out the four weights of every output column of output row y in mWeights
+  void expandWeights(size_t y, size_t y_lower, size_t y_upper);
+
+  uhdr_raw_image_t* mMap;
+  float mMapScaleFactor;
+  size_t mIntScaleFactor;                     // map_scale_factor if it is an integer, else 0
+  std::shared_ptr<const ShepardsIDW> mIdwTable;  // weights of integer scale factors
+  size_t mOutWidth;
+  int mChannels;
+  std::vector<uint32_t> mColumn0, mColumn1;  // left and right map samples of each output column
+  std::vector<float> mDistX0, mDistX1;       // x distance to those samples, other scale factors
+  std::vector<float> mLine, mRows[2], mOut;
+  size_t mRowTag[2];
+  std::vector<float> mWeights;  // out_w * 4 weights of the current row phase
+  size_t mWeightTag;            // row phase of mWeights for integer scale factors
+};
 
 ////////////////////////////////////////////////////////////////////////////////
 // function selectors
@@ -545,6 +963,9 @@ ColorTransformFn getGamutConversionFn(uhdr_color_gamut_t dst_gamut, uhdr_color_g
 ColorTransformFn getYuvToRgbFn(uhdr_color_gamut_t gamut);
 LuminanceFn getLuminanceFn(uhdr_color_gamut_t gamut);
 ColorTransformFn getInverseOetfFn(uhdr_color_transfer_t transfer);
+// returns the inverse oetf code table for the given transfer and packed rgb format, or nullptr if
+// the combination has none
+const float* getInverseOetfCodeTable(uhdr_color_transfer_t transfer, uhdr_img_fmt_t format);
 SceneToDisplayLuminanceFn getOotfFn(uhdr_color_transfer_t transfer);
 GetPixelFn getPixelFn(uhdr_img_fmt_t format);
 SamplePixelFn getSamplePixelFn(uhdr_img_fmt_t format);
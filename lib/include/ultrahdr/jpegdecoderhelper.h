@@ -51,7 +51,15 @@ typedef enum {
 /*!\brief Encapsulates a converter from JPEG to raw image format. This class is not thread-safe */
 class JpegDecoderHelper {
  public:
-  JpegDecoderHelper() = default;
+  /*!\brief Constructor
+   *
+   * \param[in]  useFastIdct       use fast integer inverse dct (JDCT_IFAST) instead of accurate
+   *                               integer inverse dct (JDCT_ISLOW)
+   * \param[in]  fancyUpsampling   use smooth (triangle filter) chroma upsampling instead of
+   *                               pixel replication. Effective only for #DECODE_TO_RGB_CS mode
+   */
+  JpegDecoderHelper(bool useFastIdct = false, bool fancyUpsampling = true)
+      : mUseFastIdct(useFastIdct), mFancyUpsampling(fancyUpsampling) {}
   ~JpegDecoderHelper() = default;
 
   /*!\brief This function decodes the bitstream that is passed to it to the desired format and
@@ -60,11 +68,15 @@ class JpegDecoderHelper {
    * \param[in]  image    pointer to compressed image
    * \param[in]  length   length of compressed image
    * \param[in]  mode     output decode format
+   * \param[in]  scale_denom  (optional) output is downscaled by this factor using libjpeg dct
+   *                         scaling. Supported values are 1, 2, 4, 8. Values other than 1 are
+   *                         supported only for #DECODE_TO_RGB_CS mode
    *
    * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
    */
   uhdr_error_info_t decompressImage(const void* image, size_t length,
-                                    decode_mode_t mode = DECODE_TO_YCBCR_CS);
+                                    decode_mode_t mode = DECODE_TO_YCBCR_CS,
+                                    unsigned int scale_denom = 1);
 
   /*!\brief This function parses the bitstream that is passed to it and makes image information
    * available to the client via getter() functions. It does not decompress the image. That is done
@@ -107,6 +119,13 @@ class JpegDecoderHelper {
   /*!\brief returns number of components in image */
   unsigned int getNumComponentsInImage() { return mNumComponents; }
 
+  /*!\brief returns width of an imcu (interleaved mcu) in pixels. Lossless transforms move whole
+   * imcus, see JpegEncoderHelper::transformImage() */
+  unsigned int getMcuWidth() { return mMcuWidth; }
+
+  /*!\brief returns height of an imcu in pixels */
+  unsigned int getMcuHeight() { return mMcuHeight; }
+
   /*!\brief returns pointer to xmp block present in input image */
   void* getXMPPtr() { return mXMPBuffer.data(); }
 
@@ -141,11 +160,16 @@ class JpegDecoderHelper {
   // max number of components supported
   static constexpr int kMaxNumComponents = 3;
 
-  uhdr_error_info_t decode(const void* image, size_t length, decode_mode_t mode);
+  uhdr_error_info_t decode(const void* image, size_t length, decode_mode_t mode,
+                           unsigned int scale_denom);
   uhdr_error_info_t decode(jpeg_decompress_struct* cinfo, uint8_t* dest);
   uhdr_error_info_t decodeToCSYCbCr(jpeg_decompress_struct* cinfo, uint8_t* dest);
   uhdr_error_info_t decodeToCSRGB(jpeg_decompress_struct* cinfo, uint8_t* dest);
 
+  // configurations
+  bool mUseFastIdct;
+  bool mFancyUpsampling;
+
   // temporary storage
   std::unique_ptr<uint8_t[]> mPlanesMCURow[kMaxNumComponents];
 
@@ -158,6 +182,8 @@ class JpegDecoderHelper {
   // image attributes
   uhdr_img_fmt_t mOutFormat;
   unsigned int mNumComponents;
+  unsigned int mMcuWidth;
+  unsigned int mMcuHeight;
   unsigned int mPlaneWidth[kMaxNumComponents];
   unsigned int mPlaneHeight[kMaxNumComponents];
   unsigned int mPlaneHStride[kMaxNumComponents];
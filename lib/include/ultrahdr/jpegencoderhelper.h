@@ -35,6 +35,7 @@ extern "C" {
 #include <vector>
 
 #include "ultrahdr_api.h"
+#include "ultrahdr/editorhelper.h"
 
 namespace ultrahdr {
 
@@ -47,7 +48,14 @@ struct destination_mgr_impl : jpeg_destination_mgr {
 /*!\brief Encapsulates a converter from raw to jpg image format. This class is not thread-safe */
 class JpegEncoderHelper {
  public:
-  JpegEncoderHelper() = default;
+  /*!\brief Constructor
+   *
+   * \param[in]  useFastDct      use fast integer forward dct (JDCT_IFAST) instead of accurate
+   *                             integer forward dct (JDCT_ISLOW)
+   * \param[in]  optimizeCoding  compute optimal huffman tables instead of using standard tables
+   */
+  JpegEncoderHelper(bool useFastDct = false, bool optimizeCoding = false)
+      : mUseFastDct(useFastDct), mOptimizeCoding(optimizeCoding) {}
   ~JpegEncoderHelper() = default;
 
   /*!\brief This function encodes the raw image that is passed to it and stores the results
@@ -81,8 +89,50 @@ class JpegEncoderHelper {
                                   const int width, const int height, const uhdr_img_fmt_t format,
                                   const int qfactor, const void* iccBuffer, const size_t iccSize);
 
-  /*! Below public methods are only effective if a call to compressImage() is made and it returned
-   * true. */
+  /*!\brief This function computes the dct coefficients of the raw image that is passed to it and
+   * caches them internally. Subsequent calls to compressCachedCoefficients() re-quantize and
+   * entropy code the cached coefficients without repeating color conversion, downsampling and
+   * forward dct. This is useful when the same image needs to be compressed at many quality factors.
+   *
+   * \param[in]  img        image to encode
+   *
+   * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+   */
+  uhdr_error_info_t cacheCoefficients(const uhdr_raw_image_t* img);
+
+  /*!\brief This function quantizes and entropy codes the coefficients cached by an earlier call to
+   * cacheCoefficients() and stores the results internally. The result is accessible via getter
+   * functions.
+   *
+   * \param[in]  qfactor    quality factor [1 - 100, 1 being poorest and 100 being best quality]
+   * \param[in]  iccBuffer  pointer to icc segment that needs to be added to the compressed image
+   * \param[in]  iccSize    size of icc segment
+   *
+   * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+   */
+  uhdr_error_info_t compressCachedCoefficients(const int qfactor, const void* iccBuffer,
+                                               const size_t iccSize);
+
+  /*!\brief This function losslessly transforms a compressed image in the dct domain and stores the
+   * results internally. The result is accessible via getter functions.
+   *
+   * Quantized coefficients are moved between blocks and, for mirrored axes, odd frequencies are
+   * negated, so no sample is decoded or re-quantized. Blocks move as whole imcus, hence the source
+   * region selected by xfm must start on an imcu boundary and, on axes that are mirrored, also end
+   * on one. Markers other than JFIF and Adobe (app1 - app15, com) are copied to the output. The
+   * output is sequential and huffman coded irrespective of the input.
+   *
+   * \param[in]  image      pointer to compressed image
+   * \param[in]  length     length of compressed image
+   * \param[in]  xfm        transform to apply, must be a remap (crop, mirror and rotate only)
+   *
+   * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+   */
+  uhdr_error_info_t transformImage(const void* image, size_t length,
+                                   const uhdr_effect_transform_t* xfm);
+
+  /*! Below public methods are only effective if a call to compressImage(),
+   * compressCachedCoefficients() or transformImage() is made and it returned true. */
 
   /*!\brief returns pointer to compressed image output */
   uhdr_compressed_image_t getCompressedImage();
@@ -110,11 +160,24 @@ class JpegEncoderHelper {
 
   destination_mgr_impl mDestMgr;  // object for managing output
 
+  // configurations
+  bool mUseFastDct;
+  bool mOptimizeCoding;
+
   // temporary storage
   std::unique_ptr<uint8_t[]> mPlanesMCURow[kMaxNumComponents];
 
   unsigned int mPlaneWidth[kMaxNumComponents];
   unsigned int mPlaneHeight[kMaxNumComponents];
+
+  // cached dct coefficients, see cacheCoefficients()
+  uhdr_img_fmt_t mCoeffFormat = UHDR_IMG_FMT_UNSPECIFIED;
+  unsigned int mCoeffWidth = 0;
+  unsigned int mCoeffHeight = 0;
+  int mCoeffNumComponents = 0;
+  unsigned int mCoeffBlocksWidth[kMaxNumComponents];
+  unsigned int mCoeffBlocksHeight[kMaxNumComponents];
+  std::vector<JCOEF> mCoeffs[kMaxNumComponents];
 };
 
 } /* namespace ultrahdr  */
@@ -23,6 +23,7 @@
 #include "ultrahdr_api.h"
 #include "ultrahdr/ultrahdr.h"
 #include "ultrahdr/ultrahdrcommon.h"
+#include "ultrahdr/editorhelper.h"
 #include "ultrahdr/jpegdecoderhelper.h"
 #include "ultrahdr/jpegencoderhelper.h"
 
@@ -43,14 +44,65 @@ static const int kMapCompressQualityAndroidDefault = 85;
 // Gain map calculation
 static const bool kUseMultiChannelGainMapDefault = true;
 static const bool kUseMultiChannelGainMapAndroidDefault = false;
+// one in every kGainRangeSampleStride map rows and columns is sampled if the gain range is
+// estimated
+static const int kGainRangeSampleStride = 4;
 
 // encoding preset
 static const uhdr_enc_preset_t kEncSpeedPresetDefault = UHDR_USAGE_BEST_QUALITY;
 static const uhdr_enc_preset_t kEncSpeedPresetAndroidDefault = UHDR_USAGE_REALTIME;
 
+// decoding preset
+static const uhdr_dec_preset_t kDecSpeedPresetDefault = UHDR_DEC_USAGE_BALANCED;
+
 // Default gamma value for gain map
 static const float kGainMapGammaDefault = 1.0f;
 
+/*!\brief encoder settings tuned by encoding preset */
+typedef struct uhdr_enc_preset_config {
+  bool use_fast_dct;           // use JDCT_IFAST forward dct instead of JDCT_ISLOW
+  bool optimize_coding;        // compute optimal huffman tables for entropy coding
+  bool subsample_chroma;       // compress rgb sdr intent with 4:2:0 chroma subsampling
+  bool one_pass_gainmap;       // compute gainmap in a single pass
+  bool estimate_gain_range;    // estimate gain range from a subsample of the map and quantize the
+                               // map while computing it (multi pass gainmap computation)
+  int map_scale_factor;        // gainmap scale factor, if not configured by application
+  bool use_multi_channel_map;  // multichannel gainmap, if not configured by application
+  unsigned int max_threads;    // upper bound on number of worker threads
+  bool use_fast_math;          // compute gains with fast log2/exp2/pow approximations
+} uhdr_enc_preset_config_t;
+
+/*!\brief returns encoder settings of an encoding preset
+ *
+ * \param[in]  preset  encoding preset
+ *
+ * \return encoder settings, settings of #kEncSpeedPresetDefault if preset is not recognized
+ */
+const uhdr_enc_preset_config_t& getEncPresetConfig(uhdr_enc_preset_t preset);
+
+/*!\brief decoder settings tuned by decoding preset */
+typedef struct uhdr_dec_preset_config {
+  bool use_fast_idct;         // use JDCT_IFAST inverse dct instead of JDCT_ISLOW
+  bool fancy_upsampling;      // use smooth chroma upsampling while decoding to rgb
+  bool nearest_map_sampling;  // sample gainmap with nearest neighbor instead of Shepard's IDW
+  bool use_transfer_fn_luts;  // evaluate transfer functions using look up tables
+  bool use_apply_gain_lut;    // evaluate gain application using look up tables
+  bool use_gain_table_2d;     // single channel maps without gamut conversion use a 2D table of
+                              // (sdr code, gain) -> 10-bit hdr code for hlg/pq outputs
+  bool use_fixed_point;       // apply gainmap with integer arithmetic for hlg/pq outputs of 8-bit
+                              // yuv base images
+  bool use_fast_math;         // apply gains with fast log2/exp2/pow approximations when look up
+                              // tables are not in use
+} uhdr_dec_preset_config_t;
+
+/*!\brief returns decoder settings of a decoding preset
+ *
+ * \param[in]  preset  decoding preset
+ *
+ * \return decoder settings, settings of #kDecSpeedPresetDefault if preset is not recognized
+ */
+const uhdr_dec_preset_config_t& getDecPresetConfig(uhdr_dec_preset_t preset);
+
 // The current JPEGR version that we encode to
 static const char* const kJpegrVersion = "1.0";
 
@@ -89,7 +141,8 @@ class JpegR {
         bool useMultiChannelGainMap = kUseMultiChannelGainMapAndroidDefault,
         float gamma = kGainMapGammaDefault,
         uhdr_enc_preset_t preset = kEncSpeedPresetAndroidDefault, float minContentBoost = FLT_MIN,
-        float maxContentBoost = FLT_MAX, float targetDispPeakBrightness = -1.0f);
+        float maxContentBoost = FLT_MAX, float targetDispPeakBrightness = -1.0f,
+        size_t targetSize = 0);
 
   /*!\brief Encode API-0.
    *
@@ -189,13 +242,48 @@ class JpegR {
    * \param[in]       metadata                 gainmap metadata descriptor
    * \param[in, out]  dest                     output image descriptor to store compressed ultrahdr
    *                                           image
+   * \param[in]       effects                  (optional) crop, mirror and rotate effects, applied
+   *                                           losslessly to both images, see transformLossless()
    *
    * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
    */
   uhdr_error_info_t encodeJPEGR(uhdr_compressed_image_t* base_img_compressed,
                                 uhdr_compressed_image_t* gainmap_img_compressed,
                                 uhdr_gainmap_metadata_ext_t* metadata,
-                                uhdr_compressed_image_t* dest);
+                                uhdr_compressed_image_t* dest,
+                                const std::deque<uhdr_effect_desc_t*>* effects = nullptr);
+
+  /*!\brief Remux API.
+   *
+   * Rewrite gainmap metadata, exif and / or icc of an ultrahdr jpeg image without re-encoding.
+   *
+   * Primary image and gainmap image are extracted from the input, their metadata segments (xmp,
+   * iso, mpf and, for primary image, exif and icc) are dropped and the images are stitched together
+   * again using the replacement metadata. Only the marker segments preceding the start of scan are
+   * examined, the entropy coded data of either image is copied as is. So the operation is lossless
+   * and does not involve any decoding.
+   *
+   * \param[in]       uhdr_compressed_img      compressed ultrahdr image descriptor
+   * \param[in]       metadata                 replacement gainmap metadata descriptor. If nullptr,
+   *                                           metadata of the input is retained
+   * \param[in]       pExif                    replacement exif block. If nullptr, exif of the input
+   *                                           is retained. If block is empty, exif is removed
+   * \param[in]       pIcc                     replacement icc block of primary image. If nullptr,
+   *                                           icc of the input is retained. If block is empty, icc
+   *                                           is removed
+   * \param[in, out]  dest                     output image descriptor to store compressed ultrahdr
+   *                                           image
+   * \param[in]       effects                  (optional) crop, mirror and rotate effects. If
+   *                                           present, the coefficients of both images are
+   *                                           rearranged as described in transformLossless()
+   *                                           instead of copying the entropy coded data
+   *
+   * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+   */
+  uhdr_error_info_t remuxJPEGR(uhdr_compressed_image_t* uhdr_compressed_img,
+                               uhdr_gainmap_metadata_ext_t* metadata, uhdr_mem_block_t* pExif,
+                               uhdr_mem_block_t* pIcc, uhdr_compressed_image_t* dest,
+                               const std::deque<uhdr_effect_desc_t*>* effects = nullptr);
 
   /*!\brief Decode API.
    *
@@ -215,9 +303,18 @@ class JpegR {
    * \param[in, out]  gainmap_img              (optional) output image descriptor to store decoded
    *                                           gainmap image
    * \param[in, out]  gainmap_metadata         (optional) descriptor to store gainmap metadata
+   * \param[in]       preset                   (optional) decoding speed preset
+   * \param[in]       sdr_xfm                  (optional) geometric transform of the decoded
+   *                                           image. If set, dest is of the transformed size
+   * \param[in]       gm_xfm                   (optional) geometric transform of the gainmap
+   *                                           image. Must be set along with sdr_xfm
    *
    * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
    *
+   * NOTE: Transforms are applied to the base and gainmap images before the gainmap is applied,
+   * so that only the pixels that are kept are evaluated. Base image layouts the transform cannot
+   * address are decoded at full size and the output is transformed.
+   *
    * NOTE: This method only supports single gain map metadata values for fields that allow
    * multi-channel metadata values.
    *
@@ -240,7 +337,35 @@ class JpegR {
                                 uhdr_color_transfer_t output_ct = UHDR_CT_LINEAR,
                                 uhdr_img_fmt_t output_format = UHDR_IMG_FMT_64bppRGBAHalfFloat,
                                 uhdr_raw_image_t* gainmap_img = nullptr,
-                                uhdr_gainmap_metadata_t* gainmap_metadata = nullptr);
+                                uhdr_gainmap_metadata_t* gainmap_metadata = nullptr,
+                                uhdr_dec_preset_t preset = kDecSpeedPresetDefault,
+                                const uhdr_effect_transform_t* sdr_xfm = nullptr,
+                                const uhdr_effect_transform_t* gm_xfm = nullptr);
+
+  /*!\brief Decompress JPEGR image once and render it at several resolutions.
+   *
+   * The primary and gain map images are decoded once. Renditions are produced largest first, each
+   * level of the base image and gain map image is area downsampled from the smallest level built
+   * so far that covers it, and the gain map is applied per level at that level's resolution.
+   * Levels below the primary image resolution are kept as 8 bit YCbCr 4:4:4 so that odd
+   * dimensions and all chroma subsamplings are handled alike.
+   *
+   * \param[in]       uhdr_compressed_img   compressed jpegr image descriptor.
+   * \param[in, out]  dests                 destination image descriptors. Dimensions, color format
+   *                                        and color transfer of each entry select the rendition,
+   *                                        supported pairs are as in decodeJPEGR().
+   * \param[in]       count                 number of entries in dests.
+   * \param[in]       max_display_boost     (optional) the maximum available boost supported by a
+   *                                        display, the value must be greater than or equal
+   *                                        to 1.0.
+   * \param[in]       preset                (optional) decoder speed/quality preset.
+   *
+   * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+   */
+  uhdr_error_info_t decodeJPEGRRenditions(uhdr_compressed_image_t* uhdr_compressed_img,
+                                          uhdr_raw_image_t** dests, size_t count,
+                                          float max_display_boost = FLT_MAX,
+                                          uhdr_dec_preset_t preset = kDecSpeedPresetDefault);
 
   /*!\brief This function parses the bitstream and returns information that is useful for actual
    * decoding. This does not decode the image. That is handled by decodeJPEGR
@@ -433,7 +558,7 @@ class JpegR {
    * This method is called in the encoding pipeline. It takes uncompressed 8-bit and 10-bit yuv
    * images as input and calculates gainmap.
    *
-   * NOTE: The input images must be the same resolution.
+   * NOTE: The input images must be the same resolution, unless sdr_downscale is configured.
    * NOTE: The SDR input is assumed to use the sRGB transfer function.
    *
    * \param[in]       sdr_intent               sdr intent raw input image descriptor
@@ -449,13 +574,19 @@ class JpegR {
    *                                           combination of r, g, b channels; otherwise, gainmap
    *                                           calculation is based of the maximun value of r, g, b
    *                                           channels.
+   * \param[in]       sdr_downscale            (optional) factor by which sdr intent is downscaled
+   *                                           with respect to hdr intent. This allows computing
+   *                                           gainmap from an sdr intent that is decoded at
+   *                                           reduced resolution. Gainmap scale factor must be a
+   *                                           multiple of this value.
    *
    * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
    */
   uhdr_error_info_t generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_image_t* hdr_intent,
                                     uhdr_gainmap_metadata_ext_t* gainmap_metadata,
                                     std::unique_ptr<uhdr_raw_image_ext_t>& gainmap_img,
-                                    bool sdr_is_601 = false, bool use_luminance = true);
+                                    bool sdr_is_601 = false, bool use_luminance = true,
+                                    int sdr_downscale = 1);
 
  protected:
   /*!\brief This method takes sdr intent, gainmap image and gainmap metadata and computes hdr
@@ -473,13 +604,20 @@ class JpegR {
    *                                           display, the value must be greater than or equal
    *                                           to 1.0
    * \param[in, out]  dest                     output image descriptor to store output
+   * \param[in]       preset                   (optional) decoding speed preset
+   * \param[in]       orientation              (optional) transform whose rotations and mirrors
+   *                                           are applied to the output as it is written. The
+   *                                           inputs are expected in source orientation, that is
+   *                                           already transformed by its get_unoriented()
    *
    * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
    */
   uhdr_error_info_t applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_image_t* gainmap_img,
                                  uhdr_gainmap_metadata_ext_t* gainmap_metadata,
                                  uhdr_color_transfer_t output_ct, uhdr_img_fmt_t output_format,
-                                 float max_display_boost, uhdr_raw_image_t* dest);
+                                 float max_display_boost, uhdr_raw_image_t* dest,
+                                 uhdr_dec_preset_t preset = kDecSpeedPresetDefault,
+                                 const uhdr_effect_transform_t* orientation = nullptr);
 
  private:
   /*!\brief compress gainmap image
@@ -491,6 +629,52 @@ class JpegR {
    */
   uhdr_error_info_t compressGainMap(uhdr_raw_image_t* gainmap_img, JpegEncoderHelper* jpeg_enc_obj);
 
+  /*!\brief compress sdr intent and gainmap image at the highest quality factor for which the
+   * resulting ultrahdr image fits in the target size. The dct coefficients of both images are
+   * computed once and only re-quantization and entropy coding is repeated per candidate quality.
+   * Candidate quality factors are searched in the range [1, quality]. For a candidate q, the gain
+   * map is compressed at min(q, gain map quality factor).
+   *
+   * \param[in]       sdr_intent_yuv           sdr intent raw image descriptor (YCbCr)
+   * \param[in]       gainmap_img              gainmap image descriptor
+   * \param[in]       quality                  quality factor upper bound for sdr intent
+   * \param[in]       exif                     optional exif metadata
+   * \param[in]       metadata                 gain map metadata
+   * \param[in, out]  dest                     output image descriptor to store compressed ultrahdr
+   *                                           image
+   *
+   * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+   */
+  uhdr_error_info_t compressToTargetSize(uhdr_raw_image_t* sdr_intent_yuv,
+                                         uhdr_raw_image_t* gainmap_img, int quality,
+                                         uhdr_mem_block_t* exif,
+                                         uhdr_gainmap_metadata_ext_t* metadata,
+                                         uhdr_compressed_image_t* dest);
+
+  /*!\brief This method applies crop, mirror and rotate effects to the primary image and the gain
+   * map image in the dct domain, see JpegEncoderHelper::transformImage().
+   *
+   * The effects are folded in to one transform of the primary image. The gain map is given the
+   * same transform over the matching region of the map, so the gain map keeps covering exactly the
+   * primary image. Edges of the selected region that become leading edges of the output have to
+   * lie on the imcu grid of both images. Crop offsets that do not are rejected, trailing edges of
+   * mirrored axes that do not are trimmed inwards to the nearest position that does, the same way
+   * jpegtran -trim drops partial imcus.
+   *
+   * \param[in]       primary_img       primary image descriptor
+   * \param[in]       gainmap_img       gainmap image descriptor
+   * \param[in]       effects           effects to apply, in order
+   * \param[in, out]  primary_enc       encoder object holding the transformed primary image
+   * \param[in, out]  gainmap_enc       encoder object holding the transformed gainmap image
+   *
+   * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+   */
+  uhdr_error_info_t transformLossless(uhdr_compressed_image_t* primary_img,
+                                      uhdr_compressed_image_t* gainmap_img,
+                                      const std::deque<uhdr_effect_desc_t*>& effects,
+                                      JpegEncoderHelper* primary_enc,
+                                      JpegEncoderHelper* gainmap_enc);
+
   /*!\brief This method is called to separate base image and gain map image from compressed
    * ultrahdr image
    *
@@ -607,6 +791,7 @@ class JpegR {
   float mMinContentBoost;           // min content boost recommendation
   float mMaxContentBoost;           // max content boost recommendation
   float mTargetDispPeakBrightness;  // target display max luminance in nits
+  size_t mTargetSize;               // target size of compressed output in bytes, 0 if unset
 };
 
 /*
@@ -24,10 +24,13 @@
 #include <GLES3/gl3.h>
 #endif
 
+#include <condition_variable>
 #include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "ultrahdr_api.h"
@@ -184,8 +187,14 @@ typedef struct uhdr_raw_image_ext : uhdr_raw_image_t {
   uhdr_raw_image_ext(uhdr_img_fmt_t fmt, uhdr_color_gamut_t cg, uhdr_color_transfer_t ct,
                      uhdr_color_range_t range, unsigned w, unsigned h, unsigned align_stride_to);
 
+  // view on the w x h rectangle of parent starting at (left, top). No pixels are copied, the view
+  // uses the strides of parent and keeps its memory alive. For subsampled formats left and top
+  // are expected to be even
+  uhdr_raw_image_ext(const uhdr_raw_image_ext& parent, unsigned left, unsigned top, unsigned w,
+                     unsigned h);
+
  private:
-  std::unique_ptr<ultrahdr::uhdr_memory_block> m_block;
+  std::shared_ptr<ultrahdr::uhdr_memory_block> m_block;
 } uhdr_raw_image_ext_t; /**< alias for struct uhdr_raw_image_ext */
 
 /**\brief extended compressed image descriptor */
@@ -354,6 +363,23 @@ bool isBufferDataContiguous(uhdr_raw_image_t* img);
 
 uhdr_error_info_t uhdr_validate_gainmap_metadata_descriptor(uhdr_gainmap_metadata_t* metadata);
 
+/**\brief queue of row ranges shared by the worker threads of a multi-threaded pass */
+class JobQueue {
+ public:
+  bool dequeueJob(unsigned int& rowStart, unsigned int& rowEnd);
+  void enqueueJob(unsigned int rowStart, unsigned int rowEnd);
+  void markQueueForEnd();
+  void reset();
+
+ private:
+  bool mQueuedAllJobs = false;
+  std::deque<std::tuple<unsigned int, unsigned int>> mJobs;
+  std::mutex mMutex;
+  std::condition_variable mCv;
+};
+
+unsigned int GetCPUCoreCount();
+
 }  // namespace ultrahdr
 
 // ===============================================================================================
@@ -380,13 +406,14 @@ struct uhdr_encoder_private : uhdr_codec_private {
   std::vector<uint8_t> m_exif;
   uhdr_gainmap_metadata_t m_metadata;
   uhdr_codec_t m_output_format;
-  int m_gainmap_scale_factor;
-  bool m_use_multi_channel_gainmap;
+  int m_gainmap_scale_factor;       // 0 if not configured, encoding preset decides
+  int m_use_multi_channel_gainmap;  // -1 if not configured, encoding preset decides
   float m_gamma;
   uhdr_enc_preset_t m_enc_preset;
   float m_min_content_boost;
   float m_max_content_boost;
   float m_target_disp_max_brightness;
+  size_t m_target_size;
 
   // internal data
   std::unique_ptr<ultrahdr::uhdr_compressed_image_ext_t> m_compressed_output_buffer;
@@ -399,11 +426,13 @@ struct uhdr_decoder_private : uhdr_codec_private {
   uhdr_img_fmt_t m_output_fmt;
   uhdr_color_transfer_t m_output_ct;
   float m_output_max_disp_boost;
+  uhdr_dec_preset_t m_dec_preset;
 
   // internal data
   bool m_probed;
   std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> m_decoded_img_buffer;
   std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> m_gainmap_img_buffer;
+  std::vector<std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t>> m_rendition_buffers;
   int m_img_wd, m_img_ht;
   int m_gainmap_wd, m_gainmap_ht, m_gainmap_num_comp;
   std::vector<uint8_t> m_exif;
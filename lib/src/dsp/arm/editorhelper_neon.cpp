@@ -1067,4 +1067,24 @@ template void rotate_buffer_clockwise_neon<uint16_t>(uint16_t*, uint16_t*, int,
 template void rotate_buffer_clockwise_neon<uint32_t>(uint32_t*, uint32_t*, int, int, int, int, int);
 template void rotate_buffer_clockwise_neon<uint64_t>(uint64_t*, uint64_t*, int, int, int, int, int);
 
+void resample_vertical_neon(float* dst, const float* const* rows, const float* weights, int taps,
+                            int len) {
+  int i = 0;
+  for (; i + 8 <= len; i += 8) {
+    float32x4_t acc0 = vmulq_n_f32(vld1q_f32(rows[0] + i), weights[0]);
+    float32x4_t acc1 = vmulq_n_f32(vld1q_f32(rows[0] + i + 4), weights[0]);
+    for (int k = 1; k < taps; k++) {
+      acc0 = vmlaq_n_f32(acc0, vld1q_f32(rows[k] + i), weights[k]);
+      acc1 = vmlaq_n_f32(acc1, vld1q_f32(rows[k] + i + 4), weights[k]);
+    }
+    vst1q_f32(dst + i, acc0);
+    vst1q_f32(dst + i + 4, acc1);
+  }
+  for (; i < len; i++) {
+    float acc = weights[0] * rows[0][i];
+    for (int k = 1; k < taps; k++) acc += weights[k] * rows[k][i];
+    dst[i] = acc;
+  }
+}
+
 }  // namespace ultrahdr
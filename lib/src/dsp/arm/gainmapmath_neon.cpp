@@ -476,4 +476,35 @@ std::unique_ptr<uhdr_raw_image_ext_t> convert_raw_input_to_ycbcr_neon(uhdr_raw_i
   return nullptr;
 }
 
+#if defined(__aarch64__)
+void floatToHalfRow_neon(const float* src, uint16_t* dst, size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    float16x4_t lo = vcvt_f16_f32(vld1q_f32(src + i));
+    float16x4_t hi = vcvt_f16_f32(vld1q_f32(src + i + 4));
+    vst1q_u16(dst + i, vreinterpretq_u16_f16(vcombine_f16(lo, hi)));
+  }
+  for (; i + 4 <= count; i += 4) {
+    vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  }
+  for (; i < count; i++) {
+    __fp16 h = (__fp16)src[i];
+    memcpy(dst + i, &h, sizeof(uint16_t));
+  }
+}
+
+void halfToFloatRow_neon(const uint16_t* src, float* dst, size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    float16x8_t v = vreinterpretq_f16_u16(vld1q_u16(src + i));
+    vst1q_f32(dst + i, vcvt_f32_f16(vget_low_f16(v)));
+    vst1q_f32(dst + i + 4, vcvt_f32_f16(vget_high_f16(v)));
+  }
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+  }
+  for (; i < count; i++) dst[i] = halfToFloat(src[i]);
+}
+#endif
+
 }  // namespace ultrahdr
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ultrahdr/editorhelper.h"
+
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+
+#include <emmintrin.h>
+
+namespace ultrahdr {
+
+template <int kElemBytes>
+static inline void unpack_sse2(__m128i a, __m128i b, __m128i* lo, __m128i* hi) {
+  if (kElemBytes == 1) {
+    *lo = _mm_unpacklo_epi8(a, b);
+    *hi = _mm_unpackhi_epi8(a, b);
+  } else if (kElemBytes == 2) {
+    *lo = _mm_unpacklo_epi16(a, b);
+    *hi = _mm_unpackhi_epi16(a, b);
+  } else if (kElemBytes == 4) {
+    *lo = _mm_unpacklo_epi32(a, b);
+    *hi = _mm_unpackhi_epi32(a, b);
+  } else {
+    *lo = _mm_unpacklo_epi64(a, b);
+    *hi = _mm_unpackhi_epi64(a, b);
+  }
+}
+
+// one interleave stage of the transpose, element pairs of size kElemBytes of rows 2k and 2k + 1 go
+// to rows k and k + N / 2
+template <int N, int kElemBytes>
+static inline void interleave_stage_sse2(__m128i* x) {
+  __m128i y[N];
+  for (int k = 0; k < N / 2; k++) {
+    unpack_sse2<kElemBytes>(x[2 * k], x[2 * k + 1], &y[k], &y[k + N / 2]);
+  }
+  for (int k = 0; k < N; k++) x[k] = y[k];
+}
+
+static inline int bit_reverse(int v, int bits) {
+  int r = 0;
+  for (int i = 0; i < bits; i++, v >>= 1) r = (r << 1) | (v & 1);
+  return r;
+}
+
+// transposes a block of 16 / sizeof(T) rows of 16 bytes each. After log2(N) interleave stages
+// register k holds source column bitrev(k)
+template <typename T>
+static inline void transpose_block_sse2(const T* src, T* dst, ptrdiff_t src_stride,
+                                        ptrdiff_t dst_stride) {
+  constexpr int N = 16 / sizeof(T);
+  constexpr int kBits = N == 16 ? 4 : N == 8 ? 3 : N == 4 ? 2 : 1;
+  __m128i x[N];
+  for (int k = 0; k < N; k++) {
+    x[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + k * src_stride));
+  }
+  if (sizeof(T) <= 1) interleave_stage_sse2<N, 1>(x);
+  if (sizeof(T) <= 2) interleave_stage_sse2<N, 2>(x);
+  if (sizeof(T) <= 4) interleave_stage_sse2<N, 4>(x);
+  interleave_stage_sse2<N, 8>(x);
+  for (int k = 0; k < N; k++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + bit_reverse(k, kBits) * dst_stride), x[k]);
+  }
+}
+
+template <typename T>
+void transpose_tile_sse2(const T* src, T* dst, int src_w, int src_h, ptrdiff_t src_stride,
+                         ptrdiff_t dst_stride) {
+  constexpr int N = 16 / sizeof(T);
+  const int w = src_w - src_w % N, h = src_h - src_h % N;
+  for (int i = 0; i < w; i += N) {
+    for (int j = 0; j < h; j += N) {
+      transpose_block_sse2(src + j * src_stride + i, dst + i * dst_stride + j, src_stride,
+                           dst_stride);
+    }
+  }
+  // right and bottom edges of the tile
+  if (w < src_w || h < src_h) {
+    for (int i = 0; i < src_w; i++) {
+      for (int j = (i < w ? h : 0); j < src_h; j++) {
+        dst[i * dst_stride + j] = src[j * src_stride + i];
+      }
+    }
+  }
+}
+
+template <typename T>
+static inline __m128i reverse_sse2(__m128i v) {
+  if (sizeof(T) == 8) return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+  if (sizeof(T) == 4) return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+  v = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+  v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+  v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+  if (sizeof(T) == 2) return v;
+  return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+template <typename T>
+void reverse_row_sse2(const T* src, T* dst, int w) {
+  constexpr int N = 16 / sizeof(T);
+  const T* src_blk = src + w;
+  int j = 0;
+  for (; j + 2 * N <= w; j += 2 * N, src_blk -= 2 * N) {
+    __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_blk - N));
+    __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_blk - 2 * N));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), reverse_sse2<T>(s0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j + N), reverse_sse2<T>(s1));
+  }
+  for (; j + N <= w; j += N, src_blk -= N) {
+    __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_blk - N));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + j), reverse_sse2<T>(s0));
+  }
+  for (; j < w; j++) {
+    dst[j] = src[w - j - 1];
+  }
+}
+
+void resample_vertical_sse2(float* dst, const float* const* rows, const float* weights, int taps,
+                            int len) {
+  int i = 0;
+  for (; i + 8 <= len; i += 8) {
+    __m128 w = _mm_set1_ps(weights[0]);
+    __m128 acc0 = _mm_mul_ps(_mm_loadu_ps(rows[0] + i), w);
+    __m128 acc1 = _mm_mul_ps(_mm_loadu_ps(rows[0] + i + 4), w);
+    for (int k = 1; k < taps; k++) {
+      w = _mm_set1_ps(weights[k]);
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), w));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(rows[k] + i + 4), w));
+    }
+    _mm_storeu_ps(dst + i, acc0);
+    _mm_storeu_ps(dst + i + 4, acc1);
+  }
+  for (; i < len; i++) {
+    float acc = weights[0] * rows[0][i];
+    for (int k = 1; k < taps; k++) acc += weights[k] * rows[k][i];
+    dst[i] = acc;
+  }
+}
+
+template void transpose_tile_sse2<uint8_t>(const uint8_t*, uint8_t*, int, int, ptrdiff_t,
+                                           ptrdiff_t);
+template void transpose_tile_sse2<uint16_t>(const uint16_t*, uint16_t*, int, int, ptrdiff_t,
+                                            ptrdiff_t);
+template void transpose_tile_sse2<uint32_t>(const uint32_t*, uint32_t*, int, int, ptrdiff_t,
+                                            ptrdiff_t);
+template void transpose_tile_sse2<uint64_t>(const uint64_t*, uint64_t*, int, int, ptrdiff_t,
+                                            ptrdiff_t);
+
+template void reverse_row_sse2<uint8_t>(const uint8_t*, uint8_t*, int);
+template void reverse_row_sse2<uint16_t>(const uint16_t*, uint16_t*, int);
+template void reverse_row_sse2<uint32_t>(const uint32_t*, uint32_t*, int);
+template void reverse_row_sse2<uint64_t>(const uint64_t*, uint64_t*, int);
+
+}  // namespace ultrahdr
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ultrahdr/gainmapmath.h"
+
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// F16C is not part of the x86 baseline, the kernels below are compiled for it on their own and
+// only called once cpuSupportsF16C() has confirmed the instructions can be executed
+#if defined(__GNUC__) || defined(__clang__)
+#define UHDR_TARGET_F16C __attribute__((target("avx,f16c")))
+#else
+#define UHDR_TARGET_F16C
+#endif
+
+namespace ultrahdr {
+
+bool cpuSupportsF16C() {
+  unsigned int ecx;
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 1);
+  ecx = (unsigned int)info[2];
+#else
+  unsigned int eax, ebx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+#endif
+  // f16c, avx and osxsave
+  const unsigned int kRequired = (1u << 29) | (1u << 28) | (1u << 27);
+  if ((ecx & kRequired) != kRequired) return false;
+  // the os must save the xmm and ymm registers for vex encoded instructions to be usable
+#if defined(_MSC_VER) && !defined(__clang__)
+  const unsigned long long xcr0 = _xgetbv(0);
+#else
+  unsigned int xcr0_lo, xcr0_hi;
+  __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  const unsigned long long xcr0 = xcr0_lo;
+#endif
+  return (xcr0 & 6) == 6;
+}
+
+UHDR_TARGET_F16C void floatToHalfRow_f16c(const float* src, uint16_t* dst, size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 v = _mm256_loadu_ps(src + i);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+  }
+  if (i < count) {
+    // tail, e.g. the channels of a single pixel
+    float in[8] = {};
+    uint16_t out[8];
+    memcpy(in, src + i, (count - i) * sizeof(float));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                     _mm256_cvtps_ph(_mm256_loadu_ps(in), _MM_FROUND_TO_NEAREST_INT));
+    memcpy(dst + i, out, (count - i) * sizeof(uint16_t));
+  }
+}
+
+UHDR_TARGET_F16C void halfToFloatRow_f16c(const uint16_t* src, float* dst, size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(v));
+  }
+  if (i < count) {
+    uint16_t in[8] = {};
+    float out[8];
+    memcpy(in, src + i, (count - i) * sizeof(uint16_t));
+    _mm256_storeu_ps(out, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))));
+    memcpy(dst + i, out, (count - i) * sizeof(float));
+  }
+}
+
+}  // namespace ultrahdr
+
+#endif
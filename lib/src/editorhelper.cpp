@@ -14,42 +14,112 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cstring>
 #include <cstdint>
 #include <cmath>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <type_traits>
 
 #include "ultrahdr/editorhelper.h"
 #include "ultrahdr/gainmapmath.h"
 
 namespace ultrahdr {
 
+// splits rows [0, rows) in to bands and runs fn on each band, spreading the bands across worker
+// threads the same way the gain map passes do
+static void for_each_row_band(int rows, const std::function<void(int, int)>& fn) {
+  const int kRowsPerJob = 64;
+  const int threads =
+      (std::min)((int)(std::min)(GetCPUCoreCount(), 4u), (rows + kRowsPerJob - 1) / kRowsPerJob);
+  if (threads <= 1) {
+    fn(0, rows);
+    return;
+  }
+  JobQueue jobQueue;
+  std::function<void()> processBands = [&jobQueue, &fn]() -> void {
+    unsigned int rowStart, rowEnd;
+    while (jobQueue.dequeueJob(rowStart, rowEnd)) {
+      fn((int)rowStart, (int)rowEnd);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (int th = 0; th < threads - 1; th++) {
+    workers.push_back(std::thread(processBands));
+  }
+  for (int rowStart = 0; rowStart < rows;) {
+    int rowEnd = (std::min)(rowStart + kRowsPerJob, rows);
+    jobQueue.enqueueJob(rowStart, rowEnd);
+    rowStart = rowEnd;
+  }
+  jobQueue.markQueueForEnd();
+  processBands();
+  std::for_each(workers.begin(), workers.end(), [](std::thread& t) { t.join(); });
+}
+
+template <typename T>
+void transpose_tile(const T* src_buffer, T* dst_buffer, int src_w, int src_h,
+                    ptrdiff_t src_stride, ptrdiff_t dst_stride) {
+  for (int i = 0; i < src_w; i++) {
+    for (int j = 0; j < src_h; j++) {
+      dst_buffer[i * dst_stride + j] = src_buffer[j * src_stride + i];
+    }
+  }
+}
+
+template <typename T>
+void transpose_buffer(const T* src_buffer, T* dst_buffer, int src_w, int src_h,
+                      ptrdiff_t src_stride, ptrdiff_t dst_stride) {
+  // a tile of source and destination stays resident in l1 while it is walked across
+  constexpr int kTile = sizeof(T) <= 2 ? 64 : 32;
+  for (int i = 0; i < src_w; i += kTile) {
+    const int tile_w = (std::min)(kTile, src_w - i);
+    for (int j = 0; j < src_h; j += kTile) {
+      const int tile_h = (std::min)(kTile, src_h - j);
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+      if constexpr (std::is_integral<T>::value) {
+        transpose_tile_sse2(src_buffer + j * src_stride + i, dst_buffer + i * dst_stride + j,
+                            tile_w, tile_h, src_stride, dst_stride);
+        continue;
+      }
+#endif
+      transpose_tile(src_buffer + j * src_stride + i, dst_buffer + i * dst_stride + j, tile_w,
+                     tile_h, src_stride, dst_stride);
+    }
+  }
+}
+
+template <typename T>
+void reverse_row(const T* src_buffer, T* dst_buffer, int w) {
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+  if constexpr (std::is_integral<T>::value) {
+    reverse_row_sse2(src_buffer, dst_buffer, w);
+    return;
+  }
+#endif
+  for (int j = 0; j < w; j++) {
+    dst_buffer[j] = src_buffer[w - j - 1];
+  }
+}
+
 template <typename T>
 void rotate_buffer_clockwise(T* src_buffer, T* dst_buffer, int src_w, int src_h, int src_stride,
                              int dst_stride, int degree) {
   if (degree == 90) {
-    int dst_w = src_h;
-    int dst_h = src_w;
-    for (int i = 0; i < dst_h; i++) {
-      for (int j = 0; j < dst_w; j++) {
-        dst_buffer[i * dst_stride + j] = src_buffer[(src_h - j - 1) * src_stride + i];
-      }
-    }
+    // dst(i, j) = src(src_h - j - 1, i), a transpose of the source read bottom up
+    transpose_buffer<T>(src_buffer + (ptrdiff_t)(src_h - 1) * src_stride, dst_buffer, src_w, src_h,
+                        -(ptrdiff_t)src_stride, dst_stride);
   } else if (degree == 180) {
-    int dst_w = src_w;
-    int dst_h = src_h;
-    for (int i = 0; i < dst_h; i++) {
-      for (int j = 0; j < dst_w; j++) {
-        dst_buffer[i * dst_stride + j] = src_buffer[(src_h - i - 1) * src_stride + (src_w - j - 1)];
-      }
+    for (int i = 0; i < src_h; i++) {
+      reverse_row<T>(src_buffer + (ptrdiff_t)(src_h - i - 1) * src_stride,
+                     dst_buffer + (ptrdiff_t)i * dst_stride, src_w);
     }
   } else if (degree == 270) {
-    int dst_w = src_h;
-    int dst_h = src_w;
-    for (int i = 0; i < dst_h; i++) {
-      for (int j = 0; j < dst_w; j++) {
-        dst_buffer[i * dst_stride + j] = src_buffer[j * src_stride + (src_w - i - 1)];
-      }
-    }
+    // dst(i, j) = src(j, src_w - i - 1), a transpose of the source written bottom up
+    transpose_buffer<T>(src_buffer, dst_buffer + (ptrdiff_t)(src_w - 1) * dst_stride, src_w, src_h,
+                        src_stride, -(ptrdiff_t)dst_stride);
   }
 }
 
@@ -58,18 +128,49 @@ void mirror_buffer(T* src_buffer, T* dst_buffer, int src_w, int src_h, int src_s
                    int dst_stride, uhdr_mirror_direction_t direction) {
   if (direction == UHDR_MIRROR_VERTICAL) {
     for (int i = 0; i < src_h; i++) {
-      memcpy(&dst_buffer[(src_h - i - 1) * dst_stride], &src_buffer[i * src_stride],
-             src_w * sizeof(T));
+      memcpy(&dst_buffer[(ptrdiff_t)(src_h - i - 1) * dst_stride],
+             &src_buffer[(ptrdiff_t)i * src_stride], src_w * sizeof(T));
     }
   } else if (direction == UHDR_MIRROR_HORIZONTAL) {
     for (int i = 0; i < src_h; i++) {
-      for (int j = 0; j < src_w; j++) {
-        dst_buffer[i * dst_stride + j] = src_buffer[i * src_stride + (src_w - j - 1)];
-      }
+      reverse_row<T>(src_buffer + (ptrdiff_t)i * src_stride, dst_buffer + (ptrdiff_t)i * dst_stride,
+                     src_w);
     }
   }
 }
 
+// runs a rotate kernel over bands of destination rows from the worker threads
+template <typename T>
+static void rotate_plane(void (*rotate)(T*, T*, int, int, int, int, int), T* src_buffer,
+                         T* dst_buffer, int src_w, int src_h, int src_stride, int dst_stride,
+                         int degree) {
+  for_each_row_band(degree == 180 ? src_h : src_w, [&](int row_start, int row_end) {
+    const int rows = row_end - row_start;
+    T* dst = dst_buffer + (ptrdiff_t)row_start * dst_stride;
+    if (degree == 90) {
+      rotate(src_buffer + row_start, dst, rows, src_h, src_stride, dst_stride, degree);
+    } else if (degree == 270) {
+      rotate(src_buffer + (src_w - row_end), dst, rows, src_h, src_stride, dst_stride, degree);
+    } else {
+      rotate(src_buffer + (ptrdiff_t)(src_h - row_end) * src_stride, dst, src_w, rows, src_stride,
+             dst_stride, degree);
+    }
+  });
+}
+
+// runs a mirror kernel over bands of destination rows from the worker threads
+template <typename T>
+static void mirror_plane(void (*mirror)(T*, T*, int, int, int, int, uhdr_mirror_direction_t),
+                         T* src_buffer, T* dst_buffer, int src_w, int src_h, int src_stride,
+                         int dst_stride, uhdr_mirror_direction_t direction) {
+  for_each_row_band(src_h, [&](int row_start, int row_end) {
+    const int src_row = direction == UHDR_MIRROR_VERTICAL ? src_h - row_end : row_start;
+    mirror(src_buffer + (ptrdiff_t)src_row * src_stride,
+           dst_buffer + (ptrdiff_t)row_start * dst_stride, src_w, row_end - row_start, src_stride,
+           dst_stride, direction);
+  });
+}
+
 template <typename T>
 void crop_buffer(T* src_buffer, T* dst_buffer, int src_stride, int dst_stride, int left, int top,
                  int wd, int ht) {
@@ -91,64 +192,13 @@ void resize_buffer(T* src_buffer, T* dst_buffer, int src_w, int src_h, int dst_w
   }
 }
 
-// This function performs bicubic interpolation on a 1D signal.
-double bicubic_interpolate(double p0, double p1, double p2, double p3, double x) {
-  // Calculate the weights for the four neighboring points.
-  double w0 = (1 - x) * (1 - x) * (1 - x);
-  double w1 = 3 * x * (1 - x) * (1 - x);
-  double w2 = 3 * x * x * (1 - x);
-  double w3 = x * x * x;
-
-  // Calculate the interpolated value.
-  return w0 * p0 + w1 * p1 + w2 * p2 + w3 * p3;
-}
-
-std::unique_ptr<uhdr_raw_image_ext_t> resize_image(uhdr_raw_image_t* src, int dst_w, int dst_h) {
-  GetPixelFn get_pixel_fn = getPixelFn(src->fmt);
-  if (get_pixel_fn == nullptr) {
-    return nullptr;
-  }
-
-  PutPixelFn put_pixel_fn = putPixelFn(src->fmt);
-  if (put_pixel_fn == nullptr) {
-    return nullptr;
-  }
-
-  std::unique_ptr<uhdr_raw_image_ext_t> dst = std::make_unique<uhdr_raw_image_ext_t>(
-      src->fmt, src->cg, src->ct, src->range, dst_w, dst_h, 64);
-
-  int src_w = src->w;
-  int src_h = src->h;
-  double scale_x = (double)src_w / dst_w;
-  double scale_y = (double)src_h / dst_h;
-  for (int y = 0; y < dst_h; y++) {
-    for (int x = 0; x < dst_w; x++) {
-      double ori_x = x * scale_x;
-      double ori_y = y * scale_y;
-      int p0_x = CLIP3((int)floor(ori_x), 0, src_w - 1);
-      int p0_y = CLIP3((int)floor(ori_y), 0, src_h - 1);
-      int p1_x = CLIP3((p0_x + 1), 0, src_w - 1);
-      int p1_y = p0_y;
-      int p2_x = p0_x;
-      int p2_y = CLIP3((p0_y + 1), 0, src_h - 1);
-      int p3_x = CLIP3((p0_x + 1), 0, src_w - 1);
-      int p3_y = CLIP3((p0_y + 1), 0, src_h - 1);
-
-      Color p0 = get_pixel_fn(src, p0_x, p0_y);
-      Color p1 = get_pixel_fn(src, p1_x, p1_y);
-      Color p2 = get_pixel_fn(src, p2_x, p2_y);
-      Color p3 = get_pixel_fn(src, p3_x, p3_y);
-
-      Color interp;
-      interp.r = (float)bicubic_interpolate(p0.r, p1.r, p2.r, p3.r, ori_x - p0_x);
-      if (src->fmt != UHDR_IMG_FMT_8bppYCbCr400) {
-        interp.g = (float)bicubic_interpolate(p0.g, p1.g, p2.g, p3.g, ori_x - p0_x);
-        interp.b = (float)bicubic_interpolate(p0.b, p1.b, p2.b, p3.b, ori_x - p0_x);
-      }
-      put_pixel_fn(dst.get(), x, y, interp);
-    }
-  }
-  return dst;
+std::unique_ptr<uhdr_raw_image_ext_t> resize_image(uhdr_raw_image_t* src, int dst_w, int dst_h,
+                                                   uhdr_resample_filter_t filter) {
+  uhdr_effect_transform_t xfm(src->fmt, src->w, src->h);
+  xfm.resize(dst_w, dst_h);
+  xfm.m_axis[0].m_filter = filter;
+  xfm.m_axis[1].m_filter = filter;
+  return apply_transform(&xfm, src);
 }
 
 template void mirror_buffer<uint8_t>(uint8_t*, uint8_t*, int, int, int, int,
@@ -165,6 +215,24 @@ template void rotate_buffer_clockwise<uint16_t>(uint16_t*, uint16_t*, int, int,
 template void rotate_buffer_clockwise<uint32_t>(uint32_t*, uint32_t*, int, int, int, int, int);
 template void rotate_buffer_clockwise<uint64_t>(uint64_t*, uint64_t*, int, int, int, int, int);
 
+template void transpose_buffer<uint8_t>(const uint8_t*, uint8_t*, int, int, ptrdiff_t, ptrdiff_t);
+template void transpose_buffer<uint16_t>(const uint16_t*, uint16_t*, int, int, ptrdiff_t,
+                                         ptrdiff_t);
+template void transpose_buffer<uint32_t>(const uint32_t*, uint32_t*, int, int, ptrdiff_t,
+                                         ptrdiff_t);
+template void transpose_buffer<uint64_t>(const uint64_t*, uint64_t*, int, int, ptrdiff_t,
+                                         ptrdiff_t);
+
+template void transpose_tile<uint8_t>(const uint8_t*, uint8_t*, int, int, ptrdiff_t, ptrdiff_t);
+template void transpose_tile<uint16_t>(const uint16_t*, uint16_t*, int, int, ptrdiff_t, ptrdiff_t);
+template void transpose_tile<uint32_t>(const uint32_t*, uint32_t*, int, int, ptrdiff_t, ptrdiff_t);
+template void transpose_tile<uint64_t>(const uint64_t*, uint64_t*, int, int, ptrdiff_t, ptrdiff_t);
+
+template void reverse_row<uint8_t>(const uint8_t*, uint8_t*, int);
+template void reverse_row<uint16_t>(const uint16_t*, uint16_t*, int);
+template void reverse_row<uint32_t>(const uint32_t*, uint32_t*, int);
+template void reverse_row<uint64_t>(const uint64_t*, uint64_t*, int);
+
 template void resize_buffer<uint8_t>(uint8_t*, uint8_t*, int, int, int, int, int, int);
 template void resize_buffer<uint16_t>(uint16_t*, uint16_t*, int, int, int, int, int, int);
 template void resize_buffer<uint32_t>(uint32_t*, uint32_t*, int, int, int, int, int, int);
@@ -213,6 +281,206 @@ uhdr_resize_effect::uhdr_resize_effect(int width, int height) : m_width{width},
   m_resize_uint64_t = resize_buffer<uint64_t>;
 }
 
+uhdr_resample_filter_t get_default_resample_filter(double scale) {
+  return scale >= 2.0 ? UHDR_RESAMPLE_AREA : UHDR_RESAMPLE_BICUBIC;
+}
+
+static float resample_kernel(uhdr_resample_filter_t filter, float x) {
+  x = std::fabs(x);
+  if (filter == UHDR_RESAMPLE_BILINEAR) {
+    return x < 1.0f ? 1.0f - x : 0.0f;
+  } else if (filter == UHDR_RESAMPLE_BICUBIC) {
+    // catmull-rom, a = -0.5
+    if (x < 1.0f) return (1.5f * x - 2.5f) * x * x + 1.0f;
+    if (x < 2.0f) return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+    return 0.0f;
+  } else if (filter == UHDR_RESAMPLE_LANCZOS3) {
+    if (x < 1e-6f) return 1.0f;
+    if (x >= 3.0f) return 0.0f;
+    const float kPi = 3.14159265358979f;
+    float px = kPi * x;
+    return 3.0f * std::sin(px) * std::sin(px / 3.0f) / (px * px);
+  }
+  return 0.0f;
+}
+
+static float resample_kernel_radius(uhdr_resample_filter_t filter) {
+  if (filter == UHDR_RESAMPLE_BILINEAR) return 1.0f;
+  if (filter == UHDR_RESAMPLE_BICUBIC) return 2.0f;
+  if (filter == UHDR_RESAMPLE_LANCZOS3) return 3.0f;
+  return 0.5f;
+}
+
+uhdr_resample_table::uhdr_resample_table(int src_len, int dst_len, double offset, double scale,
+                                         uhdr_resample_filter_t filter) {
+  const double abs_scale = std::fabs(scale);
+  // downscales stretch the kernel over the source to band limit it
+  const double filter_scale = (std::max)(abs_scale, 1.0);
+  const double support = resample_kernel_radius(filter) * filter_scale;
+
+  if (filter == UHDR_RESAMPLE_NEAREST) {
+    m_taps = 1;
+  } else if (filter == UHDR_RESAMPLE_AREA) {
+    m_taps = (int)std::ceil(abs_scale) + 1;
+  } else {
+    m_taps = (int)std::ceil(2.0 * support) + 1;
+  }
+  m_taps = (std::max)(1, (std::min)(m_taps, src_len));
+  m_start.resize(dst_len);
+  m_weights.assign((size_t)dst_len * m_taps, 0.0f);
+
+  for (int i = 0; i < dst_len; i++) {
+    const double lo = offset + i * scale;
+    const double hi = lo + scale;
+    const double center = (lo + hi) / 2.0;
+    int first, last;
+    if (filter == UHDR_RESAMPLE_NEAREST) {
+      first = last = (int)std::floor(center);
+    } else if (filter == UHDR_RESAMPLE_AREA) {
+      first = (int)std::floor((std::min)(lo, hi));
+      last = (int)std::ceil((std::max)(lo, hi)) - 1;
+    } else {
+      // kernel is centered on the interval center, source samples sit at j + 0.5
+      first = (int)std::ceil(center - 0.5 - support);
+      last = (int)std::floor(center - 0.5 + support);
+    }
+    int start = CLIP3(first, 0, src_len - 1);
+    start = (std::min)(start, src_len - m_taps);
+    m_start[i] = start;
+
+    float* weights = &m_weights[(size_t)i * m_taps];
+    float sum = 0.0f;
+    for (int j = first; j <= last; j++) {
+      float w;
+      if (filter == UHDR_RESAMPLE_NEAREST) {
+        w = 1.0f;
+      } else if (filter == UHDR_RESAMPLE_AREA) {
+        w = (float)((std::min)((std::max)(lo, hi), j + 1.0) -
+                    (std::max)((std::min)(lo, hi), (double)j));
+      } else {
+        w = resample_kernel(filter, (float)((j + 0.5 - center) / filter_scale));
+      }
+      if (w == 0.0f) continue;
+      int tap = (CLIP3(j, 0, src_len - 1)) - start;
+      if (tap < 0 || tap >= m_taps) continue;
+      weights[tap] += w;
+      sum += w;
+    }
+    if (sum == 0.0f) {
+      weights[(CLIP3((int)std::floor(center), 0, src_len - 1)) - start] = 1.0f;
+    } else {
+      for (int k = 0; k < m_taps; k++) weights[k] /= sum;
+    }
+  }
+}
+
+uhdr_effect_transform::uhdr_effect_transform(uhdr_img_fmt_t fmt, int width, int height)
+    : m_fmt{fmt}, m_src_w{width}, m_src_h{height}, m_transposed{false} {
+  m_axis[0] = {width, 0.0, 1.0, UHDR_RESAMPLE_NEAREST};
+  m_axis[1] = {height, 0.0, 1.0, UHDR_RESAMPLE_NEAREST};
+}
+
+void uhdr_effect_transform::crop(int left, int top, int wd, int ht) {
+  m_axis[0].m_offset += left * m_axis[0].m_scale;
+  m_axis[0].m_len = wd;
+  m_axis[1].m_offset += top * m_axis[1].m_scale;
+  m_axis[1].m_len = ht;
+}
+
+void uhdr_effect_transform::mirror(uhdr_mirror_direction_t direction) {
+  auto& axis = m_axis[direction == UHDR_MIRROR_HORIZONTAL ? 0 : 1];
+  axis.m_offset += axis.m_len * axis.m_scale;
+  axis.m_scale = -axis.m_scale;
+}
+
+void uhdr_effect_transform::rotate(int degree) {
+  if (degree == 90) {
+    // dst(row i, col j) = src(row h - 1 - j, col i)
+    mirror(UHDR_MIRROR_VERTICAL);
+    std::swap(m_axis[0], m_axis[1]);
+  } else if (degree == 180) {
+    mirror(UHDR_MIRROR_HORIZONTAL);
+    mirror(UHDR_MIRROR_VERTICAL);
+  } else if (degree == 270) {
+    // dst(row i, col j) = src(row j, col w - 1 - i)
+    mirror(UHDR_MIRROR_HORIZONTAL);
+    std::swap(m_axis[0], m_axis[1]);
+  }
+  if (degree == 90 || degree == 270) m_transposed = !m_transposed;
+}
+
+void uhdr_effect_transform::resize(int dst_w, int dst_h) {
+  const int dst_len[2] = {dst_w, dst_h};
+  for (int i = 0; i < 2; i++) {
+    m_axis[i].m_scale *= (double)m_axis[i].m_len / dst_len[i];
+    m_axis[i].m_len = dst_len[i];
+    m_axis[i].m_filter = get_default_resample_filter(std::fabs(m_axis[i].m_scale));
+  }
+}
+
+bool uhdr_effect_transform::is_remap() const {
+  for (int i = 0; i < 2; i++) {
+    if (std::fabs(m_axis[i].m_scale) != 1.0 ||
+        m_axis[i].m_offset != std::floor(m_axis[i].m_offset)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool uhdr_effect_transform::is_crop(int* left, int* top) const {
+  if (m_transposed || !is_remap() || m_axis[0].m_scale < 0 || m_axis[1].m_scale < 0) return false;
+  *left = (int)m_axis[0].m_offset;
+  *top = (int)m_axis[1].m_offset;
+  if (m_fmt == UHDR_IMG_FMT_24bppYCbCrP010 || m_fmt == UHDR_IMG_FMT_12bppYCbCr420) {
+    return (*left % 2) == 0 && (*top % 2) == 0;
+  }
+  return true;
+}
+
+std::vector<int> uhdr_effect_transform::get_index_map(int axis, bool chroma) const {
+  const int shift = chroma ? 1 : 0;
+  const int src_len = ((axis == 0) != m_transposed ? m_src_w : m_src_h) >> shift;
+  const double offset = m_axis[axis].m_offset / (1 << shift);
+  const double scale = m_axis[axis].m_scale;
+  std::vector<int> map(m_axis[axis].m_len >> shift);
+  for (size_t i = 0; i < map.size(); i++) {
+    map[i] = CLIP3((int)std::floor(offset + (i + 0.5) * scale), 0, src_len - 1);
+  }
+  return map;
+}
+
+uhdr_effect_transform uhdr_effect_transform::get_unoriented() const {
+  uhdr_effect_transform xfm = *this;
+  xfm.m_transposed = false;
+  for (int i = 0; i < 2; i++) {
+    auto axis = m_axis[m_transposed ? 1 - i : i];
+    if (axis.m_scale < 0) {
+      axis.m_offset += axis.m_len * axis.m_scale;
+      axis.m_scale = -axis.m_scale;
+    }
+    xfm.m_axis[i] = axis;
+  }
+  return xfm;
+}
+
+void uhdr_effect_transform::get_output_steps(ptrdiff_t stride, ptrdiff_t* origin,
+                                             ptrdiff_t* step_x, ptrdiff_t* step_y) const {
+  const ptrdiff_t out_step[2] = {1, stride};
+  ptrdiff_t src_step[2];
+  *origin = 0;
+  for (int i = 0; i < 2; i++) {
+    if (m_axis[i].m_scale < 0) {
+      *origin += (m_axis[i].m_len - 1) * out_step[i];
+      src_step[m_transposed ? 1 - i : i] = -out_step[i];
+    } else {
+      src_step[m_transposed ? 1 - i : i] = out_step[i];
+    }
+  }
+  *step_x = src_step[0];
+  *step_y = src_step[1];
+}
+
 std::unique_ptr<uhdr_raw_image_ext_t> apply_rotate(ultrahdr::uhdr_rotate_effect_t* desc,
                                                    uhdr_raw_image_t* src,
                                                    [[maybe_unused]] void* gl_ctxt,
@@ -240,49 +508,48 @@ std::unique_ptr<uhdr_raw_image_ext_t> apply_rotate(ultrahdr::uhdr_rotate_effect_
   if (src->fmt == UHDR_IMG_FMT_24bppYCbCrP010) {
     uint16_t* src_buffer = static_cast<uint16_t*>(src->planes[UHDR_PLANE_Y]);
     uint16_t* dst_buffer = static_cast<uint16_t*>(dst->planes[UHDR_PLANE_Y]);
-    desc->m_rotate_uint16_t(src_buffer, dst_buffer, src->w, src->h, src->stride[UHDR_PLANE_Y],
-                            dst->stride[UHDR_PLANE_Y], desc->m_degree);
+    rotate_plane(desc->m_rotate_uint16_t, src_buffer, dst_buffer, src->w, src->h,
+                 src->stride[UHDR_PLANE_Y], dst->stride[UHDR_PLANE_Y], desc->m_degree);
     uint32_t* src_uv_buffer = static_cast<uint32_t*>(src->planes[UHDR_PLANE_UV]);
     uint32_t* dst_uv_buffer = static_cast<uint32_t*>(dst->planes[UHDR_PLANE_UV]);
-    desc->m_rotate_uint32_t(src_uv_buffer, dst_uv_buffer, src->w / 2, src->h / 2,
-                            src->stride[UHDR_PLANE_UV] / 2, dst->stride[UHDR_PLANE_UV] / 2,
-                            desc->m_degree);
+    rotate_plane(desc->m_rotate_uint32_t, src_uv_buffer, dst_uv_buffer, src->w / 2, src->h / 2,
+                 src->stride[UHDR_PLANE_UV] / 2, dst->stride[UHDR_PLANE_UV] / 2, desc->m_degree);
   } else if (src->fmt == UHDR_IMG_FMT_12bppYCbCr420 || src->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
     uint8_t* src_buffer = static_cast<uint8_t*>(src->planes[UHDR_PLANE_Y]);
     uint8_t* dst_buffer = static_cast<uint8_t*>(dst->planes[UHDR_PLANE_Y]);
-    desc->m_rotate_uint8_t(src_buffer, dst_buffer, src->w, src->h, src->stride[UHDR_PLANE_Y],
-                           dst->stride[UHDR_PLANE_Y], desc->m_degree);
+    rotate_plane(desc->m_rotate_uint8_t, src_buffer, dst_buffer, src->w, src->h,
+                 src->stride[UHDR_PLANE_Y], dst->stride[UHDR_PLANE_Y], desc->m_degree);
     if (src->fmt == UHDR_IMG_FMT_12bppYCbCr420) {
       for (int i = 1; i < 3; i++) {
         src_buffer = static_cast<uint8_t*>(src->planes[i]);
         dst_buffer = static_cast<uint8_t*>(dst->planes[i]);
-        desc->m_rotate_uint8_t(src_buffer, dst_buffer, src->w / 2, src->h / 2, src->stride[i],
-                               dst->stride[i], desc->m_degree);
+        rotate_plane(desc->m_rotate_uint8_t, src_buffer, dst_buffer, src->w / 2, src->h / 2,
+                     src->stride[i], dst->stride[i], desc->m_degree);
       }
     }
   } else if (src->fmt == UHDR_IMG_FMT_32bppRGBA1010102 || src->fmt == UHDR_IMG_FMT_32bppRGBA8888) {
     uint32_t* src_buffer = static_cast<uint32_t*>(src->planes[UHDR_PLANE_PACKED]);
     uint32_t* dst_buffer = static_cast<uint32_t*>(dst->planes[UHDR_PLANE_PACKED]);
-    desc->m_rotate_uint32_t(src_buffer, dst_buffer, src->w, src->h, src->stride[UHDR_PLANE_PACKED],
-                            dst->stride[UHDR_PLANE_PACKED], desc->m_degree);
+    rotate_plane(desc->m_rotate_uint32_t, src_buffer, dst_buffer, src->w, src->h,
+                 src->stride[UHDR_PLANE_PACKED], dst->stride[UHDR_PLANE_PACKED], desc->m_degree);
   } else if (src->fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat) {
     uint64_t* src_buffer = static_cast<uint64_t*>(src->planes[UHDR_PLANE_PACKED]);
     uint64_t* dst_buffer = static_cast<uint64_t*>(dst->planes[UHDR_PLANE_PACKED]);
-    desc->m_rotate_uint64_t(src_buffer, dst_buffer, src->w, src->h, src->stride[UHDR_PLANE_PACKED],
-                            dst->stride[UHDR_PLANE_PACKED], desc->m_degree);
+    rotate_plane(desc->m_rotate_uint64_t, src_buffer, dst_buffer, src->w, src->h,
+                 src->stride[UHDR_PLANE_PACKED], dst->stride[UHDR_PLANE_PACKED], desc->m_degree);
   } else if (src->fmt == UHDR_IMG_FMT_24bppYCbCr444) {
     for (int i = 0; i < 3; i++) {
       uint8_t* src_buffer = static_cast<uint8_t*>(src->planes[i]);
       uint8_t* dst_buffer = static_cast<uint8_t*>(dst->planes[i]);
-      desc->m_rotate_uint8_t(src_buffer, dst_buffer, src->w, src->h, src->stride[i], dst->stride[i],
-                             desc->m_degree);
+      rotate_plane(desc->m_rotate_uint8_t, src_buffer, dst_buffer, src->w, src->h, src->stride[i],
+                   dst->stride[i], desc->m_degree);
     }
   } else if (src->fmt == UHDR_IMG_FMT_30bppYCbCr444) {
     for (int i = 0; i < 3; i++) {
       uint16_t* src_buffer = static_cast<uint16_t*>(src->planes[i]);
       uint16_t* dst_buffer = static_cast<uint16_t*>(dst->planes[i]);
-      desc->m_rotate_uint16_t(src_buffer, dst_buffer, src->w, src->h, src->stride[i],
-                              dst->stride[i], desc->m_degree);
+      rotate_plane(desc->m_rotate_uint16_t, src_buffer, dst_buffer, src->w, src->h, src->stride[i],
+                   dst->stride[i], desc->m_degree);
     }
   }
   return dst;
@@ -306,49 +573,48 @@ std::unique_ptr<uhdr_raw_image_ext_t> apply_mirror(ultrahdr::uhdr_mirror_effect_
   if (src->fmt == UHDR_IMG_FMT_24bppYCbCrP010) {
     uint16_t* src_buffer = static_cast<uint16_t*>(src->planes[UHDR_PLANE_Y]);
     uint16_t* dst_buffer = static_cast<uint16_t*>(dst->planes[UHDR_PLANE_Y]);
-    desc->m_mirror_uint16_t(src_buffer, dst_buffer, src->w, src->h, src->stride[UHDR_PLANE_Y],
-                            dst->stride[UHDR_PLANE_Y], desc->m_direction);
+    mirror_plane(desc->m_mirror_uint16_t, src_buffer, dst_buffer, src->w, src->h,
+                 src->stride[UHDR_PLANE_Y], dst->stride[UHDR_PLANE_Y], desc->m_direction);
     uint32_t* src_uv_buffer = static_cast<uint32_t*>(src->planes[UHDR_PLANE_UV]);
     uint32_t* dst_uv_buffer = static_cast<uint32_t*>(dst->planes[UHDR_PLANE_UV]);
-    desc->m_mirror_uint32_t(src_uv_buffer, dst_uv_buffer, src->w / 2, src->h / 2,
-                            src->stride[UHDR_PLANE_UV] / 2, dst->stride[UHDR_PLANE_UV] / 2,
-                            desc->m_direction);
+    mirror_plane(desc->m_mirror_uint32_t, src_uv_buffer, dst_uv_buffer, src->w / 2, src->h / 2,
+                 src->stride[UHDR_PLANE_UV] / 2, dst->stride[UHDR_PLANE_UV] / 2, desc->m_direction);
   } else if (src->fmt == UHDR_IMG_FMT_12bppYCbCr420 || src->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
     uint8_t* src_buffer = static_cast<uint8_t*>(src->planes[UHDR_PLANE_Y]);
     uint8_t* dst_buffer = static_cast<uint8_t*>(dst->planes[UHDR_PLANE_Y]);
-    desc->m_mirror_uint8_t(src_buffer, dst_buffer, src->w, src->h, src->stride[UHDR_PLANE_Y],
-                           dst->stride[UHDR_PLANE_Y], desc->m_direction);
+    mirror_plane(desc->m_mirror_uint8_t, src_buffer, dst_buffer, src->w, src->h,
+                 src->stride[UHDR_PLANE_Y], dst->stride[UHDR_PLANE_Y], desc->m_direction);
     if (src->fmt == UHDR_IMG_FMT_12bppYCbCr420) {
       for (int i = 1; i < 3; i++) {
         src_buffer = static_cast<uint8_t*>(src->planes[i]);
         dst_buffer = static_cast<uint8_t*>(dst->planes[i]);
-        desc->m_mirror_uint8_t(src_buffer, dst_buffer, src->w / 2, src->h / 2, src->stride[i],
-                               dst->stride[i], desc->m_direction);
+        mirror_plane(desc->m_mirror_uint8_t, src_buffer, dst_buffer, src->w / 2, src->h / 2,
+                     src->stride[i], dst->stride[i], desc->m_direction);
       }
     }
   } else if (src->fmt == UHDR_IMG_FMT_32bppRGBA1010102 || src->fmt == UHDR_IMG_FMT_32bppRGBA8888) {
     uint32_t* src_buffer = static_cast<uint32_t*>(src->planes[UHDR_PLANE_PACKED]);
     uint32_t* dst_buffer = static_cast<uint32_t*>(dst->planes[UHDR_PLANE_PACKED]);
-    desc->m_mirror_uint32_t(src_buffer, dst_buffer, src->w, src->h, src->stride[UHDR_PLANE_PACKED],
-                            dst->stride[UHDR_PLANE_PACKED], desc->m_direction);
+    mirror_plane(desc->m_mirror_uint32_t, src_buffer, dst_buffer, src->w, src->h,
+                 src->stride[UHDR_PLANE_PACKED], dst->stride[UHDR_PLANE_PACKED], desc->m_direction);
   } else if (src->fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat) {
     uint64_t* src_buffer = static_cast<uint64_t*>(src->planes[UHDR_PLANE_PACKED]);
     uint64_t* dst_buffer = static_cast<uint64_t*>(dst->planes[UHDR_PLANE_PACKED]);
-    desc->m_mirror_uint64_t(src_buffer, dst_buffer, src->w, src->h, src->stride[UHDR_PLANE_PACKED],
-                            dst->stride[UHDR_PLANE_PACKED], desc->m_direction);
+    mirror_plane(desc->m_mirror_uint64_t, src_buffer, dst_buffer, src->w, src->h,
+                 src->stride[UHDR_PLANE_PACKED], dst->stride[UHDR_PLANE_PACKED], desc->m_direction);
   } else if (src->fmt == UHDR_IMG_FMT_24bppYCbCr444) {
     for (int i = 0; i < 3; i++) {
       uint8_t* src_buffer = static_cast<uint8_t*>(src->planes[i]);
       uint8_t* dst_buffer = static_cast<uint8_t*>(dst->planes[i]);
-      desc->m_mirror_uint8_t(src_buffer, dst_buffer, src->w, src->h, src->stride[i], dst->stride[i],
-                             desc->m_direction);
+      mirror_plane(desc->m_mirror_uint8_t, src_buffer, dst_buffer, src->w, src->h, src->stride[i],
+                   dst->stride[i], desc->m_direction);
     }
   } else if (src->fmt == UHDR_IMG_FMT_30bppYCbCr444) {
     for (int i = 0; i < 3; i++) {
       uint16_t* src_buffer = static_cast<uint16_t*>(src->planes[i]);
       uint16_t* dst_buffer = static_cast<uint16_t*>(dst->planes[i]);
-      desc->m_mirror_uint16_t(src_buffer, dst_buffer, src->w, src->h, src->stride[i],
-                              dst->stride[i], desc->m_direction);
+      mirror_plane(desc->m_mirror_uint16_t, src_buffer, dst_buffer, src->w, src->h, src->stride[i],
+                   dst->stride[i], desc->m_direction);
     }
   }
   return dst;
@@ -420,10 +686,9 @@ std::unique_ptr<uhdr_raw_image_ext_t> apply_crop(ultrahdr::uhdr_crop_effect_t* d
   return dst;
 }
 
-std::unique_ptr<uhdr_raw_image_ext_t> apply_resize(ultrahdr::uhdr_resize_effect_t* desc,
-                                                   uhdr_raw_image_t* src, int dst_w, int dst_h,
-                                                   [[maybe_unused]] void* gl_ctxt,
-                                                   [[maybe_unused]] void* texture) {
+std::unique_ptr<uhdr_raw_image_ext_t> apply_resize(
+    [[maybe_unused]] ultrahdr::uhdr_resize_effect_t* desc, uhdr_raw_image_t* src, int dst_w,
+    int dst_h, [[maybe_unused]] void* gl_ctxt, [[maybe_unused]] void* texture) {
 #ifdef UHDR_ENABLE_GLES
   if ((src->fmt == UHDR_IMG_FMT_32bppRGBA1010102 || src->fmt == UHDR_IMG_FMT_32bppRGBA8888 ||
        src->fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat || src->fmt == UHDR_IMG_FMT_8bppYCbCr400) &&
@@ -432,58 +697,349 @@ std::unique_ptr<uhdr_raw_image_ext_t> apply_resize(ultrahdr::uhdr_resize_effect_
                              static_cast<GLuint*>(texture));
   }
 #endif
-  std::unique_ptr<uhdr_raw_image_ext_t> dst = std::make_unique<uhdr_raw_image_ext_t>(
-      src->fmt, src->cg, src->ct, src->range, dst_w, dst_h, 64);
+  uhdr_effect_transform_t xfm(src->fmt, src->w, src->h);
+  xfm.resize(dst_w, dst_h);
+  return apply_transform(&xfm, src);
+}
 
-  if (src->fmt == UHDR_IMG_FMT_24bppYCbCrP010) {
-    uint16_t* src_buffer = static_cast<uint16_t*>(src->planes[UHDR_PLANE_Y]);
-    uint16_t* dst_buffer = static_cast<uint16_t*>(dst->planes[UHDR_PLANE_Y]);
-    desc->m_resize_uint16_t(src_buffer, dst_buffer, src->w, src->h, dst->w, dst->h,
-                            src->stride[UHDR_PLANE_Y], dst->stride[UHDR_PLANE_Y]);
-    uint32_t* src_uv_buffer = static_cast<uint32_t*>(src->planes[UHDR_PLANE_UV]);
-    uint32_t* dst_uv_buffer = static_cast<uint32_t*>(dst->planes[UHDR_PLANE_UV]);
-    desc->m_resize_uint32_t(src_uv_buffer, dst_uv_buffer, src->w / 2, src->h / 2, dst->w / 2,
-                            dst->h / 2, src->stride[UHDR_PLANE_UV] / 2,
-                            dst->stride[UHDR_PLANE_UV] / 2);
-  } else if (src->fmt == UHDR_IMG_FMT_12bppYCbCr420 || src->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
-    uint8_t* src_buffer = static_cast<uint8_t*>(src->planes[UHDR_PLANE_Y]);
-    uint8_t* dst_buffer = static_cast<uint8_t*>(dst->planes[UHDR_PLANE_Y]);
-    desc->m_resize_uint8_t(src_buffer, dst_buffer, src->w, src->h, dst->w, dst->h,
-                           src->stride[UHDR_PLANE_Y], dst->stride[UHDR_PLANE_Y]);
-    if (src->fmt == UHDR_IMG_FMT_12bppYCbCr420) {
-      for (int i = 1; i < 3; i++) {
-        src_buffer = static_cast<uint8_t*>(src->planes[i]);
-        dst_buffer = static_cast<uint8_t*>(dst->planes[i]);
-        desc->m_resize_uint8_t(src_buffer, dst_buffer, src->w / 2, src->h / 2, dst->w / 2,
-                               dst->h / 2, src->stride[i], dst->stride[i]);
+// returns the common step of consecutive entries of map if it is +1 or -1, 0 otherwise
+static int get_unit_step(const std::vector<int>& map) {
+  if (map.size() < 2) return 1;
+  const int step = map[1] - map[0];
+  if (step != 1 && step != -1) return 0;
+  for (size_t j = 2; j < map.size(); j++) {
+    if (map[j] - map[j - 1] != step) return 0;
+  }
+  return step;
+}
+
+template <typename T>
+static void remap_plane(const T* src, T* dst, int src_stride, int dst_stride,
+                        const std::vector<int>& col_map, const std::vector<int>& row_map,
+                        bool transposed) {
+  const int wd = (int)col_map.size();
+  const int ht = (int)row_map.size();
+  if (wd == 0 || ht == 0) return;
+
+  // crops, mirrors and rotations walk the source one sample at a time along both axes. Those are
+  // row copies, row reversals or blocked transposes rather than per sample gathers
+  const int col_step = get_unit_step(col_map);
+  const int row_step = get_unit_step(row_map);
+
+  for_each_row_band(ht, [&](int row_start, int row_end) {
+    if (transposed && col_step != 0 && row_step != 0) {
+      // dst(i, j) = src(col_map[j], row_map[i]), lay the band out so that it reads source rows
+      // forwards and flip the destination instead if row_map walks backwards
+      const int first = row_step > 0 ? row_start : row_end - 1;
+      T* dst_band = dst + (ptrdiff_t)first * dst_stride;
+      transpose_buffer<T>(src + (ptrdiff_t)col_map[0] * src_stride + row_map[first], dst_band,
+                          row_end - row_start, wd, (ptrdiff_t)col_step * src_stride,
+                          (ptrdiff_t)row_step * dst_stride);
+      return;
+    }
+    for (int i = row_start; i < row_end; i++) {
+      T* dst_row = dst + (ptrdiff_t)i * dst_stride;
+      if (!transposed && col_step == 1) {
+        memcpy(dst_row, src + (ptrdiff_t)row_map[i] * src_stride + col_map[0], wd * sizeof(T));
+      } else if (!transposed && col_step == -1) {
+        reverse_row<T>(src + (ptrdiff_t)row_map[i] * src_stride + col_map[wd - 1], dst_row, wd);
+      } else if (!transposed) {
+        const T* src_row = src + (ptrdiff_t)row_map[i] * src_stride;
+        for (int j = 0; j < wd; j++) {
+          dst_row[j] = src_row[col_map[j]];
+        }
+      } else {
+        const T* src_col = src + row_map[i];
+        for (int j = 0; j < wd; j++) {
+          dst_row[j] = src_col[(ptrdiff_t)col_map[j] * src_stride];
+        }
       }
     }
-  } else if (src->fmt == UHDR_IMG_FMT_32bppRGBA1010102 || src->fmt == UHDR_IMG_FMT_32bppRGBA8888) {
-    uint32_t* src_buffer = static_cast<uint32_t*>(src->planes[UHDR_PLANE_PACKED]);
-    uint32_t* dst_buffer = static_cast<uint32_t*>(dst->planes[UHDR_PLANE_PACKED]);
-    desc->m_resize_uint32_t(src_buffer, dst_buffer, src->w, src->h, dst->w, dst->h,
-                            src->stride[UHDR_PLANE_PACKED], dst->stride[UHDR_PLANE_PACKED]);
-  } else if (src->fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat) {
-    uint64_t* src_buffer = static_cast<uint64_t*>(src->planes[UHDR_PLANE_PACKED]);
-    uint64_t* dst_buffer = static_cast<uint64_t*>(dst->planes[UHDR_PLANE_PACKED]);
-    desc->m_resize_uint64_t(src_buffer, dst_buffer, src->w, src->h, dst->w, dst->h,
-                            src->stride[UHDR_PLANE_PACKED], dst->stride[UHDR_PLANE_PACKED]);
-  } else if (src->fmt == UHDR_IMG_FMT_24bppYCbCr444) {
-    for (int i = 0; i < 3; i++) {
-      uint8_t* src_buffer = static_cast<uint8_t*>(src->planes[i]);
-      uint8_t* dst_buffer = static_cast<uint8_t*>(dst->planes[i]);
-      desc->m_resize_uint8_t(src_buffer, dst_buffer, src->w, src->h, dst->w, dst->h, src->stride[i],
-                             dst->stride[i]);
+  });
+}
+
+/*!\brief a packed 24 bit pixel, moved as a unit by the remapper */
+typedef struct uhdr_rgb888_sample {
+  uint8_t m_rgb[3];
+} uhdr_rgb888_sample_t;
+static_assert(sizeof(uhdr_rgb888_sample_t) == 3, "rgb888 samples must be tightly packed");
+
+static void remap_plane(int bpp, const uint8_t* src, uint8_t* dst, size_t src_stride_bytes,
+                        size_t dst_stride_bytes, const std::vector<int>& col_map,
+                        const std::vector<int>& row_map, bool transposed) {
+  if (bpp == 1) {
+    remap_plane(src, dst, (int)src_stride_bytes, (int)dst_stride_bytes, col_map, row_map,
+                transposed);
+  } else if (bpp == 2) {
+    remap_plane(reinterpret_cast<const uint16_t*>(src), reinterpret_cast<uint16_t*>(dst),
+                (int)(src_stride_bytes / 2), (int)(dst_stride_bytes / 2), col_map, row_map,
+                transposed);
+  } else if (bpp == 3) {
+    remap_plane(reinterpret_cast<const uhdr_rgb888_sample_t*>(src),
+                reinterpret_cast<uhdr_rgb888_sample_t*>(dst), (int)(src_stride_bytes / 3),
+                (int)(dst_stride_bytes / 3), col_map, row_map, transposed);
+  } else if (bpp == 4) {
+    remap_plane(reinterpret_cast<const uint32_t*>(src), reinterpret_cast<uint32_t*>(dst),
+                (int)(src_stride_bytes / 4), (int)(dst_stride_bytes / 4), col_map, row_map,
+                transposed);
+  } else if (bpp == 8) {
+    remap_plane(reinterpret_cast<const uint64_t*>(src), reinterpret_cast<uint64_t*>(dst),
+                (int)(src_stride_bytes / 8), (int)(dst_stride_bytes / 8), col_map, row_map,
+                transposed);
+  }
+}
+
+/*!\brief sample layouts seen by the resampler */
+typedef enum resample_sample_type {
+  SAMPLE_U8,          /**< 8 bit */
+  SAMPLE_U10,         /**< 10 bit in the lsbs of 16 bit words */
+  SAMPLE_P010,        /**< 10 bit in the msbs of 16 bit words */
+  SAMPLE_RGBA1010102, /**< 10 bit rgb, 2 bit alpha packed in 32 bit words */
+  SAMPLE_F16,         /**< half float */
+} resample_sample_type_t;
+
+/*!\brief one plane of an image as seen by the resampler and the remapper */
+typedef struct resample_plane_desc {
+  int m_plane;                   /**< plane index */
+  int m_channels;                /**< interleaved samples per pixel */
+  resample_sample_type_t m_type; /**< sample layout */
+  int m_bpp;                     /**< bytes per pixel */
+  int m_stride_unit;             /**< bytes per unit of stride[] */
+  bool m_chroma;                 /**< plane is subsampled by 2 in both directions */
+} resample_plane_desc_t;
+
+static std::vector<resample_plane_desc_t> get_plane_descs(uhdr_img_fmt_t fmt) {
+  switch (fmt) {
+    case UHDR_IMG_FMT_24bppYCbCrP010:
+      return {{UHDR_PLANE_Y, 1, SAMPLE_P010, 2, 2, false},
+              {UHDR_PLANE_UV, 2, SAMPLE_P010, 4, 2, true}};
+    case UHDR_IMG_FMT_12bppYCbCr420:
+      return {{UHDR_PLANE_Y, 1, SAMPLE_U8, 1, 1, false},
+              {UHDR_PLANE_U, 1, SAMPLE_U8, 1, 1, true},
+              {UHDR_PLANE_V, 1, SAMPLE_U8, 1, 1, true}};
+    case UHDR_IMG_FMT_8bppYCbCr400:
+      return {{UHDR_PLANE_Y, 1, SAMPLE_U8, 1, 1, false}};
+    case UHDR_IMG_FMT_24bppYCbCr444:
+      return {{UHDR_PLANE_Y, 1, SAMPLE_U8, 1, 1, false},
+              {UHDR_PLANE_U, 1, SAMPLE_U8, 1, 1, false},
+              {UHDR_PLANE_V, 1, SAMPLE_U8, 1, 1, false}};
+    case UHDR_IMG_FMT_30bppYCbCr444:
+      return {{UHDR_PLANE_Y, 1, SAMPLE_U10, 2, 2, false},
+              {UHDR_PLANE_U, 1, SAMPLE_U10, 2, 2, false},
+              {UHDR_PLANE_V, 1, SAMPLE_U10, 2, 2, false}};
+    case UHDR_IMG_FMT_24bppRGB888:
+      return {{UHDR_PLANE_PACKED, 3, SAMPLE_U8, 3, 3, false}};
+    case UHDR_IMG_FMT_32bppRGBA8888:
+      return {{UHDR_PLANE_PACKED, 4, SAMPLE_U8, 4, 4, false}};
+    case UHDR_IMG_FMT_32bppRGBA1010102:
+      return {{UHDR_PLANE_PACKED, 4, SAMPLE_RGBA1010102, 4, 4, false}};
+    case UHDR_IMG_FMT_64bppRGBAHalfFloat:
+      return {{UHDR_PLANE_PACKED, 4, SAMPLE_F16, 8, 8, false}};
+    default:
+      return {};
+  }
+}
+
+static void load_row(resample_sample_type_t type, const uint8_t* src, int count, float* dst) {
+  const uint16_t* src16 = reinterpret_cast<const uint16_t*>(src);
+  switch (type) {
+    case SAMPLE_U8:
+      for (int i = 0; i < count; i++) dst[i] = src[i];
+      break;
+    case SAMPLE_U10:
+      for (int i = 0; i < count; i++) dst[i] = src16[i];
+      break;
+    case SAMPLE_P010:
+      for (int i = 0; i < count; i++) dst[i] = src16[i] >> 6;
+      break;
+    case SAMPLE_RGBA1010102: {
+      const uint32_t* src32 = reinterpret_cast<const uint32_t*>(src);
+      for (int i = 0; i < count / 4; i++) {
+        dst[4 * i + 0] = src32[i] & 0x3ff;
+        dst[4 * i + 1] = (src32[i] >> 10) & 0x3ff;
+        dst[4 * i + 2] = (src32[i] >> 20) & 0x3ff;
+        dst[4 * i + 3] = src32[i] >> 30;
+      }
+      break;
     }
-  } else if (src->fmt == UHDR_IMG_FMT_30bppYCbCr444) {
-    for (int i = 0; i < 3; i++) {
-      uint16_t* src_buffer = static_cast<uint16_t*>(src->planes[i]);
-      uint16_t* dst_buffer = static_cast<uint16_t*>(dst->planes[i]);
-      desc->m_resize_uint16_t(src_buffer, dst_buffer, src->w, src->h, dst->w, dst->h,
-                              src->stride[i], dst->stride[i]);
+    case SAMPLE_F16:
+      halfToFloatRow(src16, dst, count);
+      break;
+  }
+}
+
+static void store_row(resample_sample_type_t type, const float* src, int count, uint8_t* dst) {
+  uint16_t* dst16 = reinterpret_cast<uint16_t*>(dst);
+  switch (type) {
+    case SAMPLE_U8:
+      for (int i = 0; i < count; i++) dst[i] = (uint8_t)(CLIP3(src[i] + 0.5f, 0.0f, 255.0f));
+      break;
+    case SAMPLE_U10:
+      for (int i = 0; i < count; i++) dst16[i] = (uint16_t)(CLIP3(src[i] + 0.5f, 0.0f, 1023.0f));
+      break;
+    case SAMPLE_P010:
+      for (int i = 0; i < count; i++) {
+        dst16[i] = (uint16_t)((uint16_t)(CLIP3(src[i] + 0.5f, 0.0f, 1023.0f)) << 6);
+      }
+      break;
+    case SAMPLE_RGBA1010102: {
+      uint32_t* dst32 = reinterpret_cast<uint32_t*>(dst);
+      for (int i = 0; i < count / 4; i++) {
+        uint32_t r = (uint32_t)(CLIP3(src[4 * i + 0] + 0.5f, 0.0f, 1023.0f));
+        uint32_t g = (uint32_t)(CLIP3(src[4 * i + 1] + 0.5f, 0.0f, 1023.0f));
+        uint32_t b = (uint32_t)(CLIP3(src[4 * i + 2] + 0.5f, 0.0f, 1023.0f));
+        uint32_t a = (uint32_t)(CLIP3(src[4 * i + 3] + 0.5f, 0.0f, 3.0f));
+        dst32[i] = r | (g << 10) | (b << 20) | (a << 30);
+      }
+      break;
+    }
+    case SAMPLE_F16:
+      floatToHalfRow(src, dst16, count);
+      break;
+  }
+}
+
+template <int kChannels>
+static void resample_horizontal(const float* src, float* dst, const uhdr_resample_table_t& table) {
+  const int taps = table.m_taps;
+  const int dst_w = (int)table.m_start.size();
+  for (int i = 0; i < dst_w; i++) {
+    const float* weights = &table.m_weights[(size_t)i * taps];
+    const float* s = src + (size_t)table.m_start[i] * kChannels;
+    float acc[kChannels] = {};
+    for (int k = 0; k < taps; k++) {
+      for (int c = 0; c < kChannels; c++) acc[c] += weights[k] * s[k * kChannels + c];
+    }
+    for (int c = 0; c < kChannels; c++) dst[i * kChannels + c] = acc[c];
+  }
+}
+
+void resample_vertical(float* dst, const float* const* rows, const float* weights, int taps,
+                       int len) {
+  const float* r0 = rows[0];
+  const float w0 = weights[0];
+  for (int i = 0; i < len; i++) dst[i] = w0 * r0[i];
+  for (int k = 1; k < taps; k++) {
+    const float* r = rows[k];
+    const float w = weights[k];
+    for (int i = 0; i < len; i++) dst[i] += w * r[i];
+  }
+}
+
+// separable resample of one plane, output rows are spread across threads. Each thread keeps the
+// horizontally filtered source rows of its current vertical window in a ring
+static void resample_plane(const resample_plane_desc_t& desc, const uint8_t* src,
+                           size_t src_stride_bytes, int src_w, uint8_t* dst,
+                           size_t dst_stride_bytes, const uhdr_resample_table_t& hz,
+                           const uhdr_resample_table_t& vt) {
+  const int ch = desc.m_channels;
+  const int dst_w = (int)hz.m_start.size();
+  const int dst_h = (int)vt.m_start.size();
+  const int taps = vt.m_taps;
+  if (dst_w == 0 || dst_h == 0) return;
+
+  for_each_row_band(dst_h, [&](int row_start, int row_end) {
+    std::vector<float> line((size_t)src_w * ch);
+    std::vector<float> ring((size_t)taps * dst_w * ch);
+    std::vector<int> ring_tag(taps, -1);
+    std::vector<const float*> rows(taps);
+    std::vector<float> acc((size_t)dst_w * ch);
+
+    for (int y = row_start; y < row_end; y++) {
+      for (int k = 0; k < taps; k++) {
+        const int r = vt.m_start[y] + k;
+        float* slot = &ring[(size_t)(r % taps) * dst_w * ch];
+        if (ring_tag[r % taps] != r) {
+          load_row(desc.m_type, src + r * src_stride_bytes, src_w * ch, line.data());
+          if (ch == 1) {
+            resample_horizontal<1>(line.data(), slot, hz);
+          } else if (ch == 2) {
+            resample_horizontal<2>(line.data(), slot, hz);
+          } else if (ch == 3) {
+            resample_horizontal<3>(line.data(), slot, hz);
+          } else {
+            resample_horizontal<4>(line.data(), slot, hz);
+          }
+          ring_tag[r % taps] = r;
+        }
+        rows[k] = slot;
+      }
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__ARM_NEON__) || defined(__ARM_NEON)))
+      resample_vertical_neon(acc.data(), rows.data(), &vt.m_weights[(size_t)y * taps], taps,
+                             dst_w * ch);
+#elif (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+      resample_vertical_sse2(acc.data(), rows.data(), &vt.m_weights[(size_t)y * taps], taps,
+                             dst_w * ch);
+#else
+      resample_vertical(acc.data(), rows.data(), &vt.m_weights[(size_t)y * taps], taps,
+                        dst_w * ch);
+#endif
+      store_row(desc.m_type, acc.data(), dst_w * ch, dst + y * dst_stride_bytes);
+    }
+  });
+}
+
+std::unique_ptr<uhdr_raw_image_ext_t> apply_transform(const uhdr_effect_transform_t* xfm,
+                                                      uhdr_raw_image_t* src) {
+  if (src->fmt != xfm->m_fmt) return nullptr;
+  std::vector<resample_plane_desc_t> descs = get_plane_descs(src->fmt);
+  if (descs.empty()) return nullptr;
+
+  std::unique_ptr<uhdr_raw_image_ext_t> dst = std::make_unique<uhdr_raw_image_ext_t>(
+      src->fmt, src->cg, src->ct, src->range, xfm->width(), xfm->height(), 64);
+  const bool tr = xfm->m_transposed;
+  const bool remap = xfm->is_remap();
+
+  for (const auto& desc : descs) {
+    const uint8_t* src_plane = static_cast<uint8_t*>(src->planes[desc.m_plane]);
+    uint8_t* dst_plane = static_cast<uint8_t*>(dst->planes[desc.m_plane]);
+    const size_t src_stride = (size_t)src->stride[desc.m_plane] * desc.m_stride_unit;
+    const size_t dst_stride = (size_t)dst->stride[desc.m_plane] * desc.m_stride_unit;
+
+    if (remap) {
+      remap_plane(desc.m_bpp, src_plane, dst_plane, src_stride, dst_stride,
+                  xfm->get_index_map(0, desc.m_chroma), xfm->get_index_map(1, desc.m_chroma), tr);
+      continue;
+    }
+
+    // resampling runs along the source axes, a transposed output is then remapped from a
+    // scratch plane
+    const int shift = desc.m_chroma ? 1 : 0;
+    const auto& axis_x = xfm->m_axis[tr ? 1 : 0];
+    const auto& axis_y = xfm->m_axis[tr ? 0 : 1];
+    const int src_w = xfm->m_src_w >> shift, src_h = xfm->m_src_h >> shift;
+    const int out_w = axis_x.m_len >> shift, out_h = axis_y.m_len >> shift;
+    uhdr_resample_table_t hz(src_w, out_w, axis_x.m_offset / (1 << shift), axis_x.m_scale,
+                             axis_x.m_filter);
+    uhdr_resample_table_t vt(src_h, out_h, axis_y.m_offset / (1 << shift), axis_y.m_scale,
+                             axis_y.m_filter);
+    if (!tr) {
+      resample_plane(desc, src_plane, src_stride, src_w, dst_plane, dst_stride, hz, vt);
+    } else {
+      std::vector<uint8_t> scratch((size_t)out_w * out_h * desc.m_bpp);
+      const size_t scratch_stride = (size_t)out_w * desc.m_bpp;
+      resample_plane(desc, src_plane, src_stride, src_w, scratch.data(), scratch_stride, hz, vt);
+      std::vector<int> col_map(out_h), row_map(out_w);
+      std::iota(col_map.begin(), col_map.end(), 0);
+      std::iota(row_map.begin(), row_map.end(), 0);
+      remap_plane(desc.m_bpp, scratch.data(), dst_plane, scratch_stride, dst_stride, col_map,
+                  row_map, true);
     }
   }
   return dst;
 }
 
+std::unique_ptr<uhdr_raw_image_ext_t> crop_view(uhdr_raw_image_ext_t* src, int left, int top,
+                                                int wd, int ht) {
+  if (left < 0 || top < 0 || wd <= 0 || ht <= 0 || left + wd > (int)src->w ||
+      top + ht > (int)src->h) {
+    return nullptr;
+  }
+  if ((src->fmt == UHDR_IMG_FMT_24bppYCbCrP010 || src->fmt == UHDR_IMG_FMT_12bppYCbCr420) &&
+      ((left % 2) != 0 || (top % 2) != 0 || (wd % 2) != 0 || (ht % 2) != 0)) {
+    return nullptr;
+  }
+  return std::make_unique<uhdr_raw_image_ext_t>(*src, left, top, wd, ht);
+}
+
 }  // namespace ultrahdr
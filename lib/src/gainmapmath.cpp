@@ -85,6 +85,31 @@ void ShepardsIDW::fillShepardsIDW(float* weights, int incR, int incB) {
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Shared table caches
+
+static TableCache<int, ShepardsIDW> gShepardsIDWCache(kShepardsIDWCacheSize);
+static TableCache<std::array<float, 10>, GainLUT> gGainLUTCache(kGainLUTCacheSize);
+
+std::shared_ptr<const ShepardsIDW> getShepardsIDW(int mapScaleFactor) {
+  return gShepardsIDWCache.get(mapScaleFactor,
+                               [mapScaleFactor] { return new ShepardsIDW(mapScaleFactor); });
+}
+
+std::shared_ptr<const GainLUT> getGainLUT(uhdr_gainmap_metadata_ext_t* metadata,
+                                          float gainmapWeight) {
+  // the table depends only on the content boost range, gamma and weight
+  std::array<float, 10> key;
+  for (int i = 0; i < 3; i++) {
+    key[i] = metadata->min_content_boost[i];
+    key[3 + i] = metadata->max_content_boost[i];
+    key[6 + i] = metadata->gamma[i];
+  }
+  key[9] = gainmapWeight;
+  return gGainLUTCache.get(
+      key, [metadata, gainmapWeight] { return new GainLUT(metadata, gainmapWeight); });
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // sRGB transformations
 
@@ -129,18 +154,22 @@ Color srgbInvOetf(Color e_gamma) {
   return {{{srgbInvOetf(e_gamma.r), srgbInvOetf(e_gamma.g), srgbInvOetf(e_gamma.b)}}};
 }
 
-float srgbInvOetfLUT(float e_gamma) {
-  int32_t value = static_cast<int32_t>(e_gamma * (kSrgbInvOETFNumEntries - 1) + 0.5);
-  // TODO() : Remove once conversion modules have appropriate clamping in place
-  value = CLIP3(value, 0, kSrgbInvOETFNumEntries - 1);
-  static LookUpTable kSrgbLut(kSrgbInvOETFNumEntries, static_cast<float (*)(float)>(srgbInvOetf));
-  return kSrgbLut.getTable()[value];
-}
+// The transfer function look up tables are namespace scope objects, built once while the library
+// is loaded instead of on first use. This keeps table construction off the first encode / decode
+// of a process, and per pixel lookups do not go through a thread safe static guard.
+static const LookUpTable kSrgbLut(kSrgbInvOETFNumEntries,
+                                  static_cast<float (*)(float)>(srgbInvOetf));
+static const LookUpTable kSrgbCodeLut(kSrgbInvOETFCodeEntries,
+                                      static_cast<float (*)(float)>(srgbInvOetf));
+
+float srgbInvOetfLUT(float e_gamma) { return kSrgbLut.lookup(e_gamma); }
 
 Color srgbInvOetfLUT(Color e_gamma) {
   return {{{srgbInvOetfLUT(e_gamma.r), srgbInvOetfLUT(e_gamma.g), srgbInvOetfLUT(e_gamma.b)}}};
 }
 
+const float* srgbInvOetfCodeTable() { return kSrgbCodeLut.getTable().data(); }
+
 // See IEC 61966-2-1/Amd 1:2003, Equations F.10 and F.11.
 float srgbOetf(float e) {
   constexpr float kThreshold = 0.0031308f;
@@ -251,13 +280,9 @@ float hlgOetf(float e) {
 
 Color hlgOetf(Color e) { return {{{hlgOetf(e.r), hlgOetf(e.g), hlgOetf(e.b)}}}; }
 
-float hlgOetfLUT(float e) {
-  int32_t value = static_cast<int32_t>(e * (kHlgOETFNumEntries - 1) + 0.5);
-  // TODO() : Remove once conversion modules have appropriate clamping in place
-  value = CLIP3(value, 0, kHlgOETFNumEntries - 1);
-  static LookUpTable kHlgLut(kHlgOETFNumEntries, static_cast<float (*)(float)>(hlgOetf));
-  return kHlgLut.getTable()[value];
-}
+static const LookUpTable kHlgLut(kHlgOETFNumEntries, static_cast<float (*)(float)>(hlgOetf));
+
+float hlgOetfLUT(float e) { return kHlgLut.lookup(e); }
 
 Color hlgOetfLUT(Color e) { return {{{hlgOetfLUT(e.r), hlgOetfLUT(e.g), hlgOetfLUT(e.b)}}}; }
 
@@ -274,18 +299,19 @@ Color hlgInvOetf(Color e_gamma) {
   return {{{hlgInvOetf(e_gamma.r), hlgInvOetf(e_gamma.g), hlgInvOetf(e_gamma.b)}}};
 }
 
-float hlgInvOetfLUT(float e_gamma) {
-  int32_t value = static_cast<int32_t>(e_gamma * (kHlgInvOETFNumEntries - 1) + 0.5);
-  // TODO() : Remove once conversion modules have appropriate clamping in place
-  value = CLIP3(value, 0, kHlgInvOETFNumEntries - 1);
-  static LookUpTable kHlgInvLut(kHlgInvOETFNumEntries, static_cast<float (*)(float)>(hlgInvOetf));
-  return kHlgInvLut.getTable()[value];
-}
+static const LookUpTable kHlgInvLut(kHlgInvOETFNumEntries,
+                                    static_cast<float (*)(float)>(hlgInvOetf));
+static const LookUpTable kHlgInvCodeLut(kHlgInvOETFCodeEntries,
+                                        static_cast<float (*)(float)>(hlgInvOetf));
+
+float hlgInvOetfLUT(float e_gamma) { return kHlgInvLut.lookup(e_gamma); }
 
 Color hlgInvOetfLUT(Color e_gamma) {
   return {{{hlgInvOetfLUT(e_gamma.r), hlgInvOetfLUT(e_gamma.g), hlgInvOetfLUT(e_gamma.b)}}};
 }
 
+const float* hlgInvOetfCodeTable() { return kHlgInvCodeLut.getTable().data(); }
+
 // See ITU-R BT.2100-2, Table 5, Note 5f
 // Gamma = 1.2 + 0.42 * log(kHlgMaxNits / 1000)
 static const float kOotfGamma = 1.2f;
@@ -323,13 +349,9 @@ float pqOetf(float e) {
 
 Color pqOetf(Color e) { return {{{pqOetf(e.r), pqOetf(e.g), pqOetf(e.b)}}}; }
 
-float pqOetfLUT(float e) {
-  int32_t value = static_cast<int32_t>(e * (kPqOETFNumEntries - 1) + 0.5);
-  // TODO() : Remove once conversion modules have appropriate clamping in place
-  value = CLIP3(value, 0, kPqOETFNumEntries - 1);
-  static LookUpTable kPqLut(kPqOETFNumEntries, static_cast<float (*)(float)>(pqOetf));
-  return kPqLut.getTable()[value];
-}
+static const LookUpTable kPqLut(kPqOETFNumEntries, static_cast<float (*)(float)>(pqOetf));
+
+float pqOetfLUT(float e) { return kPqLut.lookup(e); }
 
 Color pqOetfLUT(Color e) { return {{{pqOetfLUT(e.r), pqOetfLUT(e.g), pqOetfLUT(e.b)}}}; }
 
@@ -342,18 +364,19 @@ Color pqInvOetf(Color e_gamma) {
   return {{{pqInvOetf(e_gamma.r), pqInvOetf(e_gamma.g), pqInvOetf(e_gamma.b)}}};
 }
 
-float pqInvOetfLUT(float e_gamma) {
-  int32_t value = static_cast<int32_t>(e_gamma * (kPqInvOETFNumEntries - 1) + 0.5);
-  // TODO() : Remove once conversion modules have appropriate clamping in place
-  value = CLIP3(value, 0, kPqInvOETFNumEntries - 1);
-  static LookUpTable kPqInvLut(kPqInvOETFNumEntries, static_cast<float (*)(float)>(pqInvOetf));
-  return kPqInvLut.getTable()[value];
-}
+static const LookUpTable kPqInvLut(kPqInvOETFNumEntries,
+                                   static_cast<float (*)(float)>(pqInvOetf));
+static const LookUpTable kPqInvCodeLut(kPqInvOETFCodeEntries,
+                                       static_cast<float (*)(float)>(pqInvOetf));
+
+float pqInvOetfLUT(float e_gamma) { return kPqInvLut.lookup(e_gamma); }
 
 Color pqInvOetfLUT(Color e_gamma) {
   return {{{pqInvOetfLUT(e_gamma.r), pqInvOetfLUT(e_gamma.g), pqInvOetfLUT(e_gamma.b)}}};
 }
 
+const float* pqInvOetfCodeTable() { return kPqInvCodeLut.getTable().data(); }
+
 ////////////////////////////////////////////////////////////////////////////////
 // Color access functions
 
@@ -486,6 +509,38 @@ Color getRgba1010102Pixel(uhdr_raw_image_t* image, size_t x, size_t y) {
   return pixel / 1023.0f;
 }
 
+static void floatToHalfRowPortable(const float* src, uint16_t* dst, size_t count) {
+  for (size_t i = 0; i < count; i++) dst[i] = floatToHalf(src[i]);
+}
+
+static void halfToFloatRowPortable(const uint16_t* src, float* dst, size_t count) {
+  for (size_t i = 0; i < count; i++) dst[i] = halfToFloat(src[i]);
+}
+
+void floatToHalfRow(const float* src, uint16_t* dst, size_t count) {
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+  static const auto convert = cpuSupportsF16C() ? floatToHalfRow_f16c : floatToHalfRowPortable;
+#elif (defined(UHDR_ENABLE_INTRINSICS) && defined(__aarch64__) && \
+       (defined(__ARM_NEON__) || defined(__ARM_NEON)))
+  static const auto convert = floatToHalfRow_neon;
+#else
+  static const auto convert = floatToHalfRowPortable;
+#endif
+  convert(src, dst, count);
+}
+
+void halfToFloatRow(const uint16_t* src, float* dst, size_t count) {
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+  static const auto convert = cpuSupportsF16C() ? halfToFloatRow_f16c : halfToFloatRowPortable;
+#elif (defined(UHDR_ENABLE_INTRINSICS) && defined(__aarch64__) && \
+       (defined(__ARM_NEON__) || defined(__ARM_NEON)))
+  static const auto convert = halfToFloatRow_neon;
+#else
+  static const auto convert = halfToFloatRowPortable;
+#endif
+  convert(src, dst, count);
+}
+
 Color getRgbaF16Pixel(uhdr_raw_image_t* image, size_t x, size_t y) {
   uint64_t* rgbData = static_cast<uint64_t*>(image->planes[UHDR_PLANE_PACKED]);
   unsigned int srcStride = image->stride[UHDR_PLANE_PACKED];
@@ -497,6 +552,31 @@ Color getRgbaF16Pixel(uhdr_raw_image_t* image, size_t x, size_t y) {
   return sanitizePixel(pixel);
 }
 
+Color getRgba8888PixelLinear(uhdr_raw_image_t* image, size_t x, size_t y, const float* invOetf) {
+  uint32_t* rgbData = static_cast<uint32_t*>(image->planes[UHDR_PLANE_PACKED]);
+  unsigned int srcStride = image->stride[UHDR_PLANE_PACKED];
+  uint32_t rgba = rgbData[x + y * srcStride];
+
+  Color pixel;
+  pixel.r = invOetf[rgba & 0xff];
+  pixel.g = invOetf[(rgba >> 8) & 0xff];
+  pixel.b = invOetf[(rgba >> 16) & 0xff];
+  return pixel;
+}
+
+Color getRgba1010102PixelLinear(uhdr_raw_image_t* image, size_t x, size_t y,
+                                const float* invOetf) {
+  uint32_t* rgbData = static_cast<uint32_t*>(image->planes[UHDR_PLANE_PACKED]);
+  unsigned int srcStride = image->stride[UHDR_PLANE_PACKED];
+  uint32_t rgba = rgbData[x + y * srcStride];
+
+  Color pixel;
+  pixel.r = invOetf[rgba & 0x3ff];
+  pixel.g = invOetf[(rgba >> 10) & 0x3ff];
+  pixel.b = invOetf[(rgba >> 20) & 0x3ff];
+  return pixel;
+}
+
 static Color samplePixels(uhdr_raw_image_t* image, size_t map_scale_factor, size_t x, size_t y,
                           GetPixelFn get_pixel_fn) {
   Color e = {{{0.0f, 0.0f, 0.0f}}};
@@ -538,7 +618,26 @@ Color sampleRgba1010102(uhdr_raw_image_t* image, size_t map_scale_factor, size_t
 }
 
 Color sampleRgbaF16(uhdr_raw_image_t* image, size_t map_scale_factor, size_t x, size_t y) {
-  return samplePixels(image, map_scale_factor, x, y, getRgbaF16Pixel);
+  const uint64_t* rgbData = static_cast<uint64_t*>(image->planes[UHDR_PLANE_PACKED]);
+  const size_t srcStride = image->stride[UHDR_PLANE_PACKED];
+  // the pixels of a sample are contiguous along each row, convert them in runs rather than one
+  // channel at a time
+  constexpr size_t kRunPixels = 16;
+  float rgba[kRunPixels * 4];
+  Color e = {{{0.0f, 0.0f, 0.0f}}};
+  for (size_t dy = 0; dy < map_scale_factor; ++dy) {
+    const uint64_t* row = rgbData + (y * map_scale_factor + dy) * srcStride + x * map_scale_factor;
+    for (size_t dx = 0; dx < map_scale_factor; dx += kRunPixels) {
+      const size_t run = (std::min)(kRunPixels, map_scale_factor - dx);
+      halfToFloatRow(reinterpret_cast<const uint16_t*>(row + dx), rgba, run * 4);
+      for (size_t i = 0; i < run; i++) {
+        Color pixel = {{{rgba[4 * i], rgba[4 * i + 1], rgba[4 * i + 2]}}};
+        e += sanitizePixel(pixel);
+      }
+    }
+  }
+
+  return e / static_cast<float>(map_scale_factor * map_scale_factor);
 }
 
 void putRgba8888Pixel(uhdr_raw_image_t* image, size_t x, size_t y, Color& pixel) {
@@ -632,6 +731,39 @@ Color p3ToBt2100(Color e) { return ConvertGamut(e, kP3ToBt2100); }
 Color bt2100ToBt709(Color e) { return ConvertGamut(e, kBt2100ToBt709); }
 Color bt2100ToP3(Color e) { return ConvertGamut(e, kBt2100ToP3); }
 
+LinearColorPipeline& LinearColorPipeline::append(const std::array<float, 9>& matrix) {
+  std::array<float, 9> product;
+  for (int row = 0; row < 3; row++) {
+    for (int col = 0; col < 3; col++) {
+      product[row * 3 + col] = matrix[row * 3] * mMatrix[col] +
+                               matrix[row * 3 + 1] * mMatrix[3 + col] +
+                               matrix[row * 3 + 2] * mMatrix[6 + col];
+    }
+  }
+  mMatrix = product;
+  return *this;
+}
+
+LinearColorPipeline& LinearColorPipeline::append(ColorTransformFn linearFn) {
+  if (linearFn == identityConversion) return *this;
+  Color columns[3] = {linearFn({{{1.0f, 0.0f, 0.0f}}}), linearFn({{{0.0f, 1.0f, 0.0f}}}),
+                      linearFn({{{0.0f, 0.0f, 1.0f}}})};
+  return append({columns[0].r, columns[1].r, columns[2].r, columns[0].g, columns[1].g,
+                 columns[2].g, columns[0].b, columns[1].b, columns[2].b});
+}
+
+LinearColorPipeline& LinearColorPipeline::append(float scale) {
+  for (auto& coeff : mMatrix) coeff *= scale;
+  return *this;
+}
+
+bool LinearColorPipeline::isIdentity() const {
+  for (int idx = 0; idx < 9; idx++) {
+    if (mMatrix[idx] != (idx % 4 == 0 ? 1.0f : 0.0f)) return false;
+  }
+  return true;
+}
+
 // All of these conversions are derived from the respective input YUV->RGB conversion followed by
 // the RGB->YUV for the receiving encoding. They are consistent with the RGB<->YUV functions in
 // gainmapmath.cpp, given that we use BT.709 encoding for sRGB and BT.601 encoding for Display-P3,
@@ -761,8 +893,21 @@ uint8_t encodeGain(float y_sdr, float y_hdr, uhdr_gainmap_metadata_ext_t* metada
                     log2(metadata->max_content_boost[index]), index);
 }
 
+static inline float gainLog2(float x, bool useFastMath) {
+  return useFastMath ? fastLog2(x) : log2(x);
+}
+
+static inline float gainExp2(float x, bool useFastMath) {
+  return useFastMath ? fastExp2(x) : exp2(x);
+}
+
+static inline float gainPow(float x, float y, bool useFastMath) {
+  return useFastMath ? fastPow(x, y) : pow(x, y);
+}
+
 uint8_t encodeGain(float y_sdr, float y_hdr, uhdr_gainmap_metadata_ext_t* metadata,
-                   float log2MinContentBoost, float log2MaxContentBoost, int index) {
+                   float log2MinContentBoost, float log2MaxContentBoost, int index,
+                   bool useFastMath) {
   float gain = 1.0f;
   if (y_sdr > 0.0f) {
     gain = y_hdr / y_sdr;
@@ -770,14 +915,21 @@ uint8_t encodeGain(float y_sdr, float y_hdr, uhdr_gainmap_metadata_ext_t* metada
 
   if (gain < metadata->min_content_boost[index]) gain = metadata->min_content_boost[index];
   if (gain > metadata->max_content_boost[index]) gain = metadata->max_content_boost[index];
-  float gain_normalized =
-      (log2(gain) - log2MinContentBoost) / (log2MaxContentBoost - log2MinContentBoost);
-  float gain_normalized_gamma = powf(gain_normalized, metadata->gamma[index]);
+  float gain_normalized = (gainLog2(gain, useFastMath) - log2MinContentBoost) /
+                          (log2MaxContentBoost - log2MinContentBoost);
+  float gain_normalized_gamma;
+  if (useFastMath) {
+    gain_normalized_gamma = metadata->gamma[index] != 1.0f
+                                ? fastPow(gain_normalized, metadata->gamma[index])
+                                : gain_normalized;
+  } else {
+    gain_normalized_gamma = powf(gain_normalized, metadata->gamma[index]);
+  }
   return static_cast<uint8_t>(gain_normalized_gamma * 255.0f);
 }
 
-float computeGain(float sdr, float hdr) {
-  float gain = log2((hdr + kHdrOffset) / (sdr + kSdrOffset));
+float computeGain(float sdr, float hdr, bool useFastMath) {
+  float gain = gainLog2((hdr + kHdrOffset) / (sdr + kSdrOffset), useFastMath);
   if (sdr < 2.f / 255.0f) {
     // If sdr is zero and hdr is non zero, it can result in very large gain values. In compression -
     // decompression process, if the same sdr pixel increases to 1, the hdr recovered pixel will
@@ -787,9 +939,12 @@ float computeGain(float sdr, float hdr) {
   return gain;
 }
 
-uint8_t affineMapGain(float gainlog2, float mingainlog2, float maxgainlog2, float gamma) {
+uint8_t affineMapGain(float gainlog2, float mingainlog2, float maxgainlog2, float gamma,
+                      bool useFastMath) {
   float mappedVal = (gainlog2 - mingainlog2) / (maxgainlog2 - mingainlog2);
-  if (gamma != 1.0f) mappedVal = pow(mappedVal, gamma);
+  // gains outside of the range saturate, also keeps pow() away from negative bases
+  mappedVal = CLIP3(mappedVal, 0.0f, 1.0f);
+  if (gamma != 1.0f) mappedVal = gainPow(mappedVal, gamma, useFastMath);
   mappedVal *= 255;
   return CLIP3(mappedVal + 0.5f, 0, 255);
 }
@@ -802,15 +957,17 @@ Color applyGain(Color e, float gain, uhdr_gainmap_metadata_ext_t* metadata) {
   return ((e + metadata->offset_sdr[0]) * gainFactor) - metadata->offset_hdr[0];
 }
 
-Color applyGain(Color e, float gain, uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight) {
-  if (metadata->gamma[0] != 1.0f) gain = pow(gain, 1.0f / metadata->gamma[0]);
-  float logBoost = log2(metadata->min_content_boost[0]) * (1.0f - gain) +
-                   log2(metadata->max_content_boost[0]) * gain;
-  float gainFactor = exp2(logBoost * gainmapWeight);
+Color applyGain(Color e, float gain, uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight,
+                bool useFastMath) {
+  if (metadata->gamma[0] != 1.0f) gain = gainPow(gain, 1.0f / metadata->gamma[0], useFastMath);
+  float logBoost = gainLog2(metadata->min_content_boost[0], useFastMath) * (1.0f - gain) +
+                   gainLog2(metadata->max_content_boost[0], useFastMath) * gain;
+  float gainFactor = gainExp2(logBoost * gainmapWeight, useFastMath);
   return ((e + metadata->offset_sdr[0]) * gainFactor) - metadata->offset_hdr[0];
 }
 
-Color applyGainLUT(Color e, float gain, GainLUT& gainLUT, uhdr_gainmap_metadata_ext_t* metadata) {
+Color applyGainLUT(Color e, float gain, const GainLUT& gainLUT,
+                   uhdr_gainmap_metadata_ext_t* metadata) {
   float gainFactor = gainLUT.getGainFactor(gain, 0);
   return ((e + metadata->offset_sdr[0]) * gainFactor) - metadata->offset_hdr[0];
 }
@@ -833,25 +990,27 @@ Color applyGain(Color e, Color gain, uhdr_gainmap_metadata_ext_t* metadata) {
             ((e.b + metadata->offset_sdr[2]) * gainFactorB) - metadata->offset_hdr[2]}}};
 }
 
-Color applyGain(Color e, Color gain, uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight) {
-  if (metadata->gamma[0] != 1.0f) gain.r = pow(gain.r, 1.0f / metadata->gamma[0]);
-  if (metadata->gamma[1] != 1.0f) gain.g = pow(gain.g, 1.0f / metadata->gamma[1]);
-  if (metadata->gamma[2] != 1.0f) gain.b = pow(gain.b, 1.0f / metadata->gamma[2]);
-  float logBoostR = log2(metadata->min_content_boost[0]) * (1.0f - gain.r) +
-                    log2(metadata->max_content_boost[0]) * gain.r;
-  float logBoostG = log2(metadata->min_content_boost[1]) * (1.0f - gain.g) +
-                    log2(metadata->max_content_boost[1]) * gain.g;
-  float logBoostB = log2(metadata->min_content_boost[2]) * (1.0f - gain.b) +
-                    log2(metadata->max_content_boost[2]) * gain.b;
-  float gainFactorR = exp2(logBoostR * gainmapWeight);
-  float gainFactorG = exp2(logBoostG * gainmapWeight);
-  float gainFactorB = exp2(logBoostB * gainmapWeight);
+Color applyGain(Color e, Color gain, uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight,
+                bool useFastMath) {
+  if (metadata->gamma[0] != 1.0f) gain.r = gainPow(gain.r, 1.0f / metadata->gamma[0], useFastMath);
+  if (metadata->gamma[1] != 1.0f) gain.g = gainPow(gain.g, 1.0f / metadata->gamma[1], useFastMath);
+  if (metadata->gamma[2] != 1.0f) gain.b = gainPow(gain.b, 1.0f / metadata->gamma[2], useFastMath);
+  float logBoostR = gainLog2(metadata->min_content_boost[0], useFastMath) * (1.0f - gain.r) +
+                    gainLog2(metadata->max_content_boost[0], useFastMath) * gain.r;
+  float logBoostG = gainLog2(metadata->min_content_boost[1], useFastMath) * (1.0f - gain.g) +
+                    gainLog2(metadata->max_content_boost[1], useFastMath) * gain.g;
+  float logBoostB = gainLog2(metadata->min_content_boost[2], useFastMath) * (1.0f - gain.b) +
+                    gainLog2(metadata->max_content_boost[2], useFastMath) * gain.b;
+  float gainFactorR = gainExp2(logBoostR * gainmapWeight, useFastMath);
+  float gainFactorG = gainExp2(logBoostG * gainmapWeight, useFastMath);
+  float gainFactorB = gainExp2(logBoostB * gainmapWeight, useFastMath);
   return {{{((e.r + metadata->offset_sdr[0]) * gainFactorR) - metadata->offset_hdr[0],
             ((e.g + metadata->offset_sdr[1]) * gainFactorG) - metadata->offset_hdr[1],
             ((e.b + metadata->offset_sdr[2]) * gainFactorB) - metadata->offset_hdr[2]}}};
 }
 
-Color applyGainLUT(Color e, Color gain, GainLUT& gainLUT, uhdr_gainmap_metadata_ext_t* metadata) {
+Color applyGainLUT(Color e, Color gain, const GainLUT& gainLUT,
+                   uhdr_gainmap_metadata_ext_t* metadata) {
   float gainFactorR = gainLUT.getGainFactor(gain.r, 0);
   float gainFactorG = gainLUT.getGainFactor(gain.g, 1);
   float gainFactorB = gainLUT.getGainFactor(gain.b, 2);
@@ -860,6 +1019,207 @@ Color applyGainLUT(Color e, Color gain, GainLUT& gainLUT, uhdr_gainmap_metadata_
             ((e.b + metadata->offset_sdr[2]) * gainFactorB) - metadata->offset_hdr[2]}}};
 }
 
+Color applyGainLUTFromCode(Color e, uint8_t gain, const GainLUT& gainLUT,
+                           uhdr_gainmap_metadata_ext_t* metadata) {
+  float gainFactor = gainLUT.getGainFactorFromCode(gain, 0);
+  return ((e + metadata->offset_sdr[0]) * gainFactor) - metadata->offset_hdr[0];
+}
+
+Color applyGainLUTFromCode(Color e, const uint8_t* gain, const GainLUT& gainLUT,
+                           uhdr_gainmap_metadata_ext_t* metadata) {
+  float gainFactorR = gainLUT.getGainFactorFromCode(gain[0], 0);
+  float gainFactorG = gainLUT.getGainFactorFromCode(gain[1], 1);
+  float gainFactorB = gainLUT.getGainFactorFromCode(gain[2], 2);
+  return {{{((e.r + metadata->offset_sdr[0]) * gainFactorR) - metadata->offset_hdr[0],
+            ((e.g + metadata->offset_sdr[1]) * gainFactorG) - metadata->offset_hdr[1],
+            ((e.b + metadata->offset_sdr[2]) * gainFactorB) - metadata->offset_hdr[2]}}};
+}
+
+GainTable2D::GainTable2D(uhdr_gainmap_metadata_ext_t* metadata, float gainmapWeight,
+                         uhdr_color_transfer_t outputCt)
+    : mTable(new uint16_t[kGainTable2DSdrEntries * kGainTable2DGainEntries]) {
+  float sdrLinear[kGainTable2DSdrEntries];
+  for (int32_t idx = 0; idx < kGainTable2DSdrEntries; idx++) {
+    sdrLinear[idx] = srgbInvOetf(static_cast<float>(idx) / (kGainTable2DSdrEntries - 1)) +
+                     metadata->offset_sdr[0];
+  }
+  float gainFactor[kGainTable2DGainEntries];
+  float gammaInv = 1.0f / metadata->gamma[0];
+  for (int32_t idx = 0; idx < kGainTable2DGainEntries; idx++) {
+    float value = static_cast<float>(idx) / (kGainTable2DGainEntries - 1);
+    if (gammaInv != 1.0f) value = pow(value, gammaInv);
+    float logBoost = log2(metadata->min_content_boost[0]) * (1.0f - value) +
+                     log2(metadata->max_content_boost[0]) * value;
+    gainFactor[idx] = exp2(logBoost * gainmapWeight);
+  }
+  const bool isHlg = outputCt == UHDR_CT_HLG;
+  const float scale = kSdrWhiteNits / (isHlg ? kHlgMaxNits : kPqMaxNits);
+  for (int32_t j = 0; j < kGainTable2DGainEntries; j++) {
+    uint16_t* row = mTable.get() + j * kGainTable2DSdrEntries;
+    for (int32_t i = 0; i < kGainTable2DSdrEntries; i++) {
+      float hdr = (sdrLinear[i] * gainFactor[j] - metadata->offset_hdr[0]) * scale;
+      hdr = clampPixelFloat(hdr);
+      float hdrGamma = isHlg ? hlgOetf(std::pow(hdr, 1.0f / kOotfGamma)) : pqOetf(hdr);
+      row[i] = static_cast<uint16_t>(CLIP3((hdrGamma * 1023 + 0.5f), 0.0f, 1023.0f));
+    }
+  }
+}
+
+static TableCache<std::array<float, 7>, GainTable2D> gGainTable2DCache(kGainTable2DCacheSize);
+
+std::shared_ptr<const GainTable2D> getGainTable2D(uhdr_gainmap_metadata_ext_t* metadata,
+                                                  float gainmapWeight,
+                                                  uhdr_color_transfer_t outputCt) {
+  std::array<float, 7> key = {metadata->min_content_boost[0],
+                              metadata->max_content_boost[0],
+                              metadata->gamma[0],
+                              metadata->offset_sdr[0],
+                              metadata->offset_hdr[0],
+                              gainmapWeight,
+                              static_cast<float>(outputCt)};
+  return gGainTable2DCache.get(key, [metadata, gainmapWeight, outputCt] {
+    return new GainTable2D(metadata, gainmapWeight, outputCt);
+  });
+}
+
+void clearTableCaches() {
+  gShepardsIDWCache.clear();
+  gGainLUTCache.clear();
+  gGainTable2DCache.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixed point gain map application
+
+static constexpr int32_t kSdrIndexMax = (1 << kFixedPointSdrIndexBits) - 1;
+static constexpr int32_t kLinearOne = 1 << 24;  // 1.0 in Q24
+
+// BT.601 YCbCr->RGB coefficients of p3YuvToRgb(), scaled from 8-bit code units to sdr linearization
+// table index units, in Q12
+static constexpr double kCodeToSdrIndex = static_cast<double>(kSdrIndexMax) / 255.0 * 4096.0;
+static constexpr int32_t kYToSdrIndexQ12 = static_cast<int32_t>(kCodeToSdrIndex + 0.5);
+static constexpr int32_t kCrToRQ12 = static_cast<int32_t>(1.402 * kCodeToSdrIndex + 0.5);
+static constexpr int32_t kCbToGQ12 =
+    static_cast<int32_t>(0.114 * 1.772 / 0.587 * kCodeToSdrIndex + 0.5);
+static constexpr int32_t kCrToGQ12 =
+    static_cast<int32_t>(0.299 * 1.402 / 0.587 * kCodeToSdrIndex + 0.5);
+static constexpr int32_t kCbToBQ12 = static_cast<int32_t>(1.772 * kCodeToSdrIndex + 0.5);
+
+static inline int32_t floorLog2(uint32_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 31 - __builtin_clz(value);
+#else
+  int32_t result = 0;
+  while (value >>= 1) result++;
+  return result;
+#endif
+}
+
+// index of value (Q24, in range [0, 1 << 24]) on the semi-logarithmic oetf table scale. Values
+// below 1 << kFixedPointOetfMantissaBits index the table directly, larger values by their exponent
+// and top mantissa bits.
+static inline int32_t getOetfIndex(uint32_t value) {
+  constexpr int32_t kMantissaBits = kFixedPointOetfMantissaBits;
+  if (value < (1u << kMantissaBits)) return static_cast<int32_t>(value);
+  int32_t exponent = floorLog2(value);
+  return ((exponent - kMantissaBits + 1) << kMantissaBits) +
+         static_cast<int32_t>(value >> (exponent - kMantissaBits)) - (1 << kMantissaBits);
+}
+
+// Q14 matrix of a (linear) gamut conversion, returns false if it is the identity
+static bool getGamutMatrixQ14(ColorTransformFn gamutConversionFn, int32_t* matrix) {
+  LinearColorPipeline pipeline;
+  pipeline.append(gamutConversionFn);
+  for (int idx = 0; idx < 9; idx++) {
+    matrix[idx] = static_cast<int32_t>(std::lround(pipeline.getMatrix()[idx] * (1 << 14)));
+  }
+  return !pipeline.isIdentity();
+}
+
+static inline void applyMatrixQ14(const int32_t* m, int64_t& r, int64_t& g, int64_t& b) {
+  int64_t r1 = (m[0] * r + m[1] * g + m[2] * b + (1 << 13)) >> 14;
+  int64_t g1 = (m[3] * r + m[4] * g + m[5] * b + (1 << 13)) >> 14;
+  int64_t b1 = (m[6] * r + m[7] * g + m[8] * b + (1 << 13)) >> 14;
+  r = r1;
+  g = g1;
+  b = b1;
+}
+
+FixedPointGainMapApplier::FixedPointGainMapApplier(uhdr_gainmap_metadata_ext_t* metadata,
+                                                   float gainmapWeight,
+                                                   uhdr_color_transfer_t outputCt,
+                                                   ColorTransformFn sdrGamutConversionFn,
+                                                   ColorTransformFn hdrGamutConversionFn) {
+  const bool isHlg = outputCt == UHDR_CT_HLG;
+  const float scale = kSdrWhiteNits / (isHlg ? kHlgMaxNits : kPqMaxNits);
+
+  for (int32_t idx = 0; idx <= kSdrIndexMax; idx++) {
+    float value = srgbInvOetf(static_cast<float>(idx) / kSdrIndexMax);
+    mSdrLinear[idx] = static_cast<int32_t>(std::lround(value * kLinearOne));
+  }
+  for (int c = 0; c < 3; c++) {
+    float gammaInv = 1.0f / metadata->gamma[c];
+    for (int32_t idx = 0; idx < kGainFactorNumEntries; idx++) {
+      float value = static_cast<float>(idx) / static_cast<float>(kGainFactorNumEntries - 1);
+      if (gammaInv != 1.0f) value = pow(value, gammaInv);
+      float logBoost = log2(metadata->min_content_boost[c]) * (1.0f - value) +
+                       log2(metadata->max_content_boost[c]) * value;
+      mGainFactor[c][idx] =
+          static_cast<int32_t>(std::lround(exp2(logBoost * gainmapWeight) * scale * 65536.0f));
+    }
+    mOffsetSdr[c] = static_cast<int32_t>(std::lround(metadata->offset_sdr[c] * kLinearOne));
+    mOffsetHdr[c] =
+        static_cast<int32_t>(std::lround(metadata->offset_hdr[c] * scale * kLinearOne));
+  }
+  mHasSdrMatrix = getGamutMatrixQ14(sdrGamutConversionFn, mSdrMatrix);
+  mHasHdrMatrix = getGamutMatrixQ14(hdrGamutConversionFn, mHdrMatrix);
+
+  // each table entry holds the output code at the center of the value range that maps to it
+  constexpr int32_t kMantissaBits = kFixedPointOetfMantissaBits;
+  mOetf.resize(getOetfIndex(kLinearOne) + 1);
+  for (size_t idx = 0; idx < mOetf.size(); idx++) {
+    double value;
+    if (idx < (1u << kMantissaBits)) {
+      value = static_cast<double>(idx);
+    } else {
+      int32_t exponent = static_cast<int32_t>(idx >> kMantissaBits) + kMantissaBits - 1;
+      int32_t mantissa = static_cast<int32_t>(idx & ((1 << kMantissaBits) - 1));
+      value = ((1 << kMantissaBits) + mantissa + 0.5) * std::ldexp(1.0, exponent - kMantissaBits);
+    }
+    float e = static_cast<float>((std::min)(value / kLinearOne, 1.0));
+    float e_gamma = isHlg ? hlgOetf(std::pow(e, 1.0f / kOotfGamma)) : pqOetf(e);
+    mOetf[idx] = static_cast<uint16_t>(CLIP3((e_gamma * 1023 + 0.5f), 0.0f, 1023.0f));
+  }
+}
+
+uint32_t FixedPointGainMapApplier::toHdrCode(int64_t value) const {
+  value = CLIP3(value, static_cast<int64_t>(0), static_cast<int64_t>(kLinearOne));
+  return mOetf[getOetfIndex(static_cast<uint32_t>(value))];
+}
+
+uint32_t FixedPointGainMapApplier::apply(uint8_t y, uint8_t u, uint8_t v, int32_t gainIdxR,
+                                         int32_t gainIdxG, int32_t gainIdxB) const {
+  const int32_t cb = u - 128;
+  const int32_t cr = v - 128;
+  const int32_t luma = y * kYToSdrIndexQ12 + (1 << 11);
+  int32_t rIdx = (luma + kCrToRQ12 * cr) >> 12;
+  int32_t gIdx = (luma - kCbToGQ12 * cb - kCrToGQ12 * cr) >> 12;
+  int32_t bIdx = (luma + kCbToBQ12 * cb) >> 12;
+  int64_t r = mSdrLinear[CLIP3(rIdx, 0, kSdrIndexMax)];
+  int64_t g = mSdrLinear[CLIP3(gIdx, 0, kSdrIndexMax)];
+  int64_t b = mSdrLinear[CLIP3(bIdx, 0, kSdrIndexMax)];
+
+  if (mHasSdrMatrix) applyMatrixQ14(mSdrMatrix, r, g, b);
+
+  r = (((r + mOffsetSdr[0]) * mGainFactor[0][gainIdxR] + (1 << 15)) >> 16) - mOffsetHdr[0];
+  g = (((g + mOffsetSdr[1]) * mGainFactor[1][gainIdxG] + (1 << 15)) >> 16) - mOffsetHdr[1];
+  b = (((b + mOffsetSdr[2]) * mGainFactor[2][gainIdxB] + (1 << 15)) >> 16) - mOffsetHdr[2];
+
+  if (mHasHdrMatrix) applyMatrixQ14(mHdrMatrix, r, g, b);
+
+  return toHdrCode(r) | (toHdrCode(g) << 10) | (toHdrCode(b) << 20) | (0x3u << 30);
+}
+
 // TODO: do we need something more clever for filtering either the map or images
 // to generate the map?
 
@@ -924,7 +1284,7 @@ float sampleMap(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t
 }
 
 float sampleMap(uhdr_raw_image_t* map, size_t map_scale_factor, size_t x, size_t y,
-                ShepardsIDW& weightTables) {
+                const ShepardsIDW& weightTables) {
   // TODO: If map_scale_factor is guaranteed to be an integer power of 2, then optimize the
   // following by computing log2(map_scale_factor) once and then using >> log2(map_scale_factor)
   size_t x_lower = x / map_scale_factor;
@@ -1030,7 +1390,7 @@ Color sampleMap3Channel(uhdr_raw_image_t* map, float map_scale_factor, size_t x,
 }
 
 Color sampleMap3Channel(uhdr_raw_image_t* map, size_t map_scale_factor, size_t x, size_t y,
-                        ShepardsIDW& weightTables, bool has_alpha) {
+                        const ShepardsIDW& weightTables, bool has_alpha) {
   // TODO: If map_scale_factor is guaranteed to be an integer power of 2, then optimize the
   // following by computing log2(map_scale_factor) once and then using >> log2(map_scale_factor)
   size_t x_lower = x / map_scale_factor;
@@ -1085,6 +1445,192 @@ Color sampleMap3Channel(uhdr_raw_image_t* map, size_t map_scale_factor, size_t x
   return rgb1 * weights[0] + rgb2 * weights[1] + rgb3 * weights[2] + rgb4 * weights[3];
 }
 
+uint8_t sampleMapNearestCode(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t y) {
+  size_t x_map = static_cast<size_t>(static_cast<float>(x) / map_scale_factor);
+  size_t y_map = static_cast<size_t>(static_cast<float>(y) / map_scale_factor);
+
+  x_map = std::min(x_map, (size_t)map->w - 1);
+  y_map = std::min(y_map, (size_t)map->h - 1);
+
+  uint8_t* data = reinterpret_cast<uint8_t*>(map->planes[UHDR_PLANE_Y]);
+  size_t stride = map->stride[UHDR_PLANE_Y];
+
+  return data[x_map + y_map * stride];
+}
+
+const uint8_t* sampleMap3ChannelNearestCode(uhdr_raw_image_t* map, float map_scale_factor,
+                                            size_t x, size_t y, bool has_alpha) {
+  size_t x_map = static_cast<size_t>(static_cast<float>(x) / map_scale_factor);
+  size_t y_map = static_cast<size_t>(static_cast<float>(y) / map_scale_factor);
+
+  x_map = std::min(x_map, (size_t)map->w - 1);
+  y_map = std::min(y_map, (size_t)map->h - 1);
+
+  int factor = has_alpha ? 4 : 3;
+
+  uint8_t* data = reinterpret_cast<uint8_t*>(map->planes[UHDR_PLANE_PACKED]);
+  size_t stride = map->stride[UHDR_PLANE_PACKED];
+  return data + (x_map + y_map * stride) * factor;
+}
+
+float sampleMapNearest(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t y) {
+  return mapUintToFloat(sampleMapNearestCode(map, map_scale_factor, x, y));
+}
+
+Color sampleMap3ChannelNearest(uhdr_raw_image_t* map, float map_scale_factor, size_t x, size_t y,
+                               bool has_alpha) {
+  const uint8_t* pixel = sampleMap3ChannelNearestCode(map, map_scale_factor, x, y, has_alpha);
+  return {{{mapUintToFloat(pixel[0]), mapUintToFloat(pixel[1]), mapUintToFloat(pixel[2])}}};
+}
+
+GainMapRowSampler::GainMapRowSampler(uhdr_raw_image_t* map, float map_scale_factor, size_t out_w)
+    : mMap(map),
+      mMapScaleFactor(map_scale_factor),
+      mIntScaleFactor(0),
+      mOutWidth(out_w),
+      mChannels(map->fmt == UHDR_IMG_FMT_8bppYCbCr400 ? 1 : 3),
+      mColumn0(out_w),
+      mColumn1(out_w),
+      mRowTag{SIZE_MAX, SIZE_MAX},
+      mWeights(out_w * 4),
+      mWeightTag(SIZE_MAX) {
+  // integer scale factors repeat the same weights every map_scale_factor columns and rows, take
+  // them from the shared tables. Other scale factors compute them as sampleMap() does
+  if (map_scale_factor == floorf(map_scale_factor)) {
+    mIntScaleFactor = (size_t)map_scale_factor;
+    mIdwTable = getShepardsIDW((int)mIntScaleFactor);
+  } else {
+    mDistX0.resize(out_w);
+    mDistX1.resize(out_w);
+  }
+  for (size_t x = 0; x < out_w; x++) {
+    float x_map = static_cast<float>(x) / map_scale_factor;
+    size_t x_lower = mIdwTable ? x / mIntScaleFactor : static_cast<size_t>(floor(x_map));
+    size_t x_upper = std::min(x_lower + 1, (size_t)map->w - 1);
+    x_lower = std::min(x_lower, (size_t)map->w - 1);
+    mColumn0[x] = (uint32_t)x_lower * mChannels;
+    mColumn1[x] = (uint32_t)x_upper * mChannels;
+    if (!mIdwTable) {
+      mDistX0[x] = x_map - static_cast<float>(x_lower);
+      mDistX1[x] = x_map - static_cast<float>(x_upper);
+    }
+  }
+  mLine.resize((size_t)map->w * mChannels);
+  for (int i = 0; i < 2; i++) mRows[i].resize(out_w * 2 * mChannels);
+  mOut.resize(out_w * mChannels);
+}
+
+int GainMapRowSampler::expandRow(size_t map_y, int keep_slot) {
+  for (int i = 0; i < 2; i++) {
+    if (mRowTag[i] == map_y) return i;
+  }
+  const int slot = keep_slot == 0 ? 1 : 0;
+
+  float* line = mLine.data();
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(mMap->planes[UHDR_PLANE_PACKED]);
+  if (mChannels == 1) {
+    data += map_y * mMap->stride[UHDR_PLANE_Y];
+    for (size_t i = 0; i < mMap->w; i++) line[i] = mapUintToFloat(data[i]);
+  } else {
+    const int factor = mMap->fmt == UHDR_IMG_FMT_32bppRGBA8888 ? 4 : 3;
+    data += map_y * mMap->stride[UHDR_PLANE_PACKED] * factor;
+    for (size_t i = 0; i < mMap->w; i++) {
+      line[i * 3] = mapUintToFloat(data[i * factor]);
+      line[i * 3 + 1] = mapUintToFloat(data[i * factor + 1]);
+      line[i * 3 + 2] = mapUintToFloat(data[i * factor + 2]);
+    }
+  }
+
+  // the left and right map samples of each output column, side by side
+  float* out = mRows[slot].data();
+  const int ch = mChannels;
+  for (size_t x = 0; x < mOutWidth; x++) {
+    for (int c = 0; c < ch; c++) {
+      out[x * 2 * ch + c] = line[mColumn0[x] + c];
+      out[x * 2 * ch + ch + c] = line[mColumn1[x] + c];
+    }
+  }
+  mRowTag[slot] = map_y;
+  return slot;
+}
+
+void GainMapRowSampler::expandWeights(size_t y, size_t y_lower, size_t y_upper) {
+  float* w = mWeights.data();
+  if (mIdwTable) {
+    // rows of the same phase share their weights, the last map row has no lower neighbour
+    const size_t phase = y % mIntScaleFactor;
+    const size_t tag = phase * 2 + (y_lower == y_upper ? 1 : 0);
+    if (tag == mWeightTag) return;
+    const size_t offset = phase * mIntScaleFactor * 4;
+    // index 0 for interior columns, 1 for the last map column which has no right neighbour
+    const float* tableRow[2] = {
+        (y_lower == y_upper ? mIdwTable->mWeightsNB : mIdwTable->mWeights) + offset,
+        (y_lower == y_upper ? mIdwTable->mWeightsC : mIdwTable->mWeightsNR) + offset};
+    for (size_t x = 0, col = 0; x < mOutWidth; x++) {
+      const float* t = tableRow[mColumn0[x] == mColumn1[x] ? 1 : 0] + col * 4;
+      w[x * 4] = t[0], w[x * 4 + 1] = t[1], w[x * 4 + 2] = t[2], w[x * 4 + 3] = t[3];
+      if (++col == mIntScaleFactor) col = 0;
+    }
+    mWeightTag = tag;
+    return;
+  }
+
+  float y_map = static_cast<float>(y) / mMapScaleFactor;
+  const float dist_y0 = y_map - static_cast<float>(y_lower);
+  const float dist_y1 = y_map - static_cast<float>(y_upper);
+  for (size_t x = 0; x < mOutWidth; x++) {
+    const float d[4] = {pythDistance(mDistX0[x], dist_y0), pythDistance(mDistX0[x], dist_y1),
+                        pythDistance(mDistX1[x], dist_y0), pythDistance(mDistX1[x], dist_y1)};
+    int exact = -1;
+    for (int i = 0; i < 4 && exact < 0; i++) {
+      if (d[i] == 0.0f) exact = i;
+    }
+    if (exact >= 0) {
+      for (int i = 0; i < 4; i++) w[x * 4 + i] = i == exact ? 1.0f : 0.0f;
+    } else {
+      const float w1 = 1.0f / d[0], w2 = 1.0f / d[1], w3 = 1.0f / d[2], w4 = 1.0f / d[3];
+      const float total = w1 + w2 + w3 + w4;
+      w[x * 4] = w1 / total, w[x * 4 + 1] = w2 / total;
+      w[x * 4 + 2] = w3 / total, w[x * 4 + 3] = w4 / total;
+    }
+  }
+}
+
+// e1 (lower, lower), e2 (lower, upper), e3 (upper, lower), e4 (upper, upper) as in sampleMap(),
+// with the channel count fixed the loop carries no branches and is left to the auto vectorizer
+template <int ch>
+static void blendRowIDW(const float* row0, const float* row1, const float* weights, float* out,
+                        size_t out_w) {
+  for (size_t x = 0; x < out_w; x++) {
+    const float* e13 = row0 + x * 2 * ch;
+    const float* e24 = row1 + x * 2 * ch;
+    const float* w = weights + x * 4;
+    for (int c = 0; c < ch; c++) {
+      out[x * ch + c] = e13[c] * w[0] + e24[c] * w[1] + e13[ch + c] * w[2] + e24[ch + c] * w[3];
+    }
+  }
+}
+
+const float* GainMapRowSampler::sampleRow(size_t y) {
+  float y_map = static_cast<float>(y) / mMapScaleFactor;
+  size_t y_lower = mIdwTable ? y / mIntScaleFactor : static_cast<size_t>(floor(y_map));
+  size_t y_upper = std::min(y_lower + 1, (size_t)mMap->h - 1);
+  y_lower = std::min(y_lower, (size_t)mMap->h - 1);
+
+  const int slot0 = expandRow(y_lower, -1);
+  const int slot1 = expandRow(y_upper, slot0);
+  expandWeights(y, y_lower, y_upper);
+
+  if (mChannels == 1) {
+    blendRowIDW<1>(mRows[slot0].data(), mRows[slot1].data(), mWeights.data(), mOut.data(),
+                   mOutWidth);
+  } else {
+    blendRowIDW<3>(mRows[slot0].data(), mRows[slot1].data(), mWeights.data(), mOut.data(),
+                   mOutWidth);
+  }
+  return mOut.data();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // function selectors
 
@@ -1190,6 +1736,17 @@ ColorTransformFn getInverseOetfFn(uhdr_color_transfer_t transfer) {
   return nullptr;
 }
 
+const float* getInverseOetfCodeTable(uhdr_color_transfer_t transfer, uhdr_img_fmt_t format) {
+  if (format == UHDR_IMG_FMT_32bppRGBA8888 && transfer == UHDR_CT_SRGB) {
+    return srgbInvOetfCodeTable();
+  }
+  if (format == UHDR_IMG_FMT_32bppRGBA1010102) {
+    if (transfer == UHDR_CT_HLG) return hlgInvOetfCodeTable();
+    if (transfer == UHDR_CT_PQ) return pqInvOetfCodeTable();
+  }
+  return nullptr;
+}
+
 SceneToDisplayLuminanceFn getOotfFn(uhdr_color_transfer_t transfer) {
   switch (transfer) {
     case UHDR_CT_LINEAR:
@@ -173,7 +173,7 @@ static uhdr_img_fmt_t getOutputSamplingFormat(const j_decompress_ptr cinfo) {
 }
 
 uhdr_error_info_t JpegDecoderHelper::decompressImage(const void* image, size_t length,
-                                                     decode_mode_t mode) {
+                                                     decode_mode_t mode, unsigned int scale_denom) {
   if (image == nullptr) {
     uhdr_error_info_t status;
     status.error_code = UHDR_CODEC_INVALID_PARAM;
@@ -188,6 +188,23 @@ uhdr_error_info_t JpegDecoderHelper::decompressImage(const void* image, size_t l
     snprintf(status.detail, sizeof status.detail, "received bad compressed image size %zd", length);
     return status;
   }
+  if (scale_denom != 1 && scale_denom != 2 && scale_denom != 4 && scale_denom != 8) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "received bad scale denominator %u, expects one of {1, 2, 4, 8}", scale_denom);
+    return status;
+  }
+  if (scale_denom != 1 && mode != DECODE_TO_RGB_CS) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_UNSUPPORTED_FEATURE;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "dct scaling is supported only for decode mode DECODE_TO_RGB_CS, received mode %d",
+             mode);
+    return status;
+  }
 
   // reset context
   mResultBuffer.clear();
@@ -206,10 +223,11 @@ uhdr_error_info_t JpegDecoderHelper::decompressImage(const void* image, size_t l
   }
   mExifPayLoadOffset = -1;
 
-  return decode(image, length, mode);
+  return decode(image, length, mode, scale_denom);
 }
 
-uhdr_error_info_t JpegDecoderHelper::decode(const void* image, size_t length, decode_mode_t mode) {
+uhdr_error_info_t JpegDecoderHelper::decode(const void* image, size_t length, decode_mode_t mode,
+                                            unsigned int scale_denom) {
   jpeg_source_mgr_impl mgr(static_cast<const uint8_t*>(image), length);
   jpeg_decompress_struct cinfo;
   jpeg_error_mgr_impl myerr;
@@ -313,6 +331,8 @@ uhdr_error_info_t JpegDecoderHelper::decode(const void* image, size_t length, de
     }
 
     mNumComponents = cinfo.num_components;
+    mMcuWidth = DCTSIZE * cinfo.max_h_samp_factor;
+    mMcuHeight = DCTSIZE * cinfo.max_v_samp_factor;
     for (int i = 0; i < cinfo.num_components; i++) {
       mPlaneWidth[i] = std::ceil(((float)cinfo.image_width * cinfo.comp_info[i].h_samp_factor) /
                                  cinfo.max_h_samp_factor);
@@ -366,8 +386,20 @@ uhdr_error_info_t JpegDecoderHelper::decode(const void* image, size_t length, de
         jpeg_destroy_decompress(&cinfo);
         return status;
       }
-      mPlaneHStride[0] = cinfo.image_width;
-      mPlaneVStride[0] = cinfo.image_height;
+      if (scale_denom != 1) {
+        // dct scaling, the idct of each block is computed at reduced size. This skips most of the
+        // idct and upsampling work when only a downscaled version of the image is needed.
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = scale_denom;
+        jpeg_calc_output_dimensions(&cinfo);
+        mPlaneWidth[0] = cinfo.output_width;
+        mPlaneHeight[0] = cinfo.output_height;
+        mPlaneHStride[0] = cinfo.output_width;
+        mPlaneVStride[0] = cinfo.output_height;
+      } else {
+        mPlaneHStride[0] = cinfo.image_width;
+        mPlaneVStride[0] = cinfo.image_height;
+      }
       for (int i = 1; i < kMaxNumComponents; i++) {
         mPlaneHStride[i] = 0;
         mPlaneVStride[i] = 0;
@@ -399,7 +431,8 @@ uhdr_error_info_t JpegDecoderHelper::decode(const void* image, size_t length, de
       cinfo.out_color_space = cinfo.jpeg_color_space;
       cinfo.raw_data_out = TRUE;
     }
-    cinfo.dct_method = JDCT_ISLOW;
+    cinfo.dct_method = mUseFastIdct ? JDCT_IFAST : JDCT_ISLOW;
+    cinfo.do_fancy_upsampling = mFancyUpsampling ? TRUE : FALSE;
     jpeg_start_decompress(&cinfo);
     status = decode(&cinfo, static_cast<uint8_t*>(mResultBuffer.data()));
     if (status.error_code != UHDR_CODEC_OK) {
@@ -452,7 +485,7 @@ uhdr_error_info_t JpegDecoderHelper::decode(jpeg_decompress_struct* cinfo, uint8
 uhdr_error_info_t JpegDecoderHelper::decodeToCSRGB(jpeg_decompress_struct* cinfo, uint8_t* dest) {
   JSAMPLE* out = (JSAMPLE*)dest;
 
-  while (cinfo->output_scanline < cinfo->image_height) {
+  while (cinfo->output_scanline < cinfo->output_height) {
     JDIMENSION read_lines = jpeg_read_scanlines(cinfo, &out, 1);
     if (1 != read_lines) {
       uhdr_error_info_t status;
@@ -17,6 +17,7 @@
 #include <errno.h>
 #include <setjmp.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <map>
@@ -104,6 +105,21 @@ static void outputErrorMessage(j_common_ptr cinfo) {
   ALOGE("%s\n", buffer);
 }
 
+/* write icc and comment markers, must be called after the file header is emitted */
+static void writeMarkers(j_compress_ptr cinfo, bool isGainMapImg, const void* iccBuffer,
+                         const size_t iccSize) {
+  if (iccBuffer != nullptr && iccSize > 0) {
+    jpeg_write_marker(cinfo, JPEG_APP0 + 2, static_cast<const JOCTET*>(iccBuffer), iccSize);
+  }
+  if (isGainMapImg) {
+    char comment[255];
+    snprintf(comment, sizeof comment,
+             "Source: google libuhdr v%s, Coder: libjpeg v%d, Attrib: GainMap Image",
+             UHDR_LIB_VERSION_STR, JPEG_LIB_VERSION);
+    jpeg_write_marker(cinfo, JPEG_COM, reinterpret_cast<JOCTET*>(comment), strlen(comment));
+  }
+}
+
 uhdr_error_info_t JpegEncoderHelper::compressImage(const uhdr_raw_image_t* img, const int qfactor,
                                                    const void* iccBuffer, const size_t iccSize) {
   const uint8_t* planes[3]{reinterpret_cast<uint8_t*>(img->planes[UHDR_PLANE_Y]),
@@ -122,6 +138,328 @@ uhdr_error_info_t JpegEncoderHelper::compressImage(const uint8_t* planes[3],
   return encode(planes, strides, width, height, format, qfactor, iccBuffer, iccSize);
 }
 
+uhdr_error_info_t JpegEncoderHelper::cacheCoefficients(const uhdr_raw_image_t* img) {
+  // At quality 100 all quantization table entries are 1, so the coefficients recovered from the
+  // entropy coded stream are the forward dct outputs rounded to integers. Re-quantizing them at
+  // a lower quality matches a direct encode to within rounding.
+  mCoeffNumComponents = 0;
+  UHDR_ERR_CHECK(compressImage(img, 100, nullptr, 0));
+
+  jpeg_decompress_struct dinfo;
+  jpeg_error_mgr_impl myerr;
+  uhdr_error_info_t status = g_no_error;
+
+  dinfo.err = jpeg_std_error(&myerr);
+  myerr.error_exit = jpegrerror_exit;
+  myerr.output_message = outputErrorMessage;
+
+  if (0 == setjmp(myerr.setjmp_buffer)) {
+    jpeg_create_decompress(&dinfo);
+    jpeg_mem_src(&dinfo, mDestMgr.mResultBuffer.data(), mDestMgr.mResultBuffer.size());
+    jpeg_read_header(&dinfo, TRUE);
+    jvirt_barray_ptr* coefArrays = jpeg_read_coefficients(&dinfo);
+    for (int ci = 0; ci < dinfo.num_components; ci++) {
+      jpeg_component_info* comp = &dinfo.comp_info[ci];
+      // virtual arrays are padded to a multiple of the mcu dimensions
+      mCoeffBlocksWidth[ci] = ALIGNM(comp->width_in_blocks, comp->h_samp_factor);
+      mCoeffBlocksHeight[ci] = ALIGNM(comp->height_in_blocks, comp->v_samp_factor);
+      mCoeffs[ci].resize((size_t)mCoeffBlocksWidth[ci] * mCoeffBlocksHeight[ci] * DCTSIZE2);
+      for (unsigned int by = 0; by < mCoeffBlocksHeight[ci]; by++) {
+        JBLOCKARRAY rows = (*dinfo.mem->access_virt_barray)((j_common_ptr)&dinfo, coefArrays[ci],
+                                                            by, 1, FALSE);
+        memcpy(&mCoeffs[ci][(size_t)by * mCoeffBlocksWidth[ci] * DCTSIZE2], rows[0],
+               mCoeffBlocksWidth[ci] * sizeof(JBLOCK));
+      }
+    }
+    mCoeffNumComponents = dinfo.num_components;
+    jpeg_finish_decompress(&dinfo);
+  } else {
+    status.error_code = UHDR_CODEC_ERROR;
+    status.has_detail = 1;
+    dinfo.err->format_message((j_common_ptr)&dinfo, status.detail);
+  }
+  jpeg_destroy_decompress(&dinfo);
+  mDestMgr.mResultBuffer.clear();
+  if (status.error_code != UHDR_CODEC_OK) return status;
+
+  mCoeffFormat = img->fmt;
+  mCoeffWidth = img->w;
+  mCoeffHeight = img->h;
+  return status;
+}
+
+uhdr_error_info_t JpegEncoderHelper::compressCachedCoefficients(const int qfactor,
+                                                                const void* iccBuffer,
+                                                                const size_t iccSize) {
+  uhdr_error_info_t status = g_no_error;
+
+  if (mCoeffNumComponents == 0) {
+    status.error_code = UHDR_CODEC_INVALID_OPERATION;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "no cached coefficients available, call cacheCoefficients() first");
+    return status;
+  }
+  if (qfactor < 1 || qfactor > 100) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "invalid quality factor %d, expects in range [1-100]", qfactor);
+    return status;
+  }
+  std::vector<int>& factors = sample_factors.find(mCoeffFormat)->second;
+
+  jpeg_compress_struct cinfo;
+  jpeg_error_mgr_impl myerr;
+
+  cinfo.err = jpeg_std_error(&myerr);
+  myerr.error_exit = jpegrerror_exit;
+  myerr.output_message = outputErrorMessage;
+
+  if (0 == setjmp(myerr.setjmp_buffer)) {
+    jpeg_create_compress(&cinfo);
+
+    // initialize destination manager
+    mDestMgr.init_destination = &initDestination;
+    mDestMgr.empty_output_buffer = &emptyOutputBuffer;
+    mDestMgr.term_destination = &terminateDestination;
+    mDestMgr.mResultBuffer.clear();
+    cinfo.dest = reinterpret_cast<struct jpeg_destination_mgr*>(&mDestMgr);
+
+    // initialize configuration parameters, these must match the ones used by cacheCoefficients()
+    cinfo.image_width = mCoeffWidth;
+    cinfo.image_height = mCoeffHeight;
+    cinfo.input_components = mCoeffNumComponents;
+    cinfo.in_color_space = mCoeffFormat == UHDR_IMG_FMT_24bppRGB888 ? JCS_RGB
+                           : mCoeffNumComponents == 1               ? JCS_GRAYSCALE
+                                                                    : JCS_YCbCr;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, qfactor, TRUE);
+    cinfo.optimize_coding = mOptimizeCoding ? TRUE : FALSE;
+    jvirt_barray_ptr coefArrays[kMaxNumComponents];
+    for (int i = 0; i < cinfo.num_components; i++) {
+      cinfo.comp_info[i].h_samp_factor = factors[i * 2];
+      cinfo.comp_info[i].v_samp_factor = factors[i * 2 + 1];
+      coefArrays[i] = (*cinfo.mem->request_virt_barray)(
+          (j_common_ptr)&cinfo, JPOOL_IMAGE, TRUE, mCoeffBlocksWidth[i], mCoeffBlocksHeight[i],
+          cinfo.comp_info[i].v_samp_factor);
+    }
+
+    jpeg_write_coefficients(&cinfo, coefArrays);
+    writeMarkers(&cinfo, mCoeffFormat == UHDR_IMG_FMT_8bppYCbCr400 ||
+                             mCoeffFormat == UHDR_IMG_FMT_24bppRGB888,
+                 iccBuffer, iccSize);
+
+    // re-quantize
+    for (int ci = 0; ci < cinfo.num_components; ci++) {
+      const UINT16* qtbl = cinfo.quant_tbl_ptrs[cinfo.comp_info[ci].quant_tbl_no]->quantval;
+      const JCOEF* src = mCoeffs[ci].data();
+      for (unsigned int by = 0; by < mCoeffBlocksHeight[ci]; by++) {
+        JBLOCKARRAY rows = (*cinfo.mem->access_virt_barray)((j_common_ptr)&cinfo, coefArrays[ci],
+                                                            by, 1, TRUE);
+        for (unsigned int bx = 0; bx < mCoeffBlocksWidth[ci]; bx++, src += DCTSIZE2) {
+          JCOEF* dst = rows[0][bx];
+          for (int k = 0; k < DCTSIZE2; k++) {
+            int q = qtbl[k];
+            int c = src[k];
+            dst[k] = (JCOEF)(c >= 0 ? (c + (q >> 1)) / q : -((-c + (q >> 1)) / q));
+          }
+        }
+      }
+    }
+  } else {
+    status.error_code = UHDR_CODEC_ERROR;
+    status.has_detail = 1;
+    cinfo.err->format_message((j_common_ptr)&cinfo, status.detail);
+    jpeg_destroy_compress(&cinfo);
+    return status;
+  }
+
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  return status;
+}
+
+uhdr_error_info_t JpegEncoderHelper::transformImage(const void* image, size_t length,
+                                                    const uhdr_effect_transform_t* xfm) {
+  uhdr_error_info_t status = g_no_error;
+
+  if (!xfm->is_remap()) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "lossless transforms are limited to crop, mirror and rotate effects");
+    return status;
+  }
+
+  jpeg_decompress_struct dinfo{};
+  jpeg_compress_struct cinfo{};
+  jpeg_error_mgr_impl myerr;
+
+  // both objects report to the same error manager, one setjmp covers the whole transcode
+  dinfo.err = cinfo.err = jpeg_std_error(&myerr);
+  myerr.error_exit = jpegrerror_exit;
+  myerr.output_message = outputErrorMessage;
+
+  if (0 == setjmp(myerr.setjmp_buffer)) {
+    jpeg_create_decompress(&dinfo);
+    jpeg_mem_src(&dinfo, static_cast<unsigned char*>(const_cast<void*>(image)), length);
+    jpeg_save_markers(&dinfo, JPEG_COM, 0xFFFF);
+    for (int i = 0; i < 16; i++) jpeg_save_markers(&dinfo, JPEG_APP0 + i, 0xFFFF);
+    jpeg_read_header(&dinfo, TRUE);
+    jvirt_barray_ptr* srcArrays = jpeg_read_coefficients(&dinfo);
+
+    // source region of every output axis in units of imcus
+    const bool transposed = xfm->m_transposed;
+    const int srcDim[2] = {(int)dinfo.image_width, (int)dinfo.image_height};
+    const int mcuDim[2] = {DCTSIZE * dinfo.max_h_samp_factor, DCTSIZE * dinfo.max_v_samp_factor};
+    int startMcu[2], endMcu[2];
+    bool flip[2];
+    if (dinfo.num_components > kMaxNumComponents || xfm->m_src_w != srcDim[0] ||
+        xfm->m_src_h != srcDim[1]) {
+      status.error_code = UHDR_CODEC_INVALID_PARAM;
+      status.has_detail = 1;
+      snprintf(status.detail, sizeof status.detail,
+               "transform is configured for a %dx%d image, received %dx%d image with %d components",
+               xfm->m_src_w, xfm->m_src_h, srcDim[0], srcDim[1], dinfo.num_components);
+    }
+    for (int a = 0; a < 2 && status.error_code == UHDR_CODEC_OK; a++) {
+      const int s = transposed ? 1 - a : a;
+      const int len = xfm->m_axis[a].m_len;
+      flip[a] = xfm->m_axis[a].m_scale < 0;
+      const int start = (int)xfm->m_axis[a].m_offset - (flip[a] ? len : 0);
+      const int end = start + len;
+      if (len <= 0 || start < 0 || end > srcDim[s] || start % mcuDim[s] != 0 ||
+          (flip[a] && end % mcuDim[s] != 0)) {
+        status.error_code = UHDR_CODEC_INVALID_PARAM;
+        status.has_detail = 1;
+        snprintf(status.detail, sizeof status.detail,
+                 "source interval [%d, %d) of %s is not aligned to imcu size %d, it can not be "
+                 "transformed losslessly",
+                 start, end, s == 0 ? "columns" : "rows", mcuDim[s]);
+      }
+      startMcu[a] = start / mcuDim[s];
+      endMcu[a] = (end + mcuDim[s] - 1) / mcuDim[s];
+    }
+
+    if (status.error_code == UHDR_CODEC_OK) {
+      jpeg_create_compress(&cinfo);
+
+      // initialize destination manager
+      mDestMgr.init_destination = &initDestination;
+      mDestMgr.empty_output_buffer = &emptyOutputBuffer;
+      mDestMgr.term_destination = &terminateDestination;
+      mDestMgr.mResultBuffer.clear();
+      cinfo.dest = reinterpret_cast<struct jpeg_destination_mgr*>(&mDestMgr);
+
+      // sampling factors, quantization tables and pixel density follow the transposition
+      jpeg_copy_critical_parameters(&dinfo, &cinfo);
+      cinfo.optimize_coding = mOptimizeCoding ? TRUE : FALSE;
+      cinfo.image_width = xfm->width();
+      cinfo.image_height = xfm->height();
+      if (transposed) {
+        for (int ci = 0; ci < cinfo.num_components; ci++) {
+          std::swap(cinfo.comp_info[ci].h_samp_factor, cinfo.comp_info[ci].v_samp_factor);
+        }
+        for (int i = 0; i < NUM_QUANT_TBLS; i++) {
+          if (cinfo.quant_tbl_ptrs[i] == nullptr) continue;
+          UINT16* qtbl = cinfo.quant_tbl_ptrs[i]->quantval;
+          for (int v = 0; v < DCTSIZE; v++) {
+            for (int u = v + 1; u < DCTSIZE; u++) {
+              std::swap(qtbl[v * DCTSIZE + u], qtbl[u * DCTSIZE + v]);
+            }
+          }
+        }
+        std::swap(cinfo.X_density, cinfo.Y_density);
+      }
+
+      jvirt_barray_ptr dstArrays[kMaxNumComponents];
+      unsigned int dstBlocks[kMaxNumComponents][2];
+      for (int ci = 0; ci < cinfo.num_components; ci++) {
+        jpeg_component_info* comp = &cinfo.comp_info[ci];
+        // arrays are padded to whole imcus
+        dstBlocks[ci][0] = (endMcu[0] - startMcu[0]) * comp->h_samp_factor;
+        dstBlocks[ci][1] = (endMcu[1] - startMcu[1]) * comp->v_samp_factor;
+        dstArrays[ci] = (*cinfo.mem->request_virt_barray)((j_common_ptr)&cinfo, JPOOL_IMAGE, TRUE,
+                                                          dstBlocks[ci][0], dstBlocks[ci][1],
+                                                          comp->v_samp_factor);
+      }
+
+      jpeg_write_coefficients(&cinfo, dstArrays);
+      for (jpeg_saved_marker_ptr m = dinfo.marker_list; m != nullptr; m = m->next) {
+        // jpeg_write_coefficients() has written the jfif and adobe markers the output needs
+        if (m->marker == JPEG_APP0 && m->data_length >= 5 && !memcmp(m->data, "JFIF", 5)) continue;
+        if (m->marker == JPEG_APP0 + 14 && m->data_length >= 5 && !memcmp(m->data, "Adobe", 5)) {
+          continue;
+        }
+        jpeg_write_marker(&cinfo, m->marker, m->data, m->data_length);
+      }
+
+      // coefficient k of an output block is coefficient coefIdx[k] of its source block. Mirroring
+      // an axis negates the basis functions of odd frequency along it
+      int coefIdx[DCTSIZE2];
+      bool negate[DCTSIZE2];
+      for (int v = 0; v < DCTSIZE; v++) {
+        for (int u = 0; u < DCTSIZE; u++) {
+          coefIdx[v * DCTSIZE + u] = transposed ? u * DCTSIZE + v : v * DCTSIZE + u;
+          negate[v * DCTSIZE + u] = (flip[0] && (u & 1)) != (flip[1] && (v & 1));
+        }
+      }
+
+      for (int ci = 0; ci < cinfo.num_components; ci++) {
+        jpeg_component_info* comp = &dinfo.comp_info[ci];
+        const int srcSamp[2] = {comp->h_samp_factor, comp->v_samp_factor};
+        const unsigned int srcBlocks[2] = {ALIGNM(comp->width_in_blocks, comp->h_samp_factor),
+                                           ALIGNM(comp->height_in_blocks, comp->v_samp_factor)};
+        std::vector<JCOEF> coeffs((size_t)srcBlocks[0] * srcBlocks[1] * DCTSIZE2);
+        for (unsigned int by = 0; by < srcBlocks[1]; by++) {
+          JBLOCKARRAY rows = (*dinfo.mem->access_virt_barray)((j_common_ptr)&dinfo, srcArrays[ci],
+                                                              by, 1, FALSE);
+          memcpy(&coeffs[(size_t)by * srcBlocks[0] * DCTSIZE2], rows[0],
+                 srcBlocks[0] * sizeof(JBLOCK));
+        }
+
+        // source block column / row of every output block column / row
+        std::vector<unsigned int> blockMap[2];
+        for (int a = 0; a < 2; a++) {
+          const int s = transposed ? 1 - a : a;
+          blockMap[a].resize(dstBlocks[ci][a]);
+          for (unsigned int i = 0; i < dstBlocks[ci][a]; i++) {
+            unsigned int idx =
+                flip[a] ? endMcu[a] * srcSamp[s] - 1 - i : startMcu[a] * srcSamp[s] + i;
+            blockMap[a][i] = (std::min)(idx, srcBlocks[s] - 1);
+          }
+        }
+
+        for (unsigned int by = 0; by < dstBlocks[ci][1]; by++) {
+          JBLOCKARRAY rows = (*cinfo.mem->access_virt_barray)((j_common_ptr)&cinfo, dstArrays[ci],
+                                                              by, 1, TRUE);
+          for (unsigned int bx = 0; bx < dstBlocks[ci][0]; bx++) {
+            const size_t srcBlk = transposed
+                                      ? (size_t)blockMap[0][bx] * srcBlocks[0] + blockMap[1][by]
+                                      : (size_t)blockMap[1][by] * srcBlocks[0] + blockMap[0][bx];
+            const JCOEF* src = &coeffs[srcBlk * DCTSIZE2];
+            JCOEF* dst = rows[0][bx];
+            for (int k = 0; k < DCTSIZE2; k++) {
+              dst[k] = negate[k] ? (JCOEF)-src[coefIdx[k]] : src[coefIdx[k]];
+            }
+          }
+        }
+      }
+      jpeg_finish_compress(&cinfo);
+      jpeg_finish_decompress(&dinfo);
+    }
+  } else {
+    status.error_code = UHDR_CODEC_ERROR;
+    status.has_detail = 1;
+    dinfo.err->format_message((j_common_ptr)&dinfo, status.detail);
+  }
+  jpeg_destroy_compress(&cinfo);
+  jpeg_destroy_decompress(&dinfo);
+  if (status.error_code != UHDR_CODEC_OK) mDestMgr.mResultBuffer.clear();
+  return status;
+}
+
 uhdr_compressed_image_t JpegEncoderHelper::getCompressedImage() {
   uhdr_compressed_image_t img;
 
@@ -201,20 +539,12 @@ uhdr_error_info_t JpegEncoderHelper::encode(const uint8_t* planes[3], const unsi
           std::ceil(((float)cinfo.image_height * cinfo.comp_info[i].v_samp_factor) / factors[7]);
     }
     if (format != UHDR_IMG_FMT_24bppRGB888) cinfo.raw_data_in = TRUE;
-    cinfo.dct_method = JDCT_ISLOW;
+    cinfo.dct_method = mUseFastDct ? JDCT_IFAST : JDCT_ISLOW;
+    cinfo.optimize_coding = mOptimizeCoding ? TRUE : FALSE;
 
     // start compress
     jpeg_start_compress(&cinfo, TRUE);
-    if (iccBuffer != nullptr && iccSize > 0) {
-      jpeg_write_marker(&cinfo, JPEG_APP0 + 2, static_cast<const JOCTET*>(iccBuffer), iccSize);
-    }
-    if (isGainMapImg) {
-      char comment[255];
-      snprintf(comment, sizeof comment,
-               "Source: google libuhdr v%s, Coder: libjpeg v%d, Attrib: GainMap Image",
-               UHDR_LIB_VERSION_STR, JPEG_LIB_VERSION);
-      jpeg_write_marker(&cinfo, JPEG_COM, reinterpret_cast<JOCTET*>(comment), strlen(comment));
-    }
+    writeMarkers(&cinfo, isGainMapImg, iccBuffer, iccSize);
     if (format == UHDR_IMG_FMT_24bppRGB888) {
       while (cinfo.next_scanline < cinfo.image_height) {
         JSAMPROW row_pointer[]{
@@ -71,19 +71,8 @@ static const string kIsoNameSpace = "urn:iso:std:iso:ts:21496:-1";
 static_assert(kWriteXmpMetadata || kWriteIso21496_1Metadata,
               "Must write gain map metadata in XMP format, or iso 21496-1 format, or both.");
 
-class JobQueue {
- public:
-  bool dequeueJob(unsigned int& rowStart, unsigned int& rowEnd);
-  void enqueueJob(unsigned int rowStart, unsigned int rowEnd);
-  void markQueueForEnd();
-  void reset();
-
- private:
-  bool mQueuedAllJobs = false;
-  std::deque<std::tuple<unsigned int, unsigned int>> mJobs;
-  std::mutex mMutex;
-  std::condition_variable mCv;
-};
+// minimum number of output rows per applyGainMap job
+static const int kApplyGainMapJobRows = 16;
 
 bool JobQueue::dequeueJob(unsigned int& rowStart, unsigned int& rowEnd) {
   std::unique_lock<std::mutex> lock{mMutex};
@@ -140,7 +129,8 @@ unsigned int GetCPUCoreCount() { return (std::max)(1u, std::thread::hardware_con
 
 JpegR::JpegR(void* uhdrGLESCtxt, int mapDimensionScaleFactor, int mapCompressQuality,
              bool useMultiChannelGainMap, float gamma, uhdr_enc_preset_t preset,
-             float minContentBoost, float maxContentBoost, float targetDispPeakBrightness) {
+             float minContentBoost, float maxContentBoost, float targetDispPeakBrightness,
+             size_t targetSize) {
   mUhdrGLESCtxt = uhdrGLESCtxt;
   mMapDimensionScaleFactor = mapDimensionScaleFactor;
   mMapCompressQuality = mapCompressQuality;
@@ -150,6 +140,7 @@ JpegR::JpegR(void* uhdrGLESCtxt, int mapDimensionScaleFactor, int mapCompressQua
   mMinContentBoost = minContentBoost;
   mMaxContentBoost = maxContentBoost;
   mTargetDispPeakBrightness = targetDispPeakBrightness;
+  mTargetSize = targetSize;
 }
 
 /*
@@ -175,6 +166,130 @@ static void copyJpegWithoutExif(uhdr_compressed_image_t* pDest, uhdr_compressed_
          (uint8_t*)pSource->data + exif_pos + exif_size, pSource->data_sz - exif_pos - exif_size);
 }
 
+// Encoder settings of each encoding preset, in the order of decreasing speed
+static const uhdr_enc_preset_config_t kEncPresetConfigFastest = {
+    true,   // use_fast_dct
+    false,  // optimize_coding
+    true,   // subsample_chroma
+    true,   // one_pass_gainmap
+    true,   // estimate_gain_range
+    4,      // map_scale_factor
+    false,  // use_multi_channel_map
+    8,      // max_threads
+    true    // use_fast_math
+};
+static const uhdr_enc_preset_config_t kEncPresetConfigRealtime = {
+    false,                            // use_fast_dct
+    false,                            // optimize_coding
+    false,                            // subsample_chroma
+    true,                             // one_pass_gainmap
+    true,                             // estimate_gain_range
+    kMapDimensionScaleFactorDefault,  // map_scale_factor
+    kUseMultiChannelGainMapDefault,   // use_multi_channel_map
+    4,                                // max_threads
+    true                              // use_fast_math
+};
+static const uhdr_enc_preset_config_t kEncPresetConfigBalanced = {
+    false,  // use_fast_dct
+    true,   // optimize_coding
+    true,   // subsample_chroma
+    false,  // one_pass_gainmap
+    true,   // estimate_gain_range
+    2,      // map_scale_factor
+    true,   // use_multi_channel_map
+    4,      // max_threads
+    false   // use_fast_math
+};
+static const uhdr_enc_preset_config_t kEncPresetConfigBestQuality = {
+    false,                            // use_fast_dct
+    true,                             // optimize_coding
+    false,                            // subsample_chroma
+    false,                            // one_pass_gainmap
+    false,                            // estimate_gain_range
+    kMapDimensionScaleFactorDefault,  // map_scale_factor
+    kUseMultiChannelGainMapDefault,   // use_multi_channel_map
+    4,                                // max_threads
+    false                             // use_fast_math
+};
+
+const uhdr_enc_preset_config_t& getEncPresetConfig(uhdr_enc_preset_t preset) {
+  switch (preset) {
+    case UHDR_USAGE_REALTIME:
+      return kEncPresetConfigRealtime;
+    case UHDR_USAGE_BEST_QUALITY:
+      return kEncPresetConfigBestQuality;
+    case UHDR_USAGE_FASTEST:
+      return kEncPresetConfigFastest;
+    case UHDR_USAGE_BALANCED:
+      return kEncPresetConfigBalanced;
+    default:
+      return getEncPresetConfig(kEncSpeedPresetDefault);
+  }
+}
+
+// Decoder settings of each decoding preset, in the order of decreasing speed
+static const uhdr_dec_preset_config_t kDecPresetConfigRealtime = {
+    true,   // use_fast_idct
+    false,  // fancy_upsampling
+    true,   // nearest_map_sampling
+    true,   // use_transfer_fn_luts
+    true,   // use_apply_gain_lut
+    true,   // use_gain_table_2d
+    true,   // use_fixed_point
+    true    // use_fast_math
+};
+static const uhdr_dec_preset_config_t kDecPresetConfigBalanced = {
+    false,  // use_fast_idct
+    true,   // fancy_upsampling
+    false,  // nearest_map_sampling
+    true,   // use_transfer_fn_luts
+    true,   // use_apply_gain_lut
+    false,  // use_gain_table_2d
+    false,  // use_fixed_point
+    true    // use_fast_math
+};
+static const uhdr_dec_preset_config_t kDecPresetConfigBestQuality = {
+    false,  // use_fast_idct
+    true,   // fancy_upsampling
+    false,  // nearest_map_sampling
+    false,  // use_transfer_fn_luts
+    false,  // use_apply_gain_lut
+    false,  // use_gain_table_2d
+    false,  // use_fixed_point
+    false   // use_fast_math
+};
+
+const uhdr_dec_preset_config_t& getDecPresetConfig(uhdr_dec_preset_t preset) {
+  switch (preset) {
+    case UHDR_DEC_USAGE_REALTIME:
+      return kDecPresetConfigRealtime;
+    case UHDR_DEC_USAGE_BALANCED:
+      return kDecPresetConfigBalanced;
+    case UHDR_DEC_USAGE_BEST_QUALITY:
+      return kDecPresetConfigBestQuality;
+    default:
+      return getDecPresetConfig(kDecSpeedPresetDefault);
+  }
+}
+
+/*
+ * Helper function converts rgb sdr intent to YCbCr for jpeg compression.
+ *
+ * @param sdr_intent rgb sdr intent.
+ * @param subsample_chroma if true, chroma planes are subsampled by 2 in both directions.
+ */
+static std::unique_ptr<uhdr_raw_image_ext_t> convertSdrIntentToYCbCr(uhdr_raw_image_t* sdr_intent,
+                                                                     bool subsample_chroma) {
+  if (subsample_chroma) {
+    return convert_raw_input_to_ycbcr(sdr_intent, true);
+  }
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__ARM_NEON__) || defined(__ARM_NEON)))
+  return convert_raw_input_to_ycbcr_neon(sdr_intent);
+#else
+  return convert_raw_input_to_ycbcr(sdr_intent);
+#endif
+}
+
 /* Encode API-0 */
 uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent, uhdr_compressed_image_t* dest,
                                      int quality, uhdr_mem_block_t* exif) {
@@ -203,19 +318,20 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent, uhdr_compress
 
   // If hdr intent is tonemapped internally, it is observed from quality pov,
   // generateGainMapOnePass() is sufficient
-  mEncPreset = UHDR_USAGE_REALTIME;  // overriding the config option
+  const uhdr_enc_preset_t preset = mEncPreset;
+  const uhdr_enc_preset_config_t& presetConfig = getEncPresetConfig(preset);
+  if (!presetConfig.one_pass_gainmap) {
+    mEncPreset = UHDR_USAGE_REALTIME;  // overriding the config option for gain map generation
+  }
 
   // generate gain map
   uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
   std::unique_ptr<uhdr_raw_image_ext_t> gainmap;
-  UHDR_ERR_CHECK(generateGainMap(sdr_intent.get(), hdr_intent, &metadata, gainmap,
-                                 /* sdr_is_601 */ false,
-                                 /* use_luminance */ false));
-
-  // compress gain map
-  JpegEncoderHelper jpeg_enc_obj_gm;
-  UHDR_ERR_CHECK(compressGainMap(gainmap.get(), &jpeg_enc_obj_gm));
-  uhdr_compressed_image_t gainmap_compressed = jpeg_enc_obj_gm.getCompressedImage();
+  uhdr_error_info_t gm_status = generateGainMap(sdr_intent.get(), hdr_intent, &metadata, gainmap,
+                                                /* sdr_is_601 */ false,
+                                                /* use_luminance */ false);
+  mEncPreset = preset;
+  UHDR_ERR_CHECK(gm_status);
 
   std::shared_ptr<DataStruct> icc = IccHelper::writeIccProfile(UHDR_CT_SRGB, sdr_intent->cg);
 
@@ -223,15 +339,20 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent, uhdr_compress
   std::unique_ptr<uhdr_raw_image_ext_t> sdr_intent_yuv_ext;
   uhdr_raw_image_t* sdr_intent_yuv = sdr_intent.get();
   if (isPixelFormatRgb(sdr_intent->fmt)) {
-#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__ARM_NEON__) || defined(__ARM_NEON)))
-    sdr_intent_yuv_ext = convert_raw_input_to_ycbcr_neon(sdr_intent.get());
-#else
-    sdr_intent_yuv_ext = convert_raw_input_to_ycbcr(sdr_intent.get());
-#endif
+    sdr_intent_yuv_ext = convertSdrIntentToYCbCr(sdr_intent.get(), presetConfig.subsample_chroma);
     sdr_intent_yuv = sdr_intent_yuv_ext.get();
   }
 
-  JpegEncoderHelper jpeg_enc_obj_sdr;
+  if (mTargetSize > 0) {
+    return compressToTargetSize(sdr_intent_yuv, gainmap.get(), quality, exif, &metadata, dest);
+  }
+
+  // compress gain map
+  JpegEncoderHelper jpeg_enc_obj_gm(presetConfig.use_fast_dct, presetConfig.optimize_coding);
+  UHDR_ERR_CHECK(compressGainMap(gainmap.get(), &jpeg_enc_obj_gm));
+  uhdr_compressed_image_t gainmap_compressed = jpeg_enc_obj_gm.getCompressedImage();
+
+  JpegEncoderHelper jpeg_enc_obj_sdr(presetConfig.use_fast_dct, presetConfig.optimize_coding);
   UHDR_ERR_CHECK(
       jpeg_enc_obj_sdr.compressImage(sdr_intent_yuv, quality, icc->getData(), icc->getLength()));
   uhdr_compressed_image_t sdr_intent_compressed = jpeg_enc_obj_sdr.getCompressedImage();
@@ -252,21 +373,13 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent, uhdr_raw_imag
   std::unique_ptr<uhdr_raw_image_ext_t> gainmap;
   UHDR_ERR_CHECK(generateGainMap(sdr_intent, hdr_intent, &metadata, gainmap));
 
-  // compress gain map
-  JpegEncoderHelper jpeg_enc_obj_gm;
-  UHDR_ERR_CHECK(compressGainMap(gainmap.get(), &jpeg_enc_obj_gm));
-  uhdr_compressed_image_t gainmap_compressed = jpeg_enc_obj_gm.getCompressedImage();
-
   std::shared_ptr<DataStruct> icc = IccHelper::writeIccProfile(UHDR_CT_SRGB, sdr_intent->cg);
 
+  const uhdr_enc_preset_config_t& presetConfig = getEncPresetConfig(mEncPreset);
   std::unique_ptr<uhdr_raw_image_ext_t> sdr_intent_yuv_ext;
   uhdr_raw_image_t* sdr_intent_yuv = sdr_intent;
   if (isPixelFormatRgb(sdr_intent->fmt)) {
-#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__ARM_NEON__) || defined(__ARM_NEON)))
-    sdr_intent_yuv_ext = convert_raw_input_to_ycbcr_neon(sdr_intent);
-#else
-    sdr_intent_yuv_ext = convert_raw_input_to_ycbcr(sdr_intent);
-#endif
+    sdr_intent_yuv_ext = convertSdrIntentToYCbCr(sdr_intent, presetConfig.subsample_chroma);
     sdr_intent_yuv = sdr_intent_yuv_ext.get();
   }
 
@@ -277,8 +390,17 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent, uhdr_raw_imag
   UHDR_ERR_CHECK(convertYuv(sdr_intent_yuv, sdr_intent_yuv->cg, UHDR_CG_DISPLAY_P3));
 #endif
 
+  if (mTargetSize > 0) {
+    return compressToTargetSize(sdr_intent_yuv, gainmap.get(), quality, exif, &metadata, dest);
+  }
+
+  // compress gain map
+  JpegEncoderHelper jpeg_enc_obj_gm(presetConfig.use_fast_dct, presetConfig.optimize_coding);
+  UHDR_ERR_CHECK(compressGainMap(gainmap.get(), &jpeg_enc_obj_gm));
+  uhdr_compressed_image_t gainmap_compressed = jpeg_enc_obj_gm.getCompressedImage();
+
   // compress sdr image
-  JpegEncoderHelper jpeg_enc_obj_sdr;
+  JpegEncoderHelper jpeg_enc_obj_sdr(presetConfig.use_fast_dct, presetConfig.optimize_coding);
   UHDR_ERR_CHECK(
       jpeg_enc_obj_sdr.compressImage(sdr_intent_yuv, quality, icc->getData(), icc->getLength()));
   uhdr_compressed_image_t sdr_intent_compressed = jpeg_enc_obj_sdr.getCompressedImage();
@@ -316,7 +438,8 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent, uhdr_raw_imag
   UHDR_ERR_CHECK(generateGainMap(sdr_intent, hdr_intent, &metadata, gainmap));
 
   // compress gain map
-  JpegEncoderHelper jpeg_enc_obj_gm;
+  const uhdr_enc_preset_config_t& presetConfig = getEncPresetConfig(mEncPreset);
+  JpegEncoderHelper jpeg_enc_obj_gm(presetConfig.use_fast_dct, presetConfig.optimize_coding);
   UHDR_ERR_CHECK(compressGainMap(gainmap.get(), &jpeg_enc_obj_gm));
   uhdr_compressed_image_t gainmap_compressed = jpeg_enc_obj_gm.getCompressedImage();
 
@@ -327,10 +450,46 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent, uhdr_raw_imag
 uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent,
                                      uhdr_compressed_image_t* sdr_intent_compressed,
                                      uhdr_compressed_image_t* dest) {
-  // decode input jpeg, gamut is going to be bt601.
   JpegDecoderHelper jpeg_dec_obj_sdr;
-  UHDR_ERR_CHECK(jpeg_dec_obj_sdr.decompressImage(sdr_intent_compressed->data,
-                                                  sdr_intent_compressed->data_sz));
+  UHDR_ERR_CHECK(
+      jpeg_dec_obj_sdr.parseImage(sdr_intent_compressed->data, sdr_intent_compressed->data_sz));
+
+  unsigned int sdr_width = jpeg_dec_obj_sdr.getDecompressedImageWidth();
+  unsigned int sdr_height = jpeg_dec_obj_sdr.getDecompressedImageHeight();
+  if (hdr_intent->w != sdr_width || hdr_intent->h != sdr_height) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "sdr intent resolution %dx%d and hdr intent resolution %dx%d do not match", sdr_width,
+             sdr_height, hdr_intent->w, hdr_intent->h);
+    return status;
+  }
+
+  // gain map computation samples sdr intent in blocks of mMapDimensionScaleFactor pixels. If
+  // possible, let libjpeg downscale the sdr intent during decode (dct scaling) instead of
+  // reconstructing it at full resolution.
+  int sdr_downscale = 1;
+#ifdef JCS_ALPHA_EXTENSIONS
+  if (sdr_width / mMapDimensionScaleFactor > 0 && sdr_height / mMapDimensionScaleFactor > 0) {
+    for (int scale : {8, 4, 2}) {
+      if (mMapDimensionScaleFactor % scale == 0) {
+        sdr_downscale = scale;
+        break;
+      }
+    }
+  }
+#endif
+
+  // decode input jpeg, gamut is going to be bt601.
+  if (sdr_downscale > 1) {
+    UHDR_ERR_CHECK(jpeg_dec_obj_sdr.decompressImage(sdr_intent_compressed->data,
+                                                    sdr_intent_compressed->data_sz,
+                                                    DECODE_TO_RGB_CS, sdr_downscale));
+  } else {
+    UHDR_ERR_CHECK(jpeg_dec_obj_sdr.decompressImage(sdr_intent_compressed->data,
+                                                    sdr_intent_compressed->data_sz));
+  }
 
   uhdr_raw_image_t sdr_intent = jpeg_dec_obj_sdr.getDecompressedImage();
   if (jpeg_dec_obj_sdr.getICCSize() > 0) {
@@ -360,24 +519,15 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent,
     sdr_intent.cg = sdr_intent_compressed->cg;
   }
 
-  if (hdr_intent->w != sdr_intent.w || hdr_intent->h != sdr_intent.h) {
-    uhdr_error_info_t status;
-    status.error_code = UHDR_CODEC_INVALID_PARAM;
-    status.has_detail = 1;
-    snprintf(status.detail, sizeof status.detail,
-             "sdr intent resolution %dx%d and hdr intent resolution %dx%d do not match",
-             sdr_intent.w, sdr_intent.h, hdr_intent->w, hdr_intent->h);
-    return status;
-  }
-
   // generate gain map
   uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
   std::unique_ptr<uhdr_raw_image_ext_t> gainmap;
-  UHDR_ERR_CHECK(
-      generateGainMap(&sdr_intent, hdr_intent, &metadata, gainmap, true /* sdr_is_601 */));
+  UHDR_ERR_CHECK(generateGainMap(&sdr_intent, hdr_intent, &metadata, gainmap,
+                                 true /* sdr_is_601 */, true /* use_luminance */, sdr_downscale));
 
   // compress gain map
-  JpegEncoderHelper jpeg_enc_obj_gm;
+  const uhdr_enc_preset_config_t& presetConfig = getEncPresetConfig(mEncPreset);
+  JpegEncoderHelper jpeg_enc_obj_gm(presetConfig.use_fast_dct, presetConfig.optimize_coding);
   UHDR_ERR_CHECK(compressGainMap(gainmap.get(), &jpeg_enc_obj_gm));
   uhdr_compressed_image_t gainmap_compressed = jpeg_enc_obj_gm.getCompressedImage();
 
@@ -388,7 +538,24 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_raw_image_t* hdr_intent,
 uhdr_error_info_t JpegR::encodeJPEGR(uhdr_compressed_image_t* base_img_compressed,
                                      uhdr_compressed_image_t* gainmap_img_compressed,
                                      uhdr_gainmap_metadata_ext_t* metadata,
-                                     uhdr_compressed_image_t* dest) {
+                                     uhdr_compressed_image_t* dest,
+                                     const std::deque<uhdr_effect_desc_t*>* effects) {
+  const uhdr_enc_preset_config_t& presetConfig = getEncPresetConfig(mEncPreset);
+  JpegEncoderHelper base_enc(false, presetConfig.optimize_coding);
+  JpegEncoderHelper gainmap_enc(false, presetConfig.optimize_coding);
+  uhdr_compressed_image_t base_xfm, gainmap_xfm;
+  if (effects != nullptr && !effects->empty()) {
+    UHDR_ERR_CHECK(transformLossless(base_img_compressed, gainmap_img_compressed, *effects,
+                                     &base_enc, &gainmap_enc))
+    base_xfm = base_enc.getCompressedImage();
+    base_xfm.cg = base_img_compressed->cg;
+    base_xfm.ct = base_img_compressed->ct;
+    base_xfm.range = base_img_compressed->range;
+    gainmap_xfm = gainmap_enc.getCompressedImage();
+    base_img_compressed = &base_xfm;
+    gainmap_img_compressed = &gainmap_xfm;
+  }
+
   // We just want to check if ICC is present, so don't do a full decode. Note,
   // this doesn't verify that the ICC is valid.
   JpegDecoderHelper decoder;
@@ -433,6 +600,279 @@ uhdr_error_info_t JpegR::encodeJPEGR(uhdr_compressed_image_t* base_img_compresse
   return g_no_error;
 }
 
+/*
+ * Helper function copies a jpeg stream while dropping the metadata segments that are (re)generated
+ * by appendGainMap(). Only the marker segments that precede start of scan are examined, rest of the
+ * stream is copied as is.
+ *
+ * @param src jpeg stream.
+ * @param remove_exif if true, exif segment is also dropped.
+ * @param remove_icc if true, icc segments are also dropped.
+ * @param dst destination buffer.
+ */
+static uhdr_error_info_t removeMetadataSegments(uhdr_compressed_image_t* src, bool remove_exif,
+                                                bool remove_icc, std::vector<uint8_t>& dst) {
+  static const uint8_t kExifIdCode[] = {'E', 'x', 'i', 'f', '\0', '\0'};
+  static const uint8_t kICCSig[] = {'I', 'C', 'C', '_', 'P', 'R', 'O', 'F', 'I', 'L', 'E', '\0'};
+
+  const uint8_t* data = static_cast<const uint8_t*>(src->data);
+  const size_t size = src->data_sz;
+  auto hasSignature = [](const uint8_t* payload, size_t payload_size, const void* sig,
+                         size_t sig_size) {
+    return payload_size >= sig_size && !memcmp(payload, sig, sig_size);
+  };
+
+  if (size < 4 || data[0] != JpegMarker::kStart || data[1] != JpegMarker::kSOI) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_ERROR;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail, "received jpeg stream without SOI marker");
+    return status;
+  }
+
+  dst.clear();
+  dst.reserve(size);
+  dst.insert(dst.end(), data, data + 2);
+  size_t pos = 2;
+  while (pos + 4 <= size) {
+    if (data[pos] != JpegMarker::kStart) break;
+    const uint8_t marker = data[pos + 1];
+    if (marker == JpegMarker::kStart) {  // fill byte
+      pos++;
+      continue;
+    }
+    if (marker == JpegMarker::kSOS) {
+      dst.insert(dst.end(), data + pos, data + size);
+      return g_no_error;
+    }
+    const size_t length = ((size_t)data[pos + 2] << 8) | data[pos + 3];
+    if (length < 2 || pos + 2 + length > size) break;
+    const uint8_t* payload = data + pos + 4;
+    const size_t payload_size = length - 2;
+
+    bool remove = false;
+    if (marker == JpegMarker::kAPP1) {
+      remove =
+          hasSignature(payload, payload_size, kXmpNameSpace.c_str(), kXmpNameSpace.size() + 1) ||
+          (remove_exif && hasSignature(payload, payload_size, kExifIdCode, sizeof kExifIdCode));
+    } else if (marker == JpegMarker::kAPP2) {
+      remove =
+          hasSignature(payload, payload_size, kIsoNameSpace.c_str(), kIsoNameSpace.size() + 1) ||
+          hasSignature(payload, payload_size, kMpfSig, sizeof kMpfSig) ||
+          (remove_icc && hasSignature(payload, payload_size, kICCSig, sizeof kICCSig));
+    }
+    if (!remove) dst.insert(dst.end(), data + pos, data + pos + 2 + length);
+    pos += 2 + length;
+  }
+
+  uhdr_error_info_t status;
+  status.error_code = UHDR_CODEC_ERROR;
+  status.has_detail = 1;
+  snprintf(status.detail, sizeof status.detail,
+           "encountered malformed marker segment at offset %zu while searching for start of scan",
+           pos);
+  return status;
+}
+
+/* Remux API */
+uhdr_error_info_t JpegR::remuxJPEGR(uhdr_compressed_image_t* uhdr_compressed_img,
+                                    uhdr_gainmap_metadata_ext_t* metadata, uhdr_mem_block_t* pExif,
+                                    uhdr_mem_block_t* pIcc, uhdr_compressed_image_t* dest,
+                                    const std::deque<uhdr_effect_desc_t*>* effects) {
+  uhdr_compressed_image_t primary_jpeg_image, gainmap_jpeg_image;
+  UHDR_ERR_CHECK(
+      extractPrimaryImageAndGainMap(uhdr_compressed_img, &primary_jpeg_image, &gainmap_jpeg_image))
+
+  // header parse only, entropy coded segments are not touched
+  JpegDecoderHelper gainmap_decoder;
+  UHDR_ERR_CHECK(gainmap_decoder.parseImage(gainmap_jpeg_image.data, gainmap_jpeg_image.data_sz))
+
+  uhdr_gainmap_metadata_ext_t input_metadata(kJpegrVersion);
+  if (metadata == nullptr) {
+    UHDR_ERR_CHECK(parseGainMapMetadata(static_cast<uint8_t*>(gainmap_decoder.getIsoMetadataPtr()),
+                                        gainmap_decoder.getIsoMetadataSize(),
+                                        static_cast<uint8_t*>(gainmap_decoder.getXMPPtr()),
+                                        gainmap_decoder.getXMPSize(), &input_metadata))
+    metadata = &input_metadata;
+  }
+  if (!metadata->use_base_cg && !(gainmap_decoder.getICCSize() > 0)) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_UNSUPPORTED_FEATURE;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "For gainmap application space to be alternate image space, gainmap image is "
+             "expected to contain alternate image color space in the form of ICC. The ICC marker "
+             "in gainmap jpeg is missing.");
+    return status;
+  }
+
+  // exif and icc segments that are to be retained are left in place. appendGainMap() moves exif
+  // of primary image to its expected position
+  const bool replace_exif = pExif != nullptr;
+  const bool replace_icc = pIcc != nullptr;
+  if (replace_exif && pExif->data_sz == 0) pExif = nullptr;
+  void* icc = replace_icc && pIcc->data_sz > 0 ? pIcc->data : nullptr;
+  size_t icc_size = icc != nullptr ? pIcc->data_sz : 0;
+
+  std::vector<uint8_t> primary_data, gainmap_data;
+  UHDR_ERR_CHECK(
+      removeMetadataSegments(&primary_jpeg_image, replace_exif, replace_icc, primary_data))
+  UHDR_ERR_CHECK(removeMetadataSegments(&gainmap_jpeg_image, false, false, gainmap_data))
+
+  uhdr_compressed_image_t primary_image = primary_jpeg_image;
+  primary_image.data = primary_data.data();
+  primary_image.data_sz = primary_image.capacity = primary_data.size();
+  uhdr_compressed_image_t gainmap_image = gainmap_jpeg_image;
+  gainmap_image.data = gainmap_data.data();
+  gainmap_image.data_sz = gainmap_image.capacity = gainmap_data.size();
+
+  if (effects != nullptr && !effects->empty()) {
+    const uhdr_enc_preset_config_t& presetConfig = getEncPresetConfig(mEncPreset);
+    JpegEncoderHelper primary_enc(false, presetConfig.optimize_coding);
+    JpegEncoderHelper gainmap_enc(false, presetConfig.optimize_coding);
+    UHDR_ERR_CHECK(
+        transformLossless(&primary_image, &gainmap_image, *effects, &primary_enc, &gainmap_enc))
+    uhdr_compressed_image_t primary_xfm = primary_enc.getCompressedImage();
+    primary_xfm.cg = primary_image.cg;
+    primary_xfm.ct = primary_image.ct;
+    primary_xfm.range = primary_image.range;
+    uhdr_compressed_image_t gainmap_xfm = gainmap_enc.getCompressedImage();
+    return appendGainMap(&primary_xfm, &gainmap_xfm, pExif, icc, icc_size, metadata, dest);
+  }
+
+  return appendGainMap(&primary_image, &gainmap_image, pExif, icc, icc_size, metadata, dest);
+}
+
+uhdr_error_info_t JpegR::transformLossless(uhdr_compressed_image_t* primary_img,
+                                           uhdr_compressed_image_t* gainmap_img,
+                                           const std::deque<uhdr_effect_desc_t*>& effects,
+                                           JpegEncoderHelper* primary_enc,
+                                           JpegEncoderHelper* gainmap_enc) {
+  JpegDecoderHelper primary_dec, gainmap_dec;
+  UHDR_ERR_CHECK(primary_dec.parseImage(primary_img->data, primary_img->data_sz))
+  UHDR_ERR_CHECK(gainmap_dec.parseImage(gainmap_img->data, gainmap_img->data_sz))
+  const int img_dim[2] = {(int)primary_dec.getDecompressedImageWidth(),
+                          (int)primary_dec.getDecompressedImageHeight()};
+  const int img_mcu[2] = {(int)primary_dec.getMcuWidth(), (int)primary_dec.getMcuHeight()};
+  const int map_dim[2] = {(int)gainmap_dec.getDecompressedImageWidth(),
+                          (int)gainmap_dec.getDecompressedImageHeight()};
+  const int map_mcu[2] = {(int)gainmap_dec.getMcuWidth(), (int)gainmap_dec.getMcuHeight()};
+
+  uhdr_effect_transform_t xfm(UHDR_IMG_FMT_UNSPECIFIED, img_dim[0], img_dim[1]);
+  for (auto& it : effects) {
+    if (nullptr != dynamic_cast<uhdr_rotate_effect_t*>(it)) {
+      int degree = dynamic_cast<uhdr_rotate_effect_t*>(it)->m_degree;
+      if (degree != 90 && degree != 180 && degree != 270) {
+        uhdr_error_info_t status;
+        status.error_code = UHDR_CODEC_INVALID_PARAM;
+        status.has_detail = 1;
+        snprintf(status.detail, sizeof status.detail, "unsupported effect %s",
+                 it->to_string().c_str());
+        return status;
+      }
+      xfm.rotate(degree);
+    } else if (nullptr != dynamic_cast<uhdr_mirror_effect_t*>(it)) {
+      xfm.mirror(dynamic_cast<uhdr_mirror_effect_t*>(it)->m_direction);
+    } else if (nullptr != dynamic_cast<uhdr_crop_effect_t*>(it)) {
+      auto crop_effect = dynamic_cast<uhdr_crop_effect_t*>(it);
+      int left = (std::max)(0, crop_effect->m_left);
+      int right = (std::min)(xfm.width(), crop_effect->m_right);
+      int top = (std::max)(0, crop_effect->m_top);
+      int bottom = (std::min)(xfm.height(), crop_effect->m_bottom);
+      if (right - left <= 0 || bottom - top <= 0) {
+        uhdr_error_info_t status;
+        status.error_code = UHDR_CODEC_INVALID_PARAM;
+        status.has_detail = 1;
+        snprintf(status.detail, sizeof status.detail,
+                 "unexpected crop dimensions. crop width and height are expected to be > 0, crop "
+                 "width is %d, crop height is %d",
+                 right - left, bottom - top);
+        return status;
+      }
+      xfm.crop(left, top, right - left, bottom - top);
+    } else {
+      uhdr_error_info_t status;
+      status.error_code = UHDR_CODEC_UNSUPPORTED_FEATURE;
+      status.has_detail = 1;
+      snprintf(status.detail, sizeof status.detail,
+               "effect %s can not be applied losslessly, only crop, mirror and rotate effects are "
+               "supported for inputs with compressed intent",
+               it->to_string().c_str());
+      return status;
+    }
+  }
+
+  // source interval of the primary image and of the gain map along every source axis. Position p
+  // of the primary image is position p * map_dim / img_dim of the gain map
+  int img_start[2], img_end[2], map_start[2], map_end[2];
+  for (int a = 0; a < 2; a++) {
+    const int s = xfm.m_transposed ? 1 - a : a;
+    const bool flip = xfm.m_axis[a].m_scale < 0;
+    const int start = (int)xfm.m_axis[a].m_offset - (flip ? xfm.m_axis[a].m_len : 0);
+    int end = start + xfm.m_axis[a].m_len;
+    auto to_map = [&](int p, int* q) {
+      int64_t n = (int64_t)p * map_dim[s];
+      *q = (int)(n / img_dim[s]);
+      return n % img_dim[s] == 0;
+    };
+    // the leading edge of the output must start an imcu in both images
+    auto is_aligned = [&](int p, int* q) {
+      return to_map(p, q) && p % img_mcu[s] == 0 && *q % map_mcu[s] == 0;
+    };
+    auto is_valid_end = [&](int p, int* q) {
+      if (flip) return is_aligned(p, q);
+      if (p == img_dim[s]) {
+        *q = map_dim[s];
+        return true;
+      }
+      return to_map(p, q);
+    };
+    if (!is_aligned(start, &map_start[s])) {
+      uhdr_error_info_t status;
+      status.error_code = UHDR_CODEC_UNSUPPORTED_FEATURE;
+      status.has_detail = 1;
+      snprintf(status.detail, sizeof status.detail,
+               "crop offset %d along %s is not a multiple of imcu size %d of primary image that "
+               "maps to a multiple of imcu size %d of gain map image, it can not be applied "
+               "losslessly",
+               start, s == 0 ? "width" : "height", img_mcu[s], map_mcu[s]);
+      return status;
+    }
+    while (end > start && !is_valid_end(end, &map_end[s])) end--;
+    if (end == start) {
+      uhdr_error_info_t status;
+      status.error_code = UHDR_CODEC_UNSUPPORTED_FEATURE;
+      status.has_detail = 1;
+      snprintf(status.detail, sizeof status.detail,
+               "no whole imcu of primary image and gain map image is left along %s after "
+               "trimming, effects can not be applied losslessly",
+               s == 0 ? "width" : "height");
+      return status;
+    }
+    img_start[s] = start;
+    img_end[s] = end;
+  }
+
+  // rebuild the transform of either image from its source region
+  auto region_transform = [&](const int* dim, const int* start, const int* end) {
+    uhdr_effect_transform_t region(UHDR_IMG_FMT_UNSPECIFIED, dim[0], dim[1]);
+    region.m_transposed = xfm.m_transposed;
+    for (int a = 0; a < 2; a++) {
+      const int s = xfm.m_transposed ? 1 - a : a;
+      const bool flip = xfm.m_axis[a].m_scale < 0;
+      region.m_axis[a].m_len = end[s] - start[s];
+      region.m_axis[a].m_offset = flip ? end[s] : start[s];
+      region.m_axis[a].m_scale = flip ? -1.0 : 1.0;
+    }
+    return region;
+  };
+  uhdr_effect_transform_t img_xfm = region_transform(img_dim, img_start, img_end);
+  uhdr_effect_transform_t map_xfm = region_transform(map_dim, map_start, map_end);
+  UHDR_ERR_CHECK(primary_enc->transformImage(primary_img->data, primary_img->data_sz, &img_xfm))
+  UHDR_ERR_CHECK(gainmap_enc->transformImage(gainmap_img->data, gainmap_img->data_sz, &map_xfm))
+  return g_no_error;
+}
+
 uhdr_error_info_t JpegR::convertYuv(uhdr_raw_image_t* image, uhdr_color_gamut_t src_encoding,
                                     uhdr_color_gamut_t dst_encoding) {
   const std::array<float, 9>* coeffs_ptr = nullptr;
@@ -527,10 +967,80 @@ uhdr_error_info_t JpegR::compressGainMap(uhdr_raw_image_t* gainmap_img,
   return jpeg_enc_obj->compressImage(gainmap_img, mMapCompressQuality, nullptr, 0);
 }
 
+uhdr_error_info_t JpegR::compressToTargetSize(uhdr_raw_image_t* sdr_intent_yuv,
+                                              uhdr_raw_image_t* gainmap_img, int quality,
+                                              uhdr_mem_block_t* exif,
+                                              uhdr_gainmap_metadata_ext_t* metadata,
+                                              uhdr_compressed_image_t* dest) {
+  std::shared_ptr<DataStruct> icc = IccHelper::writeIccProfile(UHDR_CT_SRGB, sdr_intent_yuv->cg);
+  std::shared_ptr<DataStruct> icc_gm;
+  if (!kWriteXmpMetadata) {
+    icc_gm = IccHelper::writeIccProfile(gainmap_img->ct, gainmap_img->cg);
+  }
+
+  const uhdr_enc_preset_config_t& presetConfig = getEncPresetConfig(mEncPreset);
+  JpegEncoderHelper jpeg_enc_obj_sdr(presetConfig.use_fast_dct, presetConfig.optimize_coding);
+  JpegEncoderHelper jpeg_enc_obj_gm(presetConfig.use_fast_dct, presetConfig.optimize_coding);
+  UHDR_ERR_CHECK(jpeg_enc_obj_sdr.cacheCoefficients(sdr_intent_yuv));
+  UHDR_ERR_CHECK(jpeg_enc_obj_gm.cacheCoefficients(gainmap_img));
+
+  // compresses both images at candidate quality and assembles the output in dest. returns true if
+  // the output fits in the target size
+  auto tryQuality = [&](int q, uhdr_error_info_t& status) -> bool {
+    status = jpeg_enc_obj_gm.compressCachedCoefficients(
+        (std::max)(1, (std::min)(q, mMapCompressQuality)), icc_gm ? icc_gm->getData() : nullptr,
+        icc_gm ? icc_gm->getLength() : 0);
+    if (status.error_code != UHDR_CODEC_OK) return false;
+    status = jpeg_enc_obj_sdr.compressCachedCoefficients(q, icc->getData(), icc->getLength());
+    if (status.error_code != UHDR_CODEC_OK) return false;
+    uhdr_compressed_image_t gainmap_compressed = jpeg_enc_obj_gm.getCompressedImage();
+    uhdr_compressed_image_t sdr_intent_compressed = jpeg_enc_obj_sdr.getCompressedImage();
+    sdr_intent_compressed.cg = sdr_intent_yuv->cg;
+    status = appendGainMap(&sdr_intent_compressed, &gainmap_compressed, exif, /* icc */ nullptr,
+                           /* icc size */ 0, metadata, dest);
+    if (status.error_code == UHDR_CODEC_MEM_ERROR) {
+      // candidate does not fit in output buffer, treat as too large
+      status = g_no_error;
+      return false;
+    }
+    return status.error_code == UHDR_CODEC_OK && dest->data_sz <= mTargetSize;
+  };
+
+  // compressed size is monotonic in quality factor for all practical purposes, binary search for
+  // the largest quality that fits
+  uhdr_error_info_t status = g_no_error;
+  int lo = 1, hi = (std::max)(1, (std::min)(quality, 100)), best = 0, last = 0;
+  while (lo <= hi) {
+    int mid = lo + (hi - lo) / 2;
+    last = mid;
+    if (tryQuality(mid, status)) {
+      best = mid;
+      lo = mid + 1;
+    } else {
+      if (status.error_code != UHDR_CODEC_OK) return status;
+      hi = mid - 1;
+    }
+  }
+  if (best == 0) {
+    status.error_code = UHDR_CODEC_ERROR;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "unable to fit compressed output in target size %zu bytes even at lowest quality "
+             "factor",
+             mTargetSize);
+    return status;
+  }
+  if (last != best) {
+    tryQuality(best, status);
+    if (status.error_code != UHDR_CODEC_OK) return status;
+  }
+  return g_no_error;
+}
+
 uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_image_t* hdr_intent,
                                          uhdr_gainmap_metadata_ext_t* gainmap_metadata,
                                          std::unique_ptr<uhdr_raw_image_ext_t>& gainmap_img,
-                                         bool sdr_is_601, bool use_luminance) {
+                                         bool sdr_is_601, bool use_luminance, int sdr_downscale) {
   uhdr_error_info_t status = g_no_error;
 
   if (sdr_intent->fmt != UHDR_IMG_FMT_24bppYCbCr444 &&
@@ -688,8 +1198,19 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
     sdrYuvToRgbFn = p3YuvToRgb;
   }
 
-  unsigned int image_width = sdr_intent->w;
-  unsigned int image_height = sdr_intent->h;
+  if (sdr_downscale < 1 || sdr_intent->w < hdr_intent->w / sdr_downscale ||
+      sdr_intent->h < hdr_intent->h / sdr_downscale) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "sdr intent resolution %ux%u is not compatible with hdr intent resolution %ux%u "
+             "downscaled by factor %d",
+             sdr_intent->w, sdr_intent->h, hdr_intent->w, hdr_intent->h, sdr_downscale);
+    return status;
+  }
+
+  unsigned int image_width = hdr_intent->w;
+  unsigned int image_height = hdr_intent->h;
   unsigned int map_width = image_width / mMapDimensionScaleFactor;
   unsigned int map_height = image_height / mMapDimensionScaleFactor;
   if (map_width == 0 || map_height == 0) {
@@ -703,6 +1224,32 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
     map_width = image_width / mMapDimensionScaleFactor;
     map_height = image_height / mMapDimensionScaleFactor;
   }
+  if (mMapDimensionScaleFactor % sdr_downscale != 0) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "gainmap scale factor %d is not a multiple of sdr intent downscale factor %d",
+             mMapDimensionScaleFactor, sdr_downscale);
+    return status;
+  }
+  // sdr intent is sampled at its own resolution, this is gain map resolution when sdr intent is
+  // downscaled by gainmap scale factor
+  const int sdr_sample_factor = mMapDimensionScaleFactor / sdr_downscale;
+  // packed rgb intents read at their own resolution are linearized straight from their sample
+  // codes
+  const float* sdrInvOetfTable =
+      (sdr_sample_factor == 1 && sdr_intent->fmt == UHDR_IMG_FMT_32bppRGBA8888)
+          ? getInverseOetfCodeTable(UHDR_CT_SRGB, sdr_intent->fmt)
+          : nullptr;
+  const float* hdrInvOetfTable =
+      (mMapDimensionScaleFactor == 1 && hdr_intent->fmt == UHDR_IMG_FMT_32bppRGBA1010102)
+          ? getInverseOetfCodeTable(hdr_intent->ct, hdr_intent->fmt)
+          : nullptr;
+  // gamut conversion and scaling to nits of the linear intents, folded into one matrix each
+  LinearColorPipeline sdrToNits, hdrToNits;
+  sdrToNits.append(sdrGamutConversionFn).append(kSdrWhiteNits);
+  hdrToNits.append(hdrGamutConversionFn)
+      .append(hdr_intent->ct == UHDR_CT_LINEAR ? kSdrWhiteNits : hdr_white_nits);
 
   // NOTE: Even though gainmap image raw descriptor is being initialized with hdr intent's color
   // aspects, one should not associate gainmap image to this color profile. gain map image gamut
@@ -716,10 +1263,10 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
   uhdr_raw_image_ext_t* dest = gainmap_img.get();
 
   auto generateGainMapOnePass = [this, sdr_intent, hdr_intent, gainmap_metadata, dest, map_height,
-                                 hdrInvOetf, hdrLuminanceFn, hdrOotfFn, hdrGamutConversionFn,
-                                 sdrGamutConversionFn, luminanceFn, sdrYuvToRgbFn, hdrYuvToRgbFn,
-                                 sdr_sample_pixel_fn, hdr_sample_pixel_fn, hdr_white_nits,
-                                 use_luminance]() -> void {
+                                 hdrInvOetf, hdrLuminanceFn, hdrOotfFn, sdrToNits, hdrToNits,
+                                 luminanceFn, sdrYuvToRgbFn, hdrYuvToRgbFn, sdr_sample_pixel_fn,
+                                 hdr_sample_pixel_fn, hdr_white_nits, sdr_sample_factor,
+                                 use_luminance, sdrInvOetfTable, hdrInvOetfTable]() -> void {
     std::fill_n(gainmap_metadata->max_content_boost, 3, hdr_white_nits / kSdrWhiteNits);
     std::fill_n(gainmap_metadata->min_content_boost, 3, 1.0f);
     std::fill_n(gainmap_metadata->gamma, 3, mGamma);
@@ -735,82 +1282,93 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
     float log2MinBoost = log2(gainmap_metadata->min_content_boost[0]);
     float log2MaxBoost = log2(gainmap_metadata->max_content_boost[0]);
 
-    const int threads = (std::min)(GetCPUCoreCount(), 4u);
+    const int threads =
+        (std::min)(GetCPUCoreCount(), getEncPresetConfig(mEncPreset).max_threads);
+    const bool use_fast_math = getEncPresetConfig(mEncPreset).use_fast_math;
     const int jobSizeInRows = 1;
     unsigned int rowStep = threads == 1 ? map_height : jobSizeInRows;
     JobQueue jobQueue;
     std::function<void()> generateMap =
         [this, sdr_intent, hdr_intent, gainmap_metadata, dest, hdrInvOetf, hdrLuminanceFn,
-         hdrOotfFn, hdrGamutConversionFn, sdrGamutConversionFn, luminanceFn, sdrYuvToRgbFn,
-         hdrYuvToRgbFn, sdr_sample_pixel_fn, hdr_sample_pixel_fn, hdr_white_nits, log2MinBoost,
-         log2MaxBoost, use_luminance, &jobQueue]() -> void {
+         hdrOotfFn, sdrToNits, hdrToNits, luminanceFn, sdrYuvToRgbFn, hdrYuvToRgbFn,
+         sdr_sample_pixel_fn, hdr_sample_pixel_fn, log2MinBoost, log2MaxBoost, sdr_sample_factor,
+         use_luminance, sdrInvOetfTable, hdrInvOetfTable, use_fast_math, &jobQueue]() -> void {
       unsigned int rowStart, rowEnd;
       const bool isHdrIntentRgb = isPixelFormatRgb(hdr_intent->fmt);
       const bool isSdrIntentRgb = isPixelFormatRgb(sdr_intent->fmt);
-      const float hdrSampleToNitsFactor =
-          hdr_intent->ct == UHDR_CT_LINEAR ? kSdrWhiteNits : hdr_white_nits;
       while (jobQueue.dequeueJob(rowStart, rowEnd)) {
         for (size_t y = rowStart; y < rowEnd; ++y) {
           for (size_t x = 0; x < dest->w; ++x) {
-            Color sdr_rgb_gamma;
+            Color sdr_rgb;
 
-            if (isSdrIntentRgb) {
-              sdr_rgb_gamma = sdr_sample_pixel_fn(sdr_intent, mMapDimensionScaleFactor, x, y);
+            if (sdrInvOetfTable) {
+              sdr_rgb = getRgba8888PixelLinear(sdr_intent, x, y, sdrInvOetfTable);
             } else {
-              Color sdr_yuv_gamma = sdr_sample_pixel_fn(sdr_intent, mMapDimensionScaleFactor, x, y);
-              sdr_rgb_gamma = sdrYuvToRgbFn(sdr_yuv_gamma);
-            }
+              Color sdr_rgb_gamma;
+
+              if (isSdrIntentRgb) {
+                sdr_rgb_gamma = sdr_sample_pixel_fn(sdr_intent, sdr_sample_factor, x, y);
+              } else {
+                Color sdr_yuv_gamma = sdr_sample_pixel_fn(sdr_intent, sdr_sample_factor, x, y);
+                sdr_rgb_gamma = sdrYuvToRgbFn(sdr_yuv_gamma);
+              }
 
-            // We are assuming the SDR input is always sRGB transfer.
+              // We are assuming the SDR input is always sRGB transfer.
 #if USE_SRGB_INVOETF_LUT
-            Color sdr_rgb = srgbInvOetfLUT(sdr_rgb_gamma);
+              sdr_rgb = srgbInvOetfLUT(sdr_rgb_gamma);
 #else
-            Color sdr_rgb = srgbInvOetf(sdr_rgb_gamma);
+              sdr_rgb = srgbInvOetf(sdr_rgb_gamma);
 #endif
-            sdr_rgb = sdrGamutConversionFn(sdr_rgb);
-            sdr_rgb = clipNegatives(sdr_rgb);
+            }
+            Color sdr_rgb_nits = clipNegatives(sdrToNits.apply(sdr_rgb));
 
-            Color hdr_rgb_gamma;
+            Color hdr_rgb;
 
-            if (isHdrIntentRgb) {
-              hdr_rgb_gamma = hdr_sample_pixel_fn(hdr_intent, mMapDimensionScaleFactor, x, y);
+            if (hdrInvOetfTable) {
+              hdr_rgb = getRgba1010102PixelLinear(hdr_intent, x, y, hdrInvOetfTable);
             } else {
-              Color hdr_yuv_gamma = hdr_sample_pixel_fn(hdr_intent, mMapDimensionScaleFactor, x, y);
-              hdr_rgb_gamma = hdrYuvToRgbFn(hdr_yuv_gamma);
+              Color hdr_rgb_gamma;
+
+              if (isHdrIntentRgb) {
+                hdr_rgb_gamma = hdr_sample_pixel_fn(hdr_intent, mMapDimensionScaleFactor, x, y);
+              } else {
+                Color hdr_yuv_gamma =
+                    hdr_sample_pixel_fn(hdr_intent, mMapDimensionScaleFactor, x, y);
+                hdr_rgb_gamma = hdrYuvToRgbFn(hdr_yuv_gamma);
+              }
+              hdr_rgb = hdrInvOetf(hdr_rgb_gamma);
             }
-            Color hdr_rgb = hdrInvOetf(hdr_rgb_gamma);
             hdr_rgb = hdrOotfFn(hdr_rgb, hdrLuminanceFn);
-            hdr_rgb = hdrGamutConversionFn(hdr_rgb);
-            hdr_rgb = clipNegatives(hdr_rgb);
+            Color hdr_rgb_nits = clipNegatives(hdrToNits.apply(hdr_rgb));
 
             if (mUseMultiChannelGainMap) {
-              Color sdr_rgb_nits = sdr_rgb * kSdrWhiteNits;
-              Color hdr_rgb_nits = hdr_rgb * hdrSampleToNitsFactor;
               size_t pixel_idx = (x + y * dest->stride[UHDR_PLANE_PACKED]) * 3;
 
-              reinterpret_cast<uint8_t*>(dest->planes[UHDR_PLANE_PACKED])[pixel_idx] = encodeGain(
-                  sdr_rgb_nits.r, hdr_rgb_nits.r, gainmap_metadata, log2MinBoost, log2MaxBoost, 0);
+              reinterpret_cast<uint8_t*>(dest->planes[UHDR_PLANE_PACKED])[pixel_idx] =
+                  encodeGain(sdr_rgb_nits.r, hdr_rgb_nits.r, gainmap_metadata, log2MinBoost,
+                             log2MaxBoost, 0, use_fast_math);
               reinterpret_cast<uint8_t*>(dest->planes[UHDR_PLANE_PACKED])[pixel_idx + 1] =
                   encodeGain(sdr_rgb_nits.g, hdr_rgb_nits.g, gainmap_metadata, log2MinBoost,
-                             log2MaxBoost, 1);
+                             log2MaxBoost, 1, use_fast_math);
               reinterpret_cast<uint8_t*>(dest->planes[UHDR_PLANE_PACKED])[pixel_idx + 2] =
                   encodeGain(sdr_rgb_nits.b, hdr_rgb_nits.b, gainmap_metadata, log2MinBoost,
-                             log2MaxBoost, 2);
+                             log2MaxBoost, 2, use_fast_math);
             } else {
               float sdr_y_nits;
               float hdr_y_nits;
               if (use_luminance) {
-                sdr_y_nits = luminanceFn(sdr_rgb) * kSdrWhiteNits;
-                hdr_y_nits = luminanceFn(hdr_rgb) * hdrSampleToNitsFactor;
+                sdr_y_nits = luminanceFn(sdr_rgb_nits);
+                hdr_y_nits = luminanceFn(hdr_rgb_nits);
               } else {
-                sdr_y_nits = fmax(sdr_rgb.r, fmax(sdr_rgb.g, sdr_rgb.b)) * kSdrWhiteNits;
-                hdr_y_nits = fmax(hdr_rgb.r, fmax(hdr_rgb.g, hdr_rgb.b)) * hdrSampleToNitsFactor;
+                sdr_y_nits = fmax(sdr_rgb_nits.r, fmax(sdr_rgb_nits.g, sdr_rgb_nits.b));
+                hdr_y_nits = fmax(hdr_rgb_nits.r, fmax(hdr_rgb_nits.g, hdr_rgb_nits.b));
               }
 
               size_t pixel_idx = x + y * dest->stride[UHDR_PLANE_Y];
 
-              reinterpret_cast<uint8_t*>(dest->planes[UHDR_PLANE_Y])[pixel_idx] = encodeGain(
-                  sdr_y_nits, hdr_y_nits, gainmap_metadata, log2MinBoost, log2MaxBoost, 0);
+              reinterpret_cast<uint8_t*>(dest->planes[UHDR_PLANE_Y])[pixel_idx] =
+                  encodeGain(sdr_y_nits, hdr_y_nits, gainmap_metadata, log2MinBoost, log2MaxBoost,
+                             0, use_fast_math);
             }
           }
         }
@@ -834,103 +1392,130 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
   };
 
   auto generateGainMapTwoPass = [this, sdr_intent, hdr_intent, gainmap_metadata, dest, map_width,
-                                 map_height, hdrInvOetf, hdrLuminanceFn, hdrOotfFn,
-                                 hdrGamutConversionFn, sdrGamutConversionFn, luminanceFn,
-                                 sdrYuvToRgbFn, hdrYuvToRgbFn, sdr_sample_pixel_fn,
-                                 hdr_sample_pixel_fn, hdr_white_nits, use_luminance]() -> void {
-    uhdr_memory_block_t gainmap_mem((size_t)map_width * map_height * sizeof(float) *
-                                    (mUseMultiChannelGainMap ? 3 : 1));
-    float* gainmap_data = reinterpret_cast<float*>(gainmap_mem.m_buffer.get());
+                                 map_height, hdrInvOetf, hdrLuminanceFn, hdrOotfFn, sdrToNits,
+                                 hdrToNits, luminanceFn, sdrYuvToRgbFn, hdrYuvToRgbFn,
+                                 sdr_sample_pixel_fn, hdr_sample_pixel_fn, hdr_white_nits,
+                                 sdr_sample_factor, use_luminance, sdrInvOetfTable,
+                                 hdrInvOetfTable]() -> void {
+    const uhdr_enc_preset_config_t& presetConfig = getEncPresetConfig(mEncPreset);
+    const int threads = (std::min)(GetCPUCoreCount(), presetConfig.max_threads);
+    const bool use_fast_math = presetConfig.use_fast_math;
+    const int channels = mUseMultiChannelGainMap ? 3 : 1;
+    // If enabled, the log2 gain range is estimated from a strided subsample of the map and the
+    // map is quantized while it is computed, instead of buffering every float gain first to find
+    // the exact range. Gains outside of the estimated range saturate.
+    const bool estimate_range = presetConfig.estimate_gain_range &&
+                                map_width >= 8 * kGainRangeSampleStride &&
+                                map_height >= 8 * kGainRangeSampleStride;
+    const unsigned int sample_stride = estimate_range ? kGainRangeSampleStride : 1;
+    std::unique_ptr<uhdr_memory_block_t> gainmap_mem;
+    float* gainmap_data = nullptr;
+    if (!estimate_range) {
+      gainmap_mem = std::make_unique<uhdr_memory_block_t>((size_t)map_width * map_height *
+                                                          sizeof(float) * channels);
+      gainmap_data = reinterpret_cast<float*>(gainmap_mem->m_buffer.get());
+    }
     float gainmap_min[3] = {127.0f, 127.0f, 127.0f};
     float gainmap_max[3] = {-128.0f, -128.0f, -128.0f};
     std::mutex gainmap_minmax;
 
-    const int threads = (std::min)(GetCPUCoreCount(), 4u);
-    const int jobSizeInRows = 1;
-    unsigned int rowStep = threads == 1 ? map_height : jobSizeInRows;
-    JobQueue jobQueue;
-    std::function<void()> generateMap =
-        [this, sdr_intent, hdr_intent, gainmap_data, map_width, hdrInvOetf, hdrLuminanceFn,
-         hdrOotfFn, hdrGamutConversionFn, sdrGamutConversionFn, luminanceFn, sdrYuvToRgbFn,
-         hdrYuvToRgbFn, sdr_sample_pixel_fn, hdr_sample_pixel_fn, hdr_white_nits, use_luminance,
-         &gainmap_min, &gainmap_max, &gainmap_minmax, &jobQueue]() -> void {
-      unsigned int rowStart, rowEnd;
-      const bool isHdrIntentRgb = isPixelFormatRgb(hdr_intent->fmt);
-      const bool isSdrIntentRgb = isPixelFormatRgb(sdr_intent->fmt);
-      const float hdrSampleToNitsFactor =
-          hdr_intent->ct == UHDR_CT_LINEAR ? kSdrWhiteNits : hdr_white_nits;
-      float gainmap_min_th[3] = {127.0f, 127.0f, 127.0f};
-      float gainmap_max_th[3] = {-128.0f, -128.0f, -128.0f};
-
-      while (jobQueue.dequeueJob(rowStart, rowEnd)) {
-        for (size_t y = rowStart; y < rowEnd; ++y) {
-          for (size_t x = 0; x < map_width; ++x) {
-            Color sdr_rgb_gamma;
+    const bool isHdrIntentRgb = isPixelFormatRgb(hdr_intent->fmt);
+    const bool isSdrIntentRgb = isPixelFormatRgb(sdr_intent->fmt);
+    // log2 gain(s) of map pixel (x, y)
+    auto computeGains = [this, sdr_intent, hdr_intent, hdrInvOetf, hdrLuminanceFn, hdrOotfFn,
+                         sdrToNits, hdrToNits, luminanceFn, sdrYuvToRgbFn, hdrYuvToRgbFn,
+                         sdr_sample_pixel_fn, hdr_sample_pixel_fn, sdr_sample_factor,
+                         use_luminance, sdrInvOetfTable, hdrInvOetfTable, use_fast_math,
+                         isHdrIntentRgb, isSdrIntentRgb](size_t x, size_t y, float* gains) {
+      Color sdr_rgb;
+
+      if (sdrInvOetfTable) {
+        sdr_rgb = getRgba8888PixelLinear(sdr_intent, x, y, sdrInvOetfTable);
+      } else {
+        Color sdr_rgb_gamma;
 
-            if (isSdrIntentRgb) {
-              sdr_rgb_gamma = sdr_sample_pixel_fn(sdr_intent, mMapDimensionScaleFactor, x, y);
-            } else {
-              Color sdr_yuv_gamma = sdr_sample_pixel_fn(sdr_intent, mMapDimensionScaleFactor, x, y);
-              sdr_rgb_gamma = sdrYuvToRgbFn(sdr_yuv_gamma);
-            }
+        if (isSdrIntentRgb) {
+          sdr_rgb_gamma = sdr_sample_pixel_fn(sdr_intent, sdr_sample_factor, x, y);
+        } else {
+          Color sdr_yuv_gamma = sdr_sample_pixel_fn(sdr_intent, sdr_sample_factor, x, y);
+          sdr_rgb_gamma = sdrYuvToRgbFn(sdr_yuv_gamma);
+        }
 
-            // We are assuming the SDR input is always sRGB transfer.
+        // We are assuming the SDR input is always sRGB transfer.
 #if USE_SRGB_INVOETF_LUT
-            Color sdr_rgb = srgbInvOetfLUT(sdr_rgb_gamma);
+        sdr_rgb = srgbInvOetfLUT(sdr_rgb_gamma);
 #else
-            Color sdr_rgb = srgbInvOetf(sdr_rgb_gamma);
+        sdr_rgb = srgbInvOetf(sdr_rgb_gamma);
 #endif
-            sdr_rgb = sdrGamutConversionFn(sdr_rgb);
-            sdr_rgb = clipNegatives(sdr_rgb);
+      }
+      Color sdr_rgb_nits = clipNegatives(sdrToNits.apply(sdr_rgb));
 
-            Color hdr_rgb_gamma;
+      Color hdr_rgb;
 
-            if (isHdrIntentRgb) {
-              hdr_rgb_gamma = hdr_sample_pixel_fn(hdr_intent, mMapDimensionScaleFactor, x, y);
-            } else {
-              Color hdr_yuv_gamma = hdr_sample_pixel_fn(hdr_intent, mMapDimensionScaleFactor, x, y);
-              hdr_rgb_gamma = hdrYuvToRgbFn(hdr_yuv_gamma);
-            }
-            Color hdr_rgb = hdrInvOetf(hdr_rgb_gamma);
-            hdr_rgb = hdrOotfFn(hdr_rgb, hdrLuminanceFn);
-            hdr_rgb = hdrGamutConversionFn(hdr_rgb);
-            hdr_rgb = clipNegatives(hdr_rgb);
+      if (hdrInvOetfTable) {
+        hdr_rgb = getRgba1010102PixelLinear(hdr_intent, x, y, hdrInvOetfTable);
+      } else {
+        Color hdr_rgb_gamma;
 
-            if (mUseMultiChannelGainMap) {
-              Color sdr_rgb_nits = sdr_rgb * kSdrWhiteNits;
-              Color hdr_rgb_nits = hdr_rgb * hdrSampleToNitsFactor;
-              size_t pixel_idx = (x + y * map_width) * 3;
-
-              gainmap_data[pixel_idx] = computeGain(sdr_rgb_nits.r, hdr_rgb_nits.r);
-              gainmap_data[pixel_idx + 1] = computeGain(sdr_rgb_nits.g, hdr_rgb_nits.g);
-              gainmap_data[pixel_idx + 2] = computeGain(sdr_rgb_nits.b, hdr_rgb_nits.b);
-              for (int i = 0; i < 3; i++) {
-                gainmap_min_th[i] = (std::min)(gainmap_data[pixel_idx + i], gainmap_min_th[i]);
-                gainmap_max_th[i] = (std::max)(gainmap_data[pixel_idx + i], gainmap_max_th[i]);
-              }
-            } else {
-              float sdr_y_nits;
-              float hdr_y_nits;
+        if (isHdrIntentRgb) {
+          hdr_rgb_gamma = hdr_sample_pixel_fn(hdr_intent, mMapDimensionScaleFactor, x, y);
+        } else {
+          Color hdr_yuv_gamma = hdr_sample_pixel_fn(hdr_intent, mMapDimensionScaleFactor, x, y);
+          hdr_rgb_gamma = hdrYuvToRgbFn(hdr_yuv_gamma);
+        }
+        hdr_rgb = hdrInvOetf(hdr_rgb_gamma);
+      }
+      hdr_rgb = hdrOotfFn(hdr_rgb, hdrLuminanceFn);
+      Color hdr_rgb_nits = clipNegatives(hdrToNits.apply(hdr_rgb));
 
-              if (use_luminance) {
-                sdr_y_nits = luminanceFn(sdr_rgb) * kSdrWhiteNits;
-                hdr_y_nits = luminanceFn(hdr_rgb) * hdrSampleToNitsFactor;
-              } else {
-                sdr_y_nits = fmax(sdr_rgb.r, fmax(sdr_rgb.g, sdr_rgb.b)) * kSdrWhiteNits;
-                hdr_y_nits = fmax(hdr_rgb.r, fmax(hdr_rgb.g, hdr_rgb.b)) * hdrSampleToNitsFactor;
-              }
+      if (mUseMultiChannelGainMap) {
+        gains[0] = computeGain(sdr_rgb_nits.r, hdr_rgb_nits.r, use_fast_math);
+        gains[1] = computeGain(sdr_rgb_nits.g, hdr_rgb_nits.g, use_fast_math);
+        gains[2] = computeGain(sdr_rgb_nits.b, hdr_rgb_nits.b, use_fast_math);
+      } else {
+        float sdr_y_nits;
+        float hdr_y_nits;
 
-              size_t pixel_idx = x + y * map_width;
-              gainmap_data[pixel_idx] = computeGain(sdr_y_nits, hdr_y_nits);
-              gainmap_min_th[0] = (std::min)(gainmap_data[pixel_idx], gainmap_min_th[0]);
-              gainmap_max_th[0] = (std::max)(gainmap_data[pixel_idx], gainmap_max_th[0]);
+        if (use_luminance) {
+          sdr_y_nits = luminanceFn(sdr_rgb_nits);
+          hdr_y_nits = luminanceFn(hdr_rgb_nits);
+        } else {
+          sdr_y_nits = fmax(sdr_rgb_nits.r, fmax(sdr_rgb_nits.g, sdr_rgb_nits.b));
+          hdr_y_nits = fmax(hdr_rgb_nits.r, fmax(hdr_rgb_nits.g, hdr_rgb_nits.b));
+        }
+        gains[0] = computeGain(sdr_y_nits, hdr_y_nits, use_fast_math);
+      }
+    };
+
+    const int jobSizeInRows = 1;
+    unsigned int rowStep = threads == 1 ? map_height : jobSizeInRows;
+    JobQueue jobQueue;
+    // gathers the gain range over the map, or over its subsample if the range is estimated. Gains
+    // are kept for the encode pass if they are computed for every pixel.
+    std::function<void()> generateMap = [map_width, channels, sample_stride, gainmap_data,
+                                         &computeGains, &gainmap_min, &gainmap_max,
+                                         &gainmap_minmax, &jobQueue]() -> void {
+      unsigned int rowStart, rowEnd;
+      float gainmap_min_th[3] = {127.0f, 127.0f, 127.0f};
+      float gainmap_max_th[3] = {-128.0f, -128.0f, -128.0f};
+
+      while (jobQueue.dequeueJob(rowStart, rowEnd)) {
+        for (size_t y = rowStart; y < rowEnd; ++y) {
+          for (size_t x = sample_stride / 2; x < map_width; x += sample_stride) {
+            float sample_gains[3];
+            float* gains =
+                gainmap_data ? gainmap_data + (x + y * map_width) * channels : sample_gains;
+            computeGains(x, y, gains);
+            for (int i = 0; i < channels; i++) {
+              gainmap_min_th[i] = (std::min)(gains[i], gainmap_min_th[i]);
+              gainmap_max_th[i] = (std::max)(gains[i], gainmap_max_th[i]);
             }
           }
         }
       }
       {
         std::unique_lock<std::mutex> lock{gainmap_minmax};
-        for (int index = 0; index < (mUseMultiChannelGainMap ? 3 : 1); index++) {
+        for (int index = 0; index < channels; index++) {
           gainmap_min[index] = (std::min)(gainmap_min[index], gainmap_min_th[index]);
           gainmap_max[index] = (std::max)(gainmap_max[index], gainmap_max_th[index]);
         }
@@ -943,10 +1528,16 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
       workers.push_back(std::thread(generateMap));
     }
 
-    for (unsigned int rowStart = 0; rowStart < map_height;) {
-      unsigned int rowEnd = (std::min)(rowStart + rowStep, map_height);
-      jobQueue.enqueueJob(rowStart, rowEnd);
-      rowStart = rowEnd;
+    if (estimate_range) {
+      for (unsigned int row = sample_stride / 2; row < map_height; row += sample_stride) {
+        jobQueue.enqueueJob(row, row + 1);
+      }
+    } else {
+      for (unsigned int rowStart = 0; rowStart < map_height;) {
+        unsigned int rowEnd = (std::min)(rowStart + rowStep, map_height);
+        jobQueue.enqueueJob(rowStart, rowEnd);
+        rowStart = rowEnd;
+      }
     }
     jobQueue.markQueueForEnd();
     generateMap();
@@ -957,7 +1548,7 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
     if (kWriteXmpMetadata) {
       float min_content_boost_log2 = gainmap_min[0];
       float max_content_boost_log2 = gainmap_max[0];
-      for (int index = 1; index < (mUseMultiChannelGainMap ? 3 : 1); index++) {
+      for (int index = 1; index < channels; index++) {
         min_content_boost_log2 = (std::min)(gainmap_min[index], min_content_boost_log2);
         max_content_boost_log2 = (std::max)(gainmap_max[index], max_content_boost_log2);
       }
@@ -965,7 +1556,7 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
       std::fill_n(gainmap_max, 3, max_content_boost_log2);
     }
 
-    for (int index = 0; index < (mUseMultiChannelGainMap ? 3 : 1); index++) {
+    for (int index = 0; index < channels; index++) {
       // gain coefficient range [-14.3, 15.6] is capable of representing hdr pels from sdr pels.
       // Allowing further excursion might not offer any benefit and on the downside can cause bigger
       // error during affine map and inverse affine map.
@@ -984,29 +1575,27 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
       }
     }
 
-    std::function<void()> encodeMap = [this, gainmap_data, map_width, dest, gainmap_min,
-                                       gainmap_max, &jobQueue]() -> void {
+    std::function<void()> encodeMap = [this, gainmap_data, map_width, dest, channels,
+                                       gainmap_min, gainmap_max, use_fast_math, &computeGains,
+                                       &jobQueue]() -> void {
       unsigned int rowStart, rowEnd;
+      const int plane = mUseMultiChannelGainMap ? UHDR_PLANE_PACKED : UHDR_PLANE_Y;
 
       while (jobQueue.dequeueJob(rowStart, rowEnd)) {
-        if (mUseMultiChannelGainMap) {
-          for (size_t j = rowStart; j < rowEnd; j++) {
-            size_t dst_pixel_idx = j * dest->stride[UHDR_PLANE_PACKED] * 3;
-            size_t src_pixel_idx = j * map_width * 3;
-            for (size_t i = 0; i < map_width * 3; i++) {
-              reinterpret_cast<uint8_t*>(dest->planes[UHDR_PLANE_PACKED])[dst_pixel_idx + i] =
-                  affineMapGain(gainmap_data[src_pixel_idx + i], gainmap_min[i % 3],
-                                gainmap_max[i % 3], this->mGamma);
+        for (size_t j = rowStart; j < rowEnd; j++) {
+          uint8_t* dst = reinterpret_cast<uint8_t*>(dest->planes[plane]) +
+                         j * dest->stride[plane] * channels;
+          for (size_t i = 0; i < map_width; i++) {
+            float pixel_gains[3];
+            const float* gains = pixel_gains;
+            if (gainmap_data) {
+              gains = gainmap_data + (i + j * map_width) * channels;
+            } else {
+              computeGains(i, j, pixel_gains);
             }
-          }
-        } else {
-          for (size_t j = rowStart; j < rowEnd; j++) {
-            size_t dst_pixel_idx = j * dest->stride[UHDR_PLANE_Y];
-            size_t src_pixel_idx = j * map_width;
-            for (size_t i = 0; i < map_width; i++) {
-              reinterpret_cast<uint8_t*>(dest->planes[UHDR_PLANE_Y])[dst_pixel_idx + i] =
-                  affineMapGain(gainmap_data[src_pixel_idx + i], gainmap_min[0], gainmap_max[0],
-                                this->mGamma);
+            for (int c = 0; c < channels; c++) {
+              dst[i * channels + c] = affineMapGain(gains[c], gainmap_min[c], gainmap_max[c],
+                                                    this->mGamma, use_fast_math);
             }
           }
         }
@@ -1047,7 +1636,7 @@ uhdr_error_info_t JpegR::generateGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_
     }
   };
 
-  if (mEncPreset == UHDR_USAGE_REALTIME) {
+  if (getEncPresetConfig(mEncPreset).one_pass_gainmap) {
     generateGainMapOnePass();
   } else {
     generateGainMapTwoPass();
@@ -1387,29 +1976,104 @@ uhdr_error_info_t JpegR::parseGainMapMetadata(uint8_t* iso_data, size_t iso_size
 }
 
 /* Decode API */
+// moves the pixels of a decoded image as described by xfm. 3 channel gain maps are expanded to 4
+// channels first as the transform only addresses 8 bit rgb images with an alpha channel
+static uhdr_error_info_t transformDecodedImage(const uhdr_effect_transform_t* xfm,
+                                               uhdr_raw_image_t* src,
+                                               std::unique_ptr<uhdr_raw_image_ext_t>* dst) {
+  if (xfm->m_src_w != (int)src->w || xfm->m_src_h != (int)src->h) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "effects were prepared for an image of dimensions %dx%d, decoded image dimensions "
+             "are %ux%u",
+             xfm->m_src_w, xfm->m_src_h, src->w, src->h);
+    return status;
+  }
+  std::unique_ptr<uhdr_raw_image_ext_t> rgba;
+  if (src->fmt == UHDR_IMG_FMT_24bppRGB888) {
+    rgba = std::make_unique<uhdr_raw_image_ext_t>(UHDR_IMG_FMT_32bppRGBA8888, src->cg, src->ct,
+                                                  src->range, src->w, src->h, 64);
+    UHDR_ERR_CHECK(copy_raw_image(src, rgba.get()));
+    src = rgba.get();
+  }
+  uhdr_effect_transform_t img_xfm = *xfm;
+  img_xfm.m_fmt = src->fmt;
+  *dst = apply_transform(&img_xfm, src);
+  if (*dst == nullptr) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_UNSUPPORTED_FEATURE;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "encountered error while applying effects to image of color format %d", src->fmt);
+    return status;
+  }
+  return g_no_error;
+}
+
 uhdr_error_info_t JpegR::decodeJPEGR(uhdr_compressed_image_t* uhdr_compressed_img,
                                      uhdr_raw_image_t* dest, float max_display_boost,
                                      uhdr_color_transfer_t output_ct, uhdr_img_fmt_t output_format,
                                      uhdr_raw_image_t* gainmap_img,
-                                     uhdr_gainmap_metadata_t* gainmap_metadata) {
+                                     uhdr_gainmap_metadata_t* gainmap_metadata,
+                                     uhdr_dec_preset_t preset,
+                                     const uhdr_effect_transform_t* sdr_xfm,
+                                     const uhdr_effect_transform_t* gm_xfm) {
   uhdr_compressed_image_t primary_jpeg_image, gainmap_jpeg_image;
   UHDR_ERR_CHECK(
       extractPrimaryImageAndGainMap(uhdr_compressed_img, &primary_jpeg_image, &gainmap_jpeg_image))
 
-  JpegDecoderHelper jpeg_dec_obj_sdr;
+  const uhdr_dec_preset_config_t& presetConfig = getDecPresetConfig(preset);
+  JpegDecoderHelper jpeg_dec_obj_sdr(presetConfig.use_fast_idct, presetConfig.fancy_upsampling);
   UHDR_ERR_CHECK(jpeg_dec_obj_sdr.decompressImage(
       primary_jpeg_image.data, primary_jpeg_image.data_sz,
       (output_ct == UHDR_CT_SRGB) ? DECODE_TO_RGB_CS : DECODE_TO_YCBCR_CS));
 
-  JpegDecoderHelper jpeg_dec_obj_gm;
+  if (sdr_xfm != nullptr && gm_xfm == nullptr) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "received transform for base image without a transform for gainmap image");
+    return status;
+  }
+
+  // crops and resizes are applied to the base and gain map images ahead of the gain map
+  // application and rotations and mirrors are applied to the output as it is written. This needs
+  // the cropped base image to start and end on whole chroma samples, other layouts are decoded at
+  // full size and the output is transformed
+  uhdr_raw_image_t sdr_intent = jpeg_dec_obj_sdr.getDecompressedImage();
+  bool transform_base = false;
+  if (sdr_xfm != nullptr) {
+    const uhdr_effect_transform_t sdr_geometry = sdr_xfm->get_unoriented();
+    transform_base = sdr_intent.fmt == UHDR_IMG_FMT_24bppYCbCr444 ||
+                     sdr_intent.fmt == UHDR_IMG_FMT_32bppRGBA8888 ||
+                     (sdr_intent.fmt == UHDR_IMG_FMT_12bppYCbCr420 && sdr_intent.w % 2 == 0 &&
+                      sdr_intent.h % 2 == 0 && sdr_geometry.width() % 2 == 0 &&
+                      sdr_geometry.height() % 2 == 0 &&
+                      std::fmod(sdr_geometry.m_axis[0].m_offset, 2.0) == 0.0 &&
+                      std::fmod(sdr_geometry.m_axis[1].m_offset, 2.0) == 0.0);
+  }
+
+  JpegDecoderHelper jpeg_dec_obj_gm(presetConfig.use_fast_idct, presetConfig.fancy_upsampling);
   uhdr_raw_image_t gainmap;
+  std::unique_ptr<uhdr_raw_image_ext_t> gainmap_xfm, gainmap_geometry;
   if (gainmap_img != nullptr || output_ct != UHDR_CT_SRGB) {
     UHDR_ERR_CHECK(jpeg_dec_obj_gm.decompressImage(gainmap_jpeg_image.data,
                                                    gainmap_jpeg_image.data_sz, DECODE_STREAM));
     gainmap = jpeg_dec_obj_gm.getDecompressedImage();
+    if (gm_xfm != nullptr) {
+      UHDR_ERR_CHECK(transformDecodedImage(gm_xfm, &gainmap, &gainmap_xfm));
+      if (transform_base && output_ct != UHDR_CT_SRGB) {
+        const uhdr_effect_transform_t gm_geometry = gm_xfm->get_unoriented();
+        UHDR_ERR_CHECK(transformDecodedImage(&gm_geometry, &gainmap, &gainmap_geometry));
+      }
+    }
     if (gainmap_img != nullptr) {
-      UHDR_ERR_CHECK(copy_raw_image(&gainmap, gainmap_img));
+      UHDR_ERR_CHECK(copy_raw_image(gainmap_xfm ? gainmap_xfm.get() : &gainmap, gainmap_img));
     }
+    if (gainmap_geometry != nullptr) gainmap = *gainmap_geometry;
     gainmap.cg =
         IccHelper::readIccColorGamut(jpeg_dec_obj_gm.getICCPtr(), jpeg_dec_obj_gm.getICCSize());
   }
@@ -1436,16 +2100,238 @@ uhdr_error_info_t JpegR::decodeJPEGR(uhdr_compressed_image_t* uhdr_compressed_im
     }
   }
 
-  uhdr_raw_image_t sdr_intent = jpeg_dec_obj_sdr.getDecompressedImage();
   sdr_intent.cg =
       IccHelper::readIccColorGamut(jpeg_dec_obj_sdr.getICCPtr(), jpeg_dec_obj_sdr.getICCSize());
+  if (transform_base && output_ct == UHDR_CT_SRGB) {
+    std::unique_ptr<uhdr_raw_image_ext_t> sdr_intent_xfm;
+    UHDR_ERR_CHECK(transformDecodedImage(sdr_xfm, &sdr_intent, &sdr_intent_xfm));
+    return copy_raw_image(sdr_intent_xfm.get(), dest);
+  }
+  if (transform_base) {
+    const uhdr_effect_transform_t sdr_geometry = sdr_xfm->get_unoriented();
+    std::unique_ptr<uhdr_raw_image_ext_t> sdr_intent_geometry;
+    UHDR_ERR_CHECK(transformDecodedImage(&sdr_geometry, &sdr_intent, &sdr_intent_geometry));
+    sdr_intent = *sdr_intent_geometry;
+    return applyGainMap(&sdr_intent, &gainmap, &uhdr_metadata, output_ct, output_format,
+                        max_display_boost, dest, preset, sdr_xfm);
+  }
+
+  uhdr_raw_image_t* output = dest;
+  std::unique_ptr<uhdr_raw_image_ext_t> full_size_output;
+  if (sdr_xfm != nullptr) {
+    full_size_output = std::make_unique<uhdr_raw_image_ext_t>(
+        dest->fmt, dest->cg, dest->ct, dest->range, sdr_intent.w, sdr_intent.h, 64);
+    output = full_size_output.get();
+  }
+
   if (output_ct == UHDR_CT_SRGB) {
-    UHDR_ERR_CHECK(copy_raw_image(&sdr_intent, dest));
+    UHDR_ERR_CHECK(copy_raw_image(&sdr_intent, output));
+  } else {
+    UHDR_ERR_CHECK(applyGainMap(&sdr_intent, &gainmap, &uhdr_metadata, output_ct, output_format,
+                                max_display_boost, output, preset));
+  }
+
+  if (full_size_output != nullptr) {
+    std::unique_ptr<uhdr_raw_image_ext_t> output_xfm;
+    UHDR_ERR_CHECK(transformDecodedImage(sdr_xfm, full_size_output.get(), &output_xfm));
+    UHDR_ERR_CHECK(copy_raw_image(output_xfm.get(), dest));
+  }
+
+  return g_no_error;
+}
+
+// resamples plane src_plane of src, of dimensions src_w x src_h, to plane dst_plane of dst at the
+// dimensions of dst. Planes are handed to the resampler as 8 bit grayscale views
+static uhdr_error_info_t resamplePlane(uhdr_raw_image_t* src, int src_plane, unsigned int src_w,
+                                       unsigned int src_h, uhdr_raw_image_t* dst, int dst_plane) {
+  uhdr_raw_image_t view = *src;
+  view.fmt = UHDR_IMG_FMT_8bppYCbCr400;
+  view.w = src_w;
+  view.h = src_h;
+  view.planes[UHDR_PLANE_Y] = src->planes[src_plane];
+  view.stride[UHDR_PLANE_Y] = src->stride[src_plane];
+  const double scale = (std::min)((double)src_w / dst->w, (double)src_h / dst->h);
+  std::unique_ptr<uhdr_raw_image_ext_t> plane =
+      resize_image(&view, dst->w, dst->h,
+                   scale >= 1.0 ? UHDR_RESAMPLE_AREA : get_default_resample_filter(scale));
+  if (plane == nullptr) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_ERROR;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "encountered error while resampling plane from %ux%u to %ux%u", src_w, src_h, dst->w,
+             dst->h);
+    return status;
+  }
+  uint8_t* src_row = static_cast<uint8_t*>(plane->planes[UHDR_PLANE_Y]);
+  uint8_t* dst_row = static_cast<uint8_t*>(dst->planes[dst_plane]);
+  for (unsigned int i = 0; i < dst->h; i++) {
+    memcpy(dst_row, src_row, dst->w);
+    src_row += plane->stride[UHDR_PLANE_Y];
+    dst_row += dst->stride[dst_plane];
+  }
+  return g_no_error;
+}
+
+// builds a w x h level of a decoded image. Packed, grayscale and 4:4:4 images are resampled as is,
+// subsampled YCbCr images are resampled plane by plane to a 4:4:4 level
+static uhdr_error_info_t resampleDecodedImage(uhdr_raw_image_t* src, unsigned int w,
+                                              unsigned int h,
+                                              std::unique_ptr<uhdr_raw_image_ext_t>* dst) {
+  if (src->fmt == UHDR_IMG_FMT_32bppRGBA8888 || src->fmt == UHDR_IMG_FMT_8bppYCbCr400 ||
+      src->fmt == UHDR_IMG_FMT_24bppYCbCr444) {
+    const double scale = (std::min)((double)src->w / w, (double)src->h / h);
+    *dst = resize_image(src, w, h,
+                        scale >= 1.0 ? UHDR_RESAMPLE_AREA : get_default_resample_filter(scale));
+    if (*dst == nullptr) {
+      uhdr_error_info_t status;
+      status.error_code = UHDR_CODEC_ERROR;
+      status.has_detail = 1;
+      snprintf(status.detail, sizeof status.detail,
+               "encountered error while resampling image of color format %d from %ux%u to %ux%u",
+               src->fmt, src->w, src->h, w, h);
+      return status;
+    }
     return g_no_error;
   }
+  *dst = std::make_unique<uhdr_raw_image_ext_t>(UHDR_IMG_FMT_24bppYCbCr444, src->cg, src->ct,
+                                                src->range, w, h, 64);
+  UHDR_ERR_CHECK(resamplePlane(src, UHDR_PLANE_Y, src->w, src->h, dst->get(), UHDR_PLANE_Y));
+  const unsigned int cw = (src->w + 1) / 2;
+  const unsigned int ch = src->fmt == UHDR_IMG_FMT_12bppYCbCr420 ? (src->h + 1) / 2 : src->h;
+  UHDR_ERR_CHECK(resamplePlane(src, UHDR_PLANE_U, cw, ch, dst->get(), UHDR_PLANE_U));
+  return resamplePlane(src, UHDR_PLANE_V, cw, ch, dst->get(), UHDR_PLANE_V);
+}
 
-  UHDR_ERR_CHECK(applyGainMap(&sdr_intent, &gainmap, &uhdr_metadata, output_ct, output_format,
-                              max_display_boost, dest));
+uhdr_error_info_t JpegR::decodeJPEGRRenditions(uhdr_compressed_image_t* uhdr_compressed_img,
+                                               uhdr_raw_image_t** dests, size_t count,
+                                               float max_display_boost, uhdr_dec_preset_t preset) {
+  // sdr renditions always come from libjpeg's rgb decode, as uhdr_decode() produces them, so that
+  // their output does not depend on the other renditions requested. hdr renditions apply the gain
+  // map to the YCbCr decode
+  bool need_rgb = false, need_ycbcr = false;
+  for (size_t i = 0; i < count; i++) {
+    if (dests[i]->ct == UHDR_CT_SRGB) {
+      need_rgb = true;
+    } else {
+      need_ycbcr = true;
+    }
+  }
+
+  uhdr_compressed_image_t primary_jpeg_image, gainmap_jpeg_image;
+  UHDR_ERR_CHECK(
+      extractPrimaryImageAndGainMap(uhdr_compressed_img, &primary_jpeg_image, &gainmap_jpeg_image))
+
+  const uhdr_dec_preset_config_t& presetConfig = getDecPresetConfig(preset);
+  JpegDecoderHelper jpeg_dec_obj_rgb(presetConfig.use_fast_idct, presetConfig.fancy_upsampling);
+  uhdr_raw_image_t sdr_rgb;
+  if (need_rgb) {
+    UHDR_ERR_CHECK(jpeg_dec_obj_rgb.decompressImage(primary_jpeg_image.data,
+                                                    primary_jpeg_image.data_sz, DECODE_TO_RGB_CS));
+    sdr_rgb = jpeg_dec_obj_rgb.getDecompressedImage();
+    sdr_rgb.ct = UHDR_CT_SRGB;
+    sdr_rgb.range = UHDR_CR_FULL_RANGE;
+    sdr_rgb.cg =
+        IccHelper::readIccColorGamut(jpeg_dec_obj_rgb.getICCPtr(), jpeg_dec_obj_rgb.getICCSize());
+  }
+
+  JpegDecoderHelper jpeg_dec_obj_sdr(presetConfig.use_fast_idct, presetConfig.fancy_upsampling);
+  JpegDecoderHelper jpeg_dec_obj_gm(presetConfig.use_fast_idct, presetConfig.fancy_upsampling);
+  uhdr_raw_image_t sdr_intent;
+  uhdr_raw_image_t gainmap;
+  std::unique_ptr<uhdr_raw_image_ext_t> gainmap_rgba;
+  uhdr_gainmap_metadata_ext_t uhdr_metadata;
+  if (need_ycbcr) {
+    UHDR_ERR_CHECK(jpeg_dec_obj_sdr.decompressImage(
+        primary_jpeg_image.data, primary_jpeg_image.data_sz, DECODE_TO_YCBCR_CS));
+    sdr_intent = jpeg_dec_obj_sdr.getDecompressedImage();
+    sdr_intent.cg =
+        IccHelper::readIccColorGamut(jpeg_dec_obj_sdr.getICCPtr(), jpeg_dec_obj_sdr.getICCSize());
+
+    UHDR_ERR_CHECK(jpeg_dec_obj_gm.decompressImage(gainmap_jpeg_image.data,
+                                                   gainmap_jpeg_image.data_sz, DECODE_STREAM));
+    gainmap = jpeg_dec_obj_gm.getDecompressedImage();
+    gainmap.cg =
+        IccHelper::readIccColorGamut(jpeg_dec_obj_gm.getICCPtr(), jpeg_dec_obj_gm.getICCSize());
+    if (gainmap.fmt == UHDR_IMG_FMT_24bppRGB888) {
+      gainmap_rgba = std::make_unique<uhdr_raw_image_ext_t>(
+          UHDR_IMG_FMT_32bppRGBA8888, gainmap.cg, gainmap.ct, gainmap.range, gainmap.w, gainmap.h,
+          64);
+      UHDR_ERR_CHECK(copy_raw_image(&gainmap, gainmap_rgba.get()));
+      gainmap = *gainmap_rgba;
+    }
+    UHDR_ERR_CHECK(parseGainMapMetadata(static_cast<uint8_t*>(jpeg_dec_obj_gm.getIsoMetadataPtr()),
+                                        jpeg_dec_obj_gm.getIsoMetadataSize(),
+                                        static_cast<uint8_t*>(jpeg_dec_obj_gm.getXMPPtr()),
+                                        jpeg_dec_obj_gm.getXMPSize(), &uhdr_metadata))
+  }
+
+  // largest renditions first, so that every level can be built from a larger one
+  std::vector<size_t> order(count);
+  for (size_t i = 0; i < count; i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [dests](size_t a, size_t b) {
+    return (uint64_t)dests[a]->w * dests[a]->h > (uint64_t)dests[b]->w * dests[b]->h;
+  });
+
+  // returns the smallest image of the pyramid that covers w x h, or the decoded image
+  auto find_source = [](std::vector<std::unique_ptr<uhdr_raw_image_ext_t>>& levels,
+                        uhdr_raw_image_t* root, unsigned int w, unsigned int h) {
+    uhdr_raw_image_t* src = root;
+    for (auto& level : levels) {
+      if (level->w >= w && level->h >= h &&
+          (uint64_t)level->w * level->h <= (uint64_t)src->w * src->h) {
+        src = level.get();
+      }
+    }
+    return src;
+  };
+
+  // returns the w x h level of the pyramid rooted at root, building it from the smallest covering
+  // level if it does not exist yet
+  auto get_level = [&find_source](std::vector<std::unique_ptr<uhdr_raw_image_ext_t>>& levels,
+                                  uhdr_raw_image_t* root, unsigned int w, unsigned int h,
+                                  uhdr_raw_image_t** out) -> uhdr_error_info_t {
+    for (auto& level : levels) {
+      if (level->w == w && level->h == h) {
+        *out = level.get();
+        return g_no_error;
+      }
+    }
+    std::unique_ptr<uhdr_raw_image_ext_t> level;
+    uhdr_raw_image_t* src = find_source(levels, root, w, h);
+    UHDR_ERR_CHECK(resampleDecodedImage(src, w, h, &level));
+    level->cg = root->cg;
+    levels.push_back(std::move(level));
+    *out = levels.back().get();
+    return g_no_error;
+  };
+
+  std::vector<std::unique_ptr<uhdr_raw_image_ext_t>> rgb_levels, sdr_levels, gm_levels;
+  for (size_t i : order) {
+    uhdr_raw_image_t* dest = dests[i];
+    if (dest->ct == UHDR_CT_SRGB) {
+      uhdr_raw_image_t* rgb_level = &sdr_rgb;
+      if (dest->w != sdr_rgb.w || dest->h != sdr_rgb.h) {
+        UHDR_ERR_CHECK(get_level(rgb_levels, &sdr_rgb, dest->w, dest->h, &rgb_level));
+      }
+      UHDR_ERR_CHECK(copy_raw_image(rgb_level, dest));
+      continue;
+    }
+
+    uhdr_raw_image_t* sdr_level = &sdr_intent;
+    if (dest->w != sdr_intent.w || dest->h != sdr_intent.h) {
+      UHDR_ERR_CHECK(get_level(sdr_levels, &sdr_intent, dest->w, dest->h, &sdr_level));
+    }
+
+    // the gain map is brought down to the level resolution when it is larger, smaller maps are
+    // upsampled by the gain map application
+    uhdr_raw_image_t* gm_level = &gainmap;
+    if (gainmap.w > dest->w || gainmap.h > dest->h) {
+      UHDR_ERR_CHECK(get_level(gm_levels, &gainmap, dest->w, dest->h, &gm_level));
+    }
+    UHDR_ERR_CHECK(applyGainMap(sdr_level, gm_level, &uhdr_metadata, dest->ct, dest->fmt,
+                                max_display_boost, dest, preset));
+  }
 
   return g_no_error;
 }
@@ -1454,7 +2340,9 @@ uhdr_error_info_t JpegR::applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_ima
                                       uhdr_gainmap_metadata_ext_t* gainmap_metadata,
                                       uhdr_color_transfer_t output_ct,
                                       [[maybe_unused]] uhdr_img_fmt_t output_format,
-                                      float max_display_boost, uhdr_raw_image_t* dest) {
+                                      float max_display_boost, uhdr_raw_image_t* dest,
+                                      uhdr_dec_preset_t preset,
+                                      const uhdr_effect_transform_t* orientation) {
   if (gainmap_metadata->version.compare(kJpegrVersion)) {
     uhdr_error_info_t status;
     status.error_code = UHDR_CODEC_UNSUPPORTED_FEATURE;
@@ -1516,7 +2404,7 @@ uhdr_error_info_t JpegR::applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_ima
          (sdr_intent->fmt == UHDR_IMG_FMT_16bppYCbCr422 && sdr_intent->w % 2 == 0) ||
          (sdr_intent->fmt == UHDR_IMG_FMT_24bppYCbCr444)) &&
         isBufferDataContiguous(sdr_intent) && isBufferDataContiguous(gainmap_img) &&
-        isBufferDataContiguous(dest)) {
+        isBufferDataContiguous(dest) && orientation == nullptr) {
       // TODO: both inputs and outputs of GLES implementation assumes that raw image is contiguous
       // and without strides. If not, handle the same by using temp copy
       float display_boost = (std::min)(max_display_boost, gainmap_metadata->hdr_capacity_max);
@@ -1552,8 +2440,6 @@ uhdr_error_info_t JpegR::applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_ima
   float map_scale_factor = (float)sdr_intent->w / gainmap_img->w;
   int map_scale_factor_rnd = (std::max)(1, (int)std::roundf(map_scale_factor));
 
-  // Table will only be used when map scale factor is integer.
-  ShepardsIDW idwTable(map_scale_factor_rnd);
   float display_boost = (std::min)(max_display_boost, gainmap_metadata->hdr_capacity_max);
 
   float gainmap_weight;
@@ -1566,7 +2452,8 @@ uhdr_error_info_t JpegR::applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_ima
   } else {
     gainmap_weight = 1.0f;
   }
-  GainLUT gainLUT(gainmap_metadata, gainmap_weight);
+  std::shared_ptr<const GainLUT> gainLUTPtr = getGainLUT(gainmap_metadata, gainmap_weight);
+  const GainLUT& gainLUT = *gainLUTPtr;
 
   GetPixelFn get_pixel_fn = getPixelFn(sdr_intent->fmt);
   if (get_pixel_fn == nullptr) {
@@ -1578,81 +2465,226 @@ uhdr_error_info_t JpegR::applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_ima
     return status;
   }
 
-  JobQueue jobQueue;
-  std::function<void()> applyRecMap = [sdr_intent, gainmap_img, dest, &jobQueue, &idwTable,
-                                       output_ct, &gainLUT, gainmap_metadata, hdrGamutConversionFn,
-                                       sdrGamutConversionFn,
-#if !USE_APPLY_GAIN_LUT
-                                       gainmap_weight,
+  const uhdr_dec_preset_config_t& presetConfig = getDecPresetConfig(preset);
+  const bool nearest_map_sampling = presetConfig.nearest_map_sampling;
+  const bool use_fast_math = presetConfig.use_fast_math;
+  // look up tables are used only if they are enabled at build time and by the preset
+#if USE_APPLY_GAIN_LUT
+  const bool use_gain_lut = presetConfig.use_apply_gain_lut;
+#else
+  const bool use_gain_lut = false;
 #endif
-                                       map_scale_factor, get_pixel_fn]() -> void {
+  ColorTransformFn sdrInvOetf = srgbInvOetf;
+  ColorTransformFn hdrOetf = pqOetf;
+  if (output_ct == UHDR_CT_HLG) hdrOetf = hlgOetf;
+  if (presetConfig.use_transfer_fn_luts) {
+#if USE_SRGB_INVOETF_LUT
+    sdrInvOetf = srgbInvOetfLUT;
+#endif
+#if USE_HLG_OETF_LUT
+    if (output_ct == UHDR_CT_HLG) hdrOetf = hlgOetfLUT;
+#endif
+#if USE_PQ_OETF_LUT
+    if (output_ct == UHDR_CT_PQ) hdrOetf = pqOetfLUT;
+#endif
+  }
+
+  // single channel maps applied without a gamut conversion take the sdr code and gain straight to
+  // the hdr output code. The table is only worth building if the image has at least as many pixels
+  // as the table has entries.
+  std::shared_ptr<const GainTable2D> gainTable2DPtr;
+  if (presetConfig.use_gain_table_2d && gainmap_img->fmt == UHDR_IMG_FMT_8bppYCbCr400 &&
+      sdr_cg == hdr_cg && (output_ct == UHDR_CT_HLG || output_ct == UHDR_CT_PQ) &&
+      (size_t)sdr_intent->w * sdr_intent->h >=
+          (size_t)kGainTable2DSdrEntries * kGainTable2DGainEntries) {
+    gainTable2DPtr = getGainTable2D(gainmap_metadata, gainmap_weight, output_ct);
+  }
+  const GainTable2D* gainTable2D = gainTable2DPtr.get();
+
+  // remaining hlg/pq outputs of 8-bit yuv base images may be evaluated in fixed point
+  std::unique_ptr<FixedPointGainMapApplier> fixedPointApplierPtr;
+  size_t chroma_sub_x = 1, chroma_sub_y = 1;
+  if (presetConfig.use_fixed_point && gainTable2D == nullptr &&
+      (output_ct == UHDR_CT_HLG || output_ct == UHDR_CT_PQ) &&
+      (sdr_intent->fmt == UHDR_IMG_FMT_24bppYCbCr444 ||
+       sdr_intent->fmt == UHDR_IMG_FMT_16bppYCbCr422 ||
+       sdr_intent->fmt == UHDR_IMG_FMT_12bppYCbCr420 ||
+       sdr_intent->fmt == UHDR_IMG_FMT_8bppYCbCr400)) {
+    fixedPointApplierPtr = std::make_unique<FixedPointGainMapApplier>(
+        gainmap_metadata, gainmap_weight, output_ct, sdrGamutConversionFn, hdrGamutConversionFn);
+    if (sdr_intent->fmt != UHDR_IMG_FMT_24bppYCbCr444) chroma_sub_x = 2;
+    if (sdr_intent->fmt == UHDR_IMG_FMT_12bppYCbCr420) chroma_sub_y = 2;
+  }
+  const FixedPointGainMapApplier* fixedPointApplier = fixedPointApplierPtr.get();
+
+  // the linear steps around the gain application, folded into one matrix each: sdr gamut
+  // conversion before it, and output scaling plus hdr gamut conversion after it
+  LinearColorPipeline sdrPipeline, hdrPipeline;
+  sdrPipeline.append(sdrGamutConversionFn);
+  if (output_ct == UHDR_CT_HLG) {
+    hdrPipeline.append(kSdrWhiteNits / kHlgMaxNits);
+  } else if (output_ct == UHDR_CT_PQ) {
+    hdrPipeline.append(kSdrWhiteNits / kPqMaxNits);
+  }
+  hdrPipeline.append(hdrGamutConversionFn);
+  const bool apply_sdr_pipeline = !sdrPipeline.isIdentity();
+
+  // sdr pixel (x, y) is written to sample out_origin + x * out_step_x + y * out_step_y of dest,
+  // which rotates or mirrors the output as it is produced
+  ptrdiff_t out_origin = 0, out_step_x = 1, out_step_y = dest->stride[UHDR_PLANE_PACKED];
+  if (orientation != nullptr) {
+    orientation->get_output_steps(dest->stride[UHDR_PLANE_PACKED], &out_origin, &out_step_x,
+                                  &out_step_y);
+  }
+
+  JobQueue jobQueue;
+  std::function<void()> applyRecMap = [sdr_intent, gainmap_img, dest, &jobQueue, output_ct,
+                                       &gainLUT, gainmap_metadata, sdrPipeline, hdrPipeline,
+                                       apply_sdr_pipeline, gainmap_weight, map_scale_factor,
+                                       get_pixel_fn, nearest_map_sampling, use_gain_lut,
+                                       sdrInvOetf, hdrOetf, gainTable2D, fixedPointApplier,
+                                       chroma_sub_x, chroma_sub_y, use_fast_math, out_origin,
+                                       out_step_x, out_step_y]() -> void {
     unsigned int width = sdr_intent->w;
     unsigned int rowStart, rowEnd;
 
+    // interpolated gains are produced a row at a time from the expanded map rows of the current
+    // band of gain map cells and read contiguously below
+    std::unique_ptr<GainMapRowSampler> rowSampler;
+    if (!nearest_map_sampling) {
+      rowSampler = std::make_unique<GainMapRowSampler>(gainmap_img, map_scale_factor, width);
+    }
+    // linear output is gathered as floats and converted to half floats a row at a time
+    std::vector<float> linearRow;
+    std::vector<uint16_t> halfRow;
+    if (output_ct == UHDR_CT_LINEAR) {
+      linearRow.resize((size_t)width * 4);
+      if (out_step_x != 1) halfRow.resize((size_t)width * 4);
+    }
+
     while (jobQueue.dequeueJob(rowStart, rowEnd)) {
       for (size_t y = rowStart; y < rowEnd; ++y) {
+        const float* gains = rowSampler ? rowSampler->sampleRow(y) : nullptr;
         for (size_t x = 0; x < width; ++x) {
+          const size_t pixel_idx =
+              out_origin + (ptrdiff_t)x * out_step_x + (ptrdiff_t)y * out_step_y;
+          if (fixedPointApplier) {
+            const uint8_t* y_data =
+                reinterpret_cast<const uint8_t*>(sdr_intent->planes[UHDR_PLANE_Y]);
+            uint8_t y_code = y_data[x + y * sdr_intent->stride[UHDR_PLANE_Y]];
+            uint8_t u_code = 128, v_code = 128;
+            if (sdr_intent->fmt != UHDR_IMG_FMT_8bppYCbCr400) {
+              const uint8_t* u_data =
+                  reinterpret_cast<const uint8_t*>(sdr_intent->planes[UHDR_PLANE_U]);
+              const uint8_t* v_data =
+                  reinterpret_cast<const uint8_t*>(sdr_intent->planes[UHDR_PLANE_V]);
+              size_t cx = x / chroma_sub_x, cy = y / chroma_sub_y;
+              u_code = u_data[cx + cy * sdr_intent->stride[UHDR_PLANE_U]];
+              v_code = v_data[cx + cy * sdr_intent->stride[UHDR_PLANE_V]];
+            }
+            int32_t gain_idx[3];
+            if (gainmap_img->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
+              int32_t idx;
+              if (nearest_map_sampling) {
+                idx = FixedPointGainMapApplier::getGainIndexFromCode(
+                    sampleMapNearestCode(gainmap_img, map_scale_factor, x, y));
+              } else {
+                idx = FixedPointGainMapApplier::getGainIndex(gains[x]);
+              }
+              gain_idx[0] = gain_idx[1] = gain_idx[2] = idx;
+            } else {
+              bool has_alpha = gainmap_img->fmt == UHDR_IMG_FMT_32bppRGBA8888;
+              if (nearest_map_sampling) {
+                const uint8_t* gain =
+                    sampleMap3ChannelNearestCode(gainmap_img, map_scale_factor, x, y, has_alpha);
+                for (int c = 0; c < 3; c++) {
+                  gain_idx[c] = FixedPointGainMapApplier::getGainIndexFromCode(gain[c]);
+                }
+              } else {
+                for (int c = 0; c < 3; c++) {
+                  gain_idx[c] = FixedPointGainMapApplier::getGainIndex(gains[x * 3 + c]);
+                }
+              }
+            }
+            reinterpret_cast<uint32_t*>(dest->planes[UHDR_PLANE_PACKED])[pixel_idx] =
+                fixedPointApplier->apply(y_code, u_code, v_code, gain_idx[0], gain_idx[1],
+                                         gain_idx[2]);
+            continue;
+          }
           Color yuv_gamma_sdr = get_pixel_fn(sdr_intent, x, y);
           // Assuming the sdr image is a decoded JPEG, we should always use Rec.601 YUV coefficients
           Color rgb_gamma_sdr = p3YuvToRgb(yuv_gamma_sdr);
+          if (gainTable2D) {
+            float gain;
+
+            if (nearest_map_sampling) {
+              gain = sampleMapNearest(gainmap_img, map_scale_factor, x, y);
+            } else {
+              gain = gains[x];
+            }
+            reinterpret_cast<uint32_t*>(dest->planes[UHDR_PLANE_PACKED])[pixel_idx] =
+                gainTable2D->getRgba1010102(rgb_gamma_sdr, gain);
+            continue;
+          }
           // We are assuming the SDR base image is always sRGB transfer.
-#if USE_SRGB_INVOETF_LUT
-          Color rgb_sdr = srgbInvOetfLUT(rgb_gamma_sdr);
-#else
-          Color rgb_sdr = srgbInvOetf(rgb_gamma_sdr);
-#endif
-          rgb_sdr = sdrGamutConversionFn(rgb_sdr);
+          Color rgb_sdr = sdrInvOetf(rgb_gamma_sdr);
+          if (apply_sdr_pipeline) rgb_sdr = sdrPipeline.apply(rgb_sdr);
           Color rgb_hdr;
-          if (gainmap_img->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
+          if (nearest_map_sampling && use_gain_lut) {
+            // nearest samples are exact 8-bit codes, index the gain table with them directly
+            if (gainmap_img->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
+              uint8_t gain = sampleMapNearestCode(gainmap_img, map_scale_factor, x, y);
+              rgb_hdr = applyGainLUTFromCode(rgb_sdr, gain, gainLUT, gainmap_metadata);
+            } else {
+              bool has_alpha = gainmap_img->fmt == UHDR_IMG_FMT_32bppRGBA8888;
+              const uint8_t* gain =
+                  sampleMap3ChannelNearestCode(gainmap_img, map_scale_factor, x, y, has_alpha);
+              rgb_hdr = applyGainLUTFromCode(rgb_sdr, gain, gainLUT, gainmap_metadata);
+            }
+          } else if (gainmap_img->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
             float gain;
 
-            if (map_scale_factor != floorf(map_scale_factor)) {
-              gain = sampleMap(gainmap_img, map_scale_factor, x, y);
+            if (nearest_map_sampling) {
+              gain = sampleMapNearest(gainmap_img, map_scale_factor, x, y);
             } else {
-              gain = sampleMap(gainmap_img, map_scale_factor, x, y, idwTable);
+              gain = gains[x];
             }
 
-#if USE_APPLY_GAIN_LUT
-            rgb_hdr = applyGainLUT(rgb_sdr, gain, gainLUT, gainmap_metadata);
-#else
-            rgb_hdr = applyGain(rgb_sdr, gain, gainmap_metadata, gainmap_weight);
-#endif
+            if (use_gain_lut) {
+              rgb_hdr = applyGainLUT(rgb_sdr, gain, gainLUT, gainmap_metadata);
+            } else {
+              rgb_hdr = applyGain(rgb_sdr, gain, gainmap_metadata, gainmap_weight, use_fast_math);
+            }
           } else {
             Color gain;
+            bool has_alpha = gainmap_img->fmt == UHDR_IMG_FMT_32bppRGBA8888;
 
-            if (map_scale_factor != floorf(map_scale_factor)) {
-              gain = sampleMap3Channel(gainmap_img, map_scale_factor, x, y,
-                                       gainmap_img->fmt == UHDR_IMG_FMT_32bppRGBA8888);
+            if (nearest_map_sampling) {
+              gain = sampleMap3ChannelNearest(gainmap_img, map_scale_factor, x, y, has_alpha);
             } else {
-              gain = sampleMap3Channel(gainmap_img, map_scale_factor, x, y, idwTable,
-                                       gainmap_img->fmt == UHDR_IMG_FMT_32bppRGBA8888);
+              gain = {{{gains[x * 3], gains[x * 3 + 1], gains[x * 3 + 2]}}};
             }
 
-#if USE_APPLY_GAIN_LUT
-            rgb_hdr = applyGainLUT(rgb_sdr, gain, gainLUT, gainmap_metadata);
-#else
-            rgb_hdr = applyGain(rgb_sdr, gain, gainmap_metadata, gainmap_weight);
-#endif
+            if (use_gain_lut) {
+              rgb_hdr = applyGainLUT(rgb_sdr, gain, gainLUT, gainmap_metadata);
+            } else {
+              rgb_hdr = applyGain(rgb_sdr, gain, gainmap_metadata, gainmap_weight, use_fast_math);
+            }
           }
 
-          size_t pixel_idx = x + y * dest->stride[UHDR_PLANE_PACKED];
-
           switch (output_ct) {
             case UHDR_CT_LINEAR: {
-              rgb_hdr = hdrGamutConversionFn(rgb_hdr);
+              rgb_hdr = hdrPipeline.apply(rgb_hdr);
               rgb_hdr = clampPixelFloatLinear(rgb_hdr);
-              uint64_t rgba_f16 = colorToRgbaF16(rgb_hdr);
-              reinterpret_cast<uint64_t*>(dest->planes[UHDR_PLANE_PACKED])[pixel_idx] = rgba_f16;
+              float* rgba = &linearRow[x * 4];
+              rgba[0] = rgb_hdr.r;
+              rgba[1] = rgb_hdr.g;
+              rgba[2] = rgb_hdr.b;
+              rgba[3] = 1.0f;
               break;
             }
             case UHDR_CT_HLG: {
-#if USE_HLG_OETF_LUT
-              ColorTransformFn hdrOetf = hlgOetfLUT;
-#else
-              ColorTransformFn hdrOetf = hlgOetf;
-#endif
-              rgb_hdr = rgb_hdr * kSdrWhiteNits / kHlgMaxNits;
-              rgb_hdr = hdrGamutConversionFn(rgb_hdr);
+              rgb_hdr = hdrPipeline.apply(rgb_hdr);
               rgb_hdr = clampPixelFloat(rgb_hdr);
               rgb_hdr = hlgInverseOotfApprox(rgb_hdr);
               Color rgb_gamma_hdr = hdrOetf(rgb_hdr);
@@ -1662,13 +2694,7 @@ uhdr_error_info_t JpegR::applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_ima
               break;
             }
             case UHDR_CT_PQ: {
-#if USE_PQ_OETF_LUT
-              ColorTransformFn hdrOetf = pqOetfLUT;
-#else
-              ColorTransformFn hdrOetf = pqOetf;
-#endif
-              rgb_hdr = rgb_hdr * kSdrWhiteNits / kPqMaxNits;
-              rgb_hdr = hdrGamutConversionFn(rgb_hdr);
+              rgb_hdr = hdrPipeline.apply(rgb_hdr);
               rgb_hdr = clampPixelFloat(rgb_hdr);
               Color rgb_gamma_hdr = hdrOetf(rgb_hdr);
               uint32_t rgba_1010102 = colorToRgba1010102(rgb_gamma_hdr);
@@ -1681,6 +2707,20 @@ uhdr_error_info_t JpegR::applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_ima
               // Should be impossible to hit after input validation.
           }
         }
+        if (output_ct == UHDR_CT_LINEAR) {
+          uint64_t* rgbaData = reinterpret_cast<uint64_t*>(dest->planes[UHDR_PLANE_PACKED]);
+          const ptrdiff_t row_idx = out_origin + (ptrdiff_t)y * out_step_y;
+          if (out_step_x == 1) {
+            floatToHalfRow(linearRow.data(), reinterpret_cast<uint16_t*>(rgbaData + row_idx),
+                           linearRow.size());
+          } else {
+            floatToHalfRow(linearRow.data(), halfRow.data(), halfRow.size());
+            const uint64_t* pixels = reinterpret_cast<const uint64_t*>(halfRow.data());
+            for (size_t x = 0; x < width; ++x) {
+              rgbaData[row_idx + (ptrdiff_t)x * out_step_x] = pixels[x];
+            }
+          }
+        }
       }
     }
   };
@@ -1690,7 +2730,11 @@ uhdr_error_info_t JpegR::applyGainMap(uhdr_raw_image_t* sdr_intent, uhdr_raw_ima
   for (int th = 0; th < threads - 1; th++) {
     workers.push_back(std::thread(applyRecMap));
   }
-  const unsigned int rowStep = threads == 1 ? sdr_intent->h : map_scale_factor_rnd;
+  // jobs cover whole bands of gain map cells, several bands per job. A thread then expands each map
+  // row it touches once and reuses the samples and weights across all output rows of the band
+  const int bands_per_job = (std::max)(1, kApplyGainMapJobRows / map_scale_factor_rnd);
+  const unsigned int rowStep =
+      threads == 1 ? sdr_intent->h : map_scale_factor_rnd * bands_per_job;
   for (unsigned int rowStart = 0; rowStart < sdr_intent->h;) {
     unsigned int rowEnd = (std::min)(rowStart + rowStep, sdr_intent->h);
     jobQueue.enqueueJob(rowStart, rowEnd);
@@ -1993,16 +3037,20 @@ uhdr_error_info_t JpegR::toneMap(uhdr_raw_image_t* hdr_intent, uhdr_raw_image_t*
   ColorTransformFn hdrGamutConversionFn = getGamutConversionFn(sdr_intent->cg, hdr_intent->cg);
 
   unsigned int height = hdr_intent->h;
-  const int threads = (std::min)(GetCPUCoreCount(), 4u);
+  const int threads = (std::min)(GetCPUCoreCount(), getEncPresetConfig(mEncPreset).max_threads);
   // for 420 subsampling, process 2 rows at once
   const int jobSizeInRows = hdr_intent->fmt == UHDR_IMG_FMT_24bppYCbCrP010 ? 2 : 1;
   unsigned int rowStep = threads == 1 ? height : jobSizeInRows;
+  // packed rgb hdr intent is linearized straight from its sample codes
+  const float* hdrInvOetfTable = hdr_intent->fmt == UHDR_IMG_FMT_32bppRGBA1010102
+                                     ? getInverseOetfCodeTable(hdr_intent->ct, hdr_intent->fmt)
+                                     : nullptr;
   JobQueue jobQueue;
   std::function<void()> toneMapInternal;
 
   toneMapInternal = [hdr_intent, sdr_intent, hdrInvOetf, hdrGamutConversionFn, hdrYuvToRgbFn,
                      hdr_white_nits, get_pixel_fn, put_pixel_fn, hdrLuminanceFn, hdrOotfFn,
-                     &jobQueue]() -> void {
+                     hdrInvOetfTable, &jobQueue]() -> void {
     unsigned int rowStart, rowEnd;
     const int hfactor = hdr_intent->fmt == UHDR_IMG_FMT_24bppYCbCrP010 ? 2 : 1;
     const int vfactor = hdr_intent->fmt == UHDR_IMG_FMT_24bppYCbCrP010 ? 2 : 1;
@@ -2025,15 +3073,21 @@ uhdr_error_info_t JpegR::toneMap(uhdr_raw_image_t* hdr_intent, uhdr_raw_image_t*
 
           for (int i = 0; i < vfactor; i++) {
             for (int j = 0; j < hfactor; j++) {
-              Color hdr_rgb_gamma;
+              Color hdr_rgb;
 
-              if (isHdrIntentRgb) {
-                hdr_rgb_gamma = get_pixel_fn(hdr_intent, x + j, y + i);
+              if (hdrInvOetfTable) {
+                hdr_rgb = getRgba1010102PixelLinear(hdr_intent, x + j, y + i, hdrInvOetfTable);
               } else {
-                Color hdr_yuv_gamma = get_pixel_fn(hdr_intent, x + j, y + i);
-                hdr_rgb_gamma = hdrYuvToRgbFn(hdr_yuv_gamma);
+                Color hdr_rgb_gamma;
+
+                if (isHdrIntentRgb) {
+                  hdr_rgb_gamma = get_pixel_fn(hdr_intent, x + j, y + i);
+                } else {
+                  Color hdr_yuv_gamma = get_pixel_fn(hdr_intent, x + j, y + i);
+                  hdr_rgb_gamma = hdrYuvToRgbFn(hdr_yuv_gamma);
+                }
+                hdr_rgb = hdrInvOetf(hdr_rgb_gamma);
               }
-              Color hdr_rgb = hdrInvOetf(hdr_rgb_gamma);
               hdr_rgb = hdrOotfFn(hdr_rgb, hdrLuminanceFn);
 
               GlobalTonemapOutputs tonemap_outputs = globalTonemap(
@@ -2153,8 +3207,10 @@ status_t JpegR::areInputArgumentsValid(jr_uncompressed_ptr p010_image_ptr,
     ALOGE("unsupported gainmap gamma %f, expects to be > 0", mGamma);
     return ERROR_JPEGR_INVALID_GAMMA;
   }
-  if (mEncPreset != UHDR_USAGE_REALTIME && mEncPreset != UHDR_USAGE_BEST_QUALITY) {
-    ALOGE("invalid preset %d, expects one of {UHDR_USAGE_REALTIME, UHDR_USAGE_BEST_QUALITY}",
+  if (mEncPreset != UHDR_USAGE_REALTIME && mEncPreset != UHDR_USAGE_BEST_QUALITY &&
+      mEncPreset != UHDR_USAGE_FASTEST && mEncPreset != UHDR_USAGE_BALANCED) {
+    ALOGE("invalid preset %d, expects one of {UHDR_USAGE_REALTIME, UHDR_USAGE_BEST_QUALITY, "
+          "UHDR_USAGE_FASTEST, UHDR_USAGE_BALANCED}",
           mEncPreset);
     return ERROR_JPEGR_INVALID_ENC_PRESET;
   }
@@ -108,6 +108,40 @@ uhdr_raw_image_ext::uhdr_raw_image_ext(uhdr_img_fmt_t fmt_, uhdr_color_gamut_t c
   }
 }
 
+uhdr_raw_image_ext::uhdr_raw_image_ext(const uhdr_raw_image_ext& parent, unsigned left,
+                                       unsigned top, unsigned w_, unsigned h_)
+    : uhdr_raw_image_t(parent), m_block(parent.m_block) {
+  this->w = w_;
+  this->h = h_;
+
+  size_t bpp = 1;
+  if (fmt == UHDR_IMG_FMT_24bppYCbCrP010 || fmt == UHDR_IMG_FMT_30bppYCbCr444) {
+    bpp = 2;
+  } else if (fmt == UHDR_IMG_FMT_24bppRGB888) {
+    bpp = 3;
+  } else if (fmt == UHDR_IMG_FMT_32bppRGBA8888 || fmt == UHDR_IMG_FMT_32bppRGBA1010102) {
+    bpp = 4;
+  } else if (fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat) {
+    bpp = 8;
+  }
+
+  uint8_t* y = static_cast<uint8_t*>(parent.planes[UHDR_PLANE_Y]);
+  this->planes[UHDR_PLANE_Y] = y + bpp * (top * (size_t)parent.stride[UHDR_PLANE_Y] + left);
+  if (fmt == UHDR_IMG_FMT_24bppYCbCrP010) {
+    // interleaved cb, cr samples, one pair per two luma columns
+    uint8_t* uv = static_cast<uint8_t*>(parent.planes[UHDR_PLANE_UV]);
+    this->planes[UHDR_PLANE_UV] =
+        uv + bpp * ((top / 2) * (size_t)parent.stride[UHDR_PLANE_UV] + (left / 2) * 2);
+  } else if (fmt == UHDR_IMG_FMT_30bppYCbCr444 || fmt == UHDR_IMG_FMT_24bppYCbCr444 ||
+             fmt == UHDR_IMG_FMT_12bppYCbCr420) {
+    const unsigned shift = fmt == UHDR_IMG_FMT_12bppYCbCr420 ? 1 : 0;
+    for (int i = UHDR_PLANE_U; i <= UHDR_PLANE_V; i++) {
+      uint8_t* c = static_cast<uint8_t*>(parent.planes[i]);
+      this->planes[i] = c + bpp * ((top >> shift) * (size_t)parent.stride[i] + (left >> shift));
+    }
+  }
+}
+
 uhdr_compressed_image_ext::uhdr_compressed_image_ext(uhdr_color_gamut_t cg_,
                                                      uhdr_color_transfer_t ct_,
                                                      uhdr_color_range_t range_, size_t size) {
@@ -120,30 +154,53 @@ uhdr_compressed_image_ext::uhdr_compressed_image_ext(uhdr_color_gamut_t cg_,
   this->range = range_;
 }
 
+// effect chains that reduce to a crop hand out a view on the source image, anything else is
+// remapped into a new image
+static std::unique_ptr<uhdr_raw_image_ext_t> transform_image(const uhdr_effect_transform_t* xfm,
+                                                             uhdr_raw_image_ext_t* src) {
+  int left, top;
+  if (xfm->is_crop(&left, &top)) {
+    auto view = crop_view(src, left, top, xfm->width(), xfm->height());
+    if (view != nullptr) return view;
+  }
+  return apply_transform(xfm, src);
+}
+
 uhdr_error_info_t apply_effects(uhdr_encoder_private* enc) {
-  for (auto& it : enc->m_effects) {
-    std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> hdr_img = nullptr;
-    std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> sdr_img = nullptr;
+  if (enc->m_effects.empty()) return g_no_error;
+
+  // the effect chain is folded into one geometric transform per image, the pixels are then moved
+  // in a single pass
+  auto& hdr_raw_entry = enc->m_raw_images.find(UHDR_HDR_IMG)->second;
+  uhdr_effect_transform_t hdr_xfm(hdr_raw_entry->fmt, hdr_raw_entry->w, hdr_raw_entry->h);
+  std::unique_ptr<uhdr_effect_transform_t> sdr_xfm = nullptr;
+  if (enc->m_raw_images.find(UHDR_SDR_IMG) != enc->m_raw_images.end()) {
+    auto& sdr_raw_entry = enc->m_raw_images.find(UHDR_SDR_IMG)->second;
+    sdr_xfm = std::make_unique<uhdr_effect_transform_t>(sdr_raw_entry->fmt, sdr_raw_entry->w,
+                                                        sdr_raw_entry->h);
+  }
 
+  for (auto& it : enc->m_effects) {
     if (nullptr != dynamic_cast<uhdr_rotate_effect_t*>(it)) {
-      auto& hdr_raw_entry = enc->m_raw_images.find(UHDR_HDR_IMG)->second;
-      hdr_img = apply_rotate(dynamic_cast<uhdr_rotate_effect_t*>(it), hdr_raw_entry.get());
-      if (enc->m_raw_images.find(UHDR_SDR_IMG) != enc->m_raw_images.end()) {
-        auto& sdr_raw_entry = enc->m_raw_images.find(UHDR_SDR_IMG)->second;
-        sdr_img = apply_rotate(dynamic_cast<uhdr_rotate_effect_t*>(it), sdr_raw_entry.get());
+      int degree = dynamic_cast<uhdr_rotate_effect_t*>(it)->m_degree;
+      if (degree != 90 && degree != 180 && degree != 270) {
+        uhdr_error_info_t status;
+        status.error_code = UHDR_CODEC_UNKNOWN_ERROR;
+        status.has_detail = 1;
+        snprintf(status.detail, sizeof status.detail,
+                 "encountered unknown error while applying effect %s", it->to_string().c_str());
+        return status;
       }
+      hdr_xfm.rotate(degree);
+      if (sdr_xfm) sdr_xfm->rotate(degree);
     } else if (nullptr != dynamic_cast<uhdr_mirror_effect_t*>(it)) {
-      auto& hdr_raw_entry = enc->m_raw_images.find(UHDR_HDR_IMG)->second;
-      hdr_img = apply_mirror(dynamic_cast<uhdr_mirror_effect_t*>(it), hdr_raw_entry.get());
-      if (enc->m_raw_images.find(UHDR_SDR_IMG) != enc->m_raw_images.end()) {
-        auto& sdr_raw_entry = enc->m_raw_images.find(UHDR_SDR_IMG)->second;
-        sdr_img = apply_mirror(dynamic_cast<uhdr_mirror_effect_t*>(it), sdr_raw_entry.get());
-      }
+      uhdr_mirror_direction_t direction = dynamic_cast<uhdr_mirror_effect_t*>(it)->m_direction;
+      hdr_xfm.mirror(direction);
+      if (sdr_xfm) sdr_xfm->mirror(direction);
     } else if (nullptr != dynamic_cast<uhdr_crop_effect_t*>(it)) {
       auto crop_effect = dynamic_cast<uhdr_crop_effect_t*>(it);
-      auto& hdr_raw_entry = enc->m_raw_images.find(UHDR_HDR_IMG)->second;
       int left = (std::max)(0, crop_effect->m_left);
-      int right = (std::min)((int)hdr_raw_entry->w, crop_effect->m_right);
+      int right = (std::min)(hdr_xfm.width(), crop_effect->m_right);
       int crop_width = right - left;
       if (crop_width <= 0) {
         uhdr_error_info_t status;
@@ -166,7 +223,7 @@ uhdr_error_info_t apply_effects(uhdr_encoder_private* enc) {
       }
 
       int top = (std::max)(0, crop_effect->m_top);
-      int bottom = (std::min)((int)hdr_raw_entry->h, crop_effect->m_bottom);
+      int bottom = (std::min)(hdr_xfm.height(), crop_effect->m_bottom);
       int crop_height = bottom - top;
       if (crop_height <= 0) {
         uhdr_error_info_t status;
@@ -187,11 +244,9 @@ uhdr_error_info_t apply_effects(uhdr_encoder_private* enc) {
                  crop_height);
         return status;
       }
-      hdr_img = apply_crop(dynamic_cast<ultrahdr::uhdr_crop_effect_t*>(it), hdr_raw_entry.get(),
-                           left, top, crop_width, crop_height);
-      if (enc->m_raw_images.find(UHDR_SDR_IMG) != enc->m_raw_images.end()) {
-        auto& sdr_raw_entry = enc->m_raw_images.find(UHDR_SDR_IMG)->second;
-        if (crop_width % 2 != 0 && sdr_raw_entry->fmt == UHDR_IMG_FMT_12bppYCbCr420) {
+      hdr_xfm.crop(left, top, crop_width, crop_height);
+      if (sdr_xfm) {
+        if (crop_width % 2 != 0 && sdr_xfm->m_fmt == UHDR_IMG_FMT_12bppYCbCr420) {
           uhdr_error_info_t status;
           status.error_code = UHDR_CODEC_INVALID_PARAM;
           status.has_detail = 1;
@@ -201,7 +256,7 @@ uhdr_error_info_t apply_effects(uhdr_encoder_private* enc) {
                    crop_width);
           return status;
         }
-        if (crop_height % 2 != 0 && sdr_raw_entry->fmt == UHDR_IMG_FMT_12bppYCbCr420) {
+        if (crop_height % 2 != 0 && sdr_xfm->m_fmt == UHDR_IMG_FMT_12bppYCbCr420) {
           uhdr_error_info_t status;
           status.error_code = UHDR_CODEC_INVALID_PARAM;
           status.has_detail = 1;
@@ -211,14 +266,12 @@ uhdr_error_info_t apply_effects(uhdr_encoder_private* enc) {
                    crop_height);
           return status;
         }
-        sdr_img = apply_crop(dynamic_cast<ultrahdr::uhdr_crop_effect_t*>(it), sdr_raw_entry.get(),
-                             left, top, crop_width, crop_height);
+        sdr_xfm->crop(left, top, crop_width, crop_height);
       }
     } else if (nullptr != dynamic_cast<uhdr_resize_effect_t*>(it)) {
       auto resize_effect = dynamic_cast<uhdr_resize_effect_t*>(it);
       int dst_w = resize_effect->m_width;
       int dst_h = resize_effect->m_height;
-      auto& hdr_raw_entry = enc->m_raw_images.find(UHDR_HDR_IMG)->second;
       if (dst_w <= 0 || dst_h <= 0 || dst_w > ultrahdr::kMaxWidth || dst_h > ultrahdr::kMaxHeight) {
         uhdr_error_info_t status;
         status.error_code = UHDR_CODEC_INVALID_PARAM;
@@ -237,12 +290,9 @@ uhdr_error_info_t apply_effects(uhdr_encoder_private* enc) {
                  dst_w, dst_h);
         return status;
       }
-      hdr_img =
-          apply_resize(dynamic_cast<uhdr_resize_effect_t*>(it), hdr_raw_entry.get(), dst_w, dst_h);
-      if (enc->m_raw_images.find(UHDR_SDR_IMG) != enc->m_raw_images.end()) {
-        auto& sdr_raw_entry = enc->m_raw_images.find(UHDR_SDR_IMG)->second;
-        if ((dst_w % 2 != 0 || dst_h % 2 != 0) &&
-            sdr_raw_entry->fmt == UHDR_IMG_FMT_12bppYCbCr420) {
+      hdr_xfm.resize(dst_w, dst_h);
+      if (sdr_xfm) {
+        if ((dst_w % 2 != 0 || dst_h % 2 != 0) && sdr_xfm->m_fmt == UHDR_IMG_FMT_12bppYCbCr420) {
           uhdr_error_info_t status;
           status.error_code = UHDR_CODEC_INVALID_PARAM;
           snprintf(status.detail, sizeof status.detail,
@@ -251,24 +301,28 @@ uhdr_error_info_t apply_effects(uhdr_encoder_private* enc) {
                    dst_w, dst_h);
           return status;
         }
-        sdr_img = apply_resize(dynamic_cast<uhdr_resize_effect_t*>(it), sdr_raw_entry.get(), dst_w,
-                               dst_h);
+        sdr_xfm->resize(dst_w, dst_h);
       }
     }
+  }
 
-    if (hdr_img == nullptr ||
-        (enc->m_raw_images.find(UHDR_SDR_IMG) != enc->m_raw_images.end() && sdr_img == nullptr)) {
-      uhdr_error_info_t status;
-      status.error_code = UHDR_CODEC_UNKNOWN_ERROR;
-      status.has_detail = 1;
-      snprintf(status.detail, sizeof status.detail,
-               "encountered unknown error while applying effect %s", it->to_string().c_str());
-      return status;
-    }
-    enc->m_raw_images.insert_or_assign(UHDR_HDR_IMG, std::move(hdr_img));
-    if (sdr_img != nullptr) {
-      enc->m_raw_images.insert_or_assign(UHDR_SDR_IMG, std::move(sdr_img));
-    }
+  std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> hdr_img =
+      transform_image(&hdr_xfm, hdr_raw_entry.get());
+  std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> sdr_img = nullptr;
+  if (sdr_xfm) {
+    sdr_img = transform_image(sdr_xfm.get(), enc->m_raw_images.find(UHDR_SDR_IMG)->second.get());
+  }
+  if (hdr_img == nullptr || (sdr_xfm && sdr_img == nullptr)) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_UNKNOWN_ERROR;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "encountered unknown error while applying effects");
+    return status;
+  }
+  enc->m_raw_images.insert_or_assign(UHDR_HDR_IMG, std::move(hdr_img));
+  if (sdr_img != nullptr) {
+    enc->m_raw_images.insert_or_assign(UHDR_SDR_IMG, std::move(sdr_img));
   }
 
   return g_no_error;
@@ -278,49 +332,50 @@ bool is_resize_effect(const ultrahdr::uhdr_effect_desc_t* effect) {
   return dynamic_cast<const ultrahdr::uhdr_resize_effect_t*>(effect) != nullptr;
 }
 
-uhdr_error_info_t apply_effects(uhdr_decoder_private* dec) {
-  void *gl_ctxt = nullptr, *disp_texture_ptr = nullptr, *gm_texture_ptr = nullptr;
-#ifdef UHDR_ENABLE_GLES
-  if (dec->m_enable_gles) {
-    gl_ctxt = &dec->m_uhdr_gl_ctxt;
-    bool texture_created =
-        dec->m_uhdr_gl_ctxt.mDecodedImgTexture != 0 && dec->m_uhdr_gl_ctxt.mGainmapImgTexture != 0;
-    bool resize_effect_present = std::find_if(dec->m_effects.begin(), dec->m_effects.end(),
-                                              is_resize_effect) != dec->m_effects.end();
-    if (!texture_created && resize_effect_present &&
-        isBufferDataContiguous(dec->m_decoded_img_buffer.get()) &&
-        isBufferDataContiguous(dec->m_gainmap_img_buffer.get())) {
-      dec->m_uhdr_gl_ctxt.mDecodedImgTexture = dec->m_uhdr_gl_ctxt.create_texture(
-          dec->m_decoded_img_buffer->fmt, dec->m_decoded_img_buffer->w,
-          dec->m_decoded_img_buffer->h, dec->m_decoded_img_buffer->planes[0]);
-      dec->m_uhdr_gl_ctxt.mGainmapImgTexture = dec->m_uhdr_gl_ctxt.create_texture(
-          dec->m_gainmap_img_buffer->fmt, dec->m_gainmap_img_buffer->w,
-          dec->m_gainmap_img_buffer->h, dec->m_gainmap_img_buffer->planes[0]);
-    }
-    disp_texture_ptr = &dec->m_uhdr_gl_ctxt.mDecodedImgTexture;
-    gm_texture_ptr = &dec->m_uhdr_gl_ctxt.mGainmapImgTexture;
-  }
-#endif
+// validates the decoder effect chain and folds it in to one geometric transform for the display
+// image and one for the gain map. With a gpu context each effect is also applied to the decoded
+// buffers as it comes
+static uhdr_error_info_t compile_effects(uhdr_decoder_private* dec,
+                                         uhdr_effect_transform_t* disp_xfm,
+                                         uhdr_effect_transform_t* gm_xfm, void* gl_ctxt,
+                                         void* disp_texture_ptr, void* gm_texture_ptr) {
   for (auto& it : dec->m_effects) {
     std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> disp_img = nullptr;
     std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> gm_img = nullptr;
 
     if (nullptr != dynamic_cast<uhdr_rotate_effect_t*>(it)) {
-      disp_img = apply_rotate(dynamic_cast<uhdr_rotate_effect_t*>(it),
-                              dec->m_decoded_img_buffer.get(), gl_ctxt, disp_texture_ptr);
-      gm_img = apply_rotate(dynamic_cast<uhdr_rotate_effect_t*>(it),
-                            dec->m_gainmap_img_buffer.get(), gl_ctxt, gm_texture_ptr);
+      auto rotate_effect = dynamic_cast<uhdr_rotate_effect_t*>(it);
+      if (rotate_effect->m_degree != 90 && rotate_effect->m_degree != 180 &&
+          rotate_effect->m_degree != 270) {
+        uhdr_error_info_t status;
+        status.error_code = UHDR_CODEC_UNKNOWN_ERROR;
+        status.has_detail = 1;
+        snprintf(status.detail, sizeof status.detail,
+                 "encountered unknown error while applying effect %s", it->to_string().c_str());
+        return status;
+      }
+      disp_xfm->rotate(rotate_effect->m_degree);
+      gm_xfm->rotate(rotate_effect->m_degree);
+      if (gl_ctxt != nullptr) {
+        disp_img = apply_rotate(rotate_effect, dec->m_decoded_img_buffer.get(), gl_ctxt,
+                                disp_texture_ptr);
+        gm_img = apply_rotate(rotate_effect, dec->m_gainmap_img_buffer.get(), gl_ctxt,
+                              gm_texture_ptr);
+      }
     } else if (nullptr != dynamic_cast<uhdr_mirror_effect_t*>(it)) {
-      disp_img = apply_mirror(dynamic_cast<uhdr_mirror_effect_t*>(it),
-                              dec->m_decoded_img_buffer.get(), gl_ctxt, disp_texture_ptr);
-      gm_img = apply_mirror(dynamic_cast<uhdr_mirror_effect_t*>(it),
-                            dec->m_gainmap_img_buffer.get(), gl_ctxt, gm_texture_ptr);
+      auto mirror_effect = dynamic_cast<uhdr_mirror_effect_t*>(it);
+      disp_xfm->mirror(mirror_effect->m_direction);
+      gm_xfm->mirror(mirror_effect->m_direction);
+      if (gl_ctxt != nullptr) {
+        disp_img = apply_mirror(mirror_effect, dec->m_decoded_img_buffer.get(), gl_ctxt,
+                                disp_texture_ptr);
+        gm_img = apply_mirror(mirror_effect, dec->m_gainmap_img_buffer.get(), gl_ctxt,
+                              gm_texture_ptr);
+      }
     } else if (nullptr != dynamic_cast<uhdr_crop_effect_t*>(it)) {
       auto crop_effect = dynamic_cast<uhdr_crop_effect_t*>(it);
-      uhdr_raw_image_t* disp = dec->m_decoded_img_buffer.get();
-      uhdr_raw_image_t* gm = dec->m_gainmap_img_buffer.get();
       int left = (std::max)(0, crop_effect->m_left);
-      int right = (std::min)((int)disp->w, crop_effect->m_right);
+      int right = (std::min)(disp_xfm->width(), crop_effect->m_right);
       if (right <= left) {
         uhdr_error_info_t status;
         status.error_code = UHDR_CODEC_INVALID_PARAM;
@@ -333,7 +388,7 @@ uhdr_error_info_t apply_effects(uhdr_decoder_private* dec) {
       }
 
       int top = (std::max)(0, crop_effect->m_top);
-      int bottom = (std::min)((int)disp->h, crop_effect->m_bottom);
+      int bottom = (std::min)(disp_xfm->height(), crop_effect->m_bottom);
       if (bottom <= top) {
         uhdr_error_info_t status;
         status.error_code = UHDR_CODEC_INVALID_PARAM;
@@ -345,8 +400,8 @@ uhdr_error_info_t apply_effects(uhdr_decoder_private* dec) {
         return status;
       }
 
-      float wd_ratio = ((float)disp->w) / gm->w;
-      float ht_ratio = ((float)disp->h) / gm->h;
+      float wd_ratio = ((float)disp_xfm->width()) / gm_xfm->width();
+      float ht_ratio = ((float)disp_xfm->height()) / gm_xfm->height();
       int gm_left = (int)(left / wd_ratio);
       int gm_right = (int)(right / wd_ratio);
       if (gm_right <= gm_left) {
@@ -373,18 +428,20 @@ uhdr_error_info_t apply_effects(uhdr_decoder_private* dec) {
         return status;
       }
 
-      disp_img = apply_crop(dynamic_cast<ultrahdr::uhdr_crop_effect_t*>(it), disp, left, top,
-                            right - left, bottom - top, gl_ctxt, disp_texture_ptr);
-      gm_img = apply_crop(dynamic_cast<ultrahdr::uhdr_crop_effect_t*>(it), gm, gm_left, gm_top,
-                          (gm_right - gm_left), (gm_bottom - gm_top), gl_ctxt, gm_texture_ptr);
+      disp_xfm->crop(left, top, right - left, bottom - top);
+      gm_xfm->crop(gm_left, gm_top, gm_right - gm_left, gm_bottom - gm_top);
+      if (gl_ctxt != nullptr) {
+        disp_img = apply_crop(crop_effect, dec->m_decoded_img_buffer.get(), left, top,
+                              right - left, bottom - top, gl_ctxt, disp_texture_ptr);
+        gm_img = apply_crop(crop_effect, dec->m_gainmap_img_buffer.get(), gm_left, gm_top,
+                            (gm_right - gm_left), (gm_bottom - gm_top), gl_ctxt, gm_texture_ptr);
+      }
     } else if (nullptr != dynamic_cast<uhdr_resize_effect_t*>(it)) {
       auto resize_effect = dynamic_cast<uhdr_resize_effect_t*>(it);
       int dst_w = resize_effect->m_width;
       int dst_h = resize_effect->m_height;
-      float wd_ratio =
-          ((float)dec->m_decoded_img_buffer.get()->w) / dec->m_gainmap_img_buffer.get()->w;
-      float ht_ratio =
-          ((float)dec->m_decoded_img_buffer.get()->h) / dec->m_gainmap_img_buffer.get()->h;
+      float wd_ratio = ((float)disp_xfm->width()) / gm_xfm->width();
+      float ht_ratio = ((float)disp_xfm->height()) / gm_xfm->height();
       int dst_gm_w = (int)(dst_w / wd_ratio);
       int dst_gm_h = (int)(dst_h / ht_ratio);
       if (dst_w <= 0 || dst_h <= 0 || dst_gm_w <= 0 || dst_gm_h <= 0 ||
@@ -398,20 +455,76 @@ uhdr_error_info_t apply_effects(uhdr_decoder_private* dec) {
                  ultrahdr::kMaxWidth, ultrahdr::kMaxHeight, dst_w, dst_h, dst_gm_w, dst_gm_h);
         return status;
       }
-      disp_img =
-          apply_resize(dynamic_cast<uhdr_resize_effect_t*>(it), dec->m_decoded_img_buffer.get(),
-                       dst_w, dst_h, gl_ctxt, disp_texture_ptr);
-      gm_img =
-          apply_resize(dynamic_cast<uhdr_resize_effect_t*>(it), dec->m_gainmap_img_buffer.get(),
-                       dst_gm_w, dst_gm_h, gl_ctxt, gm_texture_ptr);
+      disp_xfm->resize(dst_w, dst_h);
+      gm_xfm->resize(dst_gm_w, dst_gm_h);
+      if (gl_ctxt != nullptr) {
+        disp_img = apply_resize(resize_effect, dec->m_decoded_img_buffer.get(), dst_w, dst_h,
+                                gl_ctxt, disp_texture_ptr);
+        gm_img = apply_resize(resize_effect, dec->m_gainmap_img_buffer.get(), dst_gm_w, dst_gm_h,
+                              gl_ctxt, gm_texture_ptr);
+      }
     }
 
+    if (gl_ctxt != nullptr) {
+      if (disp_img == nullptr || gm_img == nullptr) {
+        uhdr_error_info_t status;
+        status.error_code = UHDR_CODEC_UNKNOWN_ERROR;
+        status.has_detail = 1;
+        snprintf(status.detail, sizeof status.detail,
+                 "encountered unknown error while applying effect %s", it->to_string().c_str());
+        return status;
+      }
+      dec->m_decoded_img_buffer = std::move(disp_img);
+      dec->m_gainmap_img_buffer = std::move(gm_img);
+    }
+  }
+  return g_no_error;
+}
+
+uhdr_error_info_t apply_effects(uhdr_decoder_private* dec) {
+  void *gl_ctxt = nullptr, *disp_texture_ptr = nullptr, *gm_texture_ptr = nullptr;
+#ifdef UHDR_ENABLE_GLES
+  if (dec->m_enable_gles) {
+    gl_ctxt = &dec->m_uhdr_gl_ctxt;
+    bool texture_created =
+        dec->m_uhdr_gl_ctxt.mDecodedImgTexture != 0 && dec->m_uhdr_gl_ctxt.mGainmapImgTexture != 0;
+    bool resize_effect_present = std::find_if(dec->m_effects.begin(), dec->m_effects.end(),
+                                              is_resize_effect) != dec->m_effects.end();
+    if (!texture_created && resize_effect_present &&
+        isBufferDataContiguous(dec->m_decoded_img_buffer.get()) &&
+        isBufferDataContiguous(dec->m_gainmap_img_buffer.get())) {
+      dec->m_uhdr_gl_ctxt.mDecodedImgTexture = dec->m_uhdr_gl_ctxt.create_texture(
+          dec->m_decoded_img_buffer->fmt, dec->m_decoded_img_buffer->w,
+          dec->m_decoded_img_buffer->h, dec->m_decoded_img_buffer->planes[0]);
+      dec->m_uhdr_gl_ctxt.mGainmapImgTexture = dec->m_uhdr_gl_ctxt.create_texture(
+          dec->m_gainmap_img_buffer->fmt, dec->m_gainmap_img_buffer->w,
+          dec->m_gainmap_img_buffer->h, dec->m_gainmap_img_buffer->planes[0]);
+    }
+    disp_texture_ptr = &dec->m_uhdr_gl_ctxt.mDecodedImgTexture;
+    gm_texture_ptr = &dec->m_uhdr_gl_ctxt.mGainmapImgTexture;
+  }
+#endif
+  // without gpu support the effect chain is folded into one geometric transform per image and
+  // the pixels are moved in a single pass, the gpu path applies each effect as it comes
+  uhdr_raw_image_t* disp = dec->m_decoded_img_buffer.get();
+  uhdr_raw_image_t* gm = dec->m_gainmap_img_buffer.get();
+  uhdr_effect_transform_t disp_xfm(disp->fmt, disp->w, disp->h);
+  uhdr_effect_transform_t gm_xfm(gm->fmt, gm->w, gm->h);
+
+  UHDR_ERR_CHECK(
+      compile_effects(dec, &disp_xfm, &gm_xfm, gl_ctxt, disp_texture_ptr, gm_texture_ptr));
+
+  if (gl_ctxt == nullptr && !dec->m_effects.empty()) {
+    std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> disp_img =
+        transform_image(&disp_xfm, dec->m_decoded_img_buffer.get());
+    std::unique_ptr<ultrahdr::uhdr_raw_image_ext_t> gm_img =
+        transform_image(&gm_xfm, dec->m_gainmap_img_buffer.get());
     if (disp_img == nullptr || gm_img == nullptr) {
       uhdr_error_info_t status;
       status.error_code = UHDR_CODEC_UNKNOWN_ERROR;
       status.has_detail = 1;
       snprintf(status.detail, sizeof status.detail,
-               "encountered unknown error while applying effect %s", it->to_string().c_str());
+               "encountered unknown error while applying effects");
       return status;
     }
     dec->m_decoded_img_buffer = std::move(disp_img);
@@ -616,7 +729,7 @@ uhdr_enc_set_using_multi_channel_gainmap(uhdr_codec_private_t* enc, int use_mult
     return status;
   }
 
-  handle->m_use_multi_channel_gainmap = use_multi_channel_gainmap;
+  handle->m_use_multi_channel_gainmap = use_multi_channel_gainmap ? 1 : 0;
 
   return status;
 }
@@ -701,11 +814,13 @@ uhdr_error_info_t uhdr_enc_set_preset(uhdr_codec_private_t* enc, uhdr_enc_preset
     return status;
   }
 
-  if (preset != UHDR_USAGE_REALTIME && preset != UHDR_USAGE_BEST_QUALITY) {
+  if (preset != UHDR_USAGE_REALTIME && preset != UHDR_USAGE_BEST_QUALITY &&
+      preset != UHDR_USAGE_FASTEST && preset != UHDR_USAGE_BALANCED) {
     status.error_code = UHDR_CODEC_INVALID_PARAM;
     status.has_detail = 1;
     snprintf(status.detail, sizeof status.detail,
-             "invalid preset %d, expects one of {UHDR_USAGE_REALTIME, UHDR_USAGE_BEST_QUALITY}",
+             "invalid preset %d, expects one of {UHDR_USAGE_REALTIME, UHDR_USAGE_BEST_QUALITY, "
+             "UHDR_USAGE_FASTEST, UHDR_USAGE_BALANCED}",
              preset);
     return status;
   }
@@ -818,6 +933,32 @@ uhdr_error_info_t uhdr_enc_set_target_display_peak_brightness(uhdr_codec_private
   return status;
 }
 
+uhdr_error_info_t uhdr_enc_set_target_size(uhdr_codec_private_t* enc, size_t target_size) {
+  uhdr_error_info_t status = g_no_error;
+
+  if (dynamic_cast<uhdr_encoder_private*>(enc) == nullptr) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail, "received nullptr for uhdr codec instance");
+    return status;
+  }
+
+  uhdr_encoder_private* handle = dynamic_cast<uhdr_encoder_private*>(enc);
+
+  if (handle->m_sailed) {
+    status.error_code = UHDR_CODEC_INVALID_OPERATION;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "An earlier call to uhdr_encode() has switched the context from configurable state to "
+             "end state. The context is no longer configurable. To reuse, call reset()");
+    return status;
+  }
+
+  handle->m_target_size = target_size;
+
+  return status;
+}
+
 uhdr_error_info_t uhdr_enc_set_raw_image(uhdr_codec_private_t* enc, uhdr_raw_image_t* img,
                                          uhdr_img_label_t intent) {
   uhdr_error_info_t status = g_no_error;
@@ -1195,15 +1336,17 @@ uhdr_error_info_t uhdr_encode(uhdr_codec_private_t* enc) {
 
   uhdr_error_info_t& status = handle->m_encode_call_status;
 
+  if (handle->m_target_size > 0 && handle->m_compressed_images.size() != 0) {
+    status.error_code = UHDR_CODEC_INVALID_OPERATION;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "target size mode is not enabled for inputs with compressed intent");
+    return status;
+  }
+
   if (handle->m_compressed_images.find(UHDR_BASE_IMG) != handle->m_compressed_images.end() &&
       handle->m_compressed_images.find(UHDR_GAIN_MAP_IMG) != handle->m_compressed_images.end()) {
-    if (handle->m_effects.size() != 0) {
-      status.error_code = UHDR_CODEC_INVALID_OPERATION;
-      status.has_detail = 1;
-      snprintf(status.detail, sizeof status.detail,
-               "image effects are not enabled for inputs with compressed intent");
-      return status;
-    }
+    // api - 4, effects are applied losslessly in the dct domain by the encode call
   } else if (handle->m_raw_images.find(UHDR_HDR_IMG) != handle->m_raw_images.end()) {
     if (handle->m_compressed_images.find(UHDR_SDR_IMG) == handle->m_compressed_images.end() &&
         handle->m_raw_images.find(UHDR_SDR_IMG) == handle->m_raw_images.end()) {
@@ -1247,11 +1390,22 @@ uhdr_error_info_t uhdr_encode(uhdr_codec_private_t* enc) {
       exif.capacity = exif.data_sz = handle->m_exif.size();
     }
 
-    ultrahdr::JpegR jpegr(nullptr, handle->m_gainmap_scale_factor,
+    // gain map configurations not set by application are chosen by encoding preset
+    const ultrahdr::uhdr_enc_preset_config_t& presetConfig =
+        ultrahdr::getEncPresetConfig(handle->m_enc_preset);
+    int gainmap_scale_factor = handle->m_gainmap_scale_factor > 0
+                                   ? handle->m_gainmap_scale_factor
+                                   : presetConfig.map_scale_factor;
+    bool use_multi_channel_gainmap = handle->m_use_multi_channel_gainmap >= 0
+                                         ? handle->m_use_multi_channel_gainmap != 0
+                                         : presetConfig.use_multi_channel_map;
+
+    ultrahdr::JpegR jpegr(nullptr, gainmap_scale_factor,
                           handle->m_quality.find(UHDR_GAIN_MAP_IMG)->second,
-                          handle->m_use_multi_channel_gainmap, handle->m_gamma,
+                          use_multi_channel_gainmap, handle->m_gamma,
                           handle->m_enc_preset, handle->m_min_content_boost,
-                          handle->m_max_content_boost, handle->m_target_disp_max_brightness);
+                          handle->m_max_content_boost, handle->m_target_disp_max_brightness,
+                          handle->m_target_size);
     if (handle->m_compressed_images.find(UHDR_BASE_IMG) != handle->m_compressed_images.end() &&
         handle->m_compressed_images.find(UHDR_GAIN_MAP_IMG) != handle->m_compressed_images.end()) {
       auto& base_entry = handle->m_compressed_images.find(UHDR_BASE_IMG)->second;
@@ -1266,7 +1420,7 @@ uhdr_error_info_t uhdr_encode(uhdr_codec_private_t* enc) {
 
       // api - 4
       status = jpegr.encodeJPEGR(base_entry.get(), gainmap_entry.get(), &metadata,
-                                 handle->m_compressed_output_buffer.get());
+                                 handle->m_compressed_output_buffer.get(), &handle->m_effects);
     } else if (handle->m_raw_images.find(UHDR_HDR_IMG) != handle->m_raw_images.end()) {
       auto& hdr_raw_entry = handle->m_raw_images.find(UHDR_HDR_IMG)->second;
 
@@ -1315,6 +1469,66 @@ uhdr_error_info_t uhdr_encode(uhdr_codec_private_t* enc) {
   return status;
 }
 
+uhdr_error_info_t uhdr_remux(uhdr_codec_private_t* enc, uhdr_compressed_image_t* img,
+                             uhdr_gainmap_metadata_t* metadata, uhdr_mem_block_t* exif,
+                             uhdr_mem_block_t* icc) {
+  uhdr_error_info_t status = g_no_error;
+
+  if (dynamic_cast<uhdr_encoder_private*>(enc) == nullptr) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail, "received nullptr for uhdr codec instance");
+  } else if (img == nullptr || img->data == nullptr) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail, "received nullptr for compressed image handle");
+  } else if (img->capacity < img->data_sz) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail, "img->capacity %zd is less than img->data_sz %zd",
+             img->capacity, img->data_sz);
+  } else if ((exif != nullptr && exif->data == nullptr && exif->data_sz != 0) ||
+             (icc != nullptr && icc->data == nullptr && icc->data_sz != 0)) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "received nullptr for exif or icc data field with non-zero data_sz");
+  } else if (metadata != nullptr) {
+    status = ultrahdr::uhdr_validate_gainmap_metadata_descriptor(metadata);
+  }
+  if (status.error_code != UHDR_CODEC_OK) return status;
+
+  uhdr_encoder_private* handle = dynamic_cast<uhdr_encoder_private*>(enc);
+  if (handle->m_sailed) {
+    status.error_code = UHDR_CODEC_INVALID_OPERATION;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "An earlier call to uhdr_encode() has switched the context from configurable state to "
+             "end state. The context is no longer configurable. To reuse, call reset()");
+    return status;
+  }
+
+  handle->m_sailed = true;
+
+  size_t size = img->data_sz + (exif != nullptr ? exif->data_sz : 0) +
+                (icc != nullptr ? icc->data_sz : 0) + 64 * 1024;
+  handle->m_compressed_output_buffer = std::make_unique<ultrahdr::uhdr_compressed_image_ext_t>(
+      img->cg, img->ct, img->range, size);
+
+  std::unique_ptr<ultrahdr::uhdr_gainmap_metadata_ext_t> metadata_ext;
+  if (metadata != nullptr) {
+    metadata_ext =
+        std::make_unique<ultrahdr::uhdr_gainmap_metadata_ext_t>(*metadata, ultrahdr::kJpegrVersion);
+  }
+
+  ultrahdr::JpegR jpegr;
+  handle->m_encode_call_status =
+      jpegr.remuxJPEGR(img, metadata_ext.get(), exif, icc,
+                       handle->m_compressed_output_buffer.get(), &handle->m_effects);
+
+  return handle->m_encode_call_status;
+}
+
 uhdr_compressed_image_t* uhdr_get_encoded_stream(uhdr_codec_private_t* enc) {
   if (dynamic_cast<uhdr_encoder_private*>(enc) == nullptr) {
     return nullptr;
@@ -1349,13 +1563,14 @@ void uhdr_reset_encoder(uhdr_codec_private_t* enc) {
     handle->m_quality.emplace(UHDR_GAIN_MAP_IMG, ultrahdr::kMapCompressQualityDefault);
     handle->m_exif.clear();
     handle->m_output_format = UHDR_CODEC_JPG;
-    handle->m_gainmap_scale_factor = ultrahdr::kMapDimensionScaleFactorDefault;
-    handle->m_use_multi_channel_gainmap = ultrahdr::kUseMultiChannelGainMapDefault;
+    handle->m_gainmap_scale_factor = 0;
+    handle->m_use_multi_channel_gainmap = -1;
     handle->m_gamma = ultrahdr::kGainMapGammaDefault;
     handle->m_enc_preset = ultrahdr::kEncSpeedPresetDefault;
     handle->m_min_content_boost = FLT_MIN;
     handle->m_max_content_boost = FLT_MAX;
     handle->m_target_disp_max_brightness = -1.0f;
+    handle->m_target_size = 0;
 
     handle->m_compressed_output_buffer.reset();
     handle->m_encode_call_status = g_no_error;
@@ -1545,6 +1760,39 @@ uhdr_error_info_t uhdr_dec_set_out_max_display_boost(uhdr_codec_private_t* dec,
   return status;
 }
 
+uhdr_error_info_t uhdr_dec_set_preset(uhdr_codec_private_t* dec, uhdr_dec_preset_t preset) {
+  uhdr_error_info_t status = g_no_error;
+
+  if (dynamic_cast<uhdr_decoder_private*>(dec) == nullptr) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail, "received nullptr for uhdr codec instance");
+  } else if (preset != UHDR_DEC_USAGE_BALANCED && preset != UHDR_DEC_USAGE_REALTIME &&
+             preset != UHDR_DEC_USAGE_BEST_QUALITY) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "invalid preset %d, expects one of {UHDR_DEC_USAGE_BALANCED, UHDR_DEC_USAGE_REALTIME, "
+             "UHDR_DEC_USAGE_BEST_QUALITY}",
+             preset);
+  }
+  if (status.error_code != UHDR_CODEC_OK) return status;
+
+  uhdr_decoder_private* handle = dynamic_cast<uhdr_decoder_private*>(dec);
+  if (handle->m_probed) {
+    status.error_code = UHDR_CODEC_INVALID_OPERATION;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "An earlier call to uhdr_decode() has switched the context from configurable state to "
+             "end state. The context is no longer configurable. To reuse, call reset()");
+    return status;
+  }
+
+  handle->m_dec_preset = preset;
+
+  return status;
+}
+
 uhdr_error_info_t uhdr_dec_probe(uhdr_codec_private_t* dec) {
   if (dynamic_cast<uhdr_decoder_private*>(dec) == nullptr) {
     uhdr_error_info_t status;
@@ -1767,14 +2015,36 @@ uhdr_error_info_t uhdr_decode(uhdr_codec_private_t* dec) {
     return status;
   }
 
+  const uhdr_img_fmt_t gainmap_fmt =
+      handle->m_gainmap_num_comp == 1 ? UHDR_IMG_FMT_8bppYCbCr400 : UHDR_IMG_FMT_32bppRGBA8888;
+
+  // without gpu support, queued effects are handed to the decoder which crops, resizes and
+  // orients the 8 bit base and gain map images before the gain map is applied. The hdr math then
+  // only runs on the pixels that are kept. The gpu path applies the effects to the decoded output
+  std::unique_ptr<ultrahdr::uhdr_effect_transform_t> disp_xfm, gm_xfm;
+  bool gles_effects = false;
+#ifdef UHDR_ENABLE_GLES
+  gles_effects = handle->m_enable_gles;
+#endif
+  if (!dec->m_effects.empty() && !gles_effects) {
+    disp_xfm = std::make_unique<ultrahdr::uhdr_effect_transform_t>(
+        handle->m_output_fmt, handle->m_img_wd, handle->m_img_ht);
+    gm_xfm = std::make_unique<ultrahdr::uhdr_effect_transform_t>(
+        gainmap_fmt, handle->m_gainmap_wd, handle->m_gainmap_ht);
+    status =
+        ultrahdr::compile_effects(handle, disp_xfm.get(), gm_xfm.get(), nullptr, nullptr, nullptr);
+    if (status.error_code != UHDR_CODEC_OK) return status;
+  }
+
   handle->m_decoded_img_buffer = std::make_unique<ultrahdr::uhdr_raw_image_ext_t>(
       handle->m_output_fmt, UHDR_CG_UNSPECIFIED, handle->m_output_ct, UHDR_CR_UNSPECIFIED,
-      handle->m_img_wd, handle->m_img_ht, 1);
+      disp_xfm ? disp_xfm->width() : handle->m_img_wd,
+      disp_xfm ? disp_xfm->height() : handle->m_img_ht, 1);
 
   handle->m_gainmap_img_buffer = std::make_unique<ultrahdr::uhdr_raw_image_ext_t>(
-      handle->m_gainmap_num_comp == 1 ? UHDR_IMG_FMT_8bppYCbCr400 : UHDR_IMG_FMT_32bppRGBA8888,
-      UHDR_CG_UNSPECIFIED, UHDR_CT_UNSPECIFIED, UHDR_CR_UNSPECIFIED, handle->m_gainmap_wd,
-      handle->m_gainmap_ht, 1);
+      gainmap_fmt, UHDR_CG_UNSPECIFIED, UHDR_CT_UNSPECIFIED, UHDR_CR_UNSPECIFIED,
+      gm_xfm ? gm_xfm->width() : handle->m_gainmap_wd,
+      gm_xfm ? gm_xfm->height() : handle->m_gainmap_ht, 1);
 
 #ifdef UHDR_ENABLE_GLES
   ultrahdr::uhdr_opengl_ctxt_t* uhdrGLESCtxt = nullptr;
@@ -1793,9 +2063,10 @@ uhdr_error_info_t uhdr_decode(uhdr_codec_private_t* dec) {
   status =
       jpegr.decodeJPEGR(handle->m_uhdr_compressed_img.get(), handle->m_decoded_img_buffer.get(),
                         handle->m_output_max_disp_boost, handle->m_output_ct, handle->m_output_fmt,
-                        handle->m_gainmap_img_buffer.get(), nullptr);
+                        handle->m_gainmap_img_buffer.get(), nullptr, handle->m_dec_preset,
+                        disp_xfm.get(), gm_xfm.get());
 
-  if (status.error_code == UHDR_CODEC_OK && dec->m_effects.size() != 0) {
+  if (status.error_code == UHDR_CODEC_OK && dec->m_effects.size() != 0 && gles_effects) {
     status = ultrahdr::apply_effects(handle);
   }
 
@@ -1844,6 +2115,96 @@ uhdr_raw_image_t* uhdr_get_decoded_gainmap_image(uhdr_codec_private_t* dec) {
   return handle->m_gainmap_img_buffer.get();
 }
 
+uhdr_error_info_t uhdr_decode_renditions(uhdr_codec_private_t* dec,
+                                         const uhdr_rendition_t* renditions, unsigned int count) {
+  if (dynamic_cast<uhdr_decoder_private*>(dec) == nullptr) {
+    uhdr_error_info_t status;
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail, "received nullptr for uhdr codec instance");
+    return status;
+  }
+
+  uhdr_decoder_private* handle = dynamic_cast<uhdr_decoder_private*>(dec);
+
+  if (handle->m_sailed) {
+    return handle->m_decode_call_status;
+  }
+
+  uhdr_error_info_t& status = handle->m_decode_call_status;
+  if (renditions == nullptr || count == 0) {
+    status.error_code = UHDR_CODEC_INVALID_PARAM;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "received nullptr or empty list for rendition descriptors");
+    return status;
+  }
+  for (unsigned int i = 0; i < count; i++) {
+    const uhdr_rendition_t& r = renditions[i];
+    if (r.w == 0 || r.h == 0 || r.w > (unsigned int)ultrahdr::kMaxWidth ||
+        r.h > (unsigned int)ultrahdr::kMaxHeight) {
+      status.error_code = UHDR_CODEC_INVALID_PARAM;
+      status.has_detail = 1;
+      snprintf(status.detail, sizeof status.detail,
+               "received bad dimensions %ux%u for rendition %u, expected dimensions in range "
+               "[1x1, %dx%d]",
+               r.w, r.h, i, ultrahdr::kMaxWidth, ultrahdr::kMaxHeight);
+      return status;
+    }
+    if ((r.fmt != UHDR_IMG_FMT_32bppRGBA1010102 || (r.ct != UHDR_CT_HLG && r.ct != UHDR_CT_PQ)) &&
+        (r.fmt != UHDR_IMG_FMT_64bppRGBAHalfFloat || r.ct != UHDR_CT_LINEAR) &&
+        (r.fmt != UHDR_IMG_FMT_32bppRGBA8888 || r.ct != UHDR_CT_SRGB)) {
+      status.error_code = UHDR_CODEC_INVALID_PARAM;
+      status.has_detail = 1;
+      snprintf(status.detail, sizeof status.detail,
+               "unsupported output pixel format and output color transfer pair for rendition %u",
+               i);
+      return status;
+    }
+  }
+  if (!dec->m_effects.empty()) {
+    status.error_code = UHDR_CODEC_INVALID_OPERATION;
+    status.has_detail = 1;
+    snprintf(status.detail, sizeof status.detail,
+             "effects are not supported while decoding renditions, resize is expressed by the "
+             "rendition dimensions");
+    return status;
+  }
+
+  status = uhdr_dec_probe(dec);
+  if (status.error_code != UHDR_CODEC_OK) return status;
+
+  handle->m_sailed = true;
+
+  std::vector<uhdr_raw_image_t*> dests(count);
+  handle->m_rendition_buffers.clear();
+  for (unsigned int i = 0; i < count; i++) {
+    handle->m_rendition_buffers.push_back(std::make_unique<ultrahdr::uhdr_raw_image_ext_t>(
+        renditions[i].fmt, UHDR_CG_UNSPECIFIED, renditions[i].ct, UHDR_CR_UNSPECIFIED,
+        renditions[i].w, renditions[i].h, 1));
+    dests[i] = handle->m_rendition_buffers.back().get();
+  }
+
+  ultrahdr::JpegR jpegr;
+  status = jpegr.decodeJPEGRRenditions(handle->m_uhdr_compressed_img.get(), dests.data(), count,
+                                       handle->m_output_max_disp_boost, handle->m_dec_preset);
+  return status;
+}
+
+uhdr_raw_image_t* uhdr_get_decoded_rendition(uhdr_codec_private_t* dec, unsigned int index) {
+  if (dynamic_cast<uhdr_decoder_private*>(dec) == nullptr) {
+    return nullptr;
+  }
+
+  uhdr_decoder_private* handle = dynamic_cast<uhdr_decoder_private*>(dec);
+  if (!handle->m_sailed || handle->m_decode_call_status.error_code != UHDR_CODEC_OK ||
+      index >= handle->m_rendition_buffers.size()) {
+    return nullptr;
+  }
+
+  return handle->m_rendition_buffers[index].get();
+}
+
 void uhdr_reset_decoder(uhdr_codec_private_t* dec) {
   if (dynamic_cast<uhdr_decoder_private*>(dec) != nullptr) {
     uhdr_decoder_private* handle = dynamic_cast<uhdr_decoder_private*>(dec);
@@ -1860,11 +2221,13 @@ void uhdr_reset_decoder(uhdr_codec_private_t* dec) {
     handle->m_output_fmt = UHDR_IMG_FMT_64bppRGBAHalfFloat;
     handle->m_output_ct = UHDR_CT_LINEAR;
     handle->m_output_max_disp_boost = FLT_MAX;
+    handle->m_dec_preset = UHDR_DEC_USAGE_BALANCED;
 
     // ready to be configured
     handle->m_probed = false;
     handle->m_decoded_img_buffer.reset();
     handle->m_gainmap_img_buffer.reset();
+    handle->m_rendition_buffers.clear();
     handle->m_img_wd = 0;
     handle->m_img_ht = 0;
     handle->m_gainmap_wd = 0;
@@ -20,6 +20,7 @@
 #include <iostream>
 
 #include "ultrahdr/editorhelper.h"
+#include "ultrahdr/gainmapmath.h"
 
 // #define DUMP_OUTPUT
 
@@ -216,6 +217,80 @@ void compareImg(uhdr_raw_image_t* ref, uhdr_raw_image_t* test) {
   }
 }
 
+// compares two images sample by sample, integer samples may differ by max_diff code values and
+// half float samples by the same number of 1/1024ths of their magnitude
+void compareImgNear(uhdr_raw_image_t* ref, uhdr_raw_image_t* test, int max_diff) {
+  ASSERT_EQ(ref->fmt, test->fmt);
+  ASSERT_EQ(ref->w, test->w);
+  ASSERT_EQ(ref->h, test->h);
+  auto compare8 = [&](int plane, int wd, int ht, int ch) {
+    for (int i = 0; i < ht; i++) {
+      const uint8_t* r =
+          static_cast<uint8_t*>(ref->planes[plane]) + (size_t)i * ref->stride[plane] * ch;
+      const uint8_t* t =
+          static_cast<uint8_t*>(test->planes[plane]) + (size_t)i * test->stride[plane] * ch;
+      for (int j = 0; j < wd * ch; j++) {
+        ASSERT_LE(std::abs(r[j] - t[j]), max_diff)
+            << "plane " << plane << " at " << j << " x " << i;
+      }
+    }
+  };
+  const int w = ref->w, h = ref->h;
+  if (ref->fmt == UHDR_IMG_FMT_12bppYCbCr420) {
+    compare8(UHDR_PLANE_Y, w, h, 1);
+    compare8(UHDR_PLANE_U, w / 2, h / 2, 1);
+    compare8(UHDR_PLANE_V, w / 2, h / 2, 1);
+  } else if (ref->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
+    compare8(UHDR_PLANE_Y, w, h, 1);
+  } else if (ref->fmt == UHDR_IMG_FMT_32bppRGBA8888) {
+    compare8(UHDR_PLANE_PACKED, w, h, 4);
+  } else if (ref->fmt == UHDR_IMG_FMT_24bppYCbCrP010) {
+    for (int plane : {UHDR_PLANE_Y, UHDR_PLANE_UV}) {
+      for (int i = 0; i < (plane == UHDR_PLANE_Y ? h : h / 2); i++) {
+        const uint16_t* r =
+            static_cast<uint16_t*>(ref->planes[plane]) + (size_t)i * ref->stride[plane];
+        const uint16_t* t =
+            static_cast<uint16_t*>(test->planes[plane]) + (size_t)i * test->stride[plane];
+        for (int j = 0; j < w; j++) {
+          ASSERT_LE(std::abs((r[j] >> 6) - (t[j] >> 6)), max_diff)
+              << "plane " << plane << " at " << j << " x " << i;
+        }
+      }
+    }
+  } else if (ref->fmt == UHDR_IMG_FMT_32bppRGBA1010102) {
+    for (int i = 0; i < h; i++) {
+      const uint32_t* r = static_cast<uint32_t*>(ref->planes[UHDR_PLANE_PACKED]) +
+                          (size_t)i * ref->stride[UHDR_PLANE_PACKED];
+      const uint32_t* t = static_cast<uint32_t*>(test->planes[UHDR_PLANE_PACKED]) +
+                          (size_t)i * test->stride[UHDR_PLANE_PACKED];
+      for (int j = 0; j < w; j++) {
+        for (int shift : {0, 10, 20, 30}) {
+          const int mask = shift == 30 ? 0x3 : 0x3ff;
+          ASSERT_LE(std::abs((int)((r[j] >> shift) & mask) - (int)((t[j] >> shift) & mask)),
+                    max_diff)
+              << "channel " << shift / 10 << " at " << j << " x " << i;
+        }
+      }
+    }
+  } else if (ref->fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat) {
+    for (int i = 0; i < h; i++) {
+      const uint16_t* r = static_cast<uint16_t*>(ref->planes[UHDR_PLANE_PACKED]) +
+                          (size_t)i * ref->stride[UHDR_PLANE_PACKED] * 4;
+      const uint16_t* t = static_cast<uint16_t*>(test->planes[UHDR_PLANE_PACKED]) +
+                          (size_t)i * test->stride[UHDR_PLANE_PACKED] * 4;
+      for (int j = 0; j < w * 4; j++) {
+        const float a = halfToFloat(r[j]), b = halfToFloat(t[j]);
+        if (std::isnan(a) || std::isinf(a)) {
+          ASSERT_TRUE(std::isnan(a) ? std::isnan(b) : a == b) << "at " << j << " x " << i;
+          continue;
+        }
+        ASSERT_LE(std::abs(a - b), max_diff * (std::max)(std::abs(a), 1.0f) / 1024.0f)
+            << "at " << j << " x " << i;
+      }
+    }
+  }
+}
+
 class EditorHelperTest
     : public ::testing::TestWithParam<std::tuple<std::string, int, int, uhdr_img_fmt_t>> {
  public:
@@ -486,6 +561,219 @@ TEST_P(EditorHelperTest, MultipleEffects) {
   ASSERT_EQ(crop_ht, dst->h) << msg;
 }
 
+TEST_P(EditorHelperTest, FusedTransform) {
+  if (width < 8 || width % 4 != 0) {
+    GTEST_SKIP() << "Test skipped for resolution " + std::to_string(width) + " x " +
+                        std::to_string(height) + " format: " + std::to_string(fmt);
+  }
+  std::string msg = "failed for resolution " + std::to_string(width) + " x " +
+                    std::to_string(height) + " format: " + std::to_string(fmt);
+  initImageHandle(&img_a, width, height, fmt);
+  ASSERT_TRUE(loadFile(filename.c_str(), &img_a)) << "unable to load file " << filename;
+  ultrahdr::uhdr_rotate_effect_t r90(90), r270(270);
+  ultrahdr::uhdr_mirror_effect_t mhorz(UHDR_MIRROR_HORIZONTAL), mvert(UHDR_MIRROR_VERTICAL);
+  const int left = 2, top = 2, crop_wd = height - 4, crop_ht = width - 4;
+  ultrahdr::uhdr_crop_effect_t crop(left, left + crop_wd, top, top + crop_ht);
+  ultrahdr::uhdr_resize_effect_t resize(crop_ht / 2, crop_wd / 2);
+
+  // reference, one pass per effect
+  auto ref = apply_mirror(&mhorz, &img_a);
+  ref = apply_rotate(&r90, ref.get());
+  ref = apply_crop(&crop, ref.get(), left, top, crop_wd, crop_ht);
+  ref = apply_rotate(&r270, ref.get());
+  ref = apply_mirror(&mvert, ref.get());
+  ref = apply_resize(&resize, ref.get(), crop_ht / 2, crop_wd / 2);
+
+  uhdr_effect_transform_t xfm(img_a.fmt, img_a.w, img_a.h);
+  xfm.mirror(UHDR_MIRROR_HORIZONTAL);
+  xfm.rotate(90);
+  xfm.crop(left, top, crop_wd, crop_ht);
+  xfm.rotate(270);
+  xfm.mirror(UHDR_MIRROR_VERTICAL);
+  xfm.resize(crop_ht / 2, crop_wd / 2);
+  auto dst = apply_transform(&xfm, &img_a);
+  ASSERT_NE(dst, nullptr) << msg;
+  ASSERT_EQ(ref->w, dst->w) << msg;
+  ASSERT_EQ(ref->h, dst->h) << msg;
+  // the fused pass filters in source orientation, so sums may round differently
+  ASSERT_NO_FATAL_FAILURE(compareImgNear(ref.get(), dst.get(), 1)) << msg;
+}
+
+TEST_P(EditorHelperTest, UnorientedTransform) {
+  if (fmt != UHDR_IMG_FMT_8bppYCbCr400 && fmt != UHDR_IMG_FMT_32bppRGBA8888 &&
+      fmt != UHDR_IMG_FMT_32bppRGBA1010102 && fmt != UHDR_IMG_FMT_64bppRGBAHalfFloat) {
+    GTEST_SKIP() << "Test skipped for format: " + std::to_string(fmt);
+  }
+  if (width < 8) {
+    GTEST_SKIP() << "Test skipped for resolution " + std::to_string(width) + " x " +
+                        std::to_string(height);
+  }
+  std::string msg = "failed for resolution " + std::to_string(width) + " x " +
+                    std::to_string(height) + " format: " + std::to_string(fmt);
+  initImageHandle(&img_a, width, height, fmt);
+  ASSERT_TRUE(loadFile(filename.c_str(), &img_a)) << "unable to load file " << filename;
+  const int bpp = fmt == UHDR_IMG_FMT_8bppYCbCr400       ? 1
+                  : fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat ? 8
+                                                           : 4;
+
+  for (int degree : {0, 90, 180, 270}) {
+    for (int mirror = 0; mirror < 2; mirror++) {
+      uhdr_effect_transform_t xfm(img_a.fmt, img_a.w, img_a.h);
+      xfm.crop(1, 3, width - 4, height - 5);
+      if (mirror) xfm.mirror(UHDR_MIRROR_HORIZONTAL);
+      if (degree) xfm.rotate(degree);
+      auto ref = apply_transform(&xfm, &img_a);
+      ASSERT_NE(ref, nullptr) << msg;
+
+      // the unoriented output placed with the output steps reproduces the full transform
+      uhdr_effect_transform_t geometry = xfm.get_unoriented();
+      ASSERT_FALSE(geometry.m_transposed) << msg;
+      ASSERT_EQ(geometry.width() * geometry.height(), xfm.width() * xfm.height()) << msg;
+      auto unoriented = apply_transform(&geometry, &img_a);
+      ASSERT_NE(unoriented, nullptr) << msg;
+      ptrdiff_t origin, step_x, step_y;
+      xfm.get_output_steps(ref->stride[0], &origin, &step_x, &step_y);
+      const uint8_t* ref_data = static_cast<uint8_t*>(ref->planes[0]);
+      const uint8_t* src_data = static_cast<uint8_t*>(unoriented->planes[0]);
+      for (unsigned i = 0; i < unoriented->h; i++) {
+        for (unsigned j = 0; j < unoriented->w; j++) {
+          ptrdiff_t idx = origin + (ptrdiff_t)j * step_x + (ptrdiff_t)i * step_y;
+          ASSERT_EQ(0, memcmp(ref_data + idx * bpp,
+                              src_data + ((size_t)i * unoriented->stride[0] + j) * bpp, bpp))
+              << msg << " rotation " << degree << " mirror " << mirror << " at " << j << " x "
+              << i;
+        }
+      }
+    }
+  }
+}
+
+TEST_P(EditorHelperTest, CropView) {
+  const int left = 16;
+  const int top = 16;
+  const int crop_wd = 32;
+  const int crop_ht = 32;
+
+  if (width < (left + crop_wd) || height <= (top + crop_ht)) {
+    GTEST_SKIP() << "Test skipped as crop attributes are too large for resolution " +
+                        std::to_string(width) + " x " + std::to_string(height) +
+                        " format: " + std::to_string(fmt);
+  }
+  std::string msg = "failed for resolution " + std::to_string(width) + " x " +
+                    std::to_string(height) + " format: " + std::to_string(fmt);
+  initImageHandle(&img_a, width, height, fmt);
+  ASSERT_TRUE(loadFile(filename.c_str(), &img_a)) << "unable to load file " << filename;
+  ultrahdr::uhdr_crop_effect_t crop(left, left + crop_wd, top, top + crop_ht);
+  auto ref = apply_crop(&crop, &img_a, left, top, crop_wd, crop_ht);
+
+  uhdr_effect_transform_t identity(img_a.fmt, img_a.w, img_a.h);
+  auto parent = apply_transform(&identity, &img_a);
+  ASSERT_NE(parent, nullptr) << msg;
+  auto view = crop_view(parent.get(), left, top, crop_wd, crop_ht);
+  ASSERT_NE(view, nullptr) << msg;
+  EXPECT_EQ(view->stride[UHDR_PLANE_Y], parent->stride[UHDR_PLANE_Y]) << msg;
+  ASSERT_EQ(view->w, crop_wd) << msg;
+  ASSERT_EQ(view->h, crop_ht) << msg;
+
+  // the view keeps the pixels alive past its parent
+  parent.reset();
+  ASSERT_NO_FATAL_FAILURE(compareImg(ref.get(), view.get())) << msg;
+
+  // odd offsets cannot be expressed for subsampled chroma
+  if (fmt == UHDR_IMG_FMT_24bppYCbCrP010 || fmt == UHDR_IMG_FMT_12bppYCbCr420) {
+    EXPECT_EQ(crop_view(view.get(), 1, 0, 2, 2), nullptr) << msg;
+  }
+}
+
+static void fillConstant(uhdr_raw_image_t* img) {
+  auto fill16 = [](void* plane, int stride, int wd, int ht, const std::vector<uint16_t>& val) {
+    for (int i = 0; i < ht; i++) {
+      uint16_t* row = static_cast<uint16_t*>(plane) + (size_t)i * stride;
+      for (int j = 0; j < wd; j++) row[j] = val[j % val.size()];
+    }
+  };
+  auto fill8 = [](void* plane, int stride, int wd, int ht, const std::vector<uint8_t>& val) {
+    for (int i = 0; i < ht; i++) {
+      uint8_t* row = static_cast<uint8_t*>(plane) + (size_t)i * stride;
+      for (int j = 0; j < wd; j++) row[j] = val[j % val.size()];
+    }
+  };
+  const int w = img->w, h = img->h;
+  if (img->fmt == UHDR_IMG_FMT_24bppYCbCrP010) {
+    fill16(img->planes[UHDR_PLANE_Y], img->stride[UHDR_PLANE_Y], w, h, {512 << 6});
+    fill16(img->planes[UHDR_PLANE_UV], img->stride[UHDR_PLANE_UV], w, h / 2, {300 << 6, 700 << 6});
+  } else if (img->fmt == UHDR_IMG_FMT_12bppYCbCr420) {
+    fill8(img->planes[UHDR_PLANE_Y], img->stride[UHDR_PLANE_Y], w, h, {77});
+    fill8(img->planes[UHDR_PLANE_U], img->stride[UHDR_PLANE_U], w / 2, h / 2, {128});
+    fill8(img->planes[UHDR_PLANE_V], img->stride[UHDR_PLANE_V], w / 2, h / 2, {200});
+  } else if (img->fmt == UHDR_IMG_FMT_8bppYCbCr400) {
+    fill8(img->planes[UHDR_PLANE_Y], img->stride[UHDR_PLANE_Y], w, h, {77});
+  } else if (img->fmt == UHDR_IMG_FMT_32bppRGBA8888) {
+    fill8(img->planes[UHDR_PLANE_PACKED], img->stride[UHDR_PLANE_PACKED] * 4, w * 4, h,
+          {16, 32, 64, 255});
+  } else if (img->fmt == UHDR_IMG_FMT_32bppRGBA1010102) {
+    const uint32_t val = 100u | (200u << 10) | (300u << 20) | (3u << 30);
+    fill16(img->planes[UHDR_PLANE_PACKED], img->stride[UHDR_PLANE_PACKED] * 2, w * 2, h,
+           {(uint16_t)(val & 0xffff), (uint16_t)(val >> 16)});
+  } else if (img->fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat) {
+    fill16(img->planes[UHDR_PLANE_PACKED], img->stride[UHDR_PLANE_PACKED] * 4, w * 4, h,
+           {0x3c00, 0x3800, 0x4000, 0x3c00});
+  }
+}
+
+TEST_P(EditorHelperTest, ResizeConstant) {
+  initImageHandle(&img_a, width, height, fmt);
+  fillConstant(&img_a);
+  const int sizes[][2] = {{(((width / 2) + 1) & ~1), height / 2}, {width * 3 / 2, height * 3 / 2}};
+  const uhdr_resample_filter_t filters[] = {UHDR_RESAMPLE_NEAREST, UHDR_RESAMPLE_BILINEAR,
+                                            UHDR_RESAMPLE_BICUBIC, UHDR_RESAMPLE_LANCZOS3,
+                                            UHDR_RESAMPLE_AREA};
+  for (const auto& size : sizes) {
+    const int dst_w = size[0] + (size[0] & 1), dst_h = size[1] + (size[1] & 1);
+    uhdr_raw_image_ext_t expected(img_a.fmt, img_a.cg, img_a.ct, img_a.range, dst_w, dst_h, 64);
+    fillConstant(&expected);
+    for (auto filter : filters) {
+      auto dst = resize_image(&img_a, dst_w, dst_h, filter);
+      ASSERT_NE(dst, nullptr);
+      ASSERT_NO_FATAL_FAILURE(compareImg(&expected, dst.get()))
+          << "failed for resolution " << width << " x " << height << " format: " << fmt
+          << " filter: " << filter << " dst resolution " << dst_w << " x " << dst_h;
+    }
+  }
+}
+
+TEST_P(EditorHelperTest, ResizeAreaHalf) {
+  if (fmt != UHDR_IMG_FMT_8bppYCbCr400 && fmt != UHDR_IMG_FMT_32bppRGBA8888 &&
+      fmt != UHDR_IMG_FMT_12bppYCbCr420) {
+    GTEST_SKIP() << "Test skipped for format: " + std::to_string(fmt);
+  }
+  if (width % 4 != 0) {
+    GTEST_SKIP() << "Test skipped for resolution " + std::to_string(width) + " x " +
+                        std::to_string(height);
+  }
+  initImageHandle(&img_a, width, height, fmt);
+  ASSERT_TRUE(loadFile(filename.c_str(), &img_a)) << "unable to load file " << filename;
+  auto dst = resize_image(&img_a, width / 2, height / 2, UHDR_RESAMPLE_AREA);
+  ASSERT_NE(dst, nullptr);
+
+  // every output sample is the rounded mean of a 2x2 block
+  const int ch = fmt == UHDR_IMG_FMT_32bppRGBA8888 ? 4 : 1;
+  const int src_stride = img_a.stride[UHDR_PLANE_Y] * ch;
+  const int dst_stride = dst->stride[UHDR_PLANE_Y] * ch;
+  const uint8_t* src = static_cast<uint8_t*>(img_a.planes[UHDR_PLANE_Y]);
+  const uint8_t* out = static_cast<uint8_t*>(dst->planes[UHDR_PLANE_Y]);
+  for (int i = 0; i < height / 2; i++) {
+    for (int j = 0; j < (width / 2) * ch; j++) {
+      const int x = (j / ch) * 2 * ch + (j % ch);
+      const uint8_t* s = src + (size_t)(2 * i) * src_stride + x;
+      int sum = s[0] + s[ch] + s[src_stride] + s[src_stride + ch];
+      ASSERT_EQ((sum + 2) / 4, out[(size_t)i * dst_stride + j])
+          << "failed for resolution " << width << " x " << height << " format: " << fmt
+          << " at " << j << " x " << i;
+    }
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
     EditorAPIParameterizedTests, EditorHelperTest,
     ::testing::Combine(::testing::Values(INPUT_IMAGE), ::testing::Range(2, 80, 2),
@@ -495,4 +783,153 @@ INSTANTIATE_TEST_SUITE_P(
                                          UHDR_IMG_FMT_64bppRGBAHalfFloat,
                                          UHDR_IMG_FMT_32bppRGBA8888)));
 
+TEST(EditorHelperResampleTest, ResizeRgb888) {
+  // multichannel gain maps decode to rgb888 when libjpeg lacks the alpha extensions
+  const int w = 36, h = 20;
+  uhdr_raw_image_ext_t src(UHDR_IMG_FMT_24bppRGB888, UHDR_CG_UNSPECIFIED, UHDR_CT_UNSPECIFIED,
+                           UHDR_CR_UNSPECIFIED, w, h, 64);
+  uint8_t* src_data = static_cast<uint8_t*>(src.planes[UHDR_PLANE_PACKED]);
+  const size_t src_stride = (size_t)src.stride[UHDR_PLANE_PACKED] * 3;
+  for (int i = 0; i < h; i++) {
+    for (int j = 0; j < w * 3; j++) src_data[i * src_stride + j] = (uint8_t)(i * 7 + j * 13);
+  }
+
+  // every output sample is the rounded mean of a 2x2 block
+  auto dst = resize_image(&src, w / 2, h / 2, UHDR_RESAMPLE_AREA);
+  ASSERT_NE(dst, nullptr);
+  ASSERT_EQ(dst->fmt, UHDR_IMG_FMT_24bppRGB888);
+  const uint8_t* out = static_cast<uint8_t*>(dst->planes[UHDR_PLANE_PACKED]);
+  const size_t dst_stride = (size_t)dst->stride[UHDR_PLANE_PACKED] * 3;
+  for (int i = 0; i < h / 2; i++) {
+    for (int j = 0; j < (w / 2) * 3; j++) {
+      const uint8_t* s = src_data + (size_t)(2 * i) * src_stride + (j / 3) * 6 + (j % 3);
+      int sum = s[0] + s[3] + s[src_stride] + s[src_stride + 3];
+      ASSERT_EQ((sum + 2) / 4, out[(size_t)i * dst_stride + j]) << "at " << j << " x " << i;
+    }
+  }
+
+  // a 90 degree rotation moves whole 3 byte pixels
+  uhdr_effect_transform_t xfm(src.fmt, w, h);
+  xfm.rotate(90);
+  auto rotated = apply_transform(&xfm, &src);
+  ASSERT_NE(rotated, nullptr);
+  ASSERT_EQ((int)rotated->w, h);
+  ASSERT_EQ((int)rotated->h, w);
+  const uint8_t* rot = static_cast<uint8_t*>(rotated->planes[UHDR_PLANE_PACKED]);
+  const size_t rot_stride = (size_t)rotated->stride[UHDR_PLANE_PACKED] * 3;
+  for (int i = 0; i < w; i++) {
+    for (int j = 0; j < h; j++) {
+      ASSERT_EQ(0, memcmp(rot + i * rot_stride + j * 3, src_data + (h - j - 1) * src_stride + i * 3,
+                          3))
+          << "at " << j << " x " << i;
+    }
+  }
+}
+
+TEST(EditorHelperResampleTest, TableWeights) {
+  const uhdr_resample_filter_t filters[] = {UHDR_RESAMPLE_NEAREST, UHDR_RESAMPLE_BILINEAR,
+                                            UHDR_RESAMPLE_BICUBIC, UHDR_RESAMPLE_LANCZOS3,
+                                            UHDR_RESAMPLE_AREA};
+  const int lengths[][2] = {{64, 64}, {64, 17}, {17, 64}, {7, 3}, {3, 7}, {1, 5}, {640, 80}};
+  for (auto filter : filters) {
+    for (const auto& len : lengths) {
+      for (double sign : {1.0, -1.0}) {
+        const double scale = sign * len[0] / len[1];
+        const double offset = sign > 0 ? 0.0 : len[0];
+        uhdr_resample_table_t table(len[0], len[1], offset, scale, filter);
+        ASSERT_EQ((int)table.m_start.size(), len[1]);
+        for (int i = 0; i < len[1]; i++) {
+          ASSERT_GE(table.m_start[i], 0);
+          ASSERT_LE(table.m_start[i] + table.m_taps, len[0]);
+          float sum = 0.0f;
+          for (int k = 0; k < table.m_taps; k++) sum += table.m_weights[i * table.m_taps + k];
+          ASSERT_NEAR(sum, 1.0f, 1e-5f) << "filter " << filter << " " << len[0] << " -> " << len[1];
+        }
+      }
+    }
+  }
+
+  // 2:1 area averaging weighs each source pair equally
+  uhdr_resample_table_t area(8, 4, 0.0, 2.0, UHDR_RESAMPLE_AREA);
+  for (int i = 0; i < 4; i++) {
+    float w[2] = {0.0f, 0.0f};
+    for (int k = 0; k < area.m_taps; k++) {
+      int j = area.m_start[i] + k;
+      if (j == 2 * i || j == 2 * i + 1) {
+        w[j - 2 * i] = area.m_weights[i * area.m_taps + k];
+      } else {
+        ASSERT_EQ(area.m_weights[i * area.m_taps + k], 0.0f);
+      }
+    }
+    ASSERT_FLOAT_EQ(w[0], 0.5f);
+    ASSERT_FLOAT_EQ(w[1], 0.5f);
+  }
+}
+
+#if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__SSE2__) || defined(_M_X64)))
+TEST(EditorHelperResampleTest, VerticalSse2) {
+  const int taps = 6;
+  for (int len : {1, 7, 8, 29, 64}) {
+    std::vector<std::vector<float>> rows(taps, std::vector<float>(len));
+    std::vector<const float*> ptrs(taps);
+    for (int k = 0; k < taps; k++) {
+      for (int i = 0; i < len; i++) rows[k][i] = (float)((k * 31 + i * 17) % 97) / 96.0f;
+      ptrs[k] = rows[k].data();
+    }
+    const float weights[taps] = {-0.05f, 0.15f, 0.4f, 0.4f, 0.15f, -0.05f};
+    for (int t = 1; t <= taps; t++) {
+      std::vector<float> ref(len), test(len);
+      resample_vertical(ref.data(), ptrs.data(), weights, t, len);
+      resample_vertical_sse2(test.data(), ptrs.data(), weights, t, len);
+      for (int i = 0; i < len; i++) {
+        ASSERT_NEAR(ref[i], test[i], 1e-6f) << "taps " << t << ", length " << len << ", at " << i;
+      }
+    }
+  }
+}
+#endif
+
+template <typename T>
+static void verifyRotateMirror(int w, int h) {
+  const int src_stride = w + 3, dst_stride = (std::max)(w, h) + 5;
+  std::vector<T> src((size_t)src_stride * h), dst((size_t)dst_stride * (std::max)(w, h));
+  for (size_t i = 0; i < src.size(); i++) src[i] = (T)(i * 2654435761u);
+
+  for (int degree : {90, 180, 270}) {
+    rotate_buffer_clockwise<T>(src.data(), dst.data(), w, h, src_stride, dst_stride, degree);
+    const int dst_w = degree == 180 ? w : h, dst_h = degree == 180 ? h : w;
+    for (int i = 0; i < dst_h; i++) {
+      for (int j = 0; j < dst_w; j++) {
+        int r = (degree == 90) ? h - j - 1 : (degree == 180) ? h - i - 1 : j;
+        int c = (degree == 90) ? i : (degree == 180) ? w - j - 1 : w - i - 1;
+        ASSERT_EQ(dst[(size_t)i * dst_stride + j], src[(size_t)r * src_stride + c])
+            << "rotate " << degree << " of " << w << " x " << h << " with " << sizeof(T)
+            << " byte samples failed at " << j << " x " << i;
+      }
+    }
+  }
+  for (auto direction : {UHDR_MIRROR_HORIZONTAL, UHDR_MIRROR_VERTICAL}) {
+    mirror_buffer<T>(src.data(), dst.data(), w, h, src_stride, dst_stride, direction);
+    for (int i = 0; i < h; i++) {
+      for (int j = 0; j < w; j++) {
+        int r = direction == UHDR_MIRROR_VERTICAL ? h - i - 1 : i;
+        int c = direction == UHDR_MIRROR_HORIZONTAL ? w - j - 1 : j;
+        ASSERT_EQ(dst[(size_t)i * dst_stride + j], src[(size_t)r * src_stride + c])
+            << "mirror " << direction << " of " << w << " x " << h << " with " << sizeof(T)
+            << " byte samples failed at " << j << " x " << i;
+      }
+    }
+  }
+}
+
+TEST(EditorHelperRotateTest, MatchesReference) {
+  const int sizes[][2] = {{1, 1}, {3, 17}, {16, 16}, {33, 70}, {130, 67}, {200, 129}};
+  for (const auto& size : sizes) {
+    ASSERT_NO_FATAL_FAILURE(verifyRotateMirror<uint8_t>(size[0], size[1]));
+    ASSERT_NO_FATAL_FAILURE(verifyRotateMirror<uint16_t>(size[0], size[1]));
+    ASSERT_NO_FATAL_FAILURE(verifyRotateMirror<uint32_t>(size[0], size[1]));
+    ASSERT_NO_FATAL_FAILURE(verifyRotateMirror<uint64_t>(size[0], size[1]));
+  }
+}
+
 }  // namespace ultrahdr
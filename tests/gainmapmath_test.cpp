@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <future>
+#include <thread>
+
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
@@ -758,6 +761,32 @@ TEST_F(GainMapMathTest, YuvColorGamutConversion) {
   }
 }
 
+TEST_F(GainMapMathTest, LinearColorPipeline) {
+  LinearColorPipeline identity;
+  EXPECT_TRUE(identity.isIdentity());
+  identity.append(identityConversion).append(1.0f);
+  EXPECT_TRUE(identity.isIdentity());
+
+  const float kScale = kSdrWhiteNits / kHlgMaxNits;
+  LinearColorPipeline pipeline;
+  pipeline.append(bt709ToP3).append(kScale).append(kP3ToBt2100);
+  EXPECT_FALSE(pipeline.isIdentity());
+
+  Color colors[] = {RgbBlack(), RgbWhite(), RgbRed(), RgbGreen(), RgbBlue(),
+                    {{{0.25f, 0.5f, 0.75f}}}, {{{1.5f, 0.01f, 0.3f}}}};
+  for (const auto& e : colors) {
+    Color expected = p3ToBt2100(bt709ToP3(e) * kScale);
+    EXPECT_RGB_NEAR(pipeline.apply(e), expected);
+  }
+
+  // a conversion followed by its inverse folds to (nearly) the identity
+  LinearColorPipeline roundtrip;
+  roundtrip.append(bt709ToBt2100).append(bt2100ToBt709);
+  for (int idx = 0; idx < 9; idx++) {
+    EXPECT_NEAR(roundtrip.getMatrix()[idx], idx % 4 == 0 ? 1.0f : 0.0f, 1e-4f);
+  }
+}
+
 #if (defined(UHDR_ENABLE_INTRINSICS) && (defined(__ARM_NEON__) || defined(__ARM_NEON)))
 TEST_F(GainMapMathTest, YuvConversionNeon) {
   const std::array<Pixel, 5> SrgbYuvColors{YuvBlackPixel(), YuvWhitePixel(), SrgbYuvRedPixel(),
@@ -1125,6 +1154,52 @@ TEST_F(GainMapMathTest, srgbInvOetfLUT) {
   }
 }
 
+// Max absolute error of a table against its source function, probed at points that fall both on
+// and in between table entries.
+static void ExpectLUTAccuracy(std::function<float(float)> func, size_t numEntries,
+                              float maxErrNearest, float maxErrInterpolated) {
+  LookUpTable nearest(numEntries, func, false);
+  LookUpTable interpolated(numEntries, func, true);
+  const size_t kNumProbes = 1 << 20;
+  float errNearest = 0.0f, errInterpolated = 0.0f;
+  for (size_t idx = 0; idx <= kNumProbes; idx++) {
+    float value = static_cast<float>(idx) / static_cast<float>(kNumProbes);
+    float ref = func(value);
+    errNearest = (std::max)(errNearest, std::fabs(nearest.lookup(value) - ref));
+    errInterpolated = (std::max)(errInterpolated, std::fabs(interpolated.lookup(value) - ref));
+  }
+  EXPECT_LE(errNearest, maxErrNearest);
+  EXPECT_LE(errInterpolated, maxErrInterpolated);
+  // out of range inputs clamp to the end points
+  EXPECT_FLOAT_EQ(nearest.lookup(-0.5f), func(0.0f));
+  EXPECT_FLOAT_EQ(nearest.lookup(1.5f), func(1.0f));
+  EXPECT_FLOAT_EQ(interpolated.lookup(-0.5f), func(0.0f));
+  EXPECT_FLOAT_EQ(interpolated.lookup(1.5f), func(1.0f));
+}
+
+TEST_F(GainMapMathTest, srgbInvOetfLUTAccuracy) {
+  ExpectLUTAccuracy(static_cast<float (*)(float)>(srgbInvOetf), kSrgbInvOETFNumEntries, 1.2e-3f,
+                    1.0e-6f);
+}
+
+TEST_F(GainMapMathTest, hlgOetfLUTAccuracy) {
+  ExpectLUTAccuracy(static_cast<float (*)(float)>(hlgOetf), kHlgOETFNumEntries, 5.0e-3f, 1.8e-3f);
+}
+
+TEST_F(GainMapMathTest, hlgInvOetfLUTAccuracy) {
+  ExpectLUTAccuracy(static_cast<float (*)(float)>(hlgInvOetf), kHlgInvOETFNumEntries, 7.0e-4f,
+                    1.0e-6f);
+}
+
+TEST_F(GainMapMathTest, pqOetfLUTAccuracy) {
+  ExpectLUTAccuracy(static_cast<float (*)(float)>(pqOetf), kPqOETFNumEntries, 6.0e-2f, 2.5e-2f);
+}
+
+TEST_F(GainMapMathTest, pqInvOetfLUTAccuracy) {
+  ExpectLUTAccuracy(static_cast<float (*)(float)>(pqInvOetf), kPqInvOETFNumEntries, 1.3e-3f,
+                    1.1e-4f);
+}
+
 TEST_F(GainMapMathTest, applyGainLUT) {
   for (float boost = 1.5; boost <= 12; boost++) {
     uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
@@ -1414,6 +1489,76 @@ TEST_F(GainMapMathTest, ApplyGain) {
   EXPECT_RGB_NEAR(applyGain(e, 1.0f, &metadata), e * 4.0f);
 }
 
+TEST_F(GainMapMathTest, FastLog2Exp2) {
+  float maxLog2Error = 0.0f, maxExp2Error = 0.0f, maxPowError = 0.0f;
+  for (float x = 1.0f / 65536.0f; x < 65536.0f; x *= 1.0013f) {
+    maxLog2Error = (std::max)(maxLog2Error, std::fabs(fastLog2(x) - std::log2(x)));
+  }
+  for (float x = -126.0f; x < 128.0f; x += 0.0071f) {
+    float expected = std::exp2(x);
+    maxExp2Error = (std::max)(maxExp2Error, std::fabs(fastExp2(x) - expected) / expected);
+  }
+  for (float x = 0.001f; x <= 1.0f; x += 0.001f) {
+    for (float y : {1.0f / 2.2f, 0.5f, 2.0f, 2.2f}) {
+      float expected = std::pow(x, y);
+      maxPowError = (std::max)(maxPowError, std::fabs(fastPow(x, y) - expected));
+    }
+  }
+  EXPECT_LT(maxLog2Error, 3e-5f);
+  EXPECT_LT(maxExp2Error, 2e-7f);
+  EXPECT_LT(maxPowError, 1e-4f);
+  EXPECT_EQ(fastLog2(1.0f), 0.0f);
+  EXPECT_NEAR(fastExp2(0.0f), 1.0f, 1e-7f);
+  EXPECT_EQ(fastPow(0.0f, 2.0f), 0.0f);
+  EXPECT_EQ(fastPow(-1.0f, 2.0f), 0.0f);
+}
+
+TEST_F(GainMapMathTest, EncodeApplyGainFastMath) {
+  uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
+  for (int c = 0; c < 3; c++) {
+    metadata.min_content_boost[c] = 1.0f / 4.0f;
+    metadata.max_content_boost[c] = 8.0f;
+    metadata.gamma[c] = c == 0 ? 1.0f : 2.2f;
+    metadata.offset_sdr[c] = 1.0f / 64.0f;
+    metadata.offset_hdr[c] = 1.0f / 64.0f;
+  }
+  const float log2Min = log2(metadata.min_content_boost[0]);
+  const float log2Max = log2(metadata.max_content_boost[0]);
+
+  // encoded gains agree to within one code
+  for (float sdr = 0.0f; sdr <= 1.0f; sdr += 0.0137f) {
+    for (float hdr = 0.0f; hdr <= 8.0f; hdr += 0.0291f) {
+      for (int c = 0; c < 3; c++) {
+        EXPECT_NEAR(encodeGain(sdr, hdr, &metadata, log2Min, log2Max, c, true),
+                    encodeGain(sdr, hdr, &metadata, log2Min, log2Max, c, false), 1);
+      }
+      float gain = computeGain(sdr, hdr, true);
+      EXPECT_NEAR(gain, computeGain(sdr, hdr, false), 3e-5f);
+      EXPECT_NEAR(affineMapGain(gain, log2Min, log2Max, 2.2f, true),
+                  affineMapGain(gain, log2Min, log2Max, 2.2f, false), 1);
+    }
+  }
+
+  // applied gains agree to within 1e-4 relative error
+  for (float e = 0.0f; e <= 1.0f; e += 0.05f) {
+    for (float g = 0.0f; g <= 1.0f; g += 0.01f) {
+      for (float weight : {1.0f, 0.6f}) {
+        Color sdr = {{{e, e * 0.5f, e * 0.25f}}};
+        Color gain = {{{g, 1.0f - g, g * 0.5f}}};
+        Color expected = applyGain(sdr, gain, &metadata, weight, false);
+        Color actual = applyGain(sdr, gain, &metadata, weight, true);
+        EXPECT_NEAR(actual.r, expected.r, 1e-4f * (std::max)(1.0f, expected.r));
+        EXPECT_NEAR(actual.g, expected.g, 1e-4f * (std::max)(1.0f, expected.g));
+        EXPECT_NEAR(actual.b, expected.b, 1e-4f * (std::max)(1.0f, expected.b));
+
+        expected = applyGain(sdr, g, &metadata, weight, false);
+        actual = applyGain(sdr, g, &metadata, weight, true);
+        EXPECT_NEAR(actual.r, expected.r, 1e-4f * (std::max)(1.0f, expected.r));
+      }
+    }
+  }
+}
+
 TEST_F(GainMapMathTest, GetYuv420Pixel) {
   auto image = Yuv420Image();
   Color(*colors)[4] = Yuv420Colors();
@@ -1436,6 +1581,55 @@ TEST_F(GainMapMathTest, GetP010Pixel) {
   }
 }
 
+TEST_F(GainMapMathTest, InvOetfCodeTables) {
+  const float* srgbTable = getInverseOetfCodeTable(UHDR_CT_SRGB, UHDR_IMG_FMT_32bppRGBA8888);
+  const float* hlgTable = getInverseOetfCodeTable(UHDR_CT_HLG, UHDR_IMG_FMT_32bppRGBA1010102);
+  const float* pqTable = getInverseOetfCodeTable(UHDR_CT_PQ, UHDR_IMG_FMT_32bppRGBA1010102);
+  ASSERT_EQ(srgbTable, srgbInvOetfCodeTable());
+  ASSERT_EQ(hlgTable, hlgInvOetfCodeTable());
+  ASSERT_EQ(pqTable, pqInvOetfCodeTable());
+  EXPECT_EQ(getInverseOetfCodeTable(UHDR_CT_LINEAR, UHDR_IMG_FMT_32bppRGBA1010102), nullptr);
+  EXPECT_EQ(getInverseOetfCodeTable(UHDR_CT_SRGB, UHDR_IMG_FMT_12bppYCbCr420), nullptr);
+  EXPECT_EQ(getInverseOetfCodeTable(UHDR_CT_HLG, UHDR_IMG_FMT_24bppYCbCrP010), nullptr);
+
+  for (int32_t code = 0; code < kSrgbInvOETFCodeEntries; code++) {
+    EXPECT_FLOAT_EQ(srgbTable[code], srgbInvOetf(code / 255.0f));
+  }
+  for (int32_t code = 0; code < kHlgInvOETFCodeEntries; code++) {
+    EXPECT_FLOAT_EQ(hlgTable[code], hlgInvOetf(code / 1023.0f));
+    EXPECT_FLOAT_EQ(pqTable[code], pqInvOetf(code / 1023.0f));
+  }
+}
+
+TEST_F(GainMapMathTest, GetRgbaPixelLinear) {
+  uint32_t pixels[4 * 2];
+  for (uint32_t i = 0; i < 4; i++) {
+    uint32_t c8 = i * 85;
+    uint32_t c10 = i * 341;
+    pixels[i] = c8 | ((255 - c8) << 8) | ((c8 / 2) << 16) | (0xffu << 24);
+    pixels[4 + i] = c10 | ((1023 - c10) << 10) | ((c10 / 2) << 20) | (0x3u << 30);
+  }
+  uhdr_raw_image_t image;
+  image.w = 4;
+  image.h = 1;
+  image.planes[UHDR_PLANE_PACKED] = pixels;
+  image.stride[UHDR_PLANE_PACKED] = 4;
+
+  for (size_t x = 0; x < 4; x++) {
+    image.fmt = UHDR_IMG_FMT_32bppRGBA8888;
+    image.planes[UHDR_PLANE_PACKED] = pixels;
+    EXPECT_RGB_EQ(getRgba8888PixelLinear(&image, x, 0, srgbInvOetfCodeTable()),
+                  srgbInvOetf(getRgba8888Pixel(&image, x, 0)));
+
+    image.fmt = UHDR_IMG_FMT_32bppRGBA1010102;
+    image.planes[UHDR_PLANE_PACKED] = pixels + 4;
+    EXPECT_RGB_EQ(getRgba1010102PixelLinear(&image, x, 0, hlgInvOetfCodeTable()),
+                  hlgInvOetf(getRgba1010102Pixel(&image, x, 0)));
+    EXPECT_RGB_EQ(getRgba1010102PixelLinear(&image, x, 0, pqInvOetfCodeTable()),
+                  pqInvOetf(getRgba1010102Pixel(&image, x, 0)));
+  }
+}
+
 TEST_F(GainMapMathTest, SampleYuv420) {
   auto image = Yuv420Image();
   Color(*colors)[4] = Yuv420Colors();
@@ -1488,6 +1682,244 @@ TEST_F(GainMapMathTest, SampleP010) {
   }
 }
 
+TEST_F(GainMapMathTest, applyGainLUTWithGamma) {
+  for (float gamma : {0.5f, 2.2f, 4.0f}) {
+    uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
+
+    std::fill_n(metadata.min_content_boost, 3, 1.0f / 8.0f);
+    std::fill_n(metadata.max_content_boost, 3, 8.0f);
+    std::fill_n(metadata.gamma, 3, gamma);
+    std::fill_n(metadata.offset_sdr, 3, 0.0f);
+    std::fill_n(metadata.offset_hdr, 3, 0.0f);
+    metadata.hdr_capacity_max = metadata.max_content_boost[0];
+    metadata.hdr_capacity_min = 1.0f;
+    metadata.use_base_cg = true;
+    GainLUT gainLUT(&metadata, 0.75f);
+
+    // gamma is folded into the table, so table entries match the exact computation
+    for (size_t idx = 0; idx < kGainFactorNumEntries; idx++) {
+      float value = static_cast<float>(idx) / static_cast<float>(kGainFactorNumEntries - 1);
+      EXPECT_RGB_NEAR(applyGain(RgbWhite(), value, &metadata, 0.75f),
+                      applyGainLUT(RgbWhite(), value, gainLUT, &metadata));
+      EXPECT_RGB_NEAR(applyGain(RgbRed(), value, &metadata, 0.75f),
+                      applyGainLUT(RgbRed(), value, gainLUT, &metadata));
+    }
+
+    // the fixed point index for 8-bit codes matches the float index
+    for (int code = 0; code < 256; code++) {
+      uint8_t rgbCode[3] = {static_cast<uint8_t>(code), static_cast<uint8_t>(255 - code),
+                            static_cast<uint8_t>(code / 2)};
+      Color gain = {{{rgbCode[0] / 255.0f, rgbCode[1] / 255.0f, rgbCode[2] / 255.0f}}};
+      EXPECT_FLOAT_EQ(gainLUT.getGainFactorFromCode(rgbCode[0], 0),
+                      gainLUT.getGainFactor(gain.r, 0));
+      EXPECT_RGB_EQ(applyGainLUTFromCode(RgbWhite(), rgbCode[0], gainLUT, &metadata),
+                    applyGainLUT(RgbWhite(), gain.r, gainLUT, &metadata));
+      EXPECT_RGB_EQ(applyGainLUTFromCode(RgbWhite(), rgbCode, gainLUT, &metadata),
+                    applyGainLUT(RgbWhite(), gain, gainLUT, &metadata));
+    }
+  }
+}
+
+TEST_F(GainMapMathTest, TableCache) {
+  TableCache<int, int> cache(2);
+  int builds = 0;
+  auto create = [&builds](int value) {
+    return [&builds, value] {
+      builds++;
+      return new int(value);
+    };
+  };
+  auto one = cache.get(1, create(1));
+  EXPECT_EQ(*one, 1);
+  EXPECT_EQ(cache.get(1, create(1)), one);
+  EXPECT_EQ(builds, 1);
+
+  // 1 is most recently used, so adding 3 evicts 2
+  cache.get(2, create(2));
+  cache.get(1, create(1));
+  cache.get(3, create(3));
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_EQ(builds, 3);
+  EXPECT_EQ(cache.get(1, create(1)), one);
+  EXPECT_EQ(builds, 3);
+  cache.get(2, create(2));
+  EXPECT_EQ(builds, 4);
+
+  // evicted and cleared tables outlive the cache entry
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(*one, 1);
+
+  // concurrent lookups of the same key share a single table, even if several of them built it
+  std::vector<std::thread> workers;
+  std::vector<std::shared_ptr<const int>> results(8);
+  for (size_t i = 0; i < results.size(); i++) {
+    workers.emplace_back(
+        [&cache, &results, i] { results[i] = cache.get(7, [] { return new int(7); }); });
+  }
+  for (auto& worker : workers) worker.join();
+  for (auto& result : results) EXPECT_EQ(result, results[0]);
+  EXPECT_EQ(cache.get(7, create(7)), results[0]);
+
+  // a table being built does not hold up lookups of other keys
+  std::promise<void> buildStarted, lookupDone;
+  std::thread builder([&cache, &buildStarted, &lookupDone] {
+    cache.get(8, [&buildStarted, &lookupDone] {
+      buildStarted.set_value();
+      lookupDone.get_future().wait();
+      return new int(8);
+    });
+  });
+  buildStarted.get_future().wait();
+  EXPECT_EQ(*cache.get(7, create(7)), 7);
+  lookupDone.set_value();
+  builder.join();
+  EXPECT_EQ(*cache.get(8, create(8)), 8);
+}
+
+TEST_F(GainMapMathTest, SharedTables) {
+  clearTableCaches();
+  auto idw = getShepardsIDW(4);
+  EXPECT_EQ(idw->mMapScaleFactor, 4);
+  EXPECT_EQ(getShepardsIDW(4), idw);
+  EXPECT_NE(getShepardsIDW(2), idw);
+
+  uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
+  metadata.min_content_boost[0] = metadata.min_content_boost[1] = metadata.min_content_boost[2] =
+      1.0f / 4.0f;
+  metadata.max_content_boost[0] = metadata.max_content_boost[1] = metadata.max_content_boost[2] =
+      4.0f;
+  metadata.gamma[0] = metadata.gamma[1] = metadata.gamma[2] = 1.0f;
+  auto lut = getGainLUT(&metadata, 0.5f);
+  EXPECT_EQ(getGainLUT(&metadata, 0.5f), lut);
+  EXPECT_NE(getGainLUT(&metadata, 1.0f), lut);
+
+  // a cached table matches a freshly built one
+  GainLUT expected(&metadata, 0.5f);
+  for (int i = 0; i <= 255; i++) {
+    float gain = i / 255.0f;
+    EXPECT_FLOAT_EQ(lut->getGainFactor(gain, 0), expected.getGainFactor(gain, 0));
+  }
+
+  metadata.max_content_boost[0] = metadata.max_content_boost[1] = metadata.max_content_boost[2] =
+      8.0f;
+  EXPECT_NE(getGainLUT(&metadata, 0.5f), lut);
+  clearTableCaches();
+}
+
+TEST_F(GainMapMathTest, GainTable2D) {
+  uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
+  std::fill_n(metadata.min_content_boost, 3, 1.0f / 2.0f);
+  std::fill_n(metadata.max_content_boost, 3, 6.0f);
+  std::fill_n(metadata.gamma, 3, 1.5f);
+  std::fill_n(metadata.offset_sdr, 3, 1.0f / 64.0f);
+  std::fill_n(metadata.offset_hdr, 3, 1.0f / 64.0f);
+  const float weight = 0.8f;
+
+  for (auto ct : {UHDR_CT_HLG, UHDR_CT_PQ}) {
+    clearTableCaches();
+    auto table = getGainTable2D(&metadata, weight, ct);
+    EXPECT_EQ(getGainTable2D(&metadata, weight, ct), table);
+    EXPECT_NE(getGainTable2D(&metadata, 1.0f, ct), table);
+
+    int maxDiff = 0;
+    for (int sdr = 0; sdr < kGainTable2DSdrEntries; sdr += 3) {
+      for (int step = 0; step < kGainTable2DGainEntries; step += 7) {
+        float sdrGamma = sdr / 255.0f;
+        float gain = static_cast<float>(step) / (kGainTable2DGainEntries - 1);
+        Color rgb = applyGain(srgbInvOetf(Color{{{sdrGamma, sdrGamma, sdrGamma}}}), gain,
+                              &metadata, weight);
+        Color rgb_gamma;
+        if (ct == UHDR_CT_HLG) {
+          rgb = clampPixelFloat(rgb * kSdrWhiteNits / kHlgMaxNits);
+          rgb_gamma = hlgOetf(hlgInverseOotfApprox(rgb));
+        } else {
+          rgb = clampPixelFloat(rgb * kSdrWhiteNits / kPqMaxNits);
+          rgb_gamma = pqOetf(rgb);
+        }
+        int expected = colorToRgba1010102(rgb_gamma) & 0x3ff;
+        int actual = table->getHdrCode(sdrGamma, gain);
+        maxDiff = (std::max)(maxDiff, std::abs(expected - actual));
+        uint32_t packed = table->getRgba1010102(Color{{{sdrGamma, 0.0f, 1.0f}}}, gain);
+        EXPECT_EQ(packed & 0x3ff, actual);
+        EXPECT_EQ((packed >> 10) & 0x3ff, table->getHdrCode(0.0f, gain));
+        EXPECT_EQ((packed >> 20) & 0x3ff, table->getHdrCode(1.0f, gain));
+        EXPECT_EQ(packed >> 30, 0x3u);
+      }
+    }
+    EXPECT_LE(maxDiff, 1) << "transfer " << ct;
+  }
+  clearTableCaches();
+}
+
+TEST_F(GainMapMathTest, FixedPointGainMapApplier) {
+  uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
+  const float minBoost[3] = {1.0f / 2.0f, 1.0f / 1.5f, 1.0f};
+  const float maxBoost[3] = {6.0f, 4.0f, 8.0f};
+  for (int c = 0; c < 3; c++) {
+    metadata.min_content_boost[c] = minBoost[c];
+    metadata.max_content_boost[c] = maxBoost[c];
+    metadata.gamma[c] = c == 1 ? 2.0f : 1.0f;
+    metadata.offset_sdr[c] = 1.0f / 64.0f;
+    metadata.offset_hdr[c] = 1.0f / 64.0f;
+  }
+  const float weight = 0.9f;
+  const struct {
+    ColorTransformFn sdrGamutConversionFn;
+    ColorTransformFn hdrGamutConversionFn;
+  } gamuts[] = {{identityConversion, identityConversion},
+                {identityConversion, p3ToBt2100},
+                {bt709ToBt2100, identityConversion}};
+
+  for (auto ct : {UHDR_CT_HLG, UHDR_CT_PQ}) {
+    for (auto& gamut : gamuts) {
+      FixedPointGainMapApplier applier(&metadata, weight, ct, gamut.sdrGamutConversionFn,
+                                       gamut.hdrGamutConversionFn);
+      int maxDiff = 0;
+      double sumDiff = 0;
+      int count = 0;
+      for (int y = 0; y < 256; y += 5) {
+        for (int u = 0; u < 256; u += 17) {
+          for (int v = 0; v < 256; v += 17) {
+            for (int code = 0; code < 256; code += 15) {
+              // float reference, as evaluated by applyGainMap without look up tables
+              Color yuv = {{{y / 255.0f, (u - 128) / 255.0f, (v - 128) / 255.0f}}};
+              Color gain = {{{code / 255.0f, (255 - code) / 255.0f, code / 255.0f}}};
+              Color rgb = gamut.sdrGamutConversionFn(srgbInvOetf(p3YuvToRgb(yuv)));
+              rgb = applyGain(rgb, gain, &metadata, weight);
+              Color rgb_gamma;
+              if (ct == UHDR_CT_HLG) {
+                rgb = gamut.hdrGamutConversionFn(rgb * kSdrWhiteNits / kHlgMaxNits);
+                rgb_gamma = hlgOetf(hlgInverseOotfApprox(clampPixelFloat(rgb)));
+              } else {
+                rgb = gamut.hdrGamutConversionFn(rgb * kSdrWhiteNits / kPqMaxNits);
+                rgb_gamma = pqOetf(clampPixelFloat(rgb));
+              }
+              uint32_t expected = colorToRgba1010102(rgb_gamma);
+              uint32_t actual = applier.apply(
+                  y, u, v, FixedPointGainMapApplier::getGainIndex(gain.r),
+                  FixedPointGainMapApplier::getGainIndex(gain.g),
+                  FixedPointGainMapApplier::getGainIndexFromCode(code));
+              ASSERT_EQ(actual >> 30, 0x3u);
+              for (int c = 0; c < 3; c++) {
+                int diff = std::abs(static_cast<int>((expected >> (10 * c)) & 0x3ff) -
+                                    static_cast<int>((actual >> (10 * c)) & 0x3ff));
+                maxDiff = (std::max)(maxDiff, diff);
+                sumDiff += diff;
+                count++;
+              }
+            }
+          }
+        }
+      }
+      // the largest deviations are a few codes near black, where the pq curve is steepest and the
+      // 12-bit sdr quantization dominates
+      EXPECT_LE(maxDiff, 10) << "transfer " << ct;
+      EXPECT_LE(sumDiff / count, 0.2) << "transfer " << ct;
+    }
+  }
+}
+
 TEST_F(GainMapMathTest, SampleMap) {
   auto image = MapImage();
   float(*values)[4] = MapValues();
@@ -1528,6 +1960,78 @@ TEST_F(GainMapMathTest, SampleMap) {
   }
 }
 
+TEST_F(GainMapMathTest, SampleMapNearest) {
+  auto image = MapImage();
+  float(*values)[4] = MapValues();
+
+  for (float mapScaleFactor : {1.0f, 2.0f, 1.5f}) {
+    for (size_t y = 0; y < 4 * mapScaleFactor; ++y) {
+      for (size_t x = 0; x < 4 * mapScaleFactor; ++x) {
+        size_t x_base = (std::min)(static_cast<size_t>(x / mapScaleFactor), (size_t)3);
+        size_t y_base = (std::min)(static_cast<size_t>(y / mapScaleFactor), (size_t)3);
+        EXPECT_EQ(sampleMapNearest(&image, mapScaleFactor, x, y), values[y_base][x_base]);
+      }
+    }
+  }
+}
+
+TEST_F(GainMapMathTest, GainMapRowSampler) {
+  auto image = MapImage();
+  float(*values)[4] = MapValues();
+
+  // rgba map carrying the single channel codes, their complement and half of them
+  uint8_t* codes = static_cast<uint8_t*>(image.planes[UHDR_PLANE_Y]);
+  uint8_t rgba[4 * 4 * 4];
+  for (int i = 0; i < 16; i++) {
+    rgba[i * 4] = codes[i];
+    rgba[i * 4 + 1] = 255 - codes[i];
+    rgba[i * 4 + 2] = codes[i] / 2;
+    rgba[i * 4 + 3] = 255;
+  }
+  uhdr_raw_image_t rgbaImage = image;
+  rgbaImage.fmt = UHDR_IMG_FMT_32bppRGBA8888;
+  rgbaImage.planes[UHDR_PLANE_PACKED] = rgba;
+
+  for (float mapScaleFactor : {1.0f, 2.0f, 4.0f, 3.0f, 1.5f}) {
+    const size_t outW = static_cast<size_t>(4 * mapScaleFactor);
+    const bool integerScale = mapScaleFactor == floorf(mapScaleFactor);
+    auto idwTable = getShepardsIDW(static_cast<int>(mapScaleFactor));
+    GainMapRowSampler sampler(&image, mapScaleFactor, outW);
+    GainMapRowSampler rgbaSampler(&rgbaImage, mapScaleFactor, outW);
+    EXPECT_EQ(sampler.channels(), 1);
+    EXPECT_EQ(rgbaSampler.channels(), 3);
+    // rows are visited out of order as well to exercise the row cache
+    for (size_t y : {0, 3, 1, 2, 5, 4, 7, 6, 5, 11, 9}) {
+      if (y >= outW) continue;
+      const float* gains = sampler.sampleRow(y);
+      const float* rgbaGains = rgbaSampler.sampleRow(y);
+      for (size_t x = 0; x < outW; ++x) {
+        // same gains as the scattered samplers
+        float expected;
+        Color expectedRgb;
+        if (integerScale) {
+          expected = sampleMap(&image, (size_t)mapScaleFactor, x, y, *idwTable);
+          expectedRgb =
+              sampleMap3Channel(&rgbaImage, (size_t)mapScaleFactor, x, y, *idwTable, true);
+        } else {
+          expected = sampleMap(&image, mapScaleFactor, x, y);
+          expectedRgb = sampleMap3Channel(&rgbaImage, mapScaleFactor, x, y, true);
+        }
+        EXPECT_NEAR(gains[x], expected, 1e-6f)
+            << "scale " << mapScaleFactor << " at " << x << ", " << y;
+        EXPECT_NEAR(rgbaGains[x * 3], expectedRgb.r, 1e-6f);
+        EXPECT_NEAR(rgbaGains[x * 3 + 1], expectedRgb.g, 1e-6f);
+        EXPECT_NEAR(rgbaGains[x * 3 + 2], expectedRgb.b, 1e-6f);
+        float x_map = x / mapScaleFactor, y_map = y / mapScaleFactor;
+        if (x_map == floorf(x_map) && y_map == floorf(y_map)) {
+          EXPECT_EQ(gains[x], values[(size_t)y_map][(size_t)x_map]);
+          EXPECT_EQ(rgbaGains[x * 3 + 2], (codes[(size_t)y_map * 4 + (size_t)x_map] / 2) / 255.0f);
+        }
+      }
+    }
+  }
+}
+
 TEST_F(GainMapMathTest, ColorToRgba1010102) {
   EXPECT_EQ(colorToRgba1010102(RgbBlack()), 0x3 << 30);
   EXPECT_EQ(colorToRgba1010102(RgbWhite()), 0xFFFFFFFF);
@@ -1563,6 +2067,39 @@ TEST_F(GainMapMathTest, Float32ToFloat16) {
   EXPECT_EQ(floatToHalf(0x1.0p-126f), 0x0);          // float zero
 }
 
+TEST_F(GainMapMathTest, HalfFloatRowConversion) {
+  // every finite half float, an odd count so the conversion tail is exercised too
+  std::vector<uint16_t> halves;
+  for (uint32_t bits = 0; bits <= 0xFFFF; bits++) {
+    if ((bits & 0x7C00) != 0x7C00) halves.push_back((uint16_t)bits);
+  }
+  halves.push_back(0x3C00);
+  ASSERT_EQ(halves.size() % 2, 1u);
+
+  std::vector<float> floats(halves.size());
+  halfToFloatRow(halves.data(), floats.data(), halves.size());
+  for (size_t i = 0; i < halves.size(); i++) {
+    ASSERT_EQ(floats[i], halfToFloat(halves[i])) << "half 0x" << std::hex << halves[i];
+  }
+
+  std::vector<uint16_t> roundTrip(halves.size());
+  floatToHalfRow(floats.data(), roundTrip.data(), floats.size());
+  for (size_t i = 0; i < halves.size(); i++) {
+    ASSERT_EQ(roundTrip[i], halves[i]) << "float " << floats[i];
+  }
+
+  // values between representable halves are within one ulp of the scalar conversion
+  std::vector<float> values;
+  for (int i = 0; i < 10007; i++) {
+    values.push_back((i % 2 ? -1.0f : 1.0f) * 65504.0f * powf(i / 10007.0f, 8.0f));
+  }
+  std::vector<uint16_t> converted(values.size());
+  floatToHalfRow(values.data(), converted.data(), values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    EXPECT_LE(std::abs((int)converted[i] - (int)floatToHalf(values[i])), 1) << values[i];
+  }
+}
+
 TEST_F(GainMapMathTest, GenerateMapLuminanceSrgb) {
   EXPECT_FLOAT_EQ(SrgbYuvToLuminance(YuvBlack(), srgbLuminance), 0.0f);
   EXPECT_FLOAT_EQ(SrgbYuvToLuminance(YuvWhite(), srgbLuminance), kSdrWhiteNits);
@@ -118,6 +118,28 @@ TEST_F(JpegDecoderHelperTest, decodeYuvImageToRgba) {
             UHDR_CG_UNSPECIFIED);
 }
 
+TEST_F(JpegDecoderHelperTest, decodeYuvImageToRgbaScaled) {
+  for (unsigned int scale : {2u, 4u, 8u}) {
+    JpegDecoderHelper decoder;
+    EXPECT_EQ(decoder
+                  .decompressImage(mYuvImage.buffer.get(), mYuvImage.size, DECODE_TO_RGB_CS, scale)
+                  .error_code,
+              UHDR_CODEC_OK);
+    uhdr_raw_image_t img = decoder.getDecompressedImage();
+    EXPECT_EQ(img.w, (IMAGE_WIDTH + scale - 1) / scale);
+    EXPECT_EQ(img.h, (IMAGE_HEIGHT + scale - 1) / scale);
+  }
+  JpegDecoderHelper decoder;
+  EXPECT_NE(
+      decoder.decompressImage(mYuvImage.buffer.get(), mYuvImage.size, DECODE_TO_RGB_CS, 3)
+          .error_code,
+      UHDR_CODEC_OK);
+  EXPECT_NE(
+      decoder.decompressImage(mYuvImage.buffer.get(), mYuvImage.size, DECODE_TO_YCBCR_CS, 2)
+          .error_code,
+      UHDR_CODEC_OK);
+}
+
 TEST_F(JpegDecoderHelperTest, decodeYuvIccImage) {
   JpegDecoderHelper decoder;
   EXPECT_EQ(decoder.decompressImage(mYuvIccImage.buffer.get(), mYuvIccImage.size).error_code,
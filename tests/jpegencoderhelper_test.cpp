@@ -21,6 +21,8 @@
 
 #include "ultrahdr/ultrahdrcommon.h"
 #include "ultrahdr/jpegencoderhelper.h"
+#include "ultrahdr/jpegdecoderhelper.h"
+#include "ultrahdr/editorhelper.h"
 
 namespace ultrahdr {
 
@@ -161,4 +163,155 @@ TEST_F(JpegEncoderHelperTest, encodeRGBImage) {
   ASSERT_GT(encoder.getCompressedImageSize(), static_cast<uint32_t>(0));
 }
 
+TEST_F(JpegEncoderHelperTest, encodeCachedCoefficients) {
+  uhdr_raw_image_t img{};
+  img.fmt = UHDR_IMG_FMT_12bppYCbCr420;
+  img.w = mUnalignedImage.width;
+  img.h = mUnalignedImage.height;
+  img.planes[UHDR_PLANE_Y] = mUnalignedImage.buffer.get();
+  img.planes[UHDR_PLANE_U] = mUnalignedImage.buffer.get() + img.w * img.h;
+  img.planes[UHDR_PLANE_V] = mUnalignedImage.buffer.get() + img.w * img.h * 5 / 4;
+  img.stride[UHDR_PLANE_Y] = img.w;
+  img.stride[UHDR_PLANE_U] = img.stride[UHDR_PLANE_V] = img.w / 2;
+
+  JpegEncoderHelper cachedEncoder;
+  EXPECT_EQ(cachedEncoder.compressCachedCoefficients(JPEG_QUALITY, NULL, 0).error_code,
+            UHDR_CODEC_INVALID_OPERATION);
+  ASSERT_EQ(cachedEncoder.cacheCoefficients(&img).error_code, UHDR_CODEC_OK);
+  EXPECT_EQ(cachedEncoder.compressCachedCoefficients(0, NULL, 0).error_code,
+            UHDR_CODEC_INVALID_PARAM);
+
+  for (int quality : {20, 50, 75, JPEG_QUALITY}) {
+    JpegEncoderHelper encoder;
+    ASSERT_EQ(encoder.compressImage(&img, quality, NULL, 0).error_code, UHDR_CODEC_OK);
+    ASSERT_EQ(cachedEncoder.compressCachedCoefficients(quality, NULL, 0).error_code,
+              UHDR_CODEC_OK);
+    size_t refSize = encoder.getCompressedImageSize();
+    size_t size = cachedEncoder.getCompressedImageSize();
+    EXPECT_NEAR((double)size, (double)refSize, refSize * 0.05) << "quality " << quality;
+
+    JpegDecoderHelper refDecoder, decoder;
+    ASSERT_EQ(refDecoder
+                  .decompressImage(encoder.getCompressedImagePtr(),
+                                   encoder.getCompressedImageSize())
+                  .error_code,
+              UHDR_CODEC_OK);
+    ASSERT_EQ(decoder
+                  .decompressImage(cachedEncoder.getCompressedImagePtr(),
+                                   cachedEncoder.getCompressedImageSize())
+                  .error_code,
+              UHDR_CODEC_OK);
+    uhdr_raw_image_t refImg = refDecoder.getDecompressedImage();
+    uhdr_raw_image_t outImg = decoder.getDecompressedImage();
+    ASSERT_EQ(refImg.w, img.w);
+    ASSERT_EQ(outImg.w, img.w);
+    ASSERT_EQ(outImg.h, img.h);
+    double sumAbsDiff = 0;
+    for (unsigned int i = 0; i < img.h; i++) {
+      const uint8_t* refRow =
+          static_cast<uint8_t*>(refImg.planes[UHDR_PLANE_Y]) + i * refImg.stride[UHDR_PLANE_Y];
+      const uint8_t* outRow =
+          static_cast<uint8_t*>(outImg.planes[UHDR_PLANE_Y]) + i * outImg.stride[UHDR_PLANE_Y];
+      for (unsigned int j = 0; j < img.w; j++) sumAbsDiff += std::abs(refRow[j] - outRow[j]);
+    }
+    EXPECT_LE(sumAbsDiff / (img.w * img.h), 1.0) << "quality " << quality;
+  }
+}
+
+TEST_F(JpegEncoderHelperTest, transformImageLossless) {
+  uhdr_raw_image_t img{};
+  img.fmt = UHDR_IMG_FMT_12bppYCbCr420;
+  img.w = mAlignedImage.width;
+  img.h = mAlignedImage.height;
+  img.planes[UHDR_PLANE_Y] = mAlignedImage.buffer.get();
+  img.planes[UHDR_PLANE_U] = mAlignedImage.buffer.get() + img.w * img.h;
+  img.planes[UHDR_PLANE_V] = mAlignedImage.buffer.get() + img.w * img.h * 5 / 4;
+  img.stride[UHDR_PLANE_Y] = img.w;
+  img.stride[UHDR_PLANE_U] = img.stride[UHDR_PLANE_V] = img.w / 2;
+
+  JpegEncoderHelper encoder;
+  ASSERT_EQ(encoder.compressImage(&img, JPEG_QUALITY, NULL, 0).error_code, UHDR_CODEC_OK);
+  JpegDecoderHelper refDecoder;
+  ASSERT_EQ(refDecoder
+                .decompressImage(encoder.getCompressedImagePtr(), encoder.getCompressedImageSize())
+                .error_code,
+            UHDR_CODEC_OK);
+  uhdr_raw_image_t refImg = refDecoder.getDecompressedImage();
+
+  std::vector<uhdr_effect_transform_t> xfms;
+  for (int degree : {90, 180, 270}) {
+    xfms.emplace_back(img.fmt, img.w, img.h);
+    xfms.back().rotate(degree);
+  }
+  for (auto direction : {UHDR_MIRROR_HORIZONTAL, UHDR_MIRROR_VERTICAL}) {
+    xfms.emplace_back(img.fmt, img.w, img.h);
+    xfms.back().mirror(direction);
+  }
+  xfms.emplace_back(img.fmt, img.w, img.h);
+  xfms.back().crop(32, 16, 160, 112);
+  xfms.back().rotate(90);
+  xfms.back().mirror(UHDR_MIRROR_HORIZONTAL);
+
+  for (size_t i = 0; i < xfms.size(); i++) {
+    // moving quantized coefficients matches moving decoded pixels up to idct rounding
+    JpegEncoderHelper transformer;
+    ASSERT_EQ(transformer
+                  .transformImage(encoder.getCompressedImagePtr(),
+                                  encoder.getCompressedImageSize(), &xfms[i])
+                  .error_code,
+              UHDR_CODEC_OK)
+        << "transform " << i;
+    JpegDecoderHelper decoder;
+    ASSERT_EQ(decoder
+                  .decompressImage(transformer.getCompressedImagePtr(),
+                                   transformer.getCompressedImageSize())
+                  .error_code,
+              UHDR_CODEC_OK);
+    uhdr_raw_image_t outImg = decoder.getDecompressedImage();
+    auto expected = apply_transform(&xfms[i], &refImg);
+    ASSERT_NE(expected, nullptr);
+    ASSERT_EQ(outImg.w, expected->w) << "transform " << i;
+    ASSERT_EQ(outImg.h, expected->h) << "transform " << i;
+    for (int p = 0; p < 3; p++) {
+      const unsigned int w = p == 0 ? outImg.w : outImg.w / 2;
+      const unsigned int h = p == 0 ? outImg.h : outImg.h / 2;
+      int maxAbsDiff = 0;
+      for (unsigned int y = 0; y < h; y++) {
+        const uint8_t* expRow =
+            static_cast<uint8_t*>(expected->planes[p]) + y * expected->stride[p];
+        const uint8_t* outRow = static_cast<uint8_t*>(outImg.planes[p]) + y * outImg.stride[p];
+        for (unsigned int x = 0; x < w; x++) {
+          maxAbsDiff = (std::max)(maxAbsDiff, std::abs(expRow[x] - outRow[x]));
+        }
+      }
+      EXPECT_LE(maxAbsDiff, 2) << "transform " << i << " plane " << p;
+    }
+  }
+
+  // crop offsets and trailing edges of mirrored axes must be on the imcu grid
+  uhdr_effect_transform_t unaligned(img.fmt, img.w, img.h);
+  unaligned.crop(8, 0, 64, 64);
+  JpegEncoderHelper transformer;
+  EXPECT_EQ(transformer
+                .transformImage(encoder.getCompressedImagePtr(), encoder.getCompressedImageSize(),
+                                &unaligned)
+                .error_code,
+            UHDR_CODEC_INVALID_PARAM);
+  uhdr_effect_transform_t partial(img.fmt, img.w, img.h);
+  partial.crop(0, 0, 200, 64);
+  partial.mirror(UHDR_MIRROR_HORIZONTAL);
+  EXPECT_EQ(transformer
+                .transformImage(encoder.getCompressedImagePtr(), encoder.getCompressedImageSize(),
+                                &partial)
+                .error_code,
+            UHDR_CODEC_INVALID_PARAM);
+  uhdr_effect_transform_t resized(img.fmt, img.w, img.h);
+  resized.resize(img.w / 2, img.h / 2);
+  EXPECT_EQ(transformer
+                .transformImage(encoder.getCompressedImagePtr(), encoder.getCompressedImageSize(),
+                                &resized)
+                .error_code,
+            UHDR_CODEC_INVALID_PARAM);
+}
+
 }  // namespace ultrahdr
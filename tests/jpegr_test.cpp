@@ -21,12 +21,14 @@
 #endif
 #include <gtest/gtest.h>
 
+#include <cmath>
 #include <fstream>
 #include <iostream>
 
 #include "ultrahdr_api.h"
 
 #include "ultrahdr/ultrahdrcommon.h"
+#include "ultrahdr/editorhelper.h"
 #include "ultrahdr/jpegr.h"
 #include "ultrahdr/jpegrutils.h"
 
@@ -2386,4 +2388,975 @@ TEST(JpegRTest, ProfileGainMapFuncs) {
 #endif
 }
 
+
+TEST(JpegRTest, GenerateGainMapFromDownscaledSdr) {
+  UhdrUnCompressedStructWrapper rawImgP010(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImgP010.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImgP010.allocateMemory());
+  ASSERT_TRUE(rawImgP010.loadRawResource(kYCbCrP010FileName));
+  UhdrCompressedStructWrapper jpgImg(kImageWidth, kImageHeight);
+  ASSERT_TRUE(jpgImg.allocateMemory());
+  auto sdrJpg = jpgImg.getImageHandle();
+  ASSERT_TRUE(readFile(kSdrJpgFileName, sdrJpg->data, sdrJpg->maxLength, sdrJpg->length));
+
+  uhdr_raw_image_t hdr_intent;
+  {
+    auto rawImg = rawImgP010.getImageHandle();
+    if (rawImg->luma_stride == 0) rawImg->luma_stride = rawImg->width;
+    if (!rawImg->chroma_data) {
+      uint16_t* data = reinterpret_cast<uint16_t*>(rawImg->data);
+      rawImg->chroma_data = data + rawImg->luma_stride * rawImg->height;
+      rawImg->chroma_stride = rawImg->luma_stride;
+    }
+    hdr_intent.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+    hdr_intent.cg = UHDR_CG_BT_2100;
+    hdr_intent.ct = UHDR_CT_HLG;
+    hdr_intent.range = UHDR_CR_LIMITED_RANGE;
+    hdr_intent.w = rawImg->width;
+    hdr_intent.h = rawImg->height;
+    hdr_intent.planes[UHDR_PLANE_Y] = rawImg->data;
+    hdr_intent.stride[UHDR_PLANE_Y] = rawImg->luma_stride;
+    hdr_intent.planes[UHDR_PLANE_UV] = rawImg->chroma_data;
+    hdr_intent.stride[UHDR_PLANE_UV] = rawImg->chroma_stride;
+    hdr_intent.planes[UHDR_PLANE_V] = nullptr;
+    hdr_intent.stride[UHDR_PLANE_V] = 0;
+  }
+
+  for (int scaleFactor : {2, 4, 8}) {
+    JpegR jpegr(nullptr, scaleFactor, kQuality, false, 1.0f, UHDR_USAGE_REALTIME);
+
+    // reference, gainmap computed from sdr intent decoded at full resolution
+    JpegDecoderHelper refDecoder;
+    ASSERT_EQ(UHDR_CODEC_OK, refDecoder.decompressImage(sdrJpg->data, sdrJpg->length).error_code);
+    uhdr_raw_image_t refSdr = refDecoder.getDecompressedImage();
+    refSdr.cg = UHDR_CG_BT_709;
+    uhdr_gainmap_metadata_ext_t refMetadata(kJpegrVersion);
+    std::unique_ptr<uhdr_raw_image_ext_t> refGainmap;
+    ASSERT_EQ(UHDR_CODEC_OK,
+              jpegr.generateGainMap(&refSdr, &hdr_intent, &refMetadata, refGainmap, true)
+                  .error_code);
+
+    // gainmap computed from sdr intent decoded at gain map resolution
+    JpegDecoderHelper decoder;
+    ASSERT_EQ(UHDR_CODEC_OK, decoder
+                                 .decompressImage(sdrJpg->data, sdrJpg->length, DECODE_TO_RGB_CS,
+                                                  scaleFactor)
+                                 .error_code);
+    uhdr_raw_image_t sdr = decoder.getDecompressedImage();
+    ASSERT_EQ(sdr.w, (kImageWidth + scaleFactor - 1) / scaleFactor);
+    ASSERT_EQ(sdr.h, (kImageHeight + scaleFactor - 1) / scaleFactor);
+    sdr.cg = UHDR_CG_BT_709;
+    uhdr_gainmap_metadata_ext_t metadata(kJpegrVersion);
+    std::unique_ptr<uhdr_raw_image_ext_t> gainmap;
+    ASSERT_EQ(UHDR_CODEC_OK,
+              jpegr.generateGainMap(&sdr, &hdr_intent, &metadata, gainmap, true, true, scaleFactor)
+                  .error_code);
+
+    ASSERT_EQ(refGainmap->w, gainmap->w);
+    ASSERT_EQ(refGainmap->h, gainmap->h);
+    double sumAbsDiff = 0;
+    for (unsigned int y = 0; y < gainmap->h; y++) {
+      uint8_t* refRow = static_cast<uint8_t*>(refGainmap->planes[UHDR_PLANE_Y]) +
+                        (size_t)y * refGainmap->stride[UHDR_PLANE_Y];
+      uint8_t* row = static_cast<uint8_t*>(gainmap->planes[UHDR_PLANE_Y]) +
+                     (size_t)y * gainmap->stride[UHDR_PLANE_Y];
+      for (unsigned int x = 0; x < gainmap->w; x++) {
+        sumAbsDiff += std::abs(refRow[x] - row[x]);
+      }
+    }
+    EXPECT_LE(sumAbsDiff / ((double)gainmap->w * gainmap->h), 0.25)
+        << "for gain map scale factor " << scaleFactor;
+  }
+}
+
+TEST(JpegRTest, GenerateGainMapEstimatedRange) {
+  UhdrUnCompressedStructWrapper rawImgP010(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImgP010.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImgP010.allocateMemory());
+  ASSERT_TRUE(rawImgP010.loadRawResource(kYCbCrP010FileName));
+  UhdrCompressedStructWrapper jpgImg(kImageWidth, kImageHeight);
+  ASSERT_TRUE(jpgImg.allocateMemory());
+  auto sdrJpg = jpgImg.getImageHandle();
+  ASSERT_TRUE(readFile(kSdrJpgFileName, sdrJpg->data, sdrJpg->maxLength, sdrJpg->length));
+
+  uhdr_raw_image_t hdr_intent{};
+  hdr_intent.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+  hdr_intent.cg = UHDR_CG_BT_2100;
+  hdr_intent.ct = UHDR_CT_HLG;
+  hdr_intent.range = UHDR_CR_LIMITED_RANGE;
+  hdr_intent.w = kImageWidth;
+  hdr_intent.h = kImageHeight;
+  hdr_intent.planes[UHDR_PLANE_Y] = rawImgP010.getImageHandle()->data;
+  hdr_intent.stride[UHDR_PLANE_Y] = kImageWidth;
+  hdr_intent.planes[UHDR_PLANE_UV] =
+      ((uint8_t*)(rawImgP010.getImageHandle()->data)) + kImageWidth * kImageHeight * 2;
+  hdr_intent.stride[UHDR_PLANE_UV] = kImageWidth;
+
+  JpegDecoderHelper decoder;
+  ASSERT_EQ(UHDR_CODEC_OK, decoder.decompressImage(sdrJpg->data, sdrJpg->length).error_code);
+  uhdr_raw_image_t sdr_intent = decoder.getDecompressedImage();
+  sdr_intent.cg = UHDR_CG_BT_709;
+
+  for (bool multiChannel : {false, true}) {
+    // exact range (best quality) vs range estimated from a subsample (balanced), both two pass
+    JpegR refJpegr(nullptr, 1, kQuality, multiChannel, 1.0f, UHDR_USAGE_BEST_QUALITY);
+    JpegR jpegr(nullptr, 1, kQuality, multiChannel, 1.0f, UHDR_USAGE_BALANCED);
+    uhdr_gainmap_metadata_ext_t refMetadata(kJpegrVersion), metadata(kJpegrVersion);
+    std::unique_ptr<uhdr_raw_image_ext_t> refGainmap, gainmap;
+    ASSERT_EQ(UHDR_CODEC_OK,
+              refJpegr.generateGainMap(&sdr_intent, &hdr_intent, &refMetadata, refGainmap, true)
+                  .error_code);
+    ASSERT_EQ(UHDR_CODEC_OK,
+              jpegr.generateGainMap(&sdr_intent, &hdr_intent, &metadata, gainmap, true)
+                  .error_code);
+    ASSERT_EQ(refGainmap->fmt, gainmap->fmt);
+
+    const int channels = multiChannel ? 3 : 1;
+    for (int c = 0; c < channels; c++) {
+      // a subsample can only narrow the range
+      EXPECT_GE(metadata.min_content_boost[c], refMetadata.min_content_boost[c] * 0.999f);
+      EXPECT_LE(metadata.max_content_boost[c], refMetadata.max_content_boost[c] * 1.001f);
+    }
+
+    // compare the log2 boost encoded by each map
+    auto logBoost = [](const uhdr_gainmap_metadata_ext_t& md, uint8_t code, int c) {
+      float logMin = std::log2(md.min_content_boost[c]);
+      float logMax = std::log2(md.max_content_boost[c]);
+      return logMin + (logMax - logMin) * (code / 255.0f);
+    };
+    double sumAbsDiff = 0;
+    for (unsigned int y = 0; y < gainmap->h; y++) {
+      uint8_t* refRow = static_cast<uint8_t*>(refGainmap->planes[UHDR_PLANE_Y]) +
+                        (size_t)y * refGainmap->stride[UHDR_PLANE_Y] * channels;
+      uint8_t* row = static_cast<uint8_t*>(gainmap->planes[UHDR_PLANE_Y]) +
+                     (size_t)y * gainmap->stride[UHDR_PLANE_Y] * channels;
+      for (unsigned int x = 0; x < gainmap->w * channels; x++) {
+        sumAbsDiff += std::abs(logBoost(refMetadata, refRow[x], x % channels) -
+                               logBoost(metadata, row[x], x % channels));
+      }
+    }
+    EXPECT_LE(sumAbsDiff / ((double)gainmap->w * gainmap->h * channels), 0.05)
+        << "for multichannel " << multiChannel;
+  }
+}
+
+/* Test encoding to a target size */
+TEST(JpegRTest, EncodeToTargetSize) {
+  UhdrUnCompressedStructWrapper rawImg(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImg.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImg.allocateMemory());
+  ASSERT_TRUE(rawImg.loadRawResource(kYCbCrP010FileName));
+
+  uhdr_raw_image_t uhdrRawImg{};
+  uhdrRawImg.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+  uhdrRawImg.cg = UHDR_CG_BT_2100;
+  uhdrRawImg.ct = UHDR_CT_HLG;
+  uhdrRawImg.range = UHDR_CR_LIMITED_RANGE;
+  uhdrRawImg.w = kImageWidth;
+  uhdrRawImg.h = kImageHeight;
+  uhdrRawImg.planes[UHDR_PLANE_Y] = rawImg.getImageHandle()->data;
+  uhdrRawImg.stride[UHDR_PLANE_Y] = kImageWidth;
+  uhdrRawImg.planes[UHDR_PLANE_UV] =
+      ((uint8_t*)(rawImg.getImageHandle()->data)) + kImageWidth * kImageHeight * 2;
+  uhdrRawImg.stride[UHDR_PLANE_UV] = kImageWidth;
+
+  auto encode = [&](size_t targetSize, uhdr_error_info_t& status) -> size_t {
+    uhdr_codec_private_t* obj = uhdr_create_encoder();
+    status = uhdr_enc_set_raw_image(obj, &uhdrRawImg, UHDR_HDR_IMG);
+    EXPECT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_enc_set_quality(obj, kQuality, UHDR_BASE_IMG);
+    EXPECT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_enc_set_target_size(obj, targetSize);
+    EXPECT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_encode(obj);
+    uhdr_compressed_image_t* output = uhdr_get_encoded_stream(obj);
+    size_t size = output ? output->data_sz : 0;
+    if (output) {
+      uhdr_codec_private_t* dec = uhdr_create_decoder();
+      uhdr_error_info_t dec_status = uhdr_dec_set_image(dec, output);
+      EXPECT_EQ(UHDR_CODEC_OK, dec_status.error_code) << dec_status.detail;
+      dec_status = uhdr_decode(dec);
+      EXPECT_EQ(UHDR_CODEC_OK, dec_status.error_code) << dec_status.detail;
+      uhdr_release_decoder(dec);
+    }
+    uhdr_release_encoder(obj);
+    return size;
+  };
+
+  uhdr_error_info_t status;
+  size_t refSize = encode(0, status);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  ASSERT_GT(refSize, 0u);
+
+  // a budget larger than the default output is met at the configured quality
+  size_t size = encode(refSize * 2, status);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  EXPECT_LE(size, refSize * 2);
+  EXPECT_NEAR((double)size, (double)refSize, refSize * 0.05);
+
+  for (double ratio : {0.9, 0.75}) {
+    size_t targetSize = refSize * ratio;
+    size = encode(targetSize, status);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    EXPECT_LE(size, targetSize) << "for target size ratio " << ratio;
+    EXPECT_GE(size, targetSize / 2) << "for target size ratio " << ratio;
+  }
+
+  // unreachable budget
+  encode(1024, status);
+  EXPECT_EQ(UHDR_CODEC_ERROR, status.error_code);
+
+  // not supported for compressed intents
+  {
+    UhdrCompressedStructWrapper jpgImg(kImageWidth, kImageHeight);
+    ASSERT_TRUE(jpgImg.allocateMemory());
+    auto sdrJpg = jpgImg.getImageHandle();
+    ASSERT_TRUE(readFile(kSdrJpgFileName, sdrJpg->data, sdrJpg->maxLength, sdrJpg->length));
+    uhdr_compressed_image_t sdrImg{};
+    sdrImg.data = sdrJpg->data;
+    sdrImg.data_sz = sdrImg.capacity = sdrJpg->length;
+    sdrImg.cg = UHDR_CG_BT_709;
+    sdrImg.ct = UHDR_CT_SRGB;
+    sdrImg.range = UHDR_CR_FULL_RANGE;
+    uhdr_codec_private_t* obj = uhdr_create_encoder();
+    status = uhdr_enc_set_raw_image(obj, &uhdrRawImg, UHDR_HDR_IMG);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_enc_set_compressed_image(obj, &sdrImg, UHDR_SDR_IMG);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_enc_set_target_size(obj, refSize);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_encode(obj);
+    EXPECT_EQ(UHDR_CODEC_INVALID_OPERATION, status.error_code);
+    uhdr_release_encoder(obj);
+  }
+}
+
+/* Test encoding presets */
+TEST(JpegRTest, EncodePresets) {
+  UhdrUnCompressedStructWrapper rawImg(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImg.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImg.allocateMemory());
+  ASSERT_TRUE(rawImg.loadRawResource(kYCbCrP010FileName));
+
+  uhdr_raw_image_t uhdrRawImg{};
+  uhdrRawImg.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+  uhdrRawImg.cg = UHDR_CG_BT_2100;
+  uhdrRawImg.ct = UHDR_CT_HLG;
+  uhdrRawImg.range = UHDR_CR_LIMITED_RANGE;
+  uhdrRawImg.w = kImageWidth;
+  uhdrRawImg.h = kImageHeight;
+  uhdrRawImg.planes[UHDR_PLANE_Y] = rawImg.getImageHandle()->data;
+  uhdrRawImg.stride[UHDR_PLANE_Y] = kImageWidth;
+  uhdrRawImg.planes[UHDR_PLANE_UV] =
+      ((uint8_t*)(rawImg.getImageHandle()->data)) + kImageWidth * kImageHeight * 2;
+  uhdrRawImg.stride[UHDR_PLANE_UV] = kImageWidth;
+
+  // encodes with given preset, optionally overriding the gain map scale factor, and checks the
+  // gain map of the decoded output
+  auto encodeAndCheck = [&](uhdr_enc_preset_t preset, int scaleFactor, int expScaleFactor,
+                            bool expMultiChannel) {
+    uhdr_codec_private_t* obj = uhdr_create_encoder();
+    uhdr_error_info_t status = uhdr_enc_set_raw_image(obj, &uhdrRawImg, UHDR_HDR_IMG);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_enc_set_preset(obj, preset);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    if (scaleFactor > 0) {
+      status = uhdr_enc_set_gainmap_scale_factor(obj, scaleFactor);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    }
+    status = uhdr_encode(obj);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    uhdr_compressed_image_t* output = uhdr_get_encoded_stream(obj);
+    ASSERT_NE(nullptr, output);
+
+    uhdr_codec_private_t* dec = uhdr_create_decoder();
+    status = uhdr_dec_set_image(dec, output);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_decode(dec);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    uhdr_raw_image_t* gainmap = uhdr_get_decoded_gainmap_image(dec);
+    ASSERT_NE(nullptr, gainmap);
+    EXPECT_EQ(gainmap->w, kImageWidth / expScaleFactor) << "for preset " << preset;
+    EXPECT_EQ(gainmap->h, kImageHeight / expScaleFactor) << "for preset " << preset;
+    EXPECT_EQ(gainmap->fmt != UHDR_IMG_FMT_8bppYCbCr400, expMultiChannel)
+        << "for preset " << preset;
+    uhdr_release_decoder(dec);
+    uhdr_release_encoder(obj);
+  };
+
+  encodeAndCheck(UHDR_USAGE_FASTEST, 0, 4, false);
+  encodeAndCheck(UHDR_USAGE_REALTIME, 0, kMapDimensionScaleFactorDefault,
+                 kUseMultiChannelGainMapDefault);
+  encodeAndCheck(UHDR_USAGE_BALANCED, 0, 2, true);
+  encodeAndCheck(UHDR_USAGE_BEST_QUALITY, 0, kMapDimensionScaleFactorDefault,
+                 kUseMultiChannelGainMapDefault);
+  // explicit configuration takes precedence over preset
+  encodeAndCheck(UHDR_USAGE_FASTEST, 1, 1, false);
+
+  uhdr_codec_private_t* obj = uhdr_create_encoder();
+  uhdr_error_info_t status = uhdr_enc_set_preset(obj, static_cast<uhdr_enc_preset_t>(4));
+  EXPECT_EQ(UHDR_CODEC_INVALID_PARAM, status.error_code);
+  uhdr_release_encoder(obj);
+}
+
+TEST(JpegRTest, DecodePresets) {
+  UhdrUnCompressedStructWrapper rawImg(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImg.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImg.allocateMemory());
+  ASSERT_TRUE(rawImg.loadRawResource(kYCbCrP010FileName));
+
+  uhdr_raw_image_t uhdrRawImg{};
+  uhdrRawImg.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+  uhdrRawImg.cg = UHDR_CG_BT_2100;
+  uhdrRawImg.ct = UHDR_CT_HLG;
+  uhdrRawImg.range = UHDR_CR_LIMITED_RANGE;
+  uhdrRawImg.w = kImageWidth;
+  uhdrRawImg.h = kImageHeight;
+  uhdrRawImg.planes[UHDR_PLANE_Y] = rawImg.getImageHandle()->data;
+  uhdrRawImg.stride[UHDR_PLANE_Y] = kImageWidth;
+  uhdrRawImg.planes[UHDR_PLANE_UV] =
+      ((uint8_t*)(rawImg.getImageHandle()->data)) + kImageWidth * kImageHeight * 2;
+  uhdrRawImg.stride[UHDR_PLANE_UV] = kImageWidth;
+
+  // decodes with given preset and returns the packed output as per channel integer codes
+  auto decode = [](uhdr_compressed_image_t* img, uhdr_dec_preset_t preset,
+                   uhdr_color_transfer_t ct, uhdr_img_fmt_t fmt, std::vector<int>& codes) {
+    uhdr_codec_private_t* dec = uhdr_create_decoder();
+    uhdr_error_info_t status = uhdr_dec_set_image(dec, img);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_preset(dec, preset);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_out_color_transfer(dec, ct);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_out_img_format(dec, fmt);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_decode(dec);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    uhdr_raw_image_t* out = uhdr_get_decoded_image(dec);
+    ASSERT_NE(nullptr, out);
+    codes.clear();
+    for (unsigned int i = 0; i < out->h; i++) {
+      uint32_t* row = static_cast<uint32_t*>(out->planes[UHDR_PLANE_PACKED]) +
+                      (size_t)i * out->stride[UHDR_PLANE_PACKED];
+      for (unsigned int j = 0; j < out->w; j++) {
+        if (fmt == UHDR_IMG_FMT_32bppRGBA1010102) {
+          for (int c = 0; c < 3; c++) codes.push_back((row[j] >> (10 * c)) & 0x3ff);
+        } else {
+          for (int c = 0; c < 3; c++) codes.push_back((row[j] >> (8 * c)) & 0xff);
+        }
+      }
+    }
+    uhdr_release_decoder(dec);
+  };
+
+  // with a display p3 hdr intent, base image and gain map share the gamut, which lets the realtime
+  // preset apply single channel maps through a 2D table
+  for (auto hdrCg : {UHDR_CG_BT_2100, UHDR_CG_DISPLAY_P3}) {
+    uhdrRawImg.cg = hdrCg;
+    for (auto encPreset : {UHDR_USAGE_FASTEST, UHDR_USAGE_BALANCED}) {
+      uhdr_codec_private_t* obj = uhdr_create_encoder();
+      uhdr_error_info_t status = uhdr_enc_set_raw_image(obj, &uhdrRawImg, UHDR_HDR_IMG);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      status = uhdr_enc_set_preset(obj, encPreset);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      status = uhdr_encode(obj);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      uhdr_compressed_image_t* output = uhdr_get_encoded_stream(obj);
+      ASSERT_NE(nullptr, output);
+
+      const struct {
+        uhdr_color_transfer_t ct;
+        uhdr_img_fmt_t fmt;
+      } outputs[] = {{UHDR_CT_HLG, UHDR_IMG_FMT_32bppRGBA1010102},
+                     {UHDR_CT_PQ, UHDR_IMG_FMT_32bppRGBA1010102},
+                     {UHDR_CT_SRGB, UHDR_IMG_FMT_32bppRGBA8888}};
+      for (auto& out : outputs) {
+        std::vector<int> ref, test;
+        decode(output, UHDR_DEC_USAGE_BEST_QUALITY, out.ct, out.fmt, ref);
+        // mean absolute error bound (in output code values) of each preset w.r.t best quality
+        const struct {
+          uhdr_dec_preset_t preset;
+          double maxMeanAbsDiff;
+        } presets[] = {{UHDR_DEC_USAGE_BALANCED, 0.25}, {UHDR_DEC_USAGE_REALTIME, 1.0}};
+        for (auto& p : presets) {
+          decode(output, p.preset, out.ct, out.fmt, test);
+          ASSERT_EQ(ref.size(), test.size());
+          double sum = 0;
+          for (size_t i = 0; i < ref.size(); i++) sum += std::abs(ref[i] - test[i]);
+          EXPECT_LE(sum / ref.size(), p.maxMeanAbsDiff)
+              << "for hdr gamut " << hdrCg << ", encode preset " << encPreset
+              << ", decode preset " << p.preset << ", color transfer " << out.ct;
+          // sdr output does not involve gain map application
+          if (out.ct == UHDR_CT_SRGB && p.preset == UHDR_DEC_USAGE_BALANCED) {
+            EXPECT_EQ(ref, test);
+          }
+        }
+      }
+      uhdr_release_encoder(obj);
+    }
+  }
+
+  uhdr_codec_private_t* dec = uhdr_create_decoder();
+  uhdr_error_info_t status = uhdr_dec_set_preset(dec, static_cast<uhdr_dec_preset_t>(3));
+  EXPECT_EQ(UHDR_CODEC_INVALID_PARAM, status.error_code);
+  uhdr_release_decoder(dec);
+}
+
+TEST(JpegRTest, RemuxMetadata) {
+  UhdrUnCompressedStructWrapper rawImg(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImg.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImg.allocateMemory());
+  ASSERT_TRUE(rawImg.loadRawResource(kYCbCrP010FileName));
+
+  uhdr_raw_image_t uhdrRawImg{};
+  uhdrRawImg.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+  uhdrRawImg.cg = UHDR_CG_BT_2100;
+  uhdrRawImg.ct = UHDR_CT_HLG;
+  uhdrRawImg.range = UHDR_CR_LIMITED_RANGE;
+  uhdrRawImg.w = kImageWidth;
+  uhdrRawImg.h = kImageHeight;
+  uhdrRawImg.planes[UHDR_PLANE_Y] = rawImg.getImageHandle()->data;
+  uhdrRawImg.stride[UHDR_PLANE_Y] = kImageWidth;
+  uhdrRawImg.planes[UHDR_PLANE_UV] =
+      ((uint8_t*)(rawImg.getImageHandle()->data)) + kImageWidth * kImageHeight * 2;
+  uhdrRawImg.stride[UHDR_PLANE_UV] = kImageWidth;
+
+  uhdr_codec_private_t* enc = uhdr_create_encoder();
+  uhdr_error_info_t status = uhdr_enc_set_raw_image(enc, &uhdrRawImg, UHDR_HDR_IMG);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_encode(enc);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  uhdr_compressed_image_t* input = uhdr_get_encoded_stream(enc);
+  ASSERT_NE(nullptr, input);
+
+  // decodes the image to sdr and to linear hdr, and reads its metadata
+  struct DecodedImage {
+    std::vector<uint8_t> sdr, hdr, exif, icc;
+    uhdr_gainmap_metadata_t metadata;
+  };
+  auto decode = [](uhdr_compressed_image_t* img, DecodedImage& out) {
+    for (auto ct : {UHDR_CT_SRGB, UHDR_CT_LINEAR}) {
+      uhdr_codec_private_t* dec = uhdr_create_decoder();
+      uhdr_error_info_t status = uhdr_dec_set_image(dec, img);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      status = uhdr_dec_set_out_color_transfer(dec, ct);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      status = uhdr_dec_set_out_img_format(dec, ct == UHDR_CT_SRGB
+                                                    ? UHDR_IMG_FMT_32bppRGBA8888
+                                                    : UHDR_IMG_FMT_64bppRGBAHalfFloat);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      status = uhdr_decode(dec);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      uhdr_raw_image_t* raw = uhdr_get_decoded_image(dec);
+      ASSERT_NE(nullptr, raw);
+      uint8_t* data = static_cast<uint8_t*>(raw->planes[UHDR_PLANE_PACKED]);
+      size_t size = (size_t)raw->stride[UHDR_PLANE_PACKED] * raw->h *
+                    (ct == UHDR_CT_SRGB ? 4 : 8);
+      (ct == UHDR_CT_SRGB ? out.sdr : out.hdr).assign(data, data + size);
+      if (ct == UHDR_CT_SRGB) {
+        uhdr_mem_block_t* exif = uhdr_dec_get_exif(dec);
+        ASSERT_NE(nullptr, exif);
+        out.exif.assign((uint8_t*)exif->data, (uint8_t*)exif->data + exif->data_sz);
+        uhdr_mem_block_t* icc = uhdr_dec_get_icc(dec);
+        ASSERT_NE(nullptr, icc);
+        out.icc.assign((uint8_t*)icc->data, (uint8_t*)icc->data + icc->data_sz);
+        uhdr_gainmap_metadata_t* metadata = uhdr_dec_get_gainmap_metadata(dec);
+        ASSERT_NE(nullptr, metadata);
+        out.metadata = *metadata;
+      }
+      uhdr_release_decoder(dec);
+    }
+  };
+  // remuxes the input with given replacements
+  auto remux = [](uhdr_compressed_image_t* img, uhdr_gainmap_metadata_t* metadata,
+                  uhdr_mem_block_t* exif, uhdr_mem_block_t* icc, std::vector<uint8_t>& out) {
+    uhdr_codec_private_t* obj = uhdr_create_encoder();
+    uhdr_error_info_t status = uhdr_remux(obj, img, metadata, exif, icc);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    uhdr_compressed_image_t* output = uhdr_get_encoded_stream(obj);
+    ASSERT_NE(nullptr, output);
+    out.assign((uint8_t*)output->data, (uint8_t*)output->data + output->data_sz);
+    // context is in end state
+    status = uhdr_remux(obj, img, metadata, exif, icc);
+    EXPECT_EQ(UHDR_CODEC_INVALID_OPERATION, status.error_code);
+    uhdr_release_encoder(obj);
+  };
+  auto wrap = [](std::vector<uint8_t>& data) {
+    uhdr_compressed_image_t img{data.data(),        data.size(),         data.size(),
+                                UHDR_CG_UNSPECIFIED, UHDR_CT_UNSPECIFIED, UHDR_CR_UNSPECIFIED};
+    return img;
+  };
+
+  DecodedImage ref;
+  decode(input, ref);
+  ASSERT_FALSE(::testing::Test::HasFatalFailure());
+  ASSERT_GT(ref.icc.size(), 0);
+
+  // retaining everything yields an identical image
+  {
+    std::vector<uint8_t> remuxed;
+    remux(input, nullptr, nullptr, nullptr, remuxed);
+    ASSERT_FALSE(::testing::Test::HasFatalFailure());
+    EXPECT_EQ(remuxed.size(), input->data_sz);
+    EXPECT_EQ(0, memcmp(remuxed.data(), input->data, remuxed.size()));
+  }
+
+  // replace metadata and insert exif, pixels of base image and gain map image must not change
+  uint8_t exifData[] = {'E', 'x', 'i', 'f', 0, 0, 'M', 'M', 0, 42, 0, 0, 0, 8, 0, 0};
+  uhdr_mem_block_t exif{exifData, sizeof exifData, sizeof exifData};
+  uhdr_gainmap_metadata_t metadata = ref.metadata;
+  for (int i = 0; i < 3; i++) metadata.max_content_boost[i] *= 0.5f;
+  metadata.hdr_capacity_max *= 0.5f;
+  std::vector<uint8_t> remuxed;
+  remux(input, &metadata, &exif, nullptr, remuxed);
+  ASSERT_FALSE(::testing::Test::HasFatalFailure());
+  uhdr_compressed_image_t remuxedImg = wrap(remuxed);
+  DecodedImage test;
+  decode(&remuxedImg, test);
+  ASSERT_FALSE(::testing::Test::HasFatalFailure());
+  EXPECT_EQ(ref.sdr, test.sdr);
+  EXPECT_NE(ref.hdr, test.hdr);
+  EXPECT_EQ(ref.icc, test.icc);
+  EXPECT_EQ(std::vector<uint8_t>(exifData, exifData + sizeof exifData), test.exif);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NEAR(metadata.max_content_boost[i], test.metadata.max_content_boost[i], 1e-4f);
+  }
+  EXPECT_NEAR(metadata.hdr_capacity_max, test.metadata.hdr_capacity_max, 1e-4f);
+
+  // restoring the metadata and removing exif gives back the original rendition
+  uhdr_mem_block_t noExif{nullptr, 0, 0};
+  std::vector<uint8_t> restored;
+  remux(&remuxedImg, &ref.metadata, &noExif, nullptr, restored);
+  ASSERT_FALSE(::testing::Test::HasFatalFailure());
+  uhdr_compressed_image_t restoredImg = wrap(restored);
+  DecodedImage restoredDec;
+  decode(&restoredImg, restoredDec);
+  ASSERT_FALSE(::testing::Test::HasFatalFailure());
+  EXPECT_EQ(ref.sdr, restoredDec.sdr);
+  EXPECT_EQ(ref.hdr, restoredDec.hdr);
+  EXPECT_EQ(0, restoredDec.exif.size());
+
+  // invalid args
+  uhdr_codec_private_t* obj = uhdr_create_encoder();
+  status = uhdr_remux(obj, nullptr, nullptr, nullptr, nullptr);
+  EXPECT_EQ(UHDR_CODEC_INVALID_PARAM, status.error_code);
+  metadata.max_content_boost[0] = metadata.min_content_boost[0] * 0.5f;
+  status = uhdr_remux(obj, input, &metadata, nullptr, nullptr);
+  EXPECT_EQ(UHDR_CODEC_INVALID_PARAM, status.error_code);
+  uhdr_release_encoder(obj);
+
+  uhdr_release_encoder(enc);
+}
+
+TEST(JpegRTest, RemuxLosslessTransform) {
+  UhdrUnCompressedStructWrapper rawImg(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImg.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImg.allocateMemory());
+  ASSERT_TRUE(rawImg.loadRawResource(kYCbCrP010FileName));
+
+  uhdr_raw_image_t uhdrRawImg{};
+  uhdrRawImg.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+  uhdrRawImg.cg = UHDR_CG_BT_2100;
+  uhdrRawImg.ct = UHDR_CT_HLG;
+  uhdrRawImg.range = UHDR_CR_LIMITED_RANGE;
+  uhdrRawImg.w = kImageWidth;
+  uhdrRawImg.h = kImageHeight;
+  uhdrRawImg.planes[UHDR_PLANE_Y] = rawImg.getImageHandle()->data;
+  uhdrRawImg.stride[UHDR_PLANE_Y] = kImageWidth;
+  uhdrRawImg.planes[UHDR_PLANE_UV] =
+      ((uint8_t*)(rawImg.getImageHandle()->data)) + kImageWidth * kImageHeight * 2;
+  uhdrRawImg.stride[UHDR_PLANE_UV] = kImageWidth;
+
+  uhdr_codec_private_t* enc = uhdr_create_encoder();
+  uhdr_error_info_t status = uhdr_enc_set_raw_image(enc, &uhdrRawImg, UHDR_HDR_IMG);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_enc_set_gainmap_scale_factor(enc, 4);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_encode(enc);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  uhdr_compressed_image_t* input = uhdr_get_encoded_stream(enc);
+  ASSERT_NE(nullptr, input);
+
+  // decodes sdr rendition as rgba8888
+  auto decode = [](uhdr_compressed_image_t* img, std::vector<uint32_t>& out, unsigned int* w,
+                   unsigned int* h) {
+    uhdr_codec_private_t* dec = uhdr_create_decoder();
+    uhdr_error_info_t status = uhdr_dec_set_image(dec, img);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_out_color_transfer(dec, UHDR_CT_SRGB);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_out_img_format(dec, UHDR_IMG_FMT_32bppRGBA8888);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_decode(dec);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    uhdr_raw_image_t* raw = uhdr_get_decoded_image(dec);
+    ASSERT_NE(nullptr, raw);
+    *w = raw->w;
+    *h = raw->h;
+    out.resize((size_t)raw->w * raw->h);
+    for (unsigned int i = 0; i < raw->h; i++) {
+      memcpy(&out[(size_t)i * raw->w],
+             static_cast<uint32_t*>(raw->planes[UHDR_PLANE_PACKED]) +
+                 (size_t)i * raw->stride[UHDR_PLANE_PACKED],
+             raw->w * sizeof(uint32_t));
+    }
+    uhdr_release_decoder(dec);
+  };
+  std::vector<uint32_t> ref;
+  unsigned int refW, refH;
+  decode(input, ref, &refW, &refH);
+  ASSERT_FALSE(::testing::Test::HasFatalFailure());
+
+  // the gain map is 320x180 and its 8x8 imcus end at row 176, a vertical mirror keeps rows
+  // [0, 704) of the primary image so the gain map keeps covering it exactly
+  uhdr_codec_private_t* obj = uhdr_create_encoder();
+  status = uhdr_add_effect_rotate(obj, 90);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_remux(obj, input, nullptr, nullptr, nullptr);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  uhdr_compressed_image_t* output = uhdr_get_encoded_stream(obj);
+  ASSERT_NE(nullptr, output);
+  std::vector<uint32_t> test;
+  unsigned int testW, testH;
+  decode(output, test, &testW, &testH);
+  ASSERT_FALSE(::testing::Test::HasFatalFailure());
+  ASSERT_EQ(testW, 704u);
+  ASSERT_EQ(testH, refW);
+  double sumAbsDiff = 0;
+  for (unsigned int y = 0; y < testH; y++) {
+    for (unsigned int x = 0; x < testW; x++) {
+      uint32_t a = test[(size_t)y * testW + x];
+      uint32_t b = ref[(size_t)(testW - 1 - x) * refW + y];
+      for (int c = 0; c < 24; c += 8) {
+        sumAbsDiff += std::abs((int)((a >> c) & 0xff) - (int)((b >> c) & 0xff));
+      }
+    }
+  }
+  EXPECT_LE(sumAbsDiff / (3.0 * testW * testH), 1.0);
+  uhdr_release_encoder(obj);
+
+  // crop ends that do not map to a whole gain map sample are trimmed to the last one that does
+  obj = uhdr_create_encoder();
+  status = uhdr_add_effect_crop(obj, 0, 1001, 0, 701);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_remux(obj, input, nullptr, nullptr, nullptr);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  output = uhdr_get_encoded_stream(obj);
+  ASSERT_NE(nullptr, output);
+  decode(output, test, &testW, &testH);
+  ASSERT_FALSE(::testing::Test::HasFatalFailure());
+  EXPECT_EQ(testW, 1000u);
+  EXPECT_EQ(testH, 700u);
+  uhdr_release_encoder(obj);
+
+  // resize and crop offsets off the imcu grid can not be applied losslessly
+  obj = uhdr_create_encoder();
+  status = uhdr_add_effect_resize(obj, kImageWidth / 2, kImageHeight / 2);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_remux(obj, input, nullptr, nullptr, nullptr);
+  EXPECT_EQ(UHDR_CODEC_UNSUPPORTED_FEATURE, status.error_code);
+  uhdr_release_encoder(obj);
+  obj = uhdr_create_encoder();
+  status = uhdr_add_effect_crop(obj, 16, kImageWidth, 0, kImageHeight);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_remux(obj, input, nullptr, nullptr, nullptr);
+  EXPECT_EQ(UHDR_CODEC_UNSUPPORTED_FEATURE, status.error_code);
+  uhdr_release_encoder(obj);
+
+  uhdr_release_encoder(enc);
+}
+
+TEST(JpegRTest, DecodeRenditions) {
+  UhdrUnCompressedStructWrapper rawImg(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImg.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImg.allocateMemory());
+  ASSERT_TRUE(rawImg.loadRawResource(kYCbCrP010FileName));
+
+  uhdr_raw_image_t uhdrRawImg{};
+  uhdrRawImg.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+  uhdrRawImg.cg = UHDR_CG_BT_2100;
+  uhdrRawImg.ct = UHDR_CT_HLG;
+  uhdrRawImg.range = UHDR_CR_LIMITED_RANGE;
+  uhdrRawImg.w = kImageWidth;
+  uhdrRawImg.h = kImageHeight;
+  uhdrRawImg.planes[UHDR_PLANE_Y] = rawImg.getImageHandle()->data;
+  uhdrRawImg.stride[UHDR_PLANE_Y] = kImageWidth;
+  uhdrRawImg.planes[UHDR_PLANE_UV] =
+      ((uint8_t*)(rawImg.getImageHandle()->data)) + kImageWidth * kImageHeight * 2;
+  uhdrRawImg.stride[UHDR_PLANE_UV] = kImageWidth;
+
+  uhdr_codec_private_t* enc = uhdr_create_encoder();
+  uhdr_error_info_t status = uhdr_enc_set_raw_image(enc, &uhdrRawImg, UHDR_HDR_IMG);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_enc_set_gainmap_scale_factor(enc, 4);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_encode(enc);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  uhdr_compressed_image_t* input = uhdr_get_encoded_stream(enc);
+  ASSERT_NE(nullptr, input);
+
+  const uhdr_rendition_t renditions[] = {
+      {160, 90, UHDR_IMG_FMT_32bppRGBA1010102, UHDR_CT_PQ},
+      {kImageWidth, kImageHeight, UHDR_IMG_FMT_32bppRGBA1010102, UHDR_CT_HLG},
+      {321, 181, UHDR_IMG_FMT_32bppRGBA8888, UHDR_CT_SRGB},
+      {kImageWidth, kImageHeight, UHDR_IMG_FMT_32bppRGBA8888, UHDR_CT_SRGB},
+      {640, 360, UHDR_IMG_FMT_32bppRGBA1010102, UHDR_CT_HLG},
+      {333, 187, UHDR_IMG_FMT_64bppRGBAHalfFloat, UHDR_CT_LINEAR},
+  };
+  const unsigned int count = sizeof renditions / sizeof renditions[0];
+
+  uhdr_codec_private_t* dec = uhdr_create_decoder();
+  status = uhdr_dec_set_image(dec, input);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_decode_renditions(dec, renditions, count);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  ASSERT_EQ(nullptr, uhdr_get_decoded_rendition(dec, count));
+
+  // each rendition is compared against a separate decode with a resize effect
+  for (unsigned int i = 0; i < count; i++) {
+    const uhdr_rendition_t& r = renditions[i];
+    uhdr_raw_image_t* img = uhdr_get_decoded_rendition(dec, i);
+    ASSERT_NE(nullptr, img);
+    ASSERT_EQ(r.w, img->w);
+    ASSERT_EQ(r.h, img->h);
+    ASSERT_EQ(r.fmt, img->fmt);
+    ASSERT_EQ(r.ct, img->ct);
+    if (r.fmt == UHDR_IMG_FMT_64bppRGBAHalfFloat) continue;
+
+    uhdr_codec_private_t* refDec = uhdr_create_decoder();
+    status = uhdr_dec_set_image(refDec, input);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_out_color_transfer(refDec, r.ct);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_out_img_format(refDec, r.fmt);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    if (r.w != (unsigned int)kImageWidth || r.h != (unsigned int)kImageHeight) {
+      status = uhdr_add_effect_resize(refDec, r.w, r.h);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    }
+    status = uhdr_decode(refDec);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    uhdr_raw_image_t* ref = uhdr_get_decoded_image(refDec);
+    ASSERT_NE(nullptr, ref);
+
+    const int bits = r.fmt == UHDR_IMG_FMT_32bppRGBA8888 ? 8 : 10;
+    const uint32_t mask = (1u << bits) - 1;
+    double sum = 0;
+    int maxDiff = 0;
+    for (unsigned int y = 0; y < r.h; y++) {
+      const uint32_t* a = static_cast<uint32_t*>(img->planes[UHDR_PLANE_PACKED]) +
+                          (size_t)y * img->stride[UHDR_PLANE_PACKED];
+      const uint32_t* b = static_cast<uint32_t*>(ref->planes[UHDR_PLANE_PACKED]) +
+                          (size_t)y * ref->stride[UHDR_PLANE_PACKED];
+      for (unsigned int x = 0; x < r.w; x++) {
+        for (int c = 0; c < 3; c++) {
+          int diff = std::abs((int)((a[x] >> (c * bits)) & mask) -
+                              (int)((b[x] >> (c * bits)) & mask));
+          sum += diff;
+          maxDiff = (std::max)(maxDiff, diff);
+        }
+      }
+    }
+    // full size renditions take the same path as uhdr_decode(), smaller ones are built from the
+    // pyramid and differ from a direct resize by the resampling of the intermediate levels
+    if (r.w == (unsigned int)kImageWidth && r.h == (unsigned int)kImageHeight) {
+      EXPECT_EQ(0, maxDiff) << "rendition " << i;
+    } else {
+      EXPECT_LE(sum / (3.0 * r.w * r.h), bits == 8 ? 2.0 : 8.0) << "rendition " << i;
+    }
+    uhdr_release_decoder(refDec);
+  }
+
+  // sdr renditions do not depend on the rest of the request
+  for (unsigned int i = 0; i < count; i++) {
+    if (renditions[i].ct != UHDR_CT_SRGB) continue;
+    uhdr_codec_private_t* sdrDec = uhdr_create_decoder();
+    status = uhdr_dec_set_image(sdrDec, input);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_decode_renditions(sdrDec, &renditions[i], 1);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    uhdr_raw_image_t* a = uhdr_get_decoded_rendition(dec, i);
+    uhdr_raw_image_t* b = uhdr_get_decoded_rendition(sdrDec, 0);
+    ASSERT_NE(nullptr, b);
+    for (unsigned int y = 0; y < a->h; y++) {
+      ASSERT_EQ(0, memcmp(static_cast<uint32_t*>(a->planes[UHDR_PLANE_PACKED]) +
+                              (size_t)y * a->stride[UHDR_PLANE_PACKED],
+                          static_cast<uint32_t*>(b->planes[UHDR_PLANE_PACKED]) +
+                              (size_t)y * b->stride[UHDR_PLANE_PACKED],
+                          a->w * sizeof(uint32_t)))
+          << "rendition " << i << " row " << y;
+    }
+    uhdr_release_decoder(sdrDec);
+  }
+  uhdr_release_decoder(dec);
+
+  // argument validation
+  dec = uhdr_create_decoder();
+  status = uhdr_dec_set_image(dec, input);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_decode_renditions(dec, renditions, 0);
+  ASSERT_EQ(UHDR_CODEC_INVALID_PARAM, status.error_code) << status.detail;
+  uhdr_reset_decoder(dec);
+  const uhdr_rendition_t badPair = {160, 90, UHDR_IMG_FMT_32bppRGBA8888, UHDR_CT_HLG};
+  status = uhdr_dec_set_image(dec, input);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_decode_renditions(dec, &badPair, 1);
+  ASSERT_EQ(UHDR_CODEC_INVALID_PARAM, status.error_code) << status.detail;
+  uhdr_reset_decoder(dec);
+  const uhdr_rendition_t badSize = {0, 90, UHDR_IMG_FMT_32bppRGBA8888, UHDR_CT_SRGB};
+  status = uhdr_dec_set_image(dec, input);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_decode_renditions(dec, &badSize, 1);
+  ASSERT_EQ(UHDR_CODEC_INVALID_PARAM, status.error_code) << status.detail;
+  uhdr_reset_decoder(dec);
+  status = uhdr_dec_set_image(dec, input);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_add_effect_mirror(dec, UHDR_MIRROR_HORIZONTAL);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_decode_renditions(dec, renditions, count);
+  ASSERT_EQ(UHDR_CODEC_INVALID_OPERATION, status.error_code) << status.detail;
+  ASSERT_EQ(nullptr, uhdr_get_decoded_rendition(dec, 0));
+  uhdr_release_decoder(dec);
+
+  uhdr_release_encoder(enc);
+}
+
+TEST(JpegRTest, DecodeWithEffects) {
+  UhdrUnCompressedStructWrapper rawImg(kImageWidth, kImageHeight, YCbCr_p010);
+  ASSERT_TRUE(rawImg.setImageColorGamut(ultrahdr_color_gamut::ULTRAHDR_COLORGAMUT_BT2100));
+  ASSERT_TRUE(rawImg.allocateMemory());
+  ASSERT_TRUE(rawImg.loadRawResource(kYCbCrP010FileName));
+
+  uhdr_raw_image_t uhdrRawImg{};
+  uhdrRawImg.fmt = UHDR_IMG_FMT_24bppYCbCrP010;
+  uhdrRawImg.cg = UHDR_CG_BT_2100;
+  uhdrRawImg.ct = UHDR_CT_HLG;
+  uhdrRawImg.range = UHDR_CR_LIMITED_RANGE;
+  uhdrRawImg.w = kImageWidth;
+  uhdrRawImg.h = kImageHeight;
+  uhdrRawImg.planes[UHDR_PLANE_Y] = rawImg.getImageHandle()->data;
+  uhdrRawImg.stride[UHDR_PLANE_Y] = kImageWidth;
+  uhdrRawImg.planes[UHDR_PLANE_UV] =
+      ((uint8_t*)(rawImg.getImageHandle()->data)) + kImageWidth * kImageHeight * 2;
+  uhdrRawImg.stride[UHDR_PLANE_UV] = kImageWidth;
+
+  uhdr_codec_private_t* enc = uhdr_create_encoder();
+  uhdr_error_info_t status = uhdr_enc_set_raw_image(enc, &uhdrRawImg, UHDR_HDR_IMG);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_enc_set_gainmap_scale_factor(enc, 4);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  status = uhdr_encode(enc);
+  ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+  uhdr_compressed_image_t* input = uhdr_get_encoded_stream(enc);
+  ASSERT_NE(nullptr, input);
+
+  enum { CROP, MIRROR, ROTATE, RESIZE };
+  struct Effect {
+    int type;
+    int args[4];
+  };
+  const struct {
+    std::vector<Effect> effects;
+    bool exact;  // pure remaps and full size fallbacks reproduce the reference exactly
+  } chains[] = {
+      // crop aligned to the gain map, the base image and gain map are cropped ahead of the gain
+      // map application and the output is written oriented
+      {{{CROP, {64, 32, 640, 360}}, {MIRROR, {UHDR_MIRROR_HORIZONTAL}}, {ROTATE, {90}}}, true},
+      {{{ROTATE, {270}}, {CROP, {40, 80, 320, 640}}, {RESIZE, {200, 400}}}, false},
+      {{{RESIZE, {640, 360}}, {MIRROR, {UHDR_MIRROR_VERTICAL}}}, false},
+      // crops of the 4:2:0 base image at odd offsets or sizes split chroma samples, these decode
+      // at full size and transform the output
+      {{{CROP, {33, 17, 501, 333}}, {MIRROR, {UHDR_MIRROR_VERTICAL}}, {ROTATE, {180}}}, true},
+      {{{CROP, {33, 17, 500, 332}}, {ROTATE, {90}}}, true},
+      {{{CROP, {1, 0, 1279, 719}}, {RESIZE, {427, 239}}}, true},
+  };
+  const struct {
+    uhdr_color_transfer_t ct;
+    uhdr_img_fmt_t fmt;
+  } outputs[] = {{UHDR_CT_HLG, UHDR_IMG_FMT_32bppRGBA1010102},
+                 {UHDR_CT_PQ, UHDR_IMG_FMT_32bppRGBA1010102},
+                 {UHDR_CT_SRGB, UHDR_IMG_FMT_32bppRGBA8888}};
+
+  for (auto& out : outputs) {
+    uhdr_codec_private_t* refDec = uhdr_create_decoder();
+    status = uhdr_dec_set_image(refDec, input);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_out_color_transfer(refDec, out.ct);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_dec_set_out_img_format(refDec, out.fmt);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    status = uhdr_decode(refDec);
+    ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+    uhdr_raw_image_t* full = uhdr_get_decoded_image(refDec);
+    ASSERT_NE(nullptr, full);
+
+    for (size_t k = 0; k < sizeof chains / sizeof chains[0]; k++) {
+      uhdr_codec_private_t* dec = uhdr_create_decoder();
+      status = uhdr_dec_set_image(dec, input);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      status = uhdr_dec_set_out_color_transfer(dec, out.ct);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      status = uhdr_dec_set_out_img_format(dec, out.fmt);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      uhdr_effect_transform_t xfm(full->fmt, full->w, full->h);
+      for (auto& e : chains[k].effects) {
+        if (e.type == CROP) {
+          status = uhdr_add_effect_crop(dec, e.args[0], e.args[0] + e.args[2], e.args[1],
+                                        e.args[1] + e.args[3]);
+          xfm.crop(e.args[0], e.args[1], e.args[2], e.args[3]);
+        } else if (e.type == MIRROR) {
+          status = uhdr_add_effect_mirror(dec, (uhdr_mirror_direction_t)e.args[0]);
+          xfm.mirror((uhdr_mirror_direction_t)e.args[0]);
+        } else if (e.type == ROTATE) {
+          status = uhdr_add_effect_rotate(dec, e.args[0]);
+          xfm.rotate(e.args[0]);
+        } else {
+          status = uhdr_add_effect_resize(dec, e.args[0], e.args[1]);
+          xfm.resize(e.args[0], e.args[1]);
+        }
+        ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      }
+      status = uhdr_decode(dec);
+      ASSERT_EQ(UHDR_CODEC_OK, status.error_code) << status.detail;
+      uhdr_raw_image_t* img = uhdr_get_decoded_image(dec);
+      ASSERT_NE(nullptr, img);
+      std::unique_ptr<uhdr_raw_image_ext_t> ref = apply_transform(&xfm, full);
+      ASSERT_NE(nullptr, ref);
+      ASSERT_EQ(ref->w, img->w);
+      ASSERT_EQ(ref->h, img->h);
+      ASSERT_EQ(full->fmt, img->fmt);
+      ASSERT_EQ(full->ct, img->ct);
+
+      const int bits = out.fmt == UHDR_IMG_FMT_32bppRGBA8888 ? 8 : 10;
+      const uint32_t mask = (1u << bits) - 1;
+      double sum = 0;
+      int maxDiff = 0;
+      for (unsigned int y = 0; y < img->h; y++) {
+        const uint32_t* a = static_cast<uint32_t*>(img->planes[UHDR_PLANE_PACKED]) +
+                            (size_t)y * img->stride[UHDR_PLANE_PACKED];
+        const uint32_t* b = static_cast<uint32_t*>(ref->planes[UHDR_PLANE_PACKED]) +
+                            (size_t)y * ref->stride[UHDR_PLANE_PACKED];
+        for (unsigned int x = 0; x < img->w; x++) {
+          for (int c = 0; c < 3; c++) {
+            int diff = std::abs((int)((a[x] >> (c * bits)) & mask) -
+                                (int)((b[x] >> (c * bits)) & mask));
+            sum += diff;
+            maxDiff = (std::max)(maxDiff, diff);
+          }
+        }
+      }
+      // sdr output is transformed as decoded. Hdr output of resized chains is computed from the
+      // resampled base image and gain map, which differs from resampling the hdr output
+      if (chains[k].exact || out.ct == UHDR_CT_SRGB) {
+        EXPECT_EQ(0, maxDiff) << "chain " << k << ", color transfer " << out.ct;
+      } else {
+        EXPECT_LE(sum / (3.0 * img->w * img->h), 4.0) << "chain " << k << ", color transfer "
+                                                      << out.ct;
+      }
+      uhdr_release_decoder(dec);
+    }
+    uhdr_release_decoder(refDec);
+  }
+  uhdr_release_encoder(enc);
+}
 }  // namespace ultrahdr
@@ -166,8 +166,17 @@ typedef enum uhdr_img_label {
 typedef enum uhdr_enc_preset {
   UHDR_USAGE_REALTIME,     /**< tune encoder settings for performance */
   UHDR_USAGE_BEST_QUALITY, /**< tune encoder settings for quality */
+  UHDR_USAGE_FASTEST,      /**< tune encoder settings for speed at the cost of quality and size */
+  UHDR_USAGE_BALANCED,     /**< tune encoder settings for a trade-off between speed and quality */
 } uhdr_enc_preset_t;       /**< alias for enum uhdr_enc_preset */
 
+/*!\brief uhdr decoder usage parameter */
+typedef enum uhdr_dec_preset {
+  UHDR_DEC_USAGE_BALANCED,     /**< tune decoder settings for a speed-quality trade-off */
+  UHDR_DEC_USAGE_REALTIME,     /**< tune decoder settings for performance */
+  UHDR_DEC_USAGE_BEST_QUALITY, /**< tune decoder settings for quality */
+} uhdr_dec_preset_t;           /**< alias for enum uhdr_dec_preset */
+
 /*!\brief Algorithm return codes */
 typedef enum uhdr_codec_err {
 
@@ -273,6 +282,14 @@ typedef struct uhdr_gainmap_metadata {
   int use_base_cg;         /**< Is gainmap application space same as base image color space */
 } uhdr_gainmap_metadata_t; /**< alias for struct uhdr_gainmap_metadata */
 
+/**\brief Rendition Descriptor, one output of uhdr_decode_renditions() */
+typedef struct uhdr_rendition {
+  unsigned int w;           /**< Output width */
+  unsigned int h;           /**< Output height */
+  uhdr_img_fmt_t fmt;       /**< Output image format */
+  uhdr_color_transfer_t ct; /**< Output color transfer */
+} uhdr_rendition_t;         /**< alias for struct uhdr_rendition */
+
 /**\brief ultrahdr codec context opaque descriptor */
 typedef struct uhdr_codec_private uhdr_codec_private_t;
 
@@ -469,8 +486,17 @@ UHDR_EXTERN uhdr_error_info_t uhdr_enc_set_target_display_peak_brightness(uhdr_c
 /*!\brief Set encoding preset. Tunes the encoder configurations for performance or quality. Default
  * configuration is #UHDR_USAGE_BEST_QUALITY.
  *
+ * In the order of decreasing speed, the presets are #UHDR_USAGE_FASTEST, #UHDR_USAGE_REALTIME,
+ * #UHDR_USAGE_BALANCED and #UHDR_USAGE_BEST_QUALITY. A preset selects the jpeg forward dct method,
+ * huffman table optimization, chroma subsampling of rgb sdr intent, gain map computation passes
+ * and the number of worker threads. It also selects gain map scale factor and gain map channel
+ * count, unless these are configured by uhdr_enc_set_gainmap_scale_factor() and
+ * uhdr_enc_set_using_multi_channel_gainmap() respectively.
+ *
  * \param[in]  enc  encoder instance.
- * \param[in]  preset  encoding preset. #UHDR_USAGE_REALTIME - Tune settings for best performance
+ * \param[in]  preset  encoding preset. #UHDR_USAGE_FASTEST - Tune settings for fastest encoding
+ *                                      #UHDR_USAGE_REALTIME - Tune settings for best performance
+ *                                      #UHDR_USAGE_BALANCED - Tune settings for a trade-off
  *                                      #UHDR_USAGE_BEST_QUALITY - Tune settings for best quality
  *
  * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds,
@@ -479,6 +505,25 @@ UHDR_EXTERN uhdr_error_info_t uhdr_enc_set_target_display_peak_brightness(uhdr_c
 UHDR_EXTERN uhdr_error_info_t uhdr_enc_set_preset(uhdr_codec_private_t* enc,
                                                   uhdr_enc_preset_t preset);
 
+/*!\brief Set target size of the compressed output. When configured, the encoder searches for the
+ * highest base image quality factor, not exceeding the one set via uhdr_enc_set_quality(), for
+ * which the encoded ultrahdr image fits in the target size. The gain map image is compressed at
+ * the lesser of the candidate quality factor and its configured quality factor. The forward dct of
+ * base and gain map images is computed once; each candidate only repeats quantization and entropy
+ * coding. This mode is supported only when the base image is compressed by the library, i.e. sdr
+ * intent is not set in compressed format. If the output does not fit in the target size even at the
+ * lowest quality factor, uhdr_encode() returns #UHDR_CODEC_ERROR. Default configuration is 0,
+ * which disables this mode.
+ *
+ * \param[in]  enc  encoder instance.
+ * \param[in]  target_size  target size of the compressed output in bytes. 0 to disable.
+ *
+ * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds,
+ *                           #UHDR_CODEC_INVALID_PARAM otherwise.
+ */
+UHDR_EXTERN uhdr_error_info_t uhdr_enc_set_target_size(uhdr_codec_private_t* enc,
+                                                       size_t target_size);
+
 /*!\brief Set output image compression format. Selects the compression format for encoding base
  * image and gainmap image. Default configuration is #UHDR_CODEC_JPG
  *
@@ -521,6 +566,8 @@ UHDR_EXTERN uhdr_error_info_t uhdr_enc_set_output_format(uhdr_codec_private_t* e
  *   - uhdr_enc_set_preset()
  * - If the application wants to control target compression format
  *   - uhdr_enc_set_output_format()
+ * - If the application wants to limit the size of the compressed output
+ *   - uhdr_enc_set_target_size()
  * - The program calls uhdr_encode() to encode data. This call would initiate the process of
  * computing gain map from hdr intent and sdr intent. The sdr intent and gain map image are
  * compressed at the set quality using the codec of choice.
@@ -578,6 +625,33 @@ UHDR_EXTERN uhdr_error_info_t uhdr_enc_set_output_format(uhdr_codec_private_t* e
  */
 UHDR_EXTERN uhdr_error_info_t uhdr_encode(uhdr_codec_private_t* enc);
 
+/*!\brief Remux process call
+ * Rewrites gain map metadata, exif and / or icc of an existing uhdr image without re-encoding. The
+ * base image and gain map image are extracted from the input, their metadata segments are replaced
+ * and the images are combined again. The entropy coded data of both images is copied as is, so the
+ * operation is lossless and considerably faster than a decode followed by an encode. If crop,
+ * mirror and / or rotate effects are added to the encoder context, they are applied to both images
+ * losslessly by rearranging their dct coefficients, see uhdr_add_effect_crop(). Retained exif is
+ * not updated, an exif orientation tag the effects undo has to be reset via the exif argument.
+ * Other settings of the encoder context are not used. If the call is successful, the output is
+ * accessible via uhdr_get_encoded_stream(). Similar to uhdr_encode(), this call switches the
+ * context to end state.
+ *
+ * \param[in]  enc  encoder instance.
+ * \param[in]  img  compressed uhdr image descriptor.
+ * \param[in]  metadata  replacement gain map metadata. If nullptr, metadata of the input is
+ *                       retained.
+ * \param[in]  exif  replacement exif data. If nullptr, exif of the input is retained. If data_sz is
+ *                   0, exif is removed.
+ * \param[in]  icc  replacement icc data of base image, inclusive of the APP2 ICC_PROFILE header. If
+ *                  nullptr, icc of the input is retained. If data_sz is 0, icc is removed.
+ *
+ * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+ */
+UHDR_EXTERN uhdr_error_info_t uhdr_remux(uhdr_codec_private_t* enc, uhdr_compressed_image_t* img,
+                                         uhdr_gainmap_metadata_t* metadata, uhdr_mem_block_t* exif,
+                                         uhdr_mem_block_t* icc);
+
 /*!\brief Get encoded ultra hdr stream
  *
  * \param[in]  enc  encoder instance.
@@ -682,6 +756,25 @@ UHDR_EXTERN uhdr_error_info_t uhdr_dec_set_out_color_transfer(uhdr_codec_private
 UHDR_EXTERN uhdr_error_info_t uhdr_dec_set_out_max_display_boost(uhdr_codec_private_t* dec,
                                                                  float display_boost);
 
+/*!\brief Set decoding preset. Tunes the decoder configurations for performance or quality. Default
+ * configuration is #UHDR_DEC_USAGE_BALANCED.
+ *
+ * #UHDR_DEC_USAGE_BEST_QUALITY evaluates transfer functions and gain application in floating point.
+ * #UHDR_DEC_USAGE_BALANCED replaces them with look up tables. #UHDR_DEC_USAGE_REALTIME additionally
+ * uses fast integer inverse dct, disables fancy chroma upsampling and samples the gain map with
+ * nearest neighbor interpolation. This is meant for viewers that favor latency over accuracy.
+ *
+ * \param[in]  dec  decoder instance.
+ * \param[in]  preset  decoding preset. #UHDR_DEC_USAGE_REALTIME - Tune for best performance
+ *                                      #UHDR_DEC_USAGE_BALANCED - Tune for a trade-off
+ *                                      #UHDR_DEC_USAGE_BEST_QUALITY - Tune for best quality
+ *
+ * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds,
+ *                           #UHDR_CODEC_INVALID_PARAM otherwise.
+ */
+UHDR_EXTERN uhdr_error_info_t uhdr_dec_set_preset(uhdr_codec_private_t* dec,
+                                                  uhdr_dec_preset_t preset);
+
 /*!\brief This function parses the bitstream that is registered with the decoder context and makes
  * image information available to the client via uhdr_dec_get_() functions. It does not decompress
  * the image. That is done by uhdr_decode().
@@ -783,6 +876,8 @@ UHDR_EXTERN uhdr_gainmap_metadata_t* uhdr_dec_get_gainmap_metadata(uhdr_codec_pr
  *   - uhdr_dec_set_out_color_transfer()
  * - If the application wants to control the output display boost,
  *   - uhdr_dec_set_out_max_display_boost()
+ * - If the application wants to trade quality for speed,
+ *   - uhdr_dec_set_preset()
  * - If the application wants to enable/disable gpu acceleration,
  *   - uhdr_enable_gpu_acceleration()
  * - The program calls uhdr_decode() to decode uhdr stream. This call would initiate the process
@@ -813,6 +908,44 @@ UHDR_EXTERN uhdr_raw_image_t* uhdr_get_decoded_image(uhdr_codec_private_t* dec);
  */
 UHDR_EXTERN uhdr_raw_image_t* uhdr_get_decoded_gainmap_image(uhdr_codec_private_t* dec);
 
+/*!\brief Decode process call producing several renditions
+ * Decodes the base image and gain map image once and renders them at each of the requested sizes,
+ * formats and color transfers. This is an alternative to calling uhdr_decode() with a resize
+ * effect once per output size. Renditions are produced largest first and each smaller level of the
+ * base image and gain map image is area downsampled from the smallest larger level already built.
+ * The gain map is then applied per level at that level's resolution. SDR renditions are built
+ * from the rgb decode of the base image, as uhdr_decode() produces them, so a rendition does not
+ * depend on the other renditions requested along with it. HDR renditions need the base image in
+ * YCbCr, so a request that mixes SDR and HDR renditions decodes the base image twice, once for
+ * each. Output format and color transfer pairs follow the rules of uhdr_decode(). The max display
+ * boost and preset settings of the decoder context apply to all renditions. Queued effects and gpu
+ * acceleration are not supported by this call.
+ *
+ * Like uhdr_decode(), this call may only be made once per configured context. If the call is
+ * successful, the decoded outputs are stored internally and are accessible via
+ * uhdr_get_decoded_rendition().
+ *
+ * \param[in]  dec  decoder instance.
+ * \param[in]  renditions  array of rendition descriptors.
+ * \param[in]  count  number of entries in renditions.
+ *
+ * \return uhdr_error_info_t #UHDR_CODEC_OK if operation succeeds, uhdr_codec_err_t otherwise.
+ */
+UHDR_EXTERN uhdr_error_info_t uhdr_decode_renditions(uhdr_codec_private_t* dec,
+                                                     const uhdr_rendition_t* renditions,
+                                                     unsigned int count);
+
+/*!\brief Get a rendition image produced by uhdr_decode_renditions()
+ *
+ * \param[in]  dec  decoder instance.
+ * \param[in]  index  position of the rendition in the array passed to uhdr_decode_renditions().
+ *
+ * \return nullptr if decode renditions call is unsuccessful or index is out of range, raw image
+ * descriptor otherwise
+ */
+UHDR_EXTERN uhdr_raw_image_t* uhdr_get_decoded_rendition(uhdr_codec_private_t* dec,
+                                                         unsigned int index);
+
 /*!\brief Reset decoder instance.
  * Clears all previous settings and resets to default state and ready for re-initialization and
  * usage
@@ -843,6 +976,15 @@ UHDR_EXTERN uhdr_error_info_t uhdr_enable_gpu_acceleration(uhdr_codec_private_t*
  * Below functions list the set of edits supported. Program can set any combination of these during
  * initialization. Once the encode/decode process call is made, before encoding or after decoding
  * the edits are applied in the order of configuration.
+ *
+ * For an encode from a compressed base image and a compressed gain map image (api - 4), and for
+ * uhdr_remux(), crop, mirror and rotate edits are applied losslessly in the dct domain, the way
+ * jpegtran does. Whole imcus (blocks of 8 x 8 pixels times the largest sampling factor) are moved,
+ * so crop offsets must be multiples of the imcu size of the base image that fall on imcu boundaries
+ * of the gain map. Trailing partial imcus along mirrored axes are trimmed. Along other axes the
+ * crop end is moved inwards until it maps to a whole gain map sample, so a crop may come out
+ * smaller than requested, e.g. with a gain map of a quarter of the image size a crop of 1001 x 701
+ * pixels from the origin gives a 1000 x 700 image. Resize is not supported.
  */
 
 /*!\brief Add mirror effect